@@ -1,19 +1,49 @@
 #version 330 core
+/*<defines>*/
+// Defaults of the "interactive" quality tier
+#ifndef MAX_STEPS
 #define MAX_STEPS 100
+#endif
+#ifndef MAX_DISTANCE
 #define MAX_DISTANCE 150.0
+#endif
+#ifndef SURFACE_DISTANCE
 #define SURFACE_DISTANCE 0.001
+#endif
+// Ray hit distance of objects the ray misses
+#define NO_HIT 1e10
 
 out vec4 color;
 
 uniform vec2 u_Resolution;
+// Bottom left pixel of the rendered tile in a frame of u_Resolution
+uniform vec2 u_PixelOffset;
 uniform vec3 u_LightPos;
 
 uniform vec3 u_CameraPos;
 uniform float u_CameraRotY;
-uniform int u_EnableShadows;
 uniform float u_SmoothMinValue;
 uniform sampler2D u_NoiseTex;
 uniform float u_Time;
+uniform int u_InterleaveMode;
+uniform int u_FrameIndex;
+// Pixels apart of progressive samples and the coarser level, see ProgressiveRayMarch
+uniform int u_ProgressiveStep;
+uniform sampler2D u_CoarseTex;
+uniform int u_HasCoarse;
+// Edge strengths of the first pass and the weakest one supersampled, see SupersampledRayMarch
+uniform sampler2D u_EdgeTex;
+uniform int u_EdgeThreshold;
+// Intersects objects with closed form intersections instead of marching them while unions are hard, see RayMarchFrom
+uniform int u_AnalyticHits;
+
+// Uniform grid over bounded objects, see ObjectGrid
+uniform isamplerBuffer u_GridCells;
+uniform isamplerBuffer u_GridObjects;
+uniform vec3 u_GridMin;
+uniform vec3 u_GridCellSize;
+uniform ivec3 u_GridDims;
+uniform float u_GridMargin;
 
 /*<uniforms>*/
 
@@ -39,14 +69,90 @@ mat2 Rotate(float a)
     return mat2(c, -s, s, c);
 }
 
+// Distance along normalized rd to a sphere, 0 from inside it
+float SphereHit(vec3 ro, vec3 rd, vec3 center, float radius)
+{
+    vec3 offset = ro - center;
+    float b = dot(offset, rd);
+    float h = b * b - dot(offset, offset) + radius * radius;
+    if (h < 0.0 || -b + sqrt(h) < 0.0) {
+        return NO_HIT;
+    }
+    return max(-b - sqrt(h), 0.0);
+}
+
+// Distance along rd to an axis aligned box, 0 from inside it
+float BoxHit(vec3 ro, vec3 rd, vec3 center, vec3 halfSize)
+{
+    vec3 inverse = 1.0 / rd;
+    vec3 t0 = (center - halfSize - ro) * inverse;
+    vec3 t1 = (center + halfSize - ro) * inverse;
+    vec3 near = min(t0, t1);
+    vec3 far = max(t0, t1);
+    float enter = max(max(near.x, near.y), near.z);
+    float exit = min(min(far.x, far.y), far.z);
+    if (enter > exit || exit < 0.0) {
+        return NO_HIT;
+    }
+    return max(enter, 0.0);
+}
+
 /*<dist_functions>*/
 
+/*<scene_functions>*/
+
+// Grid ids keep object group in the high bits and index inside the group in
+// the low bits, see ShapeRegistrar
+float GetObjectDistance(int id, vec3 p)
+{
+    /*<object_dist_code>*/
+    return MAX_DISTANCE;
+}
+
+// Evaluates only objects listed in the grid cell containing p. Boxes of all
+// objects are expanded by u_GridMargin, so any object missing from the cell
+// is at least that far beyond the cell faces
+float GetGridDistance(vec3 p)
+{
+    vec3 gridMax = u_GridMin + u_GridCellSize * vec3(u_GridDims);
+    vec3 outside = max(u_GridMin - p, p - gridMax);
+    if (any(greaterThan(outside, vec3(0.0)))) {
+        return length(max(outside, 0.0)) + u_GridMargin;
+    }
+
+    ivec3 cell = clamp(ivec3((p - u_GridMin) / u_GridCellSize), ivec3(0), u_GridDims - 1);
+    vec3 cellMin = u_GridMin + vec3(cell) * u_GridCellSize;
+    vec3 toFaces = min(p - cellMin, cellMin + u_GridCellSize - p);
+    float dist = min(toFaces.x, min(toFaces.y, toFaces.z)) + u_GridMargin;
+
+    ivec2 range = texelFetch(u_GridCells, (cell.z * u_GridDims.y + cell.y) * u_GridDims.x + cell.x).xy;
+    for (int i = 0; i < range.y; i++) {
+        int id = texelFetch(u_GridObjects, range.x + i).x;
+        dist = smin(dist, GetObjectDistance(id, p), u_SmoothMinValue);
+    }
+    return dist;
+}
+
 float GetSceneDistance(vec3 cameraPos)
 {
     /*<scene_dist_code>*/
     return 0.0f;
 }
 
+// Nearest surface of objects with a RayHitCall, see ShapeRegistrar
+float GetAnalyticHit(vec3 ro, vec3 rd)
+{
+    /*<analytic_hit_code>*/
+    return NO_HIT;
+}
+
+// GetSceneDistance without the objects of GetAnalyticHit
+float GetMarchedDistance(vec3 cameraPos)
+{
+    /*<marched_dist_code>*/
+    return MAX_DISTANCE;
+}
+
 vec3 GetNormal(vec3 pointPos)
 {
     float dist = GetSceneDistance(pointPos);
@@ -60,16 +166,31 @@ vec3 GetNormal(vec3 pointPos)
     return normalize(normal);
 }
 
-float RayMarch(vec3 ro, vec3 rd, out vec3 pointPos)
+// Steps of every RayMarchFrom of the fragment, kept by StepCount mode
+int marchSteps = 0;
+
+// The surface of a hard union is where the ray first meets any of its
+// parts, so objects with closed form intersections are intersected once
+// and only the others are marched, up to that hit
+float RayMarchFrom(vec3 ro, vec3 rd, float start, int steps, out vec3 pointPos)
 {
-    float totalDistance = 0.0;
-    vec3 currCameraPos;
+    bool analytic = bool(u_AnalyticHits) && u_SmoothMinValue == 0.0;
+    float analyticHit = analytic ? GetAnalyticHit(ro, rd) : NO_HIT;
+    float totalDistance = start;
+    vec3 currCameraPos = ro + rd * start;
 
-    for (int i = 0; i < MAX_STEPS; i++) {
+    for (int i = 0; i < steps; i++) {
         // One step in direction of ray
         currCameraPos = ro + rd * totalDistance;
-        float sceneDistance = GetSceneDistance(currCameraPos);
+        float sceneDistance = analytic ? GetMarchedDistance(currCameraPos) : GetSceneDistance(currCameraPos);
         totalDistance += sceneDistance;
+        marchSteps++;
+
+        if (totalDistance >= analyticHit) {
+            totalDistance = analyticHit;
+            currCameraPos = ro + rd * analyticHit;
+            break;
+        }
 
         if (totalDistance > MAX_DISTANCE) {
             break;
@@ -85,6 +206,28 @@ float RayMarch(vec3 ro, vec3 rd, out vec3 pointPos)
     return totalDistance;
 }
 
+float RayMarch(vec3 ro, vec3 rd, out vec3 pointPos)
+{
+    return RayMarchFrom(ro, rd, 0.0, MAX_STEPS, pointPos);
+}
+
+// Marches the cone of given slope around the ray while it's empty. Any
+// ray inside the cone can start where it ends
+float ConeMarch(vec3 ro, vec3 rd, float start, float slope)
+{
+    float totalDistance = start;
+    for (int i = 0; i < MAX_STEPS && totalDistance < MAX_DISTANCE; i++) {
+        float sceneDistance = GetSceneDistance(ro + rd * totalDistance);
+        // Furthest step whose segment of every ray of the cone stays in the empty sphere
+        float step = (sceneDistance - totalDistance * slope) / (1.0 + slope);
+        if (step < SURFACE_DISTANCE) {
+            break;
+        }
+        totalDistance += step;
+    }
+    return totalDistance;
+}
+
 vec3 GetLight(vec3 pointPos)
 {
     vec3 lightPos = u_LightPos;
@@ -93,14 +236,14 @@ vec3 GetLight(vec3 pointPos)
     vec3 pointNormal = GetNormal(pointPos);
 
     float diffuse = clamp(dot(pointNormal, lightDir) * 0.5 + 0.5, 0.0, 1.0);
-    if (bool(u_EnableShadows)) {
-        vec3 dummy;
-        float lightDist = RayMarch(pointPos + pointNormal * SURFACE_DISTANCE, lightDir, dummy);
+#ifdef ENABLE_SHADOWS
+    vec3 dummy;
+    float lightDist = RayMarch(pointPos + pointNormal * SURFACE_DISTANCE, lightDir, dummy);
 
-        if (lightDist < length(lightVec)) {
-            diffuse *= 0.2;
-        }
+    if (lightDist < length(lightVec)) {
+        diffuse *= 0.2;
     }
+#endif
 
     return vec3(diffuse);
 }
@@ -111,26 +254,124 @@ vec3 GetDistanceDiffuse(float totalDistance)
     return vec3(clamp(1.0 - totalDistance / MAX_DISTANCE, 0, 1));
 }
 
-vec4 ColorizedRayMarch(vec3 ro, vec3 rd)
+vec4 ColorizedRayMarch(vec3 ro, vec3 rd, float start, int steps)
 {
     vec3 pointPos;
-    float distance = RayMarch(ro, rd, pointPos);
+    float distance = RayMarchFrom(ro, rd, start, steps, pointPos);
 
     vec3 color = GetLight(pointPos);
     // Apply fog effect
     color *= GetDistanceDiffuse(distance);
-    return vec4(color, 1.0);
+    return vec4(color, distance);
+}
+
+// Order in which pixels of a 2x2 block are marched, must match Reconstruct.shader
+const ivec2 sInterleaveOffsets[4] = ivec2[4](ivec2(0, 0), ivec2(1, 1), ivec2(1, 0), ivec2(0, 1));
+
+// Maps fragment of the (possibly reduced) march target to the full resolution pixel it shades
+vec2 GetPixelCoord()
+{
+    ivec2 coord = ivec2(gl_FragCoord.xy);
+    if (u_InterleaveMode == 1) {
+        // Checkerboard: every other pixel of a row, pattern flips each frame
+        return vec2(coord.x * 2 + ((coord.y + u_FrameIndex) & 1), coord.y) + 0.5 + u_PixelOffset;
+    }
+    if (u_InterleaveMode == 2) {
+        // One pixel of each 2x2 block per frame
+        return vec2(coord * 2 + sInterleaveOffsets[u_FrameIndex & 3]) + 0.5 + u_PixelOffset;
+    }
+    if (u_InterleaveMode == 3) {
+        // Progressive: every u_ProgressiveStep-th pixel of rows and columns
+        return vec2(coord * u_ProgressiveStep) + 0.5 + u_PixelOffset;
+    }
+    return gl_FragCoord.xy + u_PixelOffset;
+}
+
+// Level of RayMarchingWindow::RenderProgressive. Samples of the coarser
+// level, every other one of this level, are kept. Others start at the
+// nearest distance coarse samples around them found empty, and leave in
+// alpha how far the cone reaching to the finer pixels around them is empty
+vec4 ProgressiveRayMarch(vec3 ro, vec3 rd)
+{
+    ivec2 coord = ivec2(gl_FragCoord.xy);
+    float start = 0.0;
+    if (bool(u_HasCoarse)) {
+        if ((coord & 1) == ivec2(0)) {
+            return texelFetch(u_CoarseTex, coord >> 1, 0);
+        }
+        ivec2 coarseMax = textureSize(u_CoarseTex, 0) - 1;
+        start = MAX_DISTANCE;
+        for (int y = 0; y <= 1; y++) {
+            for (int x = 0; x <= 1; x++) {
+                start = min(start, texelFetch(u_CoarseTex, min((coord >> 1) + ivec2(x, y), coarseMax), 0).a);
+            }
+        }
+    }
+
+    if (u_ProgressiveStep > 1) {
+        // Finer pixels are at most half a diagonal of this level away from a sample
+        float slope = float(u_ProgressiveStep) * 0.70710678 / u_Resolution.y;
+        start = ConeMarch(ro, rd, start, slope);
+    }
+    vec4 color = ColorizedRayMarch(ro, rd, start, MAX_STEPS);
+    // Near the horizon the full pass runs out of steps along the ground and
+    // shades where it stopped, a ray starting further leaves MAX_DISTANCE
+    // instead. Rays that miss march again from the camera, as it does
+    if (start > 0.0 && color.a > MAX_DISTANCE) {
+        color = ColorizedRayMarch(ro, rd, 0.0, MAX_STEPS);
+    }
+    return vec4(color.rgb, start);
+}
+
+vec3 GetRayDirection(vec2 pixelCoord)
+{
+    vec2 uv = (pixelCoord - 0.5 * u_Resolution) / u_Resolution.y;
+    vec3 rd = vec3(uv.x, uv.y, 1.0);
+    rd.xz *= Rotate(-u_CameraRotY);
+    return normalize(rd);
+}
+
+// Rotated grid of 4 rays per pixel, edges of every direction get 4 distinct coverage levels
+const vec2 sSupersampleOffsets[4] = vec2[4](vec2(0.125, 0.375), vec2(0.375, -0.125), vec2(-0.125, -0.375), vec2(-0.375, 0.125));
+
+// Antialiased pixel of RayMarchingWindow::DrawAntialiased. Pixels whose edge
+// strength is below u_EdgeThreshold are discarded and keep the first pass,
+// a negative threshold supersamples every pixel
+vec4 SupersampledRayMarch(vec3 ro, vec2 pixelCoord)
+{
+    // Rays are marched inside the branch, some drivers run code past a discard for the discarded fragments
+    vec3 sum = vec3(0.0);
+    if (u_EdgeThreshold < 0 || int(texelFetch(u_EdgeTex, ivec2(gl_FragCoord.xy), 0).r * 255.0 + 0.5) >= u_EdgeThreshold) {
+        for (int i = 0; i < 4; i++) {
+            sum += ColorizedRayMarch(ro, GetRayDirection(pixelCoord + sSupersampleOffsets[i]), 0.0, MAX_STEPS).rgb;
+        }
+    } else {
+        discard;
+    }
+    return vec4(sum * 0.25, 1.0);
 }
 
 void main()
 {
-    vec2 uv = (gl_FragCoord.xy - 0.5 * u_Resolution) / u_Resolution.y;
+    vec2 pixelCoord = GetPixelCoord();
     // Camera position
     vec3 ro = u_CameraPos;
     // Camera ray direction
-    vec3 rd = vec3(uv.x, uv.y, 1.0);
-    rd.xz *= Rotate(-u_CameraRotY);
-    rd = normalize(rd);
+    vec3 rd = GetRayDirection(pixelCoord);
 
-    color = ColorizedRayMarch(ro, rd);
-}
\ No newline at end of file
+    if (u_InterleaveMode == 3) {
+        color = ProgressiveRayMarch(ro, rd);
+        return;
+    }
+    if (u_InterleaveMode == 5) {
+        color = SupersampledRayMarch(ro, pixelCoord);
+        return;
+    }
+    color = ColorizedRayMarch(ro, rd, 0.0, MAX_STEPS);
+    if (u_InterleaveMode == 6) {
+        color.a = float(marchSteps);
+    } else if (u_InterleaveMode != 4) {
+        // Only the first pass of antialiasing keeps hit distances
+        color.a = 1.0;
+    }
+}
@@ -0,0 +1,105 @@
+#version 330 core
+
+out vec4 color;
+
+// Reduced march target with pixels shaded this frame
+uniform sampler2D u_SampleTex;
+// Full resolution output of previous frame
+uniform sampler2D u_HistoryTex;
+uniform int u_InterleaveMode;
+uniform int u_FrameIndex;
+uniform int u_HistoryValid;
+// Pixels apart of progressive samples
+uniform int u_ProgressiveStep;
+
+// Must match Fragment.shader
+const ivec2 sInterleaveOffsets[4] = ivec2[4](ivec2(0, 0), ivec2(1, 1), ivec2(1, 0), ivec2(0, 1));
+
+// Edge strength of an antialiasing first pass, whose alpha holds hit
+// distances: the largest luma step to a neighbour, or the kink of inverse
+// distance across the pixel. Inverse distance is linear on a plane, so
+// only silhouettes and creases have a kink
+float EdgeStrength(ivec2 pixel, ivec2 sampleMax)
+{
+    const vec3 lumaWeights = vec3(0.299, 0.587, 0.114);
+    vec4 center = texelFetch(u_SampleTex, pixel, 0);
+    vec4 left = texelFetch(u_SampleTex, max(pixel - ivec2(1, 0), ivec2(0)), 0);
+    vec4 right = texelFetch(u_SampleTex, min(pixel + ivec2(1, 0), sampleMax), 0);
+    vec4 bottom = texelFetch(u_SampleTex, max(pixel - ivec2(0, 1), ivec2(0)), 0);
+    vec4 top = texelFetch(u_SampleTex, min(pixel + ivec2(0, 1), sampleMax), 0);
+
+    float luma = dot(center.rgb, lumaWeights);
+    float lumaStep = max(max(abs(dot(left.rgb, lumaWeights) - luma), abs(dot(right.rgb, lumaWeights) - luma)),
+        max(abs(dot(bottom.rgb, lumaWeights) - luma), abs(dot(top.rgb, lumaWeights) - luma)));
+
+    vec4 inverse = 1.0 / max(vec4(left.a, right.a, bottom.a, top.a), 1e-3);
+    float centerInverse = 1.0 / max(center.a, 1e-3);
+    float kink = max(abs(inverse.x + inverse.y - 2.0 * centerInverse), abs(inverse.z + inverse.w - 2.0 * centerInverse)) / centerInverse;
+    return max(lumaStep, kink);
+}
+
+bool IsMarchedThisFrame(ivec2 pixel)
+{
+    if (u_InterleaveMode == 1) {
+        return (pixel.x & 1) == ((pixel.y + u_FrameIndex) & 1);
+    }
+    return (pixel & 1) == sInterleaveOffsets[u_FrameIndex & 3];
+}
+
+ivec2 GetSampleCoord(ivec2 pixel)
+{
+    if (u_InterleaveMode == 1) {
+        return ivec2(pixel.x >> 1, pixel.y);
+    }
+    return pixel >> 1;
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    ivec2 sampleMax = textureSize(u_SampleTex, 0) - 1;
+
+    if (u_InterleaveMode == 3) {
+        // Progressive level blown up to full resolution, its alpha holds distances
+        color = vec4(texelFetch(u_SampleTex, min(pixel / u_ProgressiveStep, sampleMax), 0).rgb, 1.0);
+        return;
+    }
+
+    if (u_InterleaveMode == 4) {
+        color = vec4(clamp(EdgeStrength(pixel, sampleMax), 0.0, 1.0), 0.0, 0.0, 1.0);
+        return;
+    }
+
+    if (IsMarchedThisFrame(pixel)) {
+        color = texelFetch(u_SampleTex, min(GetSampleCoord(pixel), sampleMax), 0);
+        return;
+    }
+
+    // Gather neighbours marched this frame, any 3x3 window holds at least one
+    vec4 minColor = vec4(1.0);
+    vec4 maxColor = vec4(0.0);
+    vec4 sum = vec4(0.0);
+    float count = 0.0;
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            ivec2 neighbour = pixel + ivec2(x, y);
+            if (!IsMarchedThisFrame(neighbour)) {
+                continue;
+            }
+            vec4 s = texelFetch(u_SampleTex, clamp(GetSampleCoord(neighbour), ivec2(0), sampleMax), 0);
+            minColor = min(minColor, s);
+            maxColor = max(maxColor, s);
+            sum += s;
+            count += 1.0;
+        }
+    }
+
+    if (!bool(u_HistoryValid)) {
+        color = sum / count;
+        return;
+    }
+
+    // Reuse previous frame, clamped to the local neighbourhood to limit ghosting on motion
+    vec4 history = texelFetch(u_HistoryTex, pixel, 0);
+    color = clamp(history, minColor, maxColor);
+}
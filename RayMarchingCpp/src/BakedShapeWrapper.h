@@ -0,0 +1,260 @@
+#pragma once
+
+#include "RayMarchingWindow/IShapedObject.h"
+#include "RayMarchingWindow/IImGuiEditable.h"
+#include "RayMarchingWindow/IBakedObject.h"
+#include "RayMarchingWindow/SdfBaker.h"
+#include "OpenGL/GLCore.h"
+#include "OpenGL/Texture3D.h"
+#include "Math/Math.h"
+#include <imgui.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <optional>
+
+/*
+    Marches a static bounded object through its distance sampled into a 3D
+    texture. Far from the surface the trilinear sample is returned lowered by
+    its worst case error, near the surface the object is evaluated exactly,
+    so shading and silhouettes don't change. Outside of the volume distance
+    to the object bounds is returned
+*/
+class BakedShapeWrapper : public IShapedObject, public IImGuiEditable, public IBakedObject {
+public:
+    /*
+        resolution is the number of samples along the longest side of the
+        padded object bounds, textureSlot must not be used by the window or other objects
+    */
+    BakedShapeWrapper(std::shared_ptr<IShapedObject> shape, const std::string& name, unsigned int textureSlot, unsigned int resolution)
+        : mShape(shape), mName(name), mTextureSlot(textureSlot), mResolution(std::max(resolution, sMinResolution))
+    {
+    }
+
+    BakedShapeWrapper(const BakedShapeWrapper&) = delete;
+    BakedShapeWrapper& operator=(const BakedShapeWrapper&) = delete;
+
+    ~BakedShapeWrapper()
+    {
+        mTexture.Delete();
+    }
+
+    virtual void UpdateBake(const DistanceContext& context) override
+    {
+        std::optional<Math::AABB> bounds = mShape->Bounds();
+        if (!bounds || mShape->IsAnimated()) {
+            if (!mBakeFailed) {
+                std::cerr << "[Warning] BakedShapeWrapper: '" << mName << "' is " << (bounds ? "animated" : "unbounded")
+                    << ", evaluating it directly\n";
+                mBakeFailed = true;
+            }
+            return;
+        }
+
+        if (!mRebakeRequested && *bounds == mBakedShapeBounds && context.SmoothMin == mBakedSmoothMin) {
+            return;
+        }
+
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+        SdfBaker::Volume volume;
+        if (mPrepared && !mRebakeRequested && *bounds == mPreparedShapeBounds && context.SmoothMin == mPreparedSmoothMin) {
+            volume = std::move(*mPrepared);
+        } else {
+            volume = Bake(*bounds, context);
+        }
+        mPrepared.reset();
+        mFallbackDistance = sFallbackVoxels * sSqrt3 * VoxelSize(*bounds);
+
+        if (mTexture.Width() != volume.Dimensions[0] || mTexture.Height() != volume.Dimensions[1] || mTexture.Depth() != volume.Dimensions[2]) {
+            mTexture.Delete();
+            mTexture = OpenGL::Texture3D(volume.Dimensions[0], volume.Dimensions[1], volume.Dimensions[2], GL_R16F);
+        }
+        mTexture.Update(volume.Distances.data(), GL_RED, GL_FLOAT);
+
+        mVolumeBounds = volume.Bounds;
+        mBakedShapeBounds = *bounds;
+        mBakedSmoothMin = context.SmoothMin;
+        mRebakeRequested = false;
+        mBakeTime = std::chrono::steady_clock::now() - t0 + mPreparedTime;
+        mPreparedTime = std::chrono::duration<double, std::milli>(0.0);
+    }
+
+    /*
+        Bakes the volume UpdateBake uploads next, which mustn't run until
+        this returns
+    */
+    virtual void PrepareBake(const DistanceContext& context) override
+    {
+        std::optional<Math::AABB> bounds = mShape->Bounds();
+        if (!bounds || mShape->IsAnimated()) {
+            return;
+        }
+
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        mPrepared = Bake(*bounds, context);
+        mPreparedShapeBounds = *bounds;
+        mPreparedSmoothMin = context.SmoothMin;
+        mPreparedTime = std::chrono::steady_clock::now() - t0;
+    }
+
+    virtual void SetVolumeEnabled(bool enabled) override
+    {
+        mVolumeEnabled = enabled;
+    }
+
+    virtual bool VolumeEnabled() const override
+    {
+        return mVolumeEnabled;
+    }
+
+    virtual double BakeMilliseconds() const override
+    {
+        return mBakeTime.count();
+    }
+
+    virtual size_t VolumeSizeInBytes() const override
+    {
+        return mBakeFailed ? 0 : mTexture.SizeInBytes();
+    }
+
+    virtual void PassToShader(OpenGL::ShaderProgram& shader) override
+    {
+        mShape->PassToShader(shader);
+
+        bool enabled = mVolumeEnabled && !mBakeFailed && mTexture.Width() > 0;
+        shader.SetUniform1i(Name() + "Enabled", enabled);
+        // Set even when disabled, samplers of different types must not share a unit
+        shader.SetUniform1i(Name(), mTextureSlot);
+        if (enabled) {
+            mTexture.Bind(mTextureSlot);
+            shader.SetUniform3f(Name() + "Min", mVolumeBounds.Min().x(), mVolumeBounds.Min().y(), mVolumeBounds.Min().z());
+            shader.SetUniform3f(Name() + "Max", mVolumeBounds.Max().x(), mVolumeBounds.Max().y(), mVolumeBounds.Max().z());
+            shader.SetUniform3f(Name() + "ShapeMin", mBakedShapeBounds.Min().x(), mBakedShapeBounds.Min().y(), mBakedShapeBounds.Min().z());
+            shader.SetUniform3f(Name() + "ShapeMax", mBakedShapeBounds.Max().x(), mBakedShapeBounds.Max().y(), mBakedShapeBounds.Max().z());
+            shader.SetUniform1f(Name() + "Fallback", mFallbackDistance);
+        }
+    }
+
+    virtual void RenderImGuiEditor() override
+    {
+        ImGui::Checkbox("use baked volume", &mVolumeEnabled);
+        if (ImGui::Button("rebake")) {
+            mRebakeRequested = true;
+        }
+        ImGui::Text("%ux%ux%u samples, %.1f KB, baked in %.1f ms", mTexture.Width(), mTexture.Height(), mTexture.Depth(),
+            VolumeSizeInBytes() / 1024.0, BakeMilliseconds());
+    }
+
+    virtual std::string_view SectionName() const override
+    {
+        return Name();
+    }
+
+    virtual std::string UniformsDefinitions() const override
+    {
+        return mShape->UniformsDefinitions() + UNIFORM(sampler3D, Name()) + UNIFORM(int, Name() + "Enabled") +
+            UNIFORM(vec3, Name() + "Min") + UNIFORM(vec3, Name() + "Max") +
+            UNIFORM(vec3, Name() + "ShapeMin") + UNIFORM(vec3, Name() + "ShapeMax") + UNIFORM(float, Name() + "Fallback");
+    }
+
+    virtual std::string SceneFunctionsDefinitions() const override
+    {
+        std::string exact = mShape->DistFunctionCall("p");
+        return mShape->SceneFunctionsDefinitions() + DIST_FUNCTION_PROTOTYPE(DistFunctionName(), vec3 p) + "\n{\n"
+            "    if (" + Name() + "Enabled == 0) {\n"
+            "        return " + exact + ";\n"
+            "    }\n"
+            "    vec3 outside = max(" + Name() + "Min - p, p - " + Name() + "Max);\n"
+            "    if (any(greaterThan(outside, vec3(0.0)))) {\n"
+            "        return length(max(max(" + Name() + "ShapeMin - p, p - " + Name() + "ShapeMax), 0.0));\n"
+            "    }\n"
+            "    vec3 samples = vec3(textureSize(" + Name() + ", 0));\n"
+            "    vec3 uvw = ((p - " + Name() + "Min) / (" + Name() + "Max - " + Name() + "Min) * (samples - 1.0) + 0.5) / samples;\n"
+            "    float dist = texture(" + Name() + ", uvw).r;\n"
+            "    if (dist < " + Name() + "Fallback) {\n"
+            "        return " + exact + ";\n"
+            "    }\n"
+            "    return dist - " + Name() + "Fallback * " + std::to_string(1.0f / sFallbackVoxels) + ";\n"
+            "}\n";
+    }
+
+    virtual std::string DistFunctionCall(const std::string& fixedParam) const override
+    {
+        return DistFunctionName() + '(' + fixedParam + ')';
+    }
+
+    virtual float Distance(const Math::Vec3& p, const DistanceContext& context) const override
+    {
+        return mShape->Distance(p, context);
+    }
+
+    virtual Math::Interval DistanceRange(const Math::AABB& box, const DistanceContext& context) const override
+    {
+        return mShape->DistanceRange(box, context);
+    }
+
+    virtual std::optional<Math::AABB> Bounds() const override
+    {
+        return mShape->Bounds();
+    }
+
+    virtual bool IsAnimated() const override
+    {
+        return mShape->IsAnimated();
+    }
+
+    const std::string& Name() const
+    {
+        return mName;
+    }
+private:
+    /*
+        Bounds are padded by the fallback distance and one more voxel, so the
+        volume edge is always sampled; voxel size accounts for that padding
+    */
+    float VoxelSize(const Math::AABB& bounds) const
+    {
+        Math::Vec3 size = bounds.Size();
+        return std::max({ size.x(), size.y(), size.z() }) / (mResolution - 1 - 2.0f * sPaddingVoxels);
+    }
+
+    SdfBaker::Volume Bake(const Math::AABB& bounds, const DistanceContext& context) const
+    {
+        return SdfBaker::Bake(*mShape, bounds.Expand(sPaddingVoxels * VoxelSize(bounds)), mResolution, context);
+    }
+
+    std::string DistFunctionName() const
+    {
+        return mName + "Dist";
+    }
+private:
+    // Exact evaluation below this many voxel diagonals, trilinear error is at most one
+    static constexpr float sFallbackVoxels = 2.0f;
+    static constexpr float sSqrt3 = 1.73205081f;
+    static constexpr float sPaddingVoxels = sFallbackVoxels * sSqrt3 + 1.0f;
+    // Padding takes about 10 samples of the resolution
+    static constexpr unsigned int sMinResolution = 16;
+
+    std::shared_ptr<IShapedObject> mShape;
+    const std::string mName;
+    const unsigned int mTextureSlot;
+    const unsigned int mResolution;
+
+    OpenGL::Texture3D mTexture;
+    Math::AABB mVolumeBounds;
+    Math::AABB mBakedShapeBounds;
+    float mBakedSmoothMin = 0.0f;
+    float mFallbackDistance = 0.0f;
+    std::chrono::duration<double, std::milli> mBakeTime = std::chrono::duration<double, std::milli>(0.0);
+    bool mVolumeEnabled = true;
+    bool mRebakeRequested = false;
+    bool mBakeFailed = false;
+
+    // Left by PrepareBake for the next UpdateBake
+    std::optional<SdfBaker::Volume> mPrepared;
+    Math::AABB mPreparedShapeBounds;
+    float mPreparedSmoothMin = 0.0f;
+    std::chrono::duration<double, std::milli> mPreparedTime = std::chrono::duration<double, std::milli>(0.0);
+};
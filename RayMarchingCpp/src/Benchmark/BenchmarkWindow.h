@@ -0,0 +1,1640 @@
+#pragma once
+
+#include "RayMarchingWindow/RayMarchingWindow.h"
+#include "ImageMetrics.h"
+#include "PlaneShape.h"
+#include "SphereShape.h"
+#include "InstancedShapeSet.h"
+#include "VaseShape.h"
+#include "CubeShape.h"
+#include "SinSphere.h"
+#include "CompiledShapeWrapper.h"
+#include "StaticShapeWrapper.h"
+#include "CroppedShapeWrapper.h"
+#include "IntersectedShapeWrapper.h"
+#include "InterpolatedShapeWrapper.h"
+#include "RepeatedSpaceWrapper.h"
+#include "RayMarchingWindow/SdfBaker.h"
+#include "RayMarchingWindow/BrickMap.h"
+#include "RayMarchingWindow/SdfOctree.h"
+#include "RayMarchingWindow/SceneQuery.h"
+#include "RayMarchingWindow/CpuRenderer.h"
+#include "RayMarchingWindow/ImageWriter.h"
+#include "RayMarchingWindow/FrameStreamer.h"
+#include "RayMarchingWindow/SceneFile.h"
+#include "RayMarchingWindow/RenderServer.h"
+#include "RayMarchingWindow/TileCoordinator.h"
+#include "OpenGL/PixelReadback.h"
+#include "UnitedShapeWrapper.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <stb_image.h>
+
+/*
+    Runs the regression and benchmark suite over registered scene instead of
+    the interactive loop. Results are printed to stdout, Failed() reports
+    whether any quality check went below its threshold
+*/
+class BenchmarkWindow : public RayMarchingWindow {
+    using RayMarchingWindow::RayMarchingWindow;
+public:
+    bool Failed() const
+    {
+        return mFailed;
+    }
+protected:
+    virtual bool OnUpdate(FrameDuration elapsedTime) override
+    {
+        (void)elapsedTime;
+
+        BenchmarkStartup();
+        CompareReducedRendering();
+        BenchmarkProgressive();
+        BenchmarkAntialiasing();
+        BenchmarkQualityTiers();
+        BenchmarkObjectScaling();
+        BenchmarkAnalyticHits();
+        BenchmarkBakedVolumes();
+        BenchmarkBrickMaps();
+        BenchmarkOctree();
+        BenchmarkMeshExport();
+        BenchmarkSharpFeatures();
+        BenchmarkDistanceQueries();
+        BenchmarkSceneCompiler();
+        BenchmarkStaticScene();
+        CheckShapeCode();
+        BenchmarkFrameSequence();
+        BenchmarkReadback();
+        BenchmarkFrameStreaming();
+        BenchmarkSceneFile();
+        BenchmarkTileCoordinator();
+        // Last, it leaves the window with a served scene
+        BenchmarkRenderServer();
+
+        return false;
+    }
+
+    virtual void OnImGuiUpdate() override
+    {
+    }
+private:
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    void ResetCamera()
+    {
+        mCameraPos = { 0.0f, 1.0f, 0.0f, 1.0f };
+        mCameraRotationY = 0.0f;
+    }
+
+    /*
+        Renders the same animated fly-through in every RenderMode and compares
+        reconstructed frames with a full rate march of the same frame
+    */
+    void CompareReducedRendering()
+    {
+        std::cout << "[Benchmark] Reduced rendering vs full rate, " << sFrameCount << " frames at "
+            << mWidth << 'x' << mHeight << '\n';
+
+        OpenGL::FrameBuffer reference(mWidth, mHeight);
+        std::vector<unsigned char> referencePixels;
+        std::vector<unsigned char> pixels;
+
+        const std::pair<RenderMode, const char*> modes[] = {
+            { RenderMode::Full, "Full" },
+            { RenderMode::Checkerboard, "Checkerboard" },
+            { RenderMode::Interleaved, "Interleaved 2x2" },
+        };
+
+        for (const auto& [mode, name] : modes) {
+            SetRenderMode(mode);
+            ResetCamera();
+
+            Milliseconds frameTime(0.0);
+            double psnrSum = 0.0;
+            double psnrMin = std::numeric_limits<double>::infinity();
+
+            for (unsigned int frame = 0; frame < sFrameCount; frame++) {
+                float time = frame * sFrameStep;
+                mCameraPos.z() += sCameraSpeed * sFrameStep;
+                mCameraRotationY += sCameraRotationSpeed * sFrameStep;
+
+                GLCall(glFinish());
+                std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+                DrawFrame(time);
+                GLCall(glFinish());
+                frameTime += std::chrono::steady_clock::now() - t0;
+
+                if (mode == RenderMode::Full) {
+                    continue;
+                }
+
+                MarchScene(reference, RenderMode::Full, time);
+                reference.ReadPixels(referencePixels);
+                mHistoryBuffers[mHistoryIndex].ReadPixels(pixels);
+
+                double psnr = Benchmark::PeakSignalToNoiseRatio(referencePixels, pixels);
+                psnrSum += std::min(psnr, sPSNRCap);
+                psnrMin = std::min(psnrMin, psnr);
+            }
+
+            std::cout << "  " << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(3)
+                << std::setw(9) << frameTime.count() / sFrameCount << " ms/frame";
+
+            if (mode != RenderMode::Full) {
+                double psnrMean = psnrSum / sFrameCount;
+                bool passed = psnrMean >= sMinMeanPSNR;
+                mFailed = mFailed || !passed;
+                std::cout << std::setprecision(2) << "  PSNR mean " << psnrMean << " dB, min " << psnrMin << " dB"
+                    << (passed ? "" : "  [FAILED]");
+            }
+            std::cout << '\n';
+        }
+
+        reference.Delete();
+        SetRenderMode(RenderMode::Full);
+    }
+
+    /*
+        Renders a frame coarse to fine and compares it with one full
+        resolution pass, both read back: time to the first preview, to the
+        whole frame and how close it is. A render stopped after its first
+        level must not render the finer ones
+    */
+    void BenchmarkProgressive()
+    {
+        std::cout << "[Benchmark] Progressive rendering vs one full resolution pass at " << mWidth << 'x' << mHeight << '\n';
+        ResetCamera();
+        SetRenderMode(RenderMode::Full);
+        auto proceed = [](unsigned int, const unsigned char*) { return true; };
+        auto stop = [](unsigned int, const unsigned char*) { return false; };
+
+        // Drivers may compile variants of a program for the targets and textures bound at a draw, each goes once untimed
+        std::vector<unsigned char> reference;
+        RenderProgressive(0.0f, mQualityTierIndex, proceed);
+        MarchScene(mHistoryBuffers[mHistoryIndex], RenderMode::Full, 0.0f);
+        mHistoryBuffers[mHistoryIndex].ReadPixels(reference);
+        GLCall(glFinish());
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        MarchScene(mHistoryBuffers[mHistoryIndex], RenderMode::Full, 0.0f);
+        mHistoryBuffers[mHistoryIndex].ReadPixels(reference);
+        Milliseconds fullTime = std::chrono::steady_clock::now() - t0;
+
+        std::vector<unsigned char> pixels;
+        std::optional<ProgressiveStats> stats = RenderProgressive(0.0f, mQualityTierIndex, [&](unsigned int, const unsigned char* levelPixels) {
+            pixels.assign(levelPixels, levelPixels + reference.size());
+            return true;
+        });
+        std::optional<ProgressiveStats> stopped = RenderProgressive(0.0f, mQualityTierIndex, stop);
+        if (!stats || !stopped) {
+            mFailed = true;
+            std::cout << "  scene doesn't build  [FAILED]\n";
+            return;
+        }
+
+        double psnr = Benchmark::PeakSignalToNoiseRatio(reference, pixels);
+        bool passed = psnr >= sMinProgressivePSNR && stopped->Interrupted && stopped->Steps.size() == 1;
+        mFailed = mFailed || !passed;
+        std::cout << std::fixed << std::setprecision(1) << "  full pass     " << std::setw(8) << fullTime.count() << " ms\n"
+            << "  progressive  ";
+        for (size_t i = 0; i < stats->Steps.size(); i++) {
+            std::cout << " 1/" << stats->Steps[i] << " at " << stats->LevelMilliseconds[i] << " ms,";
+        }
+        std::cout << " first preview after " << std::setprecision(0) << 100.0 * stats->LevelMilliseconds.front() / fullTime.count()
+            << "% of the full pass, total " << 100.0 * stats->Milliseconds / fullTime.count() << "%, PSNR " << std::setprecision(2)
+            << psnr << " dB\n  stopped after the first level in " << std::setprecision(1) << stopped->Milliseconds << " ms"
+            << (passed ? "" : "  [FAILED]") << '\n' << std::defaultfloat;
+    }
+
+    /*
+        Antialiases one frame adaptively, also with a cap below its edge
+        pixels, and by uniform 4x supersampling: rays marched, time and how
+        close each frame and the one without antialiasing are to the uniform
+        one. Adaptive must get closer than no antialiasing for fewer rays,
+        and the capped one must stay within its cap
+    */
+    void BenchmarkAntialiasing()
+    {
+        std::cout << "[Benchmark] Adaptive antialiasing vs uniform 4x supersampling at " << mWidth << 'x' << mHeight << '\n';
+        ResetCamera();
+        SetRenderMode(RenderMode::Full);
+        uint64_t pixelCount = static_cast<uint64_t>(mWidth) * mHeight;
+
+        AntialiasSettings off;
+        AntialiasSettings adaptive;
+        adaptive.Mode = Antialiasing::Adaptive;
+        AntialiasSettings capped = adaptive;
+        capped.MaxExtraRays = static_cast<unsigned int>(pixelCount / sCappedAntialiasFraction);
+        AntialiasSettings uniform;
+        uniform.Mode = Antialiasing::Uniform;
+        const std::pair<AntialiasSettings, const char*> runs[] = {
+            { uniform, "uniform 4x" },
+            { off, "off" },
+            { adaptive, "adaptive" },
+            { capped, "adaptive capped" },
+        };
+
+        // Drivers may compile variants of a program for the targets and textures bound at a draw, each goes once untimed
+        for (const auto& [settings, name] : runs) {
+            SetAntialiasing(settings);
+            DrawFrame(0.0f);
+        }
+
+        std::vector<unsigned char> reference;
+        std::vector<unsigned char> pixels;
+        double offPSNR = 0.0;
+        double adaptivePSNR = 0.0;
+        uint64_t adaptiveRays = 0;
+        bool passed = true;
+        for (const auto& [settings, name] : runs) {
+            SetAntialiasing(settings);
+            GLCall(glFinish());
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            DrawFrame(0.0f);
+            mHistoryBuffers[mHistoryIndex].ReadPixels(settings.Mode == Antialiasing::Uniform ? reference : pixels);
+            Milliseconds frameTime = std::chrono::steady_clock::now() - t0;
+
+            AntialiasStats stats = LastAntialiasStats();
+            if (settings.Mode == Antialiasing::Off) {
+                stats.Rays = pixelCount;
+            }
+            std::cout << "  " << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(1)
+                << std::setw(8) << frameTime.count() << " ms, " << std::setprecision(2) << std::setw(5)
+                << static_cast<double>(stats.Rays) / pixelCount << " rays/pixel";
+            if (settings.Mode == Antialiasing::Adaptive) {
+                std::cout << ", " << stats.SupersampledPixels << " of " << stats.EdgePixels << " edge pixels supersampled";
+            }
+            if (settings.Mode != Antialiasing::Uniform) {
+                double psnr = Benchmark::PeakSignalToNoiseRatio(reference, pixels);
+                std::cout << ", PSNR " << psnr << " dB";
+                if (settings.Mode == Antialiasing::Off) {
+                    offPSNR = psnr;
+                } else if (settings.MaxExtraRays == adaptive.MaxExtraRays) {
+                    adaptivePSNR = psnr;
+                    adaptiveRays = stats.Rays;
+                } else {
+                    passed = passed && stats.Rays <= pixelCount + settings.MaxExtraRays && stats.SupersampledPixels < stats.EdgePixels;
+                }
+            }
+            std::cout << '\n' << std::defaultfloat;
+        }
+        passed = passed && adaptivePSNR >= offPSNR + sMinAntialiasGain && adaptiveRays < pixelCount * sSupersampleRays;
+        mFailed = mFailed || !passed;
+        std::cout << (passed ? "" : "  [FAILED]\n");
+        SetAntialiasing(off);
+    }
+
+    /*
+        Measures cold (compile and link) and cached switch to every quality
+        tier permutation and its frame time on a fixed camera
+    */
+    void BenchmarkQualityTiers()
+    {
+        std::cout << "[Benchmark] Quality tiers, " << sFrameCount << " frames at " << mWidth << 'x' << mHeight << '\n';
+
+        unsigned int previousTier = mQualityTierIndex;
+        bool previousShadows = mEnableShadows;
+        SetRenderMode(RenderMode::Full);
+
+        for (unsigned int i = 0; i < QualityTier::Tiers().size(); i++) {
+            for (bool shadows : { false, true }) {
+                const QualityTier& tier = QualityTier::Tiers()[i];
+
+                mProgramCache.Clear();
+                std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+                UseQualityTier(i, shadows);
+                // Drivers may defer compilation until the first draw
+                DrawFrame(0.0f);
+                GLCall(glFinish());
+                Milliseconds coldSwitch = std::chrono::steady_clock::now() - t0;
+
+                UseQualityTier((i + 1) % QualityTier::Tiers().size(), tier.Shadows);
+                t0 = std::chrono::steady_clock::now();
+                UseQualityTier(i, shadows);
+                Milliseconds cachedSwitch = std::chrono::steady_clock::now() - t0;
+
+                ResetCamera();
+                Milliseconds frameTime(0.0);
+                for (unsigned int frame = 0; frame < sFrameCount; frame++) {
+                    GLCall(glFinish());
+                    t0 = std::chrono::steady_clock::now();
+                    DrawFrame(frame * sFrameStep);
+                    GLCall(glFinish());
+                    frameTime += std::chrono::steady_clock::now() - t0;
+                }
+
+                std::cout << "  " << std::left << std::setw(20) << tier.PermutationKey(shadows) << std::right << std::fixed
+                    << std::setprecision(3) << std::setw(9) << frameTime.count() / sFrameCount << " ms/frame"
+                    << "  cold switch " << coldSwitch.count() << " ms, cached switch " << cachedSwitch.count() << " ms\n";
+            }
+        }
+
+        UseQualityTier(previousTier, previousShadows);
+    }
+
+    /*
+        count spheres scattered in front of the camera at the same density for
+        every count
+    */
+    static std::vector<InstancedShapeSet::Instance> ScatteredSpheres(unsigned int count)
+    {
+        std::mt19937 random(count);
+        float side = std::sqrt(static_cast<float>(count)) * sSphereSpacing;
+        std::uniform_real_distribution<float> x(-side * 0.5f, side * 0.5f);
+        std::uniform_real_distribution<float> y(0.5f, 2.5f);
+        std::uniform_real_distribution<float> z(2.0f, 2.0f + side);
+        std::uniform_real_distribution<float> radius(0.2f, 0.6f);
+
+        std::vector<InstancedShapeSet::Instance> spheres(count);
+        for (InstancedShapeSet::Instance& sphere : spheres) {
+            sphere.Position = Math::Vec3(x(random), y(random), z(random));
+            sphere.Size = Math::Vec3(radius(random));
+        }
+        return spheres;
+    }
+
+    Milliseconds MeasureFrameTime(unsigned int frameCount)
+    {
+        ResetCamera();
+        mCameraPos.y() = 1.5f;
+
+        Milliseconds frameTime(0.0);
+        for (unsigned int frame = 0; frame < frameCount; frame++) {
+            GLCall(glFinish());
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            DrawFrame(frame * sFrameStep);
+            GLCall(glFinish());
+            frameTime += std::chrono::steady_clock::now() - t0;
+        }
+        return frameTime / frameCount;
+    }
+
+    /*
+        Frame time of scenes from 10 to 10000 spheres evaluated linearly and
+        through the object grid, declared either as one SphereShape uniform
+        each or as a single InstancedShapeSet. Uniform counts above the
+        fragment uniform limit can't be compiled and are skipped
+    */
+    void BenchmarkObjectScaling()
+    {
+        std::cout << "[Benchmark] Object scaling, " << sScalingFrameCount << " frames at " << mWidth << 'x' << mHeight << '\n';
+
+        GLint maxUniformVectors = 0;
+        GLCall(glGetIntegerv(GL_MAX_FRAGMENT_UNIFORM_VECTORS, &maxUniformVectors));
+
+        std::vector<std::shared_ptr<IShapedObject>> sceneShapes = mShapes;
+        size_t gridThreshold = mRegistrar.GridThreshold();
+        SetRenderMode(RenderMode::Full);
+
+        auto plane = std::make_shared<PlaneShape>(0.0f, "u_PlaneObj");
+        auto instanced = std::make_shared<InstancedShapeSet>(InstancedShapeSet::Primitive::Sphere, "u_SphereSet", sFirstObjectTextureSlot);
+
+        for (unsigned int count : { 10u, 100u, 1000u, 10000u }) {
+            std::vector<InstancedShapeSet::Instance> spheres = ScatteredSpheres(count);
+
+            std::vector<std::shared_ptr<IShapedObject>> uniformShapes = { plane };
+            for (unsigned int i = 0; i < count; i++) {
+                const InstancedShapeSet::Instance& sphere = spheres[i];
+                uniformShapes.push_back(std::make_shared<SphereShape>(Math::Vec4(sphere.Position, sphere.Size.x()),
+                    "u_Sphere" + std::to_string(i)));
+            }
+            instanced->SetInstances(spheres);
+
+            const std::tuple<const char*, std::vector<std::shared_ptr<IShapedObject>>, unsigned int> scenes[] = {
+                { "uniforms ", uniformShapes, count },
+                { "instanced", { plane, instanced }, 1 },
+            };
+
+            for (const auto& [name, shapes, uniformVectors] : scenes) {
+                std::cout << "  " << std::setw(6) << count << " objects, " << name;
+                if (static_cast<int>(uniformVectors + sReservedUniformVectors) > maxUniformVectors) {
+                    std::cout << "  skipped, exceeds " << maxUniformVectors << " fragment uniform vectors\n";
+                    continue;
+                }
+
+                mShapes = shapes;
+                for (bool useGrid : { false, true }) {
+                    mRegistrar.SetGridThreshold(useGrid ? 1 : std::numeric_limits<size_t>::max());
+
+                    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+                    bool built = BuildScene();
+                    Milliseconds buildTime = std::chrono::steady_clock::now() - t0;
+
+                    std::cout << (useGrid ? "  grid " : "  linear ") << std::fixed << std::setprecision(3);
+                    if (built) {
+                        std::cout << MeasureFrameTime(sScalingFrameCount).count() << " ms/frame (build " << buildTime.count() << " ms)";
+                    } else {
+                        std::cout << "build failed";
+                    }
+                }
+                std::cout << '\n';
+            }
+        }
+
+        // Instances change without touching the program: only buffers and the grid are updated
+        mShapes = { plane, instanced };
+        mRegistrar.SetGridThreshold(0);
+        instanced->SetInstances({});
+        BuildScene();
+        DrawFrame(0.0f);
+        std::vector<InstancedShapeSet::Instance> spheres = ScatteredSpheres(10000);
+        GLCall(glFinish());
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        instanced->SetInstances(spheres);
+        DrawFrame(0.0f);
+        GLCall(glFinish());
+        Milliseconds updateTime = std::chrono::steady_clock::now() - t0;
+        std::cout << "  Adding 10000 instances: " << std::fixed << std::setprecision(3) << updateTime.count()
+            << " ms including first frame, no shader rebuild\n";
+
+        mShapes = sceneShapes;
+        mRegistrar.SetGridThreshold(gridThreshold);
+        BuildScene();
+    }
+
+    /*
+        Steps marched and frame time of the registered scene and of one of
+        spheres and cubes on the waved plane, with hard unions, intersecting
+        analytic objects and marching them. Frames must look alike and take
+        fewer steps
+    */
+    void BenchmarkAnalyticHits()
+    {
+        std::cout << "[Benchmark] Analytic ray hits vs marching every object, " << sAnalyticFrameCount << " frames at "
+            << mWidth << 'x' << mHeight << '\n';
+
+        std::vector<std::shared_ptr<IShapedObject>> sceneShapes = mShapes;
+        float smoothMin = mSmoothMin;
+        SetRenderMode(RenderMode::Full);
+        SetSmoothMin(0.0f);
+
+        std::vector<std::shared_ptr<IShapedObject>> primitives = { std::make_shared<PlaneShape>(0.0f, "u_PlaneObj") };
+        std::vector<std::shared_ptr<IShapedObject>> pair;
+        for (unsigned int i = 0; i < sAnalyticPrimitiveCount; i++) {
+            Math::Vec4 coords(-4.0f + 2.0f * i, 1.0f + 0.25f * (i % 3), 5.0f + 1.5f * (i % 4), 0.6f);
+            std::string name = "u_AnalyticShape" + std::to_string(i);
+            std::shared_ptr<IShapedObject> shape = (i % 2 == 0) ? std::shared_ptr<IShapedObject>(std::make_shared<SphereShape>(coords, name))
+                : std::make_shared<CubeShape>(coords, name);
+            // The last two as one hard union subtree
+            (i + 2 < sAnalyticPrimitiveCount ? primitives : pair).push_back(shape);
+        }
+        primitives.push_back(std::make_shared<UnitedShapeWrapper>(pair));
+
+        const std::pair<const char*, std::vector<std::shared_ptr<IShapedObject>>> scenes[] = {
+            { "scene", sceneShapes },
+            { "primitives", primitives },
+        };
+        std::vector<unsigned char> marchedPixels;
+        std::vector<unsigned char> pixels;
+        for (const auto& [name, shapes] : scenes) {
+            mShapes = shapes;
+            if (!BuildScene()) {
+                mFailed = true;
+                std::cout << "  " << name << " doesn't build  [FAILED]\n";
+                continue;
+            }
+
+            uint64_t steps[2] = {};
+            Milliseconds frameTime[2];
+            for (bool analytic : { false, true }) {
+                SetAnalyticHits(analytic);
+                // Drivers may compile variants of a program for the targets bound at a draw, the first frames go untimed
+                DrawFrame(0.0f);
+                CountMarchSteps(0.0f);
+                frameTime[analytic] = MeasureFrameTime(sAnalyticFrameCount);
+                steps[analytic] = CountMarchSteps(0.0f);
+                MarchScene(mHistoryBuffers[mHistoryIndex], RenderMode::Full, 0.0f);
+                mHistoryBuffers[mHistoryIndex].ReadPixels(analytic ? pixels : marchedPixels);
+            }
+
+            double pixelCount = static_cast<double>(mWidth) * mHeight;
+            double psnr = Benchmark::PeakSignalToNoiseRatio(marchedPixels, pixels);
+            bool passed = psnr >= sMinAnalyticPSNR && steps[1] <= steps[0];
+            mFailed = mFailed || !passed;
+            std::cout << "  " << std::left << std::setw(11) << name << std::right << std::fixed << std::setprecision(1)
+                << mRegistrar.AnalyticCount() << " analytic objects, steps/pixel " << steps[0] / pixelCount << " -> " << steps[1] / pixelCount
+                << " (" << std::setprecision(0) << 100.0 * (1.0 - static_cast<double>(steps[1]) / std::max<uint64_t>(steps[0], 1))
+                << "% saved), " << std::setprecision(3) << frameTime[0].count() << " -> " << frameTime[1].count() << " ms/frame, PSNR "
+                << std::setprecision(2) << std::min(psnr, sPSNRCap) << " dB" << (passed ? "" : "  [FAILED]") << '\n' << std::defaultfloat;
+        }
+
+        SetAnalyticHits(true);
+        SetSmoothMin(smoothMin);
+        mShapes = sceneShapes;
+        BuildScene();
+    }
+
+    /*
+        Bake time, memory and frame time of every baked object with its volume
+        enabled and with the object evaluated directly
+    */
+    void BenchmarkBakedVolumes()
+    {
+        std::cout << "[Benchmark] Baked volumes, " << sFrameCount << " frames at " << mWidth << 'x' << mHeight << '\n';
+        SetRenderMode(RenderMode::Full);
+
+        for (unsigned int i = 0; i < mBakedObjects.size(); i++) {
+            const std::shared_ptr<IBakedObject>& object = mBakedObjects[i];
+            bool wasEnabled = object->VolumeEnabled();
+
+            object->SetVolumeEnabled(false);
+            Milliseconds exactTime = MeasureFrameTime(sFrameCount);
+            object->SetVolumeEnabled(true);
+            Milliseconds bakedTime = MeasureFrameTime(sFrameCount);
+            object->SetVolumeEnabled(wasEnabled);
+
+            std::cout << "  object " << i << std::fixed << std::setprecision(3) << ": baked in " << object->BakeMilliseconds()
+                << " ms, " << object->VolumeSizeInBytes() / 1024.0 << " KB, " << exactTime.count() << " ms/frame exact, "
+                << bakedTime.count() << " ms/frame baked\n";
+        }
+    }
+
+    /*
+        Dense volume and brick maps of a vase at growing resolutions: bake
+        time, size and time to map the cache file back and validate it.
+        A cache with a cell pointing past its bricks has to be rejected
+    */
+    void BenchmarkBrickMaps()
+    {
+        std::cout << "[Benchmark] Dense volumes vs brick maps of a vase\n";
+
+        VaseShape vase(Math::Vec4(0.0f, 0.0f, 0.0f, 1.0f), "u_BenchmarkVase");
+        DistanceContext context = { mSmoothMin, 0.0f, mNoiseTexture.get() };
+        Math::AABB bounds = *vase.Bounds();
+        Math::Vec3 size = bounds.Size();
+        const std::string path = "cache/benchmark.bricks";
+
+        for (unsigned int resolution : { 64u, 128u, 256u }) {
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            SdfBaker::Volume dense = SdfBaker::Bake(vase, bounds, resolution, context);
+            Milliseconds denseTime = std::chrono::steady_clock::now() - t0;
+
+            // Dense volumes are uploaded as half floats
+            std::cout << "  " << std::setw(3) << resolution << " samples, dense " << std::fixed << std::setprecision(1)
+                << dense.Distances.size() * 2 / 1024.0 << " KB in " << denseTime.count() << " ms";
+
+            float voxelSize = std::max({ size.x(), size.y(), size.z() }) / (resolution - 1);
+            for (unsigned int bits : { 8u, 16u }) {
+                t0 = std::chrono::steady_clock::now();
+                uint64_t fingerprint = BrickMap::Fingerprint(vase, bounds, context);
+                BrickMap map = BrickMap::Bake(vase, bounds, voxelSize, sBrickMapBandVoxels * std::sqrt(3.0f) * voxelSize, bits, fingerprint, context);
+                Milliseconds bakeTime = std::chrono::steady_clock::now() - t0;
+                map.Save(path);
+
+                t0 = std::chrono::steady_clock::now();
+                std::optional<BrickMap> loaded = BrickMap::Load(path);
+                bool valid = loaded && loaded->GetHeader().Fingerprint == BrickMap::Fingerprint(vase, bounds, context);
+                Milliseconds loadTime = std::chrono::steady_clock::now() - t0;
+
+                std::cout << ", " << bits << " bit " << map.GetHeader().BrickCount << " bricks " << map.SizeInBytes() / 1024.0
+                    << " KB in " << bakeTime.count() << " ms, " << (valid ? "loaded in " : "load failed in ") << loadTime.count() << " ms";
+            }
+            std::cout << '\n';
+        }
+
+        // A cell pointing past the bricks has to be rejected like a truncated file
+        bool rejected = false;
+        if (std::optional<BrickMap> saved = BrickMap::Load(path)) {
+            BrickMap::Header header = saved->GetHeader();
+            saved.reset();
+            std::ifstream file(path, std::ios::binary);
+            std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            file.close();
+
+            uint64_t cellCount = static_cast<uint64_t>(header.Cells[0]) * header.Cells[1] * header.Cells[2];
+            BrickMap::Cell* cells = reinterpret_cast<BrickMap::Cell*>(bytes.data() + header.CellsOffset);
+            BrickMap::Cell* cell = std::find_if(cells, cells + cellCount, [](const BrickMap::Cell& c) { return c.Brick != BrickMap::sEmptyBrick; });
+            if (cell != cells + cellCount) {
+                cell->Brick = header.BrickCount;
+            }
+            std::ofstream(path, std::ios::binary | std::ios::trunc).write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+            rejected = !BrickMap::Load(path);
+        }
+        std::cout << "  cell with a brick index past the file " << (rejected ? "rejected" : "loaded  [FAILED]") << '\n';
+        mFailed = mFailed || !rejected;
+
+        std::error_code error;
+        std::filesystem::remove(path, error);
+    }
+
+    /*
+        Octree of the scene at growing depths: build time, size against a
+        dense grid of the same resolution, point queries and a CPU ray
+        marched image compared with the analytic scene distance
+    */
+    void BenchmarkOctree()
+    {
+        std::cout << "[Benchmark] Scene octree over a " << sOctreeSceneSize << " units cube\n";
+
+        UnitedShapeWrapper scene(mShapes);
+        DistanceContext context = { mSmoothMin, 0.0f, mNoiseTexture.get() };
+        Math::Vec3 center(0.0f, sOctreeSceneSize * 0.5f - 4.0f, 6.0f);
+        Math::AABB bounds(center - sOctreeSceneSize * 0.5f, center + sOctreeSceneSize * 0.5f);
+        auto sceneDistance = [&](const Math::Vec3& p) { return scene.Distance(p, context); };
+
+        std::vector<Math::Vec3> points(sOctreeQueryCount);
+        std::mt19937 random(0);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        for (Math::Vec3& point : points) {
+            point = bounds.Min() + Math::Vec3(unit(random), unit(random), unit(random)) * sOctreeSceneSize;
+        }
+
+        std::vector<float> referenceDepths;
+        Milliseconds sceneQueryTime = MeasureQueries(points, sceneDistance);
+        Milliseconds sceneMarchTime = MarchCpuImage(sceneDistance, bounds, referenceDepths);
+        std::cout << "  analytic scene: " << std::fixed << std::setprecision(1) << sceneQueryTime.count() << " ms for "
+            << sOctreeQueryCount << " queries, image marched in " << sceneMarchTime.count() << " ms\n";
+
+        for (unsigned int depth : { 6u, 7u, 8u }) {
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            SdfOctree octree = SdfOctree::Build(scene, bounds, depth, context);
+            Milliseconds buildTime = std::chrono::steady_clock::now() - t0;
+            auto octreeDistance = [&](const Math::Vec3& p) { return octree.Distance(p); };
+
+            std::vector<float> depths;
+            Milliseconds queryTime = MeasureQueries(points, octreeDistance);
+            Milliseconds marchTime = MarchCpuImage(octreeDistance, bounds, depths);
+
+            unsigned int mismatches = 0;
+            for (size_t i = 0; i < depths.size(); i++) {
+                mismatches += std::abs(depths[i] - referenceDepths[i]) > sOctreeSceneSize / (1u << depth) ? 1 : 0;
+            }
+
+            size_t denseSize = static_cast<size_t>((1u << depth) + 1) * ((1u << depth) + 1) * ((1u << depth) + 1) * sizeof(float);
+            std::cout << "  depth " << depth << ": built in " << buildTime.count() << " ms, " << octree.LeafCount() << " leaves, "
+                << octree.SizeInBytes() / 1024.0 << " KB (dense " << denseSize / 1024.0 << " KB), " << queryTime.count()
+                << " ms for queries, image marched in " << marchTime.count() << " ms, "
+                << mismatches * 100.0 / depths.size() << "% pixels off by more than a leaf\n";
+        }
+    }
+
+    /*
+        Scene mesh export at growing resolutions: time, triangles, share of
+        blocks sampled and file size
+    */
+    void BenchmarkMeshExport()
+    {
+        std::cout << "[Benchmark] Scene mesh export over a " << sMeshExportSize << " units cube\n";
+
+        const std::string path = "export/benchmark.ply";
+        for (unsigned int resolution : { 128u, 256u, 512u, 1024u }) {
+            std::optional<MeshExporter::Stats> stats = ExportMesh(path, resolution);
+            if (!stats) {
+                std::cout << "  couldn't write " << path << '\n';
+                mFailed = true;
+                return;
+            }
+
+            std::error_code error;
+            std::cout << "  " << std::setw(4) << resolution << " cells, " << std::fixed << std::setprecision(1) << stats->Milliseconds
+                << " ms, " << stats->TriangleCount << " triangles, " << stats->SampledBlocks * 100.0 / stats->TotalBlocks
+                << "% blocks sampled, " << std::filesystem::file_size(path, error) / (1024.0 * 1024.0) << " MB\n";
+        }
+
+        std::error_code error;
+        std::filesystem::remove(path, error);
+    }
+
+    /*
+        Marching cubes against dual contouring of a cube and a vase: time,
+        triangles and how far triangle centers are from the surface, which
+        is where cut off edges show
+    */
+    void BenchmarkSharpFeatures()
+    {
+        std::cout << "[Benchmark] Marching cubes vs dual contouring, triangle center distance rms/max\n";
+
+        DistanceContext context = { mSmoothMin, 0.0f, mNoiseTexture.get() };
+        CubeShape cube(Math::Vec4(0.0f, 0.0f, 0.0f, 0.75f), "u_BenchmarkCube");
+        VaseShape vase(Math::Vec4(0.0f, 0.0f, 0.0f, 1.0f), "u_BenchmarkVase");
+        std::pair<const char*, const IShapedObject*> shapes[] = { { "cube", &cube }, { "vase", &vase } };
+
+        for (const auto& [name, shape] : shapes) {
+            // Cubic bounds with a margin, so both methods get cubic cells of the same size
+            Math::AABB shapeBounds = *shape->Bounds();
+            Math::Vec3 size = shapeBounds.Size();
+            Math::Vec3 halfSize(std::max(size.x(), std::max(size.y(), size.z())) * 0.55f);
+            Math::AABB bounds(shapeBounds.Center() - halfSize, shapeBounds.Center() + halfSize);
+
+            for (unsigned int depth : { 4u, 5u, 6u, 7u }) {
+                Mesh marched;
+                MeshExporter::Stats marchedStats = MeshExporter::Extract(*shape, bounds, 1u << depth, context, marched);
+
+                // Both contouring times include building the octree
+                std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+                SdfOctree octree = SdfOctree::Build(*shape, bounds, depth, context);
+                Milliseconds octreeTime = std::chrono::steady_clock::now() - t0;
+                DualContouring::Stats contouredStats, simplifiedStats;
+                Mesh contoured = DualContouring::Extract(*shape, octree, context, 0.0f, &contouredStats);
+                Mesh simplified = DualContouring::Extract(*shape, octree, context, halfSize.x() * 2.0f / (1u << depth) * sDualContouringError,
+                    &simplifiedStats);
+
+                std::cout << "  " << name << ' ' << std::setw(3) << (1u << depth) << " cells\n";
+                PrintMeshError("    marching cubes    ", *shape, context, marched, marchedStats.Milliseconds);
+                PrintMeshError("    dual contouring   ", *shape, context, contoured, octreeTime.count() + contouredStats.Milliseconds);
+                PrintMeshError("    simplified        ", *shape, context, simplified, octreeTime.count() + simplifiedStats.Milliseconds);
+            }
+        }
+    }
+
+    /*
+        Batched distance and normal queries against the scene and its cube
+        ring alone, compared with a Distance call per point and four per normal
+    */
+    void BenchmarkDistanceQueries()
+    {
+        std::cout << "[Benchmark] Batched distance and normal queries, " << sQueryPointTotal << " points per run\n";
+
+        UnitedShapeWrapper scene(mShapes);
+        DistanceContext context = { mSmoothMin, 0.0f, mNoiseTexture.get() };
+        Math::Vec3 center(0.0f, sOctreeSceneSize * 0.5f - 4.0f, 6.0f);
+        Math::AABB bounds(center - sOctreeSceneSize * 0.5f, center + sOctreeSceneSize * 0.5f);
+
+        std::vector<Math::Vec3> points(sQueryPointTotal);
+        std::mt19937 random(0);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        for (Math::Vec3& point : points) {
+            point = bounds.Min() + Math::Vec3(unit(random), unit(random), unit(random)) * sOctreeSceneSize;
+        }
+
+        std::vector<std::pair<const char*, const IShapedObject*>> objects = { { "scene", &scene } };
+        for (const std::shared_ptr<IShapedObject>& shape : mShapes) {
+            if (dynamic_cast<const InstancedShapeSet*>(shape.get())) {
+                objects.emplace_back("ring", shape.get());
+            }
+        }
+
+        std::vector<float> referenceDistances(points.size()), distances(points.size());
+        std::vector<Math::Vec3> referenceNormals(points.size()), normals(points.size());
+        for (const auto& [name, object] : objects) {
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < points.size(); i++) {
+                float dist = object->Distance(points[i], context);
+                Math::Vec3 normal = dist - Math::Vec3(object->Distance(points[i] - Math::Vec3(sQueryNormalOffset, 0.0f, 0.0f), context),
+                    object->Distance(points[i] - Math::Vec3(0.0f, sQueryNormalOffset, 0.0f), context),
+                    object->Distance(points[i] - Math::Vec3(0.0f, 0.0f, sQueryNormalOffset), context));
+                float length = normal.Magnitude();
+                referenceDistances[i] = dist;
+                referenceNormals[i] = length > 0.0f ? normal / length : Math::Vec3(0.0f);
+            }
+            Milliseconds pointTime = std::chrono::steady_clock::now() - t0;
+            std::cout << "  " << name << ", call per point: " << std::fixed << std::setprecision(2)
+                << points.size() / pointTime.count() / 1000.0 << " M points/s\n";
+
+            for (size_t batchSize : { size_t(64), size_t(1024), size_t(16384), sQueryPointTotal }) {
+                for (unsigned int threadCount : { 1u, 0u }) {
+                    t0 = std::chrono::steady_clock::now();
+                    for (size_t first = 0; first < points.size(); first += batchSize) {
+                        SceneQuery::QueryDistances(*object, context, points.data() + first, std::min(batchSize, points.size() - first),
+                            distances.data() + first, normals.data() + first, threadCount);
+                    }
+                    Milliseconds batchTime = std::chrono::steady_clock::now() - t0;
+
+                    float maxDistanceError = 0.0f, maxNormalError = 0.0f;
+                    for (size_t i = 0; i < points.size(); i++) {
+                        maxDistanceError = std::max(maxDistanceError, std::abs(distances[i] - referenceDistances[i]));
+                        maxNormalError = std::max(maxNormalError, (normals[i] - referenceNormals[i]).Magnitude());
+                    }
+                    std::cout << "    " << std::setw(6) << batchSize << " points per call, " << (threadCount == 1 ? "1 thread:  " : "all threads:")
+                        << std::setprecision(1) << std::setw(9) << batchTime.count() * 1000.0 * batchSize / points.size() << " us/call, "
+                        << std::setprecision(2) << std::setw(6) << points.size() / batchTime.count() / 1000.0 << " M points/s, max error "
+                        << std::scientific << std::setprecision(1) << maxDistanceError << " distance, " << maxNormalError << " normal\n"
+                        << std::fixed;
+                }
+            }
+        }
+    }
+
+    /*
+        Marches the CPU image through a scene of primitives interpreted,
+        compiled by SceneCompiler and written by hand, then cropped and
+        intersected shapes and the registered scene interpreted and compiled
+        with its fallbacks. Compiled depths have to match interpreted ones
+    */
+    void BenchmarkSceneCompiler()
+    {
+        std::cout << "[Benchmark] Scene compiled to native code, CPU image of " << sCpuImageWidth << " pixels wide\n";
+
+        DistanceContext context = { mSmoothMin, 0.0f, mNoiseTexture.get() };
+        Math::Vec3 center(0.0f, sOctreeSceneSize * 0.5f - 4.0f, 6.0f);
+        Math::AABB bounds(center - sOctreeSceneSize * 0.5f, center + sOctreeSceneSize * 0.5f);
+
+        auto primitives = std::make_shared<UnitedShapeWrapper>(std::vector<std::shared_ptr<IShapedObject>>{
+            std::make_shared<PlaneShape>(0.0f, "u_CompiledPlane"),
+            std::make_shared<SphereShape>(Math::Vec4(0.0f, 1.0f, 6.0f, 1.0f), "u_CompiledSphere"),
+            std::make_shared<CubeShape>(Math::Vec4(2.5f, 1.0f, 7.0f, 0.75f), "u_CompiledCube"),
+            std::make_shared<VaseShape>(Math::Vec4(-2.5f, 1.0f, 7.0f, 1.0f), "u_CompiledVase") });
+        auto handWritten = [&context](const Math::Vec3& p) {
+            const float x = p.x(), y = p.y(), z = p.z();
+            float plane = y - std::sin(x / 10.0f);
+            float sphere = std::sqrt(x * x + (y - 1.0f) * (y - 1.0f) + (z - 6.0f) * (z - 6.0f)) - 1.0f;
+            float cube = Math::BoxDistance(x - 2.5f, y - 1.0f, z - 7.0f, 0.75f, 0.75f, 0.75f);
+            float vaseX = x + 2.5f, vaseY = y - 1.0f, vaseZ = z - 7.0f;
+            float scale = Math::Mix(1.0f, 4.0f, Math::SmoothStep(-1.0f, 1.0f, vaseY));
+            float c = std::cos(vaseY), s = std::sin(vaseY);
+            vaseX *= scale;
+            vaseZ *= scale;
+            float vase = Math::BoxDistance(vaseX * c - vaseZ * s, vaseY, vaseX * s + vaseZ * c, 1.0f, 1.0f, 1.0f) / scale;
+            float dist = Math::SmoothMin(Math::SmoothMin(plane, sphere, context.SmoothMin), cube, context.SmoothMin);
+            return Math::SmoothMin(dist, vase, context.SmoothMin);
+        };
+
+        // Cropping and intersecting pass a negative smoothing value to smooth the maximum
+        auto carved = std::make_shared<UnitedShapeWrapper>(std::vector<std::shared_ptr<IShapedObject>>{
+            std::make_shared<PlaneShape>(0.0f, "u_CarvedPlane"),
+            std::make_shared<CroppedShapeWrapper>(std::make_shared<SphereShape>(Math::Vec4(0.0f, 1.0f, 6.0f, 1.0f), "u_CarvedSphere"),
+                std::make_shared<SinSphereShape>(Math::Vec4(0.5f, 1.5f, 5.5f, 0.75f), "u_CarvedSinSphere")),
+            std::make_shared<IntersectedShapeWrapper>(std::make_shared<CubeShape>(Math::Vec4(2.5f, 1.0f, 7.0f, 0.75f), "u_CarvedCube"),
+                std::make_shared<SphereShape>(Math::Vec4(2.5f, 1.0f, 7.0f, 1.0f), "u_CarvedCubeSphere")) });
+
+        std::pair<const char*, std::shared_ptr<IShapedObject>> scenes[] = {
+            { "primitives", primitives }, { "cropped and intersected", carved },
+            { "registered scene", std::make_shared<UnitedShapeWrapper>(mShapes) } };
+        for (const auto& [name, scene] : scenes) {
+            std::string log;
+            std::optional<SceneCompiler::Program> program = SceneCompiler::Compile(*scene, &log);
+            if (!program) {
+                std::cout << "  " << name << ": compiler failed\n" << log << '\n';
+                return;
+            }
+            std::cout << "  " << name << ": " << (program->Cached ? "loaded from cache" : "compiled") << " in " << std::fixed << std::setprecision(1)
+                << program->Milliseconds << " ms, " << program->Fallbacks.size() << " objects called back\n";
+            CompiledShapeWrapper compiled(scene, std::move(*program));
+
+            std::vector<float> interpretedDepths, compiledDepths;
+            Milliseconds interpretedTime = MarchCpuImage([&](const Math::Vec3& p) { return scene->Distance(p, context); }, bounds, interpretedDepths);
+            Milliseconds compiledTime = MarchCpuImage([&](const Math::Vec3& p) { return compiled.Distance(p, context); }, bounds, compiledDepths);
+            float maxDifference = 0.0f;
+            for (size_t i = 0; i < interpretedDepths.size(); i++) {
+                maxDifference = std::max(maxDifference, std::abs(compiledDepths[i] - interpretedDepths[i]));
+            }
+            std::cout << "    interpreted " << interpretedTime.count() << " ms, compiled " << compiledTime.count() << " ms";
+            if (scene == primitives) {
+                std::vector<float> handWrittenDepths;
+                std::cout << ", hand-written " << MarchCpuImage(handWritten, bounds, handWrittenDepths).count() << " ms";
+            }
+            std::cout << ", max depth difference " << maxDifference << '\n';
+            if (maxDifference != 0.0f) {
+                std::cout << "  " << name << ": compiled depths differ from interpreted ones\n";
+                mFailed = true;
+            }
+        }
+    }
+
+    /*
+        Scene of BuildScene in Main.cpp composed from StaticScene templates
+        against the same scene built from dynamic objects, with the vase not
+        baked in both. Also checks that the interval form of the static scene
+        contains point distances of random boxes
+    */
+    void BenchmarkStaticScene()
+    {
+        std::cout << "[Benchmark] Static scene templates vs dynamic scene graph, CPU image of " << sCpuImageWidth << " pixels wide\n";
+
+        DistanceContext context = { mSmoothMin, 0.0f, mNoiseTexture.get() };
+        Math::Vec3 center(0.0f, sOctreeSceneSize * 0.5f - 4.0f, 6.0f);
+        Math::AABB bounds(center - sOctreeSceneSize * 0.5f, center + sOctreeSceneSize * 0.5f);
+
+        const float x = 0.0f, y = 1.8f, z = 6.0f;
+        using namespace StaticScene;
+        Array<Transform<Box>, sStaticRingSize> ring;
+        auto dynamicRing = std::make_shared<InstancedShapeSet>(InstancedShapeSet::Primitive::Cube, "u_StaticRing", sFirstObjectTextureSlot);
+        for (unsigned int i = 0; i < sStaticRingSize; i++) {
+            float angle = 6.2831853f * i / sStaticRingSize;
+            Math::Vec3 position(x + std::cos(angle) * 4.0f, 0.25f, z + std::sin(angle) * 4.0f);
+            ring.Elements[i] = Transform<Box>(Box(0.0f, 0.0f, 0.0f, 0.1f, 0.25f, 0.25f), position.x(), position.y(), position.z(), angle);
+            dynamicRing->AddInstance({ position, Math::Vec3(0.1f, 0.25f, 0.25f), angle });
+        }
+        auto croppedSinCube = Mix(Box(x, y, z, 0.75f, 0.75f, 0.75f), Subtract(Sphere(x, y, z, 1.0f), SinSphere(x, y, z, 1.0f)), 0.5f);
+        auto repeated = Repeat(SmoothUnion(croppedSinCube, Vase(x, 0.0f, z, 1.0f)), x, 0.0f, z, 25.0f);
+        StaticShapeWrapper staticScene(SmoothUnion(SmoothUnion(Plane(0.0f), repeated), ring), "u_StaticScene");
+
+        auto sphere = std::make_shared<SphereShape>(Math::Vec4(x, y, z, 1.0f), "u_StaticSphere");
+        auto cube = std::make_shared<CubeShape>(Math::Vec4(x, y, z, 0.75f), "u_StaticCube");
+        auto croppedSin = std::make_shared<CroppedShapeWrapper>(sphere, std::make_shared<SinSphereShape>(Math::Vec4(x, y, z, 1.0f), "u_StaticSinSphere"));
+        auto dynamicRepeated = std::make_shared<RepeatedSpaceWrapper>(std::vector<std::shared_ptr<IShapedObject>>{
+            std::make_shared<InterpolatedShapeWrapper>(cube, croppedSin, 0.5f), std::make_shared<VaseShape>(Math::Vec4(x, 0.0f, z, 1.0f), "u_StaticVase") },
+            Math::Vec4(x, 0.0f, z, 25.0f), "u_StaticRepeated");
+        UnitedShapeWrapper dynamicScene({ std::make_shared<PlaneShape>(0.0f, "u_StaticPlane"), dynamicRepeated, dynamicRing });
+
+        std::vector<float> dynamicDepths, staticDepths, wrappedDepths;
+        Milliseconds dynamicTime = MarchCpuImage([&](const Math::Vec3& p) { return dynamicScene.Distance(p, context); }, bounds, dynamicDepths);
+        const auto& scene = staticScene.Scene();
+        Milliseconds staticTime = MarchCpuImage([&](const Math::Vec3& p) { return scene.Distance(p.x(), p.y(), p.z(), context); }, bounds, staticDepths);
+        Milliseconds wrappedTime = MarchCpuImage([&](const Math::Vec3& p) { return staticScene.Distance(p, context); }, bounds, wrappedDepths);
+        float maxDifference = 0.0f;
+        for (size_t i = 0; i < dynamicDepths.size(); i++) {
+            maxDifference = std::max(maxDifference, std::abs(staticDepths[i] - dynamicDepths[i]));
+        }
+        std::cout << "  dynamic " << std::fixed << std::setprecision(1) << dynamicTime.count() << " ms, static " << staticTime.count()
+            << " ms, static through IShapedObject " << wrappedTime.count() << " ms, max depth difference " << maxDifference << '\n';
+
+        std::mt19937 random(7);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        unsigned int outside = 0;
+        for (unsigned int i = 0; i < sOctreeQueryCount / 100; i++) {
+            Math::Vec3 min = bounds.Min() + Math::Vec3(unit(random), unit(random), unit(random)) * sOctreeSceneSize;
+            Math::AABB box(min, min + Math::Vec3(unit(random), unit(random), unit(random)) * 2.0f);
+            Math::Interval range = staticScene.DistanceRange(box, context);
+            Math::Vec3 point = box.Min() + (box.Max() - box.Min()) * unit(random);
+            outside += range.Contains(staticScene.Distance(point, context)) ? 0 : 1;
+        }
+        std::string glsl = staticScene.SceneFunctionsDefinitions();
+        std::cout << "  " << outside << " of " << sOctreeQueryCount / 100 << " point distances outside of their box range, "
+            << std::count(glsl.begin(), glsl.end(), '\n') << " lines of GLSL\n";
+        if (outside > 0) {
+            mFailed = true;
+        }
+    }
+
+    /*
+        Evaluates each shape written with ShapeCode through Distance, the
+        Float4 batch, its GLSL compiled as C++ and its SceneCompiler C++ at
+        the same random points, and checks DistanceRange of random boxes
+        contains the distances inside them
+    */
+    void CheckShapeCode()
+    {
+        std::cout << "[Benchmark] Shape code agreement, max difference from Distance over " << sShapeCodePointCount << " points\n";
+
+        DistanceContext context = { mSmoothMin, 0.7f, mNoiseTexture.get() };
+        const Math::Vec3 center(0.5f, 1.2f, 6.0f);
+        const Math::Vec4 coords(center.x(), center.y(), center.z(), 1.0f);
+        std::vector<std::tuple<std::string, std::shared_ptr<IShapedObject>, std::array<float, 4>, unsigned int, std::string>> shapes = {
+            { "plane", std::make_shared<PlaneShape>(center.y(), "u_CheckPlane"), { center.y(), 0.0f, 0.0f, 0.0f }, PlaneShape::sParamCount,
+                ShapeCode::GlslDefinition<PlaneShape>("Shape0") },
+            { "sphere", std::make_shared<SphereShape>(coords, "u_CheckSphere"), { center.x(), center.y(), center.z(), 1.0f }, SphereShape::sParamCount,
+                ShapeCode::GlslDefinition<SphereShape>("Shape1") },
+            { "cube", std::make_shared<CubeShape>(coords, "u_CheckCube"), { center.x(), center.y(), center.z(), 1.0f }, CubeShape::sParamCount,
+                ShapeCode::GlslDefinition<CubeShape>("Shape2") },
+            { "sin sphere", std::make_shared<SinSphereShape>(coords, "u_CheckSinSphere"), { center.x(), center.y(), center.z(), 1.0f },
+                SinSphereShape::sParamCount, ShapeCode::GlslDefinition<SinSphereShape>("Shape3") },
+            { "vase", std::make_shared<VaseShape>(coords, "u_CheckVase"), { center.x(), center.y(), center.z(), 1.0f }, VaseShape::sParamCount,
+                ShapeCode::GlslDefinition<VaseShape>("Shape4") } };
+
+        std::string source = ShapeCode::sGlslAsCppPrelude;
+        for (const auto& shape : shapes) {
+            source += std::get<4>(shape) + '\n';
+        }
+        source += "}\n";
+        for (size_t i = 0; i < shapes.size(); i++) {
+            std::string name = "Shape" + std::to_string(i);
+            std::string obj = std::get<3>(shapes[i]) == 1 ? "obj[0]" : "glsl::vec4{ obj[0], obj[1], obj[2], obj[3] }";
+            source += "\nSHAPE_EXPORT float " + name + "Distance(float x, float y, float z, const float* obj, float time)\n{\n"
+                "    glsl::u_Time = time;\n    return glsl::" + name + "(glsl::vec3{ x, y, z }, " + obj + ");\n}\n";
+        }
+        std::string log;
+        std::shared_ptr<SharedLibrary> glslLibrary = SceneCompiler::Build(source, &log);
+        if (!glslLibrary) {
+            std::cout << "  compiler failed\n" << log << '\n';
+            mFailed = true;
+            return;
+        }
+
+        std::mt19937 random(11);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::vector<float> x(sShapeCodePointCount), y(sShapeCodePointCount), z(sShapeCodePointCount);
+        for (unsigned int i = 0; i < sShapeCodePointCount; i++) {
+            x[i] = center.x() + unit(random) * 3.0f;
+            y[i] = center.y() + unit(random) * 3.0f;
+            z[i] = center.z() + unit(random) * 3.0f;
+        }
+
+        using ShapeFunction = float (*)(float x, float y, float z, const float* obj, float time);
+        for (size_t i = 0; i < shapes.size(); i++) {
+            const auto& [name, shape, obj, paramCount, glsl] = shapes[i];
+            auto glslDistance = reinterpret_cast<ShapeFunction>(glslLibrary->Symbol("Shape" + std::to_string(i) + "Distance"));
+            std::optional<SceneCompiler::Program> program = SceneCompiler::Compile(*shape);
+            if (!glslDistance || !program) {
+                std::cout << "  " << name << ": code missing\n";
+                mFailed = true;
+                continue;
+            }
+            SceneCompiler::Context programContext = SceneCompiler::MakeContext(context, program->Fallbacks);
+
+            std::vector<float> batchDistances(sShapeCodePointCount);
+            for (size_t first = 0; first < sShapeCodePointCount; first += PointBatch::sMaxCount) {
+                PointBatch batch = { &x[first], &y[first], &z[first], std::min<size_t>(PointBatch::sMaxCount, sShapeCodePointCount - first) };
+                shape->Distances(batch, &batchDistances[first], context);
+            }
+            float batchDifference = 0.0f, glslDifference = 0.0f, cppDifference = 0.0f;
+            unsigned int outside = 0;
+            for (unsigned int j = 0; j < sShapeCodePointCount; j++) {
+                float dist = shape->Distance(Math::Vec3(x[j], y[j], z[j]), context);
+                batchDifference = std::max(batchDifference, std::abs(batchDistances[j] - dist));
+                glslDifference = std::max(glslDifference, std::abs(glslDistance(x[j], y[j], z[j], obj.data(), context.Time) - dist));
+                cppDifference = std::max(cppDifference, std::abs(program->Distance(x[j], y[j], z[j], &programContext) - dist));
+
+                Math::Vec3 extent = Math::Vec3(std::abs(unit(random)), std::abs(unit(random)), std::abs(unit(random))) * 0.5f;
+                Math::Vec3 point(x[j], y[j], z[j]);
+                outside += shape->DistanceRange(Math::AABB(point - extent, point + extent), context).Contains(dist) ? 0 : 1;
+            }
+            std::cout << "  " << std::setw(10) << name << ": Float4 batch " << std::scientific << std::setprecision(1) << batchDifference
+                << ", GLSL " << glslDifference << ", SceneCompiler " << cppDifference << ", " << outside << " outside of box range\n" << std::fixed;
+            if (batchDifference > 0.0f || cppDifference > 0.0f || glslDifference > sShapeCodeGlslTolerance || outside > 0) {
+                mFailed = true;
+            }
+        }
+    }
+
+    void PrintMeshError(const char* label, const IShapedObject& shape, const DistanceContext& context, const Mesh& mesh, double milliseconds)
+    {
+        double squares = 0.0;
+        float maxError = 0.0f;
+        for (size_t i = 0; i < mesh.Triangles.size(); i += 3) {
+            Math::Vec3 center;
+            for (size_t j = 0; j < 3; j++) {
+                const float* vertex = &mesh.Vertices[mesh.Triangles[i + j] * 3];
+                center = center + Math::Vec3(vertex[0], vertex[1], vertex[2]) / 3.0f;
+            }
+            float error = std::abs(shape.Distance(center, context));
+            squares += error * error;
+            maxError = std::max(maxError, error);
+        }
+        double rms = mesh.TriangleCount() > 0 ? std::sqrt(squares / mesh.TriangleCount()) : 0.0;
+        std::cout << label << std::setw(7) << mesh.TriangleCount() << " triangles, " << std::fixed << std::setprecision(1) << std::setw(7)
+            << milliseconds << " ms, " << std::setprecision(5) << rms << '/' << maxError << '\n';
+    }
+
+    /*
+        Compares a CpuRenderer frame with the shader one, checks a written
+        PNG decodes to the same pixels, then renders a sequence to PNG with
+        one encoder and with the default pool to show how much the render
+        thread waits for encoders
+    */
+    void BenchmarkFrameSequence()
+    {
+        std::cout << "[Benchmark] Frame sequence, " << sSequenceFrameCount << " frames at " << mWidth << 'x' << mHeight << '\n';
+        ResetCamera();
+        SetRenderMode(RenderMode::Full);
+        const QualityTier& tier = QualityTier::Tiers()[mQualityTierIndex];
+
+        DrawFrame(0.0f);
+        std::vector<unsigned char> gpuPixels;
+        mHistoryBuffers[mHistoryIndex].ReadPixels(gpuPixels);
+
+        std::vector<float> colors(gpuPixels.size());
+        CpuRenderer::View view = { mCameraPos, mCameraRotationY, Math::Vec3(mLightPos.x(), mLightPos.y(), mLightPos.z()) };
+        DistanceContext context = { mSmoothMin, 0.0f, mNoiseTexture.get() };
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        CpuRenderer::Render(*CpuScene(), context, view, tier, mEnableShadows, mWidth, mHeight, colors.data());
+        Milliseconds cpuTime = std::chrono::steady_clock::now() - t0;
+        std::vector<unsigned char> cpuPixels(colors.size());
+        for (size_t i = 0; i < colors.size(); i++) {
+            cpuPixels[i] = static_cast<unsigned char>(std::clamp(colors[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+        }
+        double psnr = Benchmark::PeakSignalToNoiseRatio(gpuPixels, cpuPixels);
+        bool cpuPassed = psnr >= sMinCpuRendererPSNR;
+        mFailed = mFailed || !cpuPassed;
+        std::cout << "  CPU renderer  " << std::fixed << std::setprecision(1) << cpuTime.count() << " ms/frame, PSNR "
+            << std::setprecision(2) << psnr << " dB against the shader" << (cpuPassed ? "" : "  [FAILED]") << '\n';
+
+        const std::filesystem::path directory = "export/benchmark_sequence";
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        const std::string pngPath = (directory / "check.png").string();
+        int width = 0;
+        int height = 0;
+        int channels = 0;
+        t0 = std::chrono::steady_clock::now();
+        bool written = ImageWriter::WritePng(pngPath, mWidth, mHeight, gpuPixels.data());
+        Milliseconds pngTime = std::chrono::steady_clock::now() - t0;
+        // Rows are written top to bottom, stb_image keeps them so
+        stbi_set_flip_vertically_on_load(1);
+        unsigned char* decoded = written ? stbi_load(pngPath.c_str(), &width, &height, &channels, 4) : nullptr;
+        stbi_set_flip_vertically_on_load(0);
+        bool pngPassed = decoded && width == static_cast<int>(mWidth) && height == static_cast<int>(mHeight) &&
+            std::memcmp(decoded, gpuPixels.data(), gpuPixels.size()) == 0;
+        mFailed = mFailed || !pngPassed;
+        std::cout << "  PNG           " << std::setprecision(1) << pngTime.count() << " ms, " << std::setprecision(0)
+            << std::filesystem::file_size(pngPath, error) / 1024.0 << " KB of " << gpuPixels.size() / 1024.0 << " KB"
+            << (pngPassed ? ", decodes to the same pixels" : ", decoded pixels differ  [FAILED]") << '\n';
+        stbi_image_free(decoded);
+
+        for (unsigned int encoders : { 1u, 0u }) {
+            SequenceSettings settings;
+            settings.Directory = directory.string();
+            settings.FrameCount = sSequenceFrameCount;
+            settings.TimeStep = sFrameStep;
+            settings.QualityTierIndex = mQualityTierIndex;
+            settings.EncoderThreads = encoders;
+            settings.QueueCapacity = encoders == 1 ? 1 : 0;
+            std::optional<SequenceStats> stats = RenderSequence(settings);
+            bool passed = stats && stats->Encoder.Frames == sSequenceFrameCount && stats->Encoder.Failures == 0;
+            mFailed = mFailed || !passed;
+            if (!stats) {
+                std::cout << "  Sequence couldn't be rendered  [FAILED]\n";
+                continue;
+            }
+            std::cout << "  " << stats->EncoderThreads << " encoder(s), " << std::setw(2) << stats->FrameSlots << " slots" << std::setprecision(1) << std::setw(8) << stats->FramesPerSecond() << " fps, render "
+                << stats->RenderMilliseconds / sSequenceFrameCount << " ms/frame, encode " << stats->Encoder.EncodeMilliseconds / sSequenceFrameCount
+                << " ms/frame, back-pressure " << stats->Encoder.StalledFrames << " frames " << stats->Encoder.WaitMilliseconds << " ms"
+                << (passed ? "" : "  [FAILED]") << '\n';
+        }
+
+        std::filesystem::remove_all(directory, error);
+        std::cout << std::defaultfloat;
+    }
+
+    /*
+        Throughput of the animated fly-through without capture, with
+        glReadPixels after every frame and through a PixelReadback. Both
+        capturing runs checksum the pixels, the readback must deliver the
+        same frames in order
+    */
+    void BenchmarkReadback()
+    {
+        std::cout << "[Benchmark] Frame capture, " << sFrameCount << " frames at " << mWidth << 'x' << mHeight << '\n';
+        SetRenderMode(RenderMode::Full);
+
+        std::vector<uint64_t> checksums(sFrameCount, 0);
+        std::vector<unsigned char> pixels;
+        uint64_t mismatches = 0;
+        uint64_t nextFrame = 0;
+        OpenGL::PixelReadback readback(mWidth, mHeight, [&](const unsigned char* data, uint64_t frame) {
+            mismatches += (frame != nextFrame++ || Checksum(data, readback.SizeInBytes()) != checksums[frame]) ? 1 : 0;
+        });
+
+        const char* names[] = { "no capture", "glReadPixels", "PBO ring" };
+        double uncaptured = 0.0;
+        for (unsigned int mode = 0; mode < 3; mode++) {
+            ResetCamera();
+            GLCall(glFinish());
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            for (unsigned int frame = 0; frame < sFrameCount; frame++) {
+                mCameraPos.z() += sCameraSpeed * sFrameStep;
+                mCameraRotationY += sCameraRotationSpeed * sFrameStep;
+                DrawFrame(frame * sFrameStep);
+                if (mode == 1) {
+                    mHistoryBuffers[mHistoryIndex].ReadPixels(pixels);
+                    checksums[frame] = Checksum(pixels.data(), pixels.size());
+                } else if (mode == 2) {
+                    readback.Read(mHistoryBuffers[mHistoryIndex], frame);
+                }
+            }
+            readback.Flush();
+            GLCall(glFinish());
+            double frameTime = Milliseconds(std::chrono::steady_clock::now() - t0).count() / sFrameCount;
+            uncaptured = mode == 0 ? frameTime : uncaptured;
+
+            std::cout << "  " << std::left << std::setw(14) << names[mode] << std::right << std::fixed << std::setprecision(3)
+                << std::setw(9) << frameTime << " ms/frame";
+            if (mode > 0) {
+                std::cout << std::setprecision(1) << ", capture overhead " << (frameTime / uncaptured - 1.0) * 100.0 << '%';
+            }
+            std::cout << '\n';
+        }
+
+        const OpenGL::PixelReadback::Stats& stats = readback.GetStats();
+        bool passed = mismatches == 0 && stats.Frames == sFrameCount;
+        mFailed = mFailed || !passed;
+        std::cout << "  " << stats.Frames << " frames read back, " << stats.StalledFrames << " waited " << std::setprecision(3)
+            << stats.WaitMilliseconds << " ms on fences, " << mismatches << " differ from glReadPixels" << (passed ? "" : "  [FAILED]")
+            << '\n' << std::defaultfloat;
+        readback.Delete();
+    }
+
+    /*
+        The rendered frame scaled to 1080p goes sFrameCount times through
+        a FrameStreamer into the null device as Y4M and raw RGBA, as fast
+        as the writer takes it. Checks the SSE2 YUV conversion gives the
+        scalar bytes, also for odd sizes, and that Y4M keeps up with 60 fps
+    */
+    void BenchmarkFrameStreaming()
+    {
+        std::cout << "[Benchmark] Frame streaming, " << sFrameCount << " frames at " << sStreamWidth << 'x' << sStreamHeight << '\n';
+        ResetCamera();
+        SetRenderMode(RenderMode::Full);
+        DrawFrame(0.0f);
+        std::vector<unsigned char> rendered;
+        mHistoryBuffers[mHistoryIndex].ReadPixels(rendered);
+        auto scaled = [&](unsigned int width, unsigned int height) {
+            std::vector<unsigned char> pixels(static_cast<size_t>(width) * height * 4);
+            for (unsigned int y = 0; y < height; y++) {
+                for (unsigned int x = 0; x < width; x++) {
+                    size_t source = (static_cast<size_t>(y) * mHeight / height * mWidth + static_cast<size_t>(x) * mWidth / width) * 4;
+                    std::memcpy(&pixels[(static_cast<size_t>(y) * width + x) * 4], &rendered[source], 4);
+                }
+            }
+            return pixels;
+        };
+        std::vector<unsigned char> frame = scaled(sStreamWidth, sStreamHeight);
+
+        bool converted = true;
+        std::array<double, 2> convertTimes = { 0.0, 0.0 };
+        for (auto [width, height] : { std::pair<unsigned int, unsigned int>(sStreamWidth, sStreamHeight), { 37, 19 } }) {
+            std::vector<unsigned char> pixels = width == sStreamWidth ? frame : scaled(width, height);
+            size_t size = static_cast<size_t>(width) * height + static_cast<size_t>((width + 1) / 2) * ((height + 1) / 2) * 2;
+            std::array<std::vector<unsigned char>, 2> planes = { std::vector<unsigned char>(size), std::vector<unsigned char>(size) };
+            for (unsigned int simd = 0; simd < 2; simd++) {
+                std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+                FrameStreamer::ConvertToYuv420(pixels.data(), width, height, planes[simd].data(), simd == 1);
+                convertTimes[simd] = width == sStreamWidth ? Milliseconds(std::chrono::steady_clock::now() - t0).count() : convertTimes[simd];
+            }
+            converted = converted && planes[0] == planes[1];
+        }
+        // White is the top of the studio range with neutral chroma
+        unsigned char white[4 * 4] = {};
+        std::memset(white, 255, sizeof(white));
+        unsigned char whiteYuv[6] = {};
+        FrameStreamer::ConvertToYuv420(white, 2, 2, whiteYuv);
+        converted = converted && whiteYuv[0] == 235 && whiteYuv[4] == 128 && whiteYuv[5] == 128;
+        mFailed = mFailed || !converted;
+        std::cout << "  RGB to YUV    " << std::fixed << std::setprecision(2) << convertTimes[0] << " ms scalar, " << convertTimes[1]
+            << " ms SSE2" << (converted ? ", same bytes" : ", bytes differ  [FAILED]") << '\n';
+
+        for (auto [format, policy, name] : { std::tuple(FrameStreamer::Format::Y4m, FrameStreamer::Policy::Block, "Y4M"),
+            std::tuple(FrameStreamer::Format::Rgba, FrameStreamer::Policy::Block, "RGBA"),
+            std::tuple(FrameStreamer::Format::Y4m, FrameStreamer::Policy::Drop, "Y4M, drop") }) {
+            FrameStreamer streamer(sNullDevice, format, policy, sStreamWidth, sStreamHeight, 60);
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            for (unsigned int i = 0; i < sFrameCount && streamer.IsOpen(); i++) {
+                if (FrameStreamer::Frame* streamFrame = streamer.Acquire()) {
+                    streamFrame->Pixels.assign(frame.begin(), frame.end());
+                    streamer.Submit(*streamFrame);
+                }
+            }
+            FrameStreamer::Stats stats = streamer.Finish();
+            double framesPerSecond = (stats.Frames + stats.DroppedFrames) * 1000.0 / Milliseconds(std::chrono::steady_clock::now() - t0).count();
+            uint64_t frames = std::max<uint64_t>(stats.Frames, 1);
+
+            bool passed = stats.Failures == 0 && stats.Frames + stats.DroppedFrames == sFrameCount &&
+                (policy == FrameStreamer::Policy::Drop || stats.Frames == sFrameCount) &&
+                (format != FrameStreamer::Format::Y4m || policy == FrameStreamer::Policy::Drop || framesPerSecond >= sMinStreamFramesPerSecond);
+            mFailed = mFailed || !passed;
+            std::cout << "  " << std::left << std::setw(12) << name << std::right << std::setprecision(1) << std::setw(8) << framesPerSecond
+                << " fps, convert " << std::setprecision(2) << stats.ConvertMilliseconds / frames << " ms/frame, write "
+                << stats.WriteMilliseconds / frames << " ms/frame, " << stats.StalledFrames << " stalled, " << stats.DroppedFrames
+                << " dropped" << (passed ? "" : "  [FAILED]") << '\n';
+        }
+        std::cout << std::defaultfloat;
+    }
+
+    /*
+        Draws the first frame, which ends the startup, so every benchmark
+        run reports its time to first frame and the phases before it
+    */
+    void BenchmarkStartup()
+    {
+        std::cout << "[Benchmark] Startup\n";
+        DrawFrame(0.0f);
+        FinishStartup();
+
+        std::cout << "  time to first frame " << std::fixed << std::setprecision(1) << GetStartupProfiler().FirstFrameMilliseconds()
+            << " ms, " << GetStartupProfiler().JobMilliseconds() << " ms of loading, codegen and baking on " << mJobs->ThreadCount()
+            << (mJobs->ThreadCount() == 1 ? " job thread" : " job threads") << " next to the main thread\n" << std::defaultfloat;
+    }
+
+    /*
+        res/scenes/Main.scene against the scene of Main.cpp, without the ring
+        of cubes the benchmarks add to it, at random points, then parse,
+        binary save and mapped load times of a generated scene of
+        sSceneFileInstanceCount instances. Also checks broken lines are
+        reported
+    */
+    void BenchmarkSceneFile()
+    {
+        std::cout << "[Benchmark] Scene files\n";
+        std::string log;
+        std::optional<SceneFile> mainScene = SceneFile::Load("res/scenes/Main.scene", "", &log);
+        std::optional<SceneFile::Objects> objects = mainScene ? mainScene->Instantiate(sFirstObjectTextureSlot, &log) : std::nullopt;
+        float maxDifference = std::numeric_limits<float>::infinity();
+        if (objects) {
+            std::vector<std::shared_ptr<IShapedObject>> shapes;
+            std::copy_if(mShapes.begin(), mShapes.end(), std::back_inserter(shapes), [](const std::shared_ptr<IShapedObject>& shape) {
+                return !dynamic_cast<const InstancedShapeSet*>(shape.get());
+            });
+            UnitedShapeWrapper loaded(objects->Drawn);
+            UnitedShapeWrapper built(shapes);
+            DistanceContext context = { mSmoothMin, 0.0f, mNoiseTexture.get() };
+            std::mt19937 random(sSceneFilePointCount);
+            std::uniform_real_distribution<float> x(-30.0f, 30.0f);
+            std::uniform_real_distribution<float> y(-1.0f, 6.0f);
+            std::uniform_real_distribution<float> z(-20.0f, 40.0f);
+            maxDifference = 0.0f;
+            for (unsigned int i = 0; i < sSceneFilePointCount; i++) {
+                Math::Vec3 p(x(random), y(random), z(random));
+                maxDifference = std::max(maxDifference, std::abs(loaded.Distance(p, context) - built.Distance(p, context)));
+            }
+        }
+        bool mainPassed = maxDifference <= sSceneFileTolerance;
+        mFailed = mFailed || !mainPassed;
+        std::cout << "  Main.scene    " << (objects ? std::to_string(objects->Drawn.size()) + " objects drawn, " : log + ", ")
+            << "largest distance difference to Main.cpp " << std::scientific << std::setprecision(1) << maxDifference
+            << (mainPassed ? "" : "  [FAILED]") << '\n' << std::defaultfloat;
+
+        std::ostringstream generated;
+        generated << "tier 1\nplane ground 0\ninstances spheres sphere\ninstances cubes cube\n" << std::fixed << std::setprecision(4);
+        std::mt19937 random(sSceneFileInstanceCount);
+        std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+        std::uniform_real_distribution<float> size(0.1f, 1.0f);
+        for (unsigned int i = 0; i < sSceneFileInstanceCount; i++) {
+            float s = size(random);
+            generated << "instance " << (i % 2 == 0 ? "spheres " : "cubes ") << position(random) << ' ' << s << ' ' << position(random)
+                << ' ' << s << ' ' << s << ' ' << s << ' ' << position(random) * 0.01f << '\n';
+        }
+        generated << "draw ground spheres cubes\n";
+        const std::string text = generated.str();
+
+        const std::filesystem::path directory = "export/benchmark_scene";
+        const std::string binaryPath = (directory / "generated.scenebin").string();
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        std::optional<SceneFile> parsed = SceneFile::Parse(text, &log);
+        Milliseconds parseTime = std::chrono::steady_clock::now() - t0;
+        bool saved = parsed && parsed->Save(binaryPath);
+        t0 = std::chrono::steady_clock::now();
+        std::optional<SceneFile> mapped = saved ? SceneFile::LoadBinary(binaryPath) : std::nullopt;
+        Milliseconds mapTime = std::chrono::steady_clock::now() - t0;
+        bool generatedPassed = mapped && mapped->IsMapped() && mapped->GetHeader().InstanceCount == sSceneFileInstanceCount &&
+            mapped->SizeInBytes() == parsed->SizeInBytes() && std::memcmp(mapped->Data(), parsed->Data(), parsed->SizeInBytes()) == 0;
+        mFailed = mFailed || !generatedPassed;
+        std::cout << "  generated     " << sSceneFileInstanceCount << " instances, text " << std::fixed << std::setprecision(1)
+            << text.size() / (1024.0 * 1024.0) << " MB parsed in " << parseTime.count() << " ms, binary "
+            << (parsed ? parsed->SizeInBytes() : 0) / (1024.0 * 1024.0) << " MB mapped in " << std::setprecision(3) << mapTime.count() << " ms"
+            << (generatedPassed ? "" : "  [FAILED]") << '\n' << std::defaultfloat;
+
+        // Misspelled arguments, references to undefined objects and unknown keywords
+        bool reported = true;
+        for (const char* broken : { "sphere a 1 2 3\n", "# comment\ncropped c missing other\n", "sphere a 0 0 0 x\n", "torus t 1\n" }) {
+            std::string brokenLog;
+            reported = reported && !SceneFile::Parse(broken, &brokenLog) && brokenLog.rfind("line ", 0) == 0;
+        }
+        mFailed = mFailed || !reported;
+        std::cout << "  broken lines  " << (reported ? "reported with their line" : "not reported  [FAILED]") << '\n';
+        std::error_code error;
+        std::filesystem::remove_all(directory, error);
+    }
+
+    /*
+        A client thread asks for frames of two scenes in turn, served once
+        with a cold program cache and twice warm, without batching and with
+        it. Batching must not change a single pixel of the answers
+    */
+    void BenchmarkRenderServer()
+    {
+        std::cout << "[Benchmark] Render server, " << sServerRequestCount << " requests at " << sServerWidth << "x" << sServerHeight
+            << " alternating two scenes\n";
+        const std::filesystem::path directory = "export/benchmark_server";
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        const std::string smallScene = (directory / "Small.scene").string();
+        std::ofstream(smallScene) << "tier 0\nplane ground 0\nsphere ball 0 1 5 1\ncube box 2 0.5 6 0.5\ndraw ground ball box\n";
+#ifdef _WIN32
+        const std::string address = "tcp:" + std::to_string(sServerPort);
+#else
+        const std::string address = (directory / "server.sock").string();
+#endif
+        const unsigned int width = mWidth;
+        const unsigned int height = mHeight;
+
+        std::vector<std::vector<uint8_t>> reference;
+        for (unsigned int run = 0; run < 3; run++) {
+            RenderServer::Settings settings;
+            settings.Address = address;
+            settings.MaxBatch = run == 1 ? 1 : sServerBatch;
+            RenderServer server(settings);
+            if (!server.IsOpen()) {
+                mFailed = true;
+                std::cout << "  can't listen on " << address << "  [FAILED]\n";
+                break;
+            }
+
+            std::vector<std::vector<uint8_t>> images(sServerRequestCount);
+            unsigned int failures = 0;
+            std::thread client([&]() {
+                RenderClient connection(address);
+                for (unsigned int i = 0; i < sServerRequestCount; i++) {
+                    std::ostringstream line;
+                    line << "render " << (i % 2 == 0 ? "res/scenes/Main.scene" : smallScene) << ' ' << sServerWidth << ' ' << sServerHeight
+                        << ' ' << 0.1f * i << " 0 1 " << -0.05f * i << ' ' << 0.02f * i << " rgba";
+                    connection.Send(line.str());
+                }
+                for (unsigned int i = 0; i < sServerRequestCount; i++) {
+                    std::optional<RenderClient::Answer> answer = connection.Receive();
+                    if (!answer) {
+                        failures += sServerRequestCount - i;
+                        break;
+                    }
+                    if (!answer->Ok || answer->Number >= sServerRequestCount) {
+                        failures++;
+                        continue;
+                    }
+                    images[answer->Number] = std::move(answer->Data);
+                }
+                server.Shutdown();
+            });
+            server.Run(*this);
+            client.join();
+
+            unsigned int mismatches = 0;
+            if (reference.empty()) {
+                reference = images;
+            }
+            for (unsigned int i = 0; i < sServerRequestCount; i++) {
+                mismatches += images[i] != reference[i] ? 1 : 0;
+            }
+            RenderServer::Stats stats = server.GetStats();
+            bool passed = failures == 0 && stats.Failures == 0 && mismatches == 0;
+            mFailed = mFailed || !passed;
+            std::cout << "  " << (run == 0 ? "cold" : "warm") << ", batch " << std::setw(2) << settings.MaxBatch << std::fixed
+                << std::setprecision(1) << std::setw(7) << stats.RequestsPerSecond() << " requests/s, latency median "
+                << stats.LatencyMedianMilliseconds << " ms, p95 " << stats.LatencyP95Milliseconds << " ms, " << stats.Groups
+                << " program switches, " << stats.ProgramCompiles << " compiled, " << mismatches << " images differ"
+                << (passed ? "" : "  [FAILED]") << '\n' << std::defaultfloat;
+        }
+
+        Resize(width, height);
+        std::filesystem::remove_all(directory, error);
+    }
+
+    /*
+        Renders a still as tiles on 1 to sMaxTileWorkers worker processes.
+        Each frame is rendered twice and the second one is timed, so the
+        scene compile of the workers isn't. Every frame must match the one
+        of a single worker
+    */
+    void BenchmarkTileCoordinator()
+    {
+        std::cout << "[Benchmark] Tile coordinator, " << sTileFrameWidth << "x" << sTileFrameHeight << " in " << sTileSize
+            << " pixel tiles\n";
+        TileCoordinator::Frame frame;
+        frame.Scene = "res/scenes/Main.scene";
+        frame.Width = sTileFrameWidth;
+        frame.Height = sTileFrameHeight;
+        frame.Camera = mCameraPos;
+        frame.RotationY = mCameraRotationY;
+
+        std::vector<uint8_t> reference;
+        double baseline = 0.0;
+        for (unsigned int workers = 1; workers <= sMaxTileWorkers; workers *= 2) {
+            TileCoordinator::Settings settings;
+            settings.Workers = workers;
+            settings.TileSize = sTileSize;
+            TileCoordinator coordinator(settings);
+            TileCoordinator::Stats stats;
+            std::optional<std::vector<uint8_t>> image = coordinator.Render(frame);
+            if (image) {
+                image = coordinator.Render(frame, &stats);
+            }
+            if (!image) {
+                mFailed = true;
+                std::cout << "  " << workers << " workers: frame couldn't be rendered  [FAILED]\n";
+                break;
+            }
+            if (reference.empty()) {
+                reference = *image;
+                baseline = stats.Milliseconds;
+            }
+            bool passed = *image == reference && stats.LostWorkers == 0;
+            mFailed = mFailed || !passed;
+            std::cout << "  " << workers << (workers == 1 ? " worker " : " workers") << std::fixed << std::setprecision(1)
+                << std::setw(9) << stats.Milliseconds << " ms, " << std::setprecision(2) << baseline / stats.Milliseconds
+                << "x, started in " << std::setprecision(0) << coordinator.StartMilliseconds() << " ms, tiles per worker";
+            for (unsigned int tiles : stats.WorkerTiles) {
+                std::cout << ' ' << tiles;
+            }
+            std::cout << ", " << stats.Reassigned << " reassigned" << (passed ? "" : "  [FAILED]") << '\n' << std::defaultfloat;
+        }
+    }
+
+    template <typename Distance>
+    static Milliseconds MeasureQueries(const std::vector<Math::Vec3>& points, const Distance& distance)
+    {
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        volatile float sum = 0.0f;
+        for (const Math::Vec3& point : points) {
+            sum = sum + distance(point);
+        }
+        return std::chrono::steady_clock::now() - t0;
+    }
+
+    /*
+        FNV-1a of size bytes
+    */
+    static uint64_t Checksum(const unsigned char* data, size_t size)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < size; i++) {
+            hash = (hash ^ data[i]) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    /*
+        Sphere traces the camera view of the default tier at low resolution
+        until rays hit or leave bounds, depths get the travelled distance of
+        every pixel
+    */
+    template <typename Distance>
+    Milliseconds MarchCpuImage(const Distance& distance, const Math::AABB& bounds, std::vector<float>& depths) const
+    {
+        const QualityTier& tier = QualityTier::Tiers()[sDefaultQualityTier];
+        const unsigned int width = sCpuImageWidth;
+        const unsigned int height = sCpuImageWidth * mHeight / mWidth;
+        Math::Vec3 origin(0.0f, 1.5f, 0.0f);
+        depths.resize(static_cast<size_t>(width) * height);
+
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        for (unsigned int y = 0; y < height; y++) {
+            for (unsigned int x = 0; x < width; x++) {
+                Math::Vec3 direction((x + 0.5f - 0.5f * width) / height, (y + 0.5f - 0.5f * height) / height, 1.0f);
+                direction = Math::RotateXZ(direction, -sCpuCameraRotationY);
+                direction = direction / direction.Magnitude();
+
+                float travelled = 0.0f;
+                for (int step = 0; step < tier.MaxSteps; step++) {
+                    Math::Vec3 p = origin + direction * travelled;
+                    if (!bounds.Contains(p)) {
+                        travelled = tier.MaxDistance;
+                        break;
+                    }
+                    float dist = distance(p);
+                    travelled += dist;
+                    if (travelled > tier.MaxDistance || std::abs(dist) < tier.SurfaceDistance) {
+                        break;
+                    }
+                }
+                depths[static_cast<size_t>(y) * width + x] = std::min(travelled, tier.MaxDistance);
+            }
+        }
+        return std::chrono::steady_clock::now() - t0;
+    }
+private:
+    static constexpr unsigned int sFrameCount = 120;
+    static constexpr float sFrameStep = 1.0f / 60.0f;
+    static constexpr float sCameraSpeed = 3.0f;
+    static constexpr float sCameraRotationSpeed = 0.25f;
+    // Identical frames give infinite PSNR, cap it to keep the mean finite
+    static constexpr double sPSNRCap = 100.0;
+    static constexpr double sMinMeanPSNR = 25.0;
+    static constexpr unsigned int sScalingFrameCount = 30;
+    static constexpr float sSphereSpacing = 3.0f;
+    // Uniform vectors used by the fragment shader besides the objects
+    static constexpr unsigned int sReservedUniformVectors = 32;
+    // Band width in voxel diagonals, same as BrickMapShapeWrapper
+    static constexpr float sBrickMapBandVoxels = 3.0f;
+    static constexpr float sOctreeSceneSize = 32.0f;
+    static constexpr unsigned int sOctreeQueryCount = 100000;
+    static constexpr unsigned int sCpuImageWidth = 160;
+    static constexpr float sCpuCameraRotationY = -0.6f;
+    static constexpr size_t sQueryPointTotal = 1 << 16;
+    static constexpr unsigned int sShapeCodePointCount = 4096;
+    // GLSL mix is computed as x * (1 - a) + y * a, Math::Mix as x + (y - x) * a
+    static constexpr float sShapeCodeGlslTolerance = 1e-5f;
+    // Cubes of the ring BuildScene adds for the benchmarks
+    static constexpr size_t sStaticRingSize = 32;
+    // SURFACE_DISTANCE of the shader, same as SceneQuery
+    static constexpr float sQueryNormalOffset = 0.001f;
+    static constexpr unsigned int sSequenceFrameCount = 60;
+    // CPU and GPU floats differ at silhouettes where rays graze surfaces
+    static constexpr double sMinCpuRendererPSNR = 30.0;
+    // The full pass runs out of steps before the ground near the horizon, where rays starting further reach it
+    static constexpr double sMinProgressivePSNR = 34.0;
+    static constexpr unsigned int sAnalyticPrimitiveCount = 6;
+    static constexpr unsigned int sAnalyticFrameCount = 5;
+    // Marching stops short of silhouettes and runs out of steps along the horizon, rays that intersect objects don't
+    static constexpr double sMinAnalyticPSNR = 30.0;
+    // Capped adaptive antialiasing may add a ray for this fraction of the pixels
+    static constexpr uint64_t sCappedAntialiasFraction = 8;
+    // PSNR adaptive antialiasing must gain over none, both against uniform 4x supersampling
+    static constexpr double sMinAntialiasGain = 6.0;
+    static constexpr unsigned int sSceneFileInstanceCount = 1 << 18;
+    static constexpr unsigned int sSceneFilePointCount = 4096;
+    // Main.scene writes the numbers of Main.cpp in decimal
+    static constexpr float sSceneFileTolerance = 1e-5f;
+    static constexpr unsigned int sTileFrameWidth = 960;
+    static constexpr unsigned int sTileFrameHeight = 540;
+    static constexpr unsigned int sTileSize = 128;
+    static constexpr unsigned int sMaxTileWorkers = 4;
+    static constexpr unsigned int sServerRequestCount = 24;
+    static constexpr unsigned int sServerWidth = 160;
+    static constexpr unsigned int sServerHeight = 90;
+    static constexpr size_t sServerBatch = 16;
+    // Windows has no Unix domain sockets here, the benchmark serves on localhost TCP
+    static constexpr unsigned int sServerPort = 47800;
+    static constexpr unsigned int sStreamWidth = 1920;
+    static constexpr unsigned int sStreamHeight = 1080;
+    static constexpr double sMinStreamFramesPerSecond = 60.0;
+#ifdef _WIN32
+    static constexpr const char* sNullDevice = "NUL";
+#else
+    static constexpr const char* sNullDevice = "/dev/null";
+#endif
+
+    bool mFailed = false;
+};
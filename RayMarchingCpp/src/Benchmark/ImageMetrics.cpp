@@ -0,0 +1,27 @@
+#include "ImageMetrics.h"
+#include "OpenGL/GLCore.h"
+
+#include <cmath>
+#include <limits>
+
+double Benchmark::PeakSignalToNoiseRatio(const std::vector<unsigned char>& reference, const std::vector<unsigned char>& image)
+{
+    ASSERT(reference.size() == image.size());
+
+    double squaredError = 0.0;
+    size_t samples = 0;
+    for (size_t i = 0; i + 3 < reference.size(); i += 4) {
+        for (size_t channel = 0; channel < 3; channel++) {
+            double diff = static_cast<double>(reference[i + channel]) - static_cast<double>(image[i + channel]);
+            squaredError += diff * diff;
+        }
+        samples += 3;
+    }
+
+    if (samples == 0 || squaredError == 0.0) {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    double mse = squaredError / samples;
+    return 10.0 * std::log10(255.0 * 255.0 / mse);
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <vector>
+
+namespace Benchmark {
+
+    /*
+        PSNR in dB over RGB channels of two RGBA8 images of the same size,
+        returns infinity for identical images
+    */
+    double PeakSignalToNoiseRatio(const std::vector<unsigned char>& reference, const std::vector<unsigned char>& image);
+
+}
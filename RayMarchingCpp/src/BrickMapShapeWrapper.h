@@ -0,0 +1,373 @@
+#pragma once
+
+#include "RayMarchingWindow/IShapedObject.h"
+#include "RayMarchingWindow/IImGuiEditable.h"
+#include "RayMarchingWindow/IBakedObject.h"
+#include "RayMarchingWindow/BrickMap.h"
+#include "OpenGL/GLCore.h"
+#include "OpenGL/Texture3D.h"
+#include "Math/Math.h"
+#include <imgui.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+/*
+    Sparse counterpart of BakedShapeWrapper: the object is marched through a
+    BrickMap. Bricks are packed into an atlas texture, a second texture maps
+    every cell to its brick or holds the distance bound of an empty cell.
+    The map is saved to cachePath and reused by later runs while the object
+    and bake settings stay the same
+*/
+class BrickMapShapeWrapper : public IShapedObject, public IImGuiEditable, public IBakedObject {
+public:
+    /*
+        resolution is the number of samples along the longest side of the
+        padded object bounds, bitsPerDistance is 8 or 16. Uses textureSlot
+        and the next one. Empty cachePath disables the cache
+    */
+    BrickMapShapeWrapper(std::shared_ptr<IShapedObject> shape, const std::string& name, unsigned int textureSlot,
+        unsigned int resolution, unsigned int bitsPerDistance, const std::string& cachePath)
+        : mShape(shape), mName(name), mTextureSlot(textureSlot), mResolution(std::max(resolution, sMinResolution)),
+        mBitsPerDistance(bitsPerDistance > 8 ? 16 : 8), mCachePath(cachePath)
+    {
+    }
+
+    BrickMapShapeWrapper(const BrickMapShapeWrapper&) = delete;
+    BrickMapShapeWrapper& operator=(const BrickMapShapeWrapper&) = delete;
+
+    ~BrickMapShapeWrapper()
+    {
+        mAtlas.Delete();
+        mCells.Delete();
+    }
+
+    virtual void UpdateBake(const DistanceContext& context) override
+    {
+        std::optional<Math::AABB> bounds = mShape->Bounds();
+        if (!bounds || mShape->IsAnimated()) {
+            if (!mBakeFailed) {
+                std::cerr << "[Warning] BrickMapShapeWrapper: '" << mName << "' is " << (bounds ? "animated" : "unbounded")
+                    << ", evaluating it directly\n";
+                mBakeFailed = true;
+            }
+            return;
+        }
+
+        if (!mRebakeRequested && *bounds == mBakedShapeBounds && context.SmoothMin == mBakedSmoothMin) {
+            return;
+        }
+
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+        std::optional<BrickMap> map;
+        if (mPrepared && !mRebakeRequested && *bounds == mPreparedShapeBounds && context.SmoothMin == mPreparedSmoothMin) {
+            map = std::move(mPrepared);
+            mLoadedFromCache = mPreparedFromCache;
+        } else {
+            map = LoadOrBake(*bounds, context, !mRebakeRequested, mLoadedFromCache);
+        }
+        mPrepared.reset();
+        float voxelSize = map->GetHeader().VoxelSize;
+        float band = map->GetHeader().Band;
+
+        if (!Upload(*map)) {
+            std::cerr << "[Warning] BrickMapShapeWrapper: " << map->GetHeader().BrickCount << " bricks of '" << mName
+                << "' don't fit into a 3D texture, evaluating it directly\n";
+            mBakeFailed = true;
+            return;
+        }
+
+        mVolumeBounds = map->Bounds();
+        mBakedShapeBounds = *bounds;
+        mBakedSmoothMin = context.SmoothMin;
+        mVoxelSize = voxelSize;
+        mBand = band;
+        mFallbackDistance = sFallbackVoxels * sSqrt3 * voxelSize;
+        // Trilinear error is at most one voxel diagonal, quantization adds one step
+        mMargin = sSqrt3 * voxelSize + 2.0f * band / ((1u << mBitsPerDistance) - 1);
+        mBrickCount = map->GetHeader().BrickCount;
+        mCacheSize = map->SizeInBytes();
+        mRebakeRequested = false;
+        mBakeTime = std::chrono::steady_clock::now() - t0 + mPreparedTime;
+        mPreparedTime = std::chrono::duration<double, std::milli>(0.0);
+    }
+
+    /*
+        Loads or bakes the map UpdateBake uploads next, which mustn't run
+        until this returns
+    */
+    virtual void PrepareBake(const DistanceContext& context) override
+    {
+        std::optional<Math::AABB> bounds = mShape->Bounds();
+        if (!bounds || mShape->IsAnimated()) {
+            return;
+        }
+
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        mPrepared = LoadOrBake(*bounds, context, true, mPreparedFromCache);
+        mPreparedShapeBounds = *bounds;
+        mPreparedSmoothMin = context.SmoothMin;
+        mPreparedTime = std::chrono::steady_clock::now() - t0;
+    }
+
+    virtual void SetVolumeEnabled(bool enabled) override
+    {
+        mVolumeEnabled = enabled;
+    }
+
+    virtual bool VolumeEnabled() const override
+    {
+        return mVolumeEnabled;
+    }
+
+    virtual double BakeMilliseconds() const override
+    {
+        return mBakeTime.count();
+    }
+
+    virtual size_t VolumeSizeInBytes() const override
+    {
+        return mBakeFailed ? 0 : mAtlas.SizeInBytes() + mCells.SizeInBytes();
+    }
+
+    bool LoadedFromCache() const
+    {
+        return mLoadedFromCache;
+    }
+
+    virtual void PassToShader(OpenGL::ShaderProgram& shader) override
+    {
+        mShape->PassToShader(shader);
+
+        bool enabled = mVolumeEnabled && !mBakeFailed && mAtlas.Width() > 0;
+        shader.SetUniform1i(Name() + "Enabled", enabled);
+        // Set even when disabled, samplers of different types must not share a unit
+        shader.SetUniform1i(Name(), mTextureSlot);
+        shader.SetUniform1i(Name() + "Cells", mTextureSlot + 1);
+        if (enabled) {
+            mAtlas.Bind(mTextureSlot);
+            mCells.Bind(mTextureSlot + 1);
+            shader.SetUniform3f(Name() + "Min", mVolumeBounds.Min().x(), mVolumeBounds.Min().y(), mVolumeBounds.Min().z());
+            shader.SetUniform3f(Name() + "Max", mVolumeBounds.Max().x(), mVolumeBounds.Max().y(), mVolumeBounds.Max().z());
+            shader.SetUniform3f(Name() + "ShapeMin", mBakedShapeBounds.Min().x(), mBakedShapeBounds.Min().y(), mBakedShapeBounds.Min().z());
+            shader.SetUniform3f(Name() + "ShapeMax", mBakedShapeBounds.Max().x(), mBakedShapeBounds.Max().y(), mBakedShapeBounds.Max().z());
+            shader.SetUniform1f(Name() + "VoxelSize", mVoxelSize);
+            shader.SetUniform1f(Name() + "Band", mBand);
+            shader.SetUniform1f(Name() + "Fallback", mFallbackDistance);
+            shader.SetUniform1f(Name() + "Margin", mMargin);
+        }
+    }
+
+    virtual void RenderImGuiEditor() override
+    {
+        ImGui::Checkbox("use brick map", &mVolumeEnabled);
+        if (ImGui::Button("rebake")) {
+            mRebakeRequested = true;
+        }
+        ImGui::Text("%u bricks, %.1f KB in textures, %.1f KB on disk", mBrickCount, VolumeSizeInBytes() / 1024.0, mCacheSize / 1024.0);
+        ImGui::Text("%s in %.1f ms", mLoadedFromCache ? "loaded from cache" : "baked", BakeMilliseconds());
+    }
+
+    virtual std::string_view SectionName() const override
+    {
+        return Name();
+    }
+
+    virtual std::string UniformsDefinitions() const override
+    {
+        return mShape->UniformsDefinitions() + UNIFORM(sampler3D, Name()) + UNIFORM(sampler3D, Name() + "Cells") +
+            UNIFORM(int, Name() + "Enabled") + UNIFORM(vec3, Name() + "Min") + UNIFORM(vec3, Name() + "Max") +
+            UNIFORM(vec3, Name() + "ShapeMin") + UNIFORM(vec3, Name() + "ShapeMax") + UNIFORM(float, Name() + "VoxelSize") +
+            UNIFORM(float, Name() + "Band") + UNIFORM(float, Name() + "Fallback") + UNIFORM(float, Name() + "Margin");
+    }
+
+    virtual std::string SceneFunctionsDefinitions() const override
+    {
+        std::string exact = mShape->DistFunctionCall("p");
+        std::string brickVoxels = std::to_string(BrickMap::sBrickVoxels) + ".0";
+        return mShape->SceneFunctionsDefinitions() + DIST_FUNCTION_PROTOTYPE(DistFunctionName(), vec3 p) + "\n{\n"
+            "    if (" + Name() + "Enabled == 0) {\n"
+            "        return " + exact + ";\n"
+            "    }\n"
+            "    vec3 outside = max(" + Name() + "Min - p, p - " + Name() + "Max);\n"
+            "    if (any(greaterThan(outside, vec3(0.0)))) {\n"
+            "        return length(max(max(" + Name() + "ShapeMin - p, p - " + Name() + "ShapeMax), 0.0));\n"
+            "    }\n"
+            "    vec3 voxel = (p - " + Name() + "Min) / " + Name() + "VoxelSize;\n"
+            "    ivec3 cellIndex = min(ivec3(voxel / " + brickVoxels + "), textureSize(" + Name() + "Cells, 0) - 1);\n"
+            "    vec4 cell = texelFetch(" + Name() + "Cells, cellIndex, 0);\n"
+            "    if (cell.x < 0.0) {\n"
+            "        return cell.w;\n"
+            "    }\n"
+            "    vec3 texel = cell.xyz + voxel - vec3(cellIndex) * " + brickVoxels + " + 0.5;\n"
+            "    float dist = (texture(" + Name() + ", texel / vec3(textureSize(" + Name() + ", 0))).r * 2.0 - 1.0) * " + Name() + "Band;\n"
+            "    if (dist < " + Name() + "Fallback) {\n"
+            "        return " + exact + ";\n"
+            "    }\n"
+            "    return dist - " + Name() + "Margin;\n"
+            "}\n";
+    }
+
+    virtual std::string DistFunctionCall(const std::string& fixedParam) const override
+    {
+        return DistFunctionName() + '(' + fixedParam + ')';
+    }
+
+    virtual float Distance(const Math::Vec3& p, const DistanceContext& context) const override
+    {
+        return mShape->Distance(p, context);
+    }
+
+    virtual Math::Interval DistanceRange(const Math::AABB& box, const DistanceContext& context) const override
+    {
+        return mShape->DistanceRange(box, context);
+    }
+
+    virtual std::optional<Math::AABB> Bounds() const override
+    {
+        return mShape->Bounds();
+    }
+
+    virtual bool IsAnimated() const override
+    {
+        return mShape->IsAnimated();
+    }
+
+    const std::string& Name() const
+    {
+        return mName;
+    }
+private:
+    /*
+        Takes the map from the cache if useCache and it was made from the
+        same object and settings, otherwise bakes and saves it
+    */
+    std::optional<BrickMap> LoadOrBake(const Math::AABB& bounds, const DistanceContext& context, bool useCache, bool& loadedFromCache)
+    {
+        // Volume is padded by the band and one more voxel, so rays enter it before reaching the band
+        const float paddingVoxels = sBandVoxels * sSqrt3 + 1.0f;
+        Math::Vec3 size = bounds.Size();
+        float voxelSize = std::max({ size.x(), size.y(), size.z() }) / (mResolution - 2.0f * paddingVoxels);
+        float band = sBandVoxels * sSqrt3 * voxelSize;
+        uint64_t fingerprint = BrickMap::Fingerprint(*mShape, bounds, context);
+
+        std::optional<BrickMap> map;
+        if (useCache && !mCachePath.empty()) {
+            map = BrickMap::Load(mCachePath);
+            if (map && (map->GetHeader().Fingerprint != fingerprint || map->GetHeader().VoxelSize != voxelSize ||
+                map->GetHeader().Band != band || map->GetHeader().BitsPerDistance != mBitsPerDistance)) {
+                map.reset();
+            }
+        }
+        loadedFromCache = map.has_value();
+
+        if (!map) {
+            map = BrickMap::Bake(*mShape, bounds.Expand(paddingVoxels * voxelSize), voxelSize, band, mBitsPerDistance, fingerprint, context);
+            if (!mCachePath.empty() && !map->Save(mCachePath)) {
+                std::cerr << "[Warning] BrickMapShapeWrapper: can't write cache file '" << mCachePath << "'\n";
+            }
+        }
+        return map;
+    }
+
+    /*
+        Packs bricks into a cube of bricks in index order and fills the cell
+        texture, bricks are read from the map one by one
+    */
+    bool Upload(const BrickMap& map)
+    {
+        const BrickMap::Header& header = map.GetHeader();
+        const unsigned int samples = BrickMap::sBrickSamples;
+
+        unsigned int perAxis = std::max(static_cast<unsigned int>(std::ceil(std::cbrt(static_cast<double>(header.BrickCount)))), 1u);
+        unsigned int layers = std::max((header.BrickCount + perAxis * perAxis - 1) / (perAxis * perAxis), 1u);
+        GLint maxSize = 0;
+        GLCall(glGetIntegerv(GL_MAX_3D_TEXTURE_SIZE, &maxSize));
+        if (static_cast<GLint>(perAxis * samples) > maxSize) {
+            return false;
+        }
+
+        if (mAtlas.Width() != perAxis * samples || mAtlas.Depth() != layers * samples || mAtlasBits != mBitsPerDistance) {
+            mAtlas.Delete();
+            mAtlas = OpenGL::Texture3D(perAxis * samples, perAxis * samples, layers * samples, mBitsPerDistance == 8 ? GL_R8 : GL_R16);
+            mAtlasBits = mBitsPerDistance;
+        }
+
+        GLenum type = mBitsPerDistance == 8 ? GL_UNSIGNED_BYTE : GL_UNSIGNED_SHORT;
+        for (unsigned int i = 0; i < header.BrickCount; i++) {
+            mAtlas.UpdateRegion(i % perAxis * samples, i / perAxis % perAxis * samples, i / (perAxis * perAxis) * samples,
+                samples, samples, samples, map.Brick(i), GL_RED, type);
+        }
+
+        std::vector<float> cells;
+        cells.reserve(static_cast<size_t>(header.Cells[0]) * header.Cells[1] * header.Cells[2] * 4);
+        for (unsigned int z = 0; z < header.Cells[2]; z++) {
+            for (unsigned int y = 0; y < header.Cells[1]; y++) {
+                for (unsigned int x = 0; x < header.Cells[0]; x++) {
+                    const BrickMap::Cell& cell = map.GetCell(x, y, z);
+                    if (cell.Brick == BrickMap::sEmptyBrick) {
+                        cells.insert(cells.end(), { -1.0f, -1.0f, -1.0f, cell.MinDistance });
+                    } else {
+                        cells.insert(cells.end(), { static_cast<float>(cell.Brick % perAxis * samples),
+                            static_cast<float>(cell.Brick / perAxis % perAxis * samples),
+                            static_cast<float>(cell.Brick / (perAxis * perAxis) * samples), 0.0f });
+                    }
+                }
+            }
+        }
+
+        if (mCells.Width() != header.Cells[0] || mCells.Height() != header.Cells[1] || mCells.Depth() != header.Cells[2]) {
+            mCells.Delete();
+            mCells = OpenGL::Texture3D(header.Cells[0], header.Cells[1], header.Cells[2], GL_RGBA32F, false);
+        }
+        mCells.Update(cells.data(), GL_RGBA, GL_FLOAT);
+        return true;
+    }
+
+    std::string DistFunctionName() const
+    {
+        return mName + "Dist";
+    }
+private:
+    // Exact evaluation below this many voxel diagonals, bricks cover a wider band
+    static constexpr float sFallbackVoxels = 2.0f;
+    static constexpr float sBandVoxels = 3.0f;
+    static constexpr float sSqrt3 = 1.73205081f;
+    // Padding takes about 13 samples of the resolution
+    static constexpr unsigned int sMinResolution = 32;
+
+    std::shared_ptr<IShapedObject> mShape;
+    const std::string mName;
+    const unsigned int mTextureSlot;
+    const unsigned int mResolution;
+    const unsigned int mBitsPerDistance;
+    const std::string mCachePath;
+
+    OpenGL::Texture3D mAtlas;
+    OpenGL::Texture3D mCells;
+    unsigned int mAtlasBits = 0;
+    Math::AABB mVolumeBounds;
+    Math::AABB mBakedShapeBounds;
+    float mBakedSmoothMin = 0.0f;
+    float mVoxelSize = 0.0f;
+    float mBand = 0.0f;
+    float mFallbackDistance = 0.0f;
+    float mMargin = 0.0f;
+    unsigned int mBrickCount = 0;
+    size_t mCacheSize = 0;
+    std::chrono::duration<double, std::milli> mBakeTime = std::chrono::duration<double, std::milli>(0.0);
+    bool mVolumeEnabled = true;
+    bool mRebakeRequested = false;
+    bool mBakeFailed = false;
+    bool mLoadedFromCache = false;
+
+    // Left by PrepareBake for the next UpdateBake
+    std::optional<BrickMap> mPrepared;
+    bool mPreparedFromCache = false;
+    Math::AABB mPreparedShapeBounds;
+    float mPreparedSmoothMin = 0.0f;
+    std::chrono::duration<double, std::milli> mPreparedTime = std::chrono::duration<double, std::milli>(0.0);
+};
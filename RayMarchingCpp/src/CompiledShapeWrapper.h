@@ -0,0 +1,91 @@
+#pragma once
+
+#include "RayMarchingWindow/IShapedObject.h"
+#include "RayMarchingWindow/SceneCompiler.h"
+#include "Math/Math.h"
+
+#include <memory>
+
+/*
+    Object whose CPU distance runs the native code SceneCompiler made of
+    it. Everything else, shader code included, is passed to the object.
+    Parameters are compiled in as they were, IsCurrent tells whether the
+    object has changed since
+*/
+class CompiledShapeWrapper : public IShapedObject {
+public:
+    CompiledShapeWrapper(std::shared_ptr<IShapedObject> object, SceneCompiler::Program program)
+        : mObject(object), mProgram(std::move(program))
+    {
+    }
+
+    virtual void PassToShader(OpenGL::ShaderProgram& shader) override
+    {
+        mObject->PassToShader(shader);
+    }
+
+    virtual std::string UniformsDefinitions() const override
+    {
+        return mObject->UniformsDefinitions();
+    }
+
+    virtual std::string SceneFunctionsDefinitions() const override
+    {
+        return mObject->SceneFunctionsDefinitions();
+    }
+
+    virtual std::string DistFunctionCall(const std::string& fixedParam) const override
+    {
+        return mObject->DistFunctionCall(fixedParam);
+    }
+
+    virtual std::string RayHitCall(const std::string& originParam, const std::string& directionParam) const override
+    {
+        return mObject->RayHitCall(originParam, directionParam);
+    }
+
+    virtual std::string CppDistFunctionCall(const std::string& fixedParam, CppSceneSource& source) const override
+    {
+        return mObject->CppDistFunctionCall(fixedParam, source);
+    }
+
+    virtual float Distance(const Math::Vec3& p, const DistanceContext& context) const override
+    {
+        SceneCompiler::Context compiledContext = SceneCompiler::MakeContext(context, mProgram.Fallbacks);
+        return mProgram.Distance(p.x(), p.y(), p.z(), &compiledContext);
+    }
+
+    virtual void Distances(const PointBatch& batch, float* out, const DistanceContext& context) const override
+    {
+        SceneCompiler::Context compiledContext = SceneCompiler::MakeContext(context, mProgram.Fallbacks);
+        mProgram.Distances(batch.X, batch.Y, batch.Z, batch.Count, out, &compiledContext);
+    }
+
+    virtual Math::Interval DistanceRange(const Math::AABB& box, const DistanceContext& context) const override
+    {
+        return mObject->DistanceRange(box, context);
+    }
+
+    virtual std::optional<Math::AABB> Bounds() const override
+    {
+        return mObject->Bounds();
+    }
+
+    virtual bool IsAnimated() const override
+    {
+        return mObject->IsAnimated();
+    }
+
+    bool IsCurrent() const
+    {
+        return SceneCompiler::Hash(*mObject) == mProgram.Hash;
+    }
+
+    const SceneCompiler::Program& Program() const
+    {
+        return mProgram;
+    }
+private:
+    std::shared_ptr<IShapedObject> mObject;
+    SceneCompiler::Program mProgram;
+};
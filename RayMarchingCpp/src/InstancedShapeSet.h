@@ -0,0 +1,301 @@
+#pragma once
+
+#include "RayMarchingWindow/IShapedObject.h"
+#include "RayMarchingWindow/IInstancedObject.h"
+#include "OpenGL/GLCore.h"
+#include "OpenGL/TextureBuffer.h"
+#include "Math/Math.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+/*
+    Instances of one primitive whose parameters live in a texture buffer
+    instead of uniforms. Generated code depends only on the primitive, so
+    adding or moving instances costs a buffer upload, not a shader rebuild.
+    Each instance takes two texels: position and rotation around Y, size
+*/
+class InstancedShapeSet : public IShapedObject, public IInstancedObject {
+public:
+    enum class Primitive {
+        Sphere,
+        Cube,
+    };
+
+    struct Instance {
+        Math::Vec3 Position;
+        // Radius in x for spheres, half extents for cubes
+        Math::Vec3 Size;
+        float RotationY = 0.0f;
+    };
+public:
+    /*
+        textureSlot is the texture unit the instance buffer is bound to while
+        rendering, it must not be used by the window or other objects
+    */
+    InstancedShapeSet(Primitive primitive, const std::string& name, unsigned int textureSlot)
+        : mPrimitive(primitive), mName(name), mTextureSlot(textureSlot), mBuffer(GL_RGBA32F)
+    {
+    }
+
+    InstancedShapeSet(const InstancedShapeSet&) = delete;
+    InstancedShapeSet& operator=(const InstancedShapeSet&) = delete;
+
+    ~InstancedShapeSet()
+    {
+        mBuffer.Delete();
+    }
+
+    void AddInstance(const Instance& instance)
+    {
+        mInstances.push_back(instance);
+        mUploaded = false;
+    }
+
+    void SetInstances(std::vector<Instance> instances)
+    {
+        mInstances = std::move(instances);
+        mUploaded = false;
+    }
+
+    const std::vector<Instance>& Instances() const
+    {
+        return mInstances;
+    }
+
+    virtual void PassToShader(OpenGL::ShaderProgram& shader) override
+    {
+        if (!mUploaded) {
+            Upload();
+        }
+        mBuffer.Bind(mTextureSlot);
+        shader.SetUniform1i(Name(), mTextureSlot);
+    }
+
+    virtual std::string UniformsDefinitions() const override
+    {
+        return UNIFORM(samplerBuffer, Name());
+    }
+
+    virtual std::string SceneFunctionsDefinitions() const override
+    {
+        std::string primitiveCode = mPrimitive == Primitive::Sphere
+            ? "    return length(local) - size.x;\n"
+            : "    vec3 d = abs(local) - size.xyz;\n"
+              "    return min(max(d.x, max(d.y, d.z)), 0.0) + length(max(d, 0.0));\n";
+        std::string primitiveHit = mPrimitive == Primitive::Sphere
+            ? "SphereHit(origin, direction, vec3(0.0), size.x)"
+            : "BoxHit(origin, direction, vec3(0.0), size.xyz)";
+
+        return DIST_FUNCTION_PROTOTYPE(InstanceDistFunctionName(), int i, vec3 p) + "\n{\n"
+            "    vec4 placement = texelFetch(" + Name() + ", i * 2);\n"
+            "    vec4 size = texelFetch(" + Name() + ", i * 2 + 1);\n"
+            "    vec3 local = p - placement.xyz;\n"
+            "    local.xz *= Rotate(placement.w);\n" +
+            primitiveCode +
+            "}\n" +
+            DIST_FUNCTION_PROTOTYPE(DistFunctionName(), vec3 p) + "\n{\n"
+            "    float dist = MAX_DISTANCE;\n"
+            "    int count = textureSize(" + Name() + ") / 2;\n"
+            "    for (int i = 0; i < count; i++) {\n"
+            "        dist = smin(dist, " + InstanceDistFunctionCall("i", "p") + ", u_SmoothMinValue);\n"
+            "    }\n"
+            "    return dist;\n"
+            "}\n" +
+            "float " + HitFunctionName() + "(vec3 ro, vec3 rd)\n{\n"
+            "    float hit = NO_HIT;\n"
+            "    int count = textureSize(" + Name() + ") / 2;\n"
+            "    for (int i = 0; i < count; i++) {\n"
+            "        vec4 placement = texelFetch(" + Name() + ", i * 2);\n"
+            "        vec4 size = texelFetch(" + Name() + ", i * 2 + 1);\n"
+            "        vec3 origin = ro - placement.xyz;\n"
+            "        vec3 direction = rd;\n"
+            "        origin.xz *= Rotate(placement.w);\n"
+            "        direction.xz *= Rotate(placement.w);\n"
+            "        hit = min(hit, " + primitiveHit + ");\n"
+            "    }\n"
+            "    return hit;\n"
+            "}\n";
+    }
+
+    /*
+        Intersects every instance, rotated into the space of each
+    */
+    virtual std::string RayHitCall(const std::string& originParam, const std::string& directionParam) const override
+    {
+        return HitFunctionName() + '(' + originParam + ", " + directionParam + ')';
+    }
+
+    /*
+        Evaluates all instances in a loop, used when the set isn't in the object grid
+    */
+    virtual std::string DistFunctionCall(const std::string& fixedParam) const override
+    {
+        return DistFunctionName() + '(' + fixedParam + ')';
+    }
+
+    /*
+        Instances are written into the code with the sine and cosine of their rotation
+    */
+    virtual std::string CppDistFunctionCall(const std::string& fixedParam, CppSceneSource& source) const override
+    {
+        if (mInstances.empty()) {
+            return CppSceneSource::Literal(std::numeric_limits<float>::max());
+        }
+        std::string instances;
+        for (const Instance& instance : mInstances) {
+            instances += "    { " + CppSceneSource::Literal(instance.Position) + ", " + CppSceneSource::Literal(instance.Size) + ", " +
+                CppSceneSource::Literal(std::cos(instance.RotationY)) + ", " + CppSceneSource::Literal(std::sin(instance.RotationY)) + " },\n";
+        }
+        std::string distance = mPrimitive == Primitive::Sphere ? "length(local) - instance.Size.x" : "BoxDistance(local, instance.Size)";
+        return source.AddFunction("static const struct { vec3 Position, Size; float Cos, Sin; } instances[] = {\n" + instances + "};\n"
+            "float dist = std::numeric_limits<float>::max();\n"
+            "for (const auto& instance : instances) {\n"
+            "    vec3 d = p - instance.Position;\n"
+            "    vec3 local = { d.x * instance.Cos - d.z * instance.Sin, d.y, d.x * instance.Sin + d.z * instance.Cos };\n"
+            "    dist = SmoothMin(dist, " + distance + ", c.SmoothMin);\n"
+            "}\n"
+            "return dist;", fixedParam);
+    }
+
+    virtual float Distance(const Math::Vec3& p, const DistanceContext& context) const override
+    {
+        float dist = std::numeric_limits<float>::max();
+        for (unsigned int i = 0; i < mInstances.size(); i++) {
+            dist = Math::SmoothMin(dist, InstanceDistance(i, p), context.SmoothMin);
+        }
+        return dist;
+    }
+
+    /*
+        Goes over instances in the outer loop, so the inner one runs over points of the batch
+    */
+    virtual void Distances(const PointBatch& batch, float* out, const DistanceContext& context) const override
+    {
+        std::fill(out, out + batch.Count, std::numeric_limits<float>::max());
+        float dist[PointBatch::sMaxCount];
+        for (const Instance& instance : mInstances) {
+            const float c = std::cos(instance.RotationY), s = std::sin(instance.RotationY);
+            const float px = instance.Position.x(), py = instance.Position.y(), pz = instance.Position.z();
+            const float sx = instance.Size.x(), sy = instance.Size.y(), sz = instance.Size.z();
+            if (mPrimitive == Primitive::Sphere) {
+                batch.Evaluate(dist, [=](auto x, auto y, auto z) {
+                    x = x - px;
+                    y = y - py;
+                    z = z - pz;
+                    return Math::Sqrt(x * x + y * y + z * z) - sx;
+                });
+            } else {
+                batch.Evaluate(dist, [=](auto x, auto y, auto z) {
+                    x = x - px;
+                    y = y - py;
+                    z = z - pz;
+                    return Math::BoxDistance(x * c - z * s, y, x * s + z * c, sx, sy, sz);
+                });
+            }
+            Math::SmoothMin(out, dist, batch.Count, context.SmoothMin);
+        }
+    }
+
+    virtual Math::Interval DistanceRange(const Math::AABB& box, const DistanceContext& context) const override
+    {
+        Math::Interval dist = std::numeric_limits<float>::max();
+        for (unsigned int i = 0; i < mInstances.size(); i++) {
+            dist = Math::SmoothMin(dist, InstanceDistanceRange(i, box), context.SmoothMin);
+        }
+        return dist;
+    }
+
+    virtual std::optional<Math::AABB> Bounds() const override
+    {
+        Math::AABB bounds;
+        for (unsigned int i = 0; i < mInstances.size(); i++) {
+            bounds = bounds.Union(InstanceBounds(i));
+        }
+        return bounds;
+    }
+
+    virtual unsigned int InstanceCount() const override
+    {
+        return static_cast<unsigned int>(mInstances.size());
+    }
+
+    virtual Math::AABB InstanceBounds(unsigned int index) const override
+    {
+        const Instance& instance = mInstances[index];
+        Math::Vec3 extent(instance.Size.x());
+        if (mPrimitive == Primitive::Cube) {
+            float c = std::abs(std::cos(instance.RotationY));
+            float s = std::abs(std::sin(instance.RotationY));
+            extent = Math::Vec3(c * instance.Size.x() + s * instance.Size.z(), instance.Size.y(),
+                s * instance.Size.x() + c * instance.Size.z());
+        }
+        return Math::AABB(instance.Position - extent, instance.Position + extent);
+    }
+
+    virtual std::string InstanceDistFunctionCall(const std::string& indexParam, const std::string& fixedParam) const override
+    {
+        return InstanceDistFunctionName() + '(' + indexParam + ", " + fixedParam + ')';
+    }
+
+    const std::string& Name() const
+    {
+        return mName;
+    }
+private:
+    void Upload()
+    {
+        std::vector<float> texels;
+        texels.reserve(mInstances.size() * 8);
+        for (const Instance& instance : mInstances) {
+            texels.insert(texels.end(), { instance.Position.x(), instance.Position.y(), instance.Position.z(), instance.RotationY,
+                instance.Size.x(), instance.Size.y(), instance.Size.z(), 0.0f });
+        }
+        mBuffer.Update(texels.data(), texels.size() * sizeof(float));
+        mUploaded = true;
+    }
+
+    float InstanceDistance(unsigned int index, const Math::Vec3& p) const
+    {
+        const Instance& instance = mInstances[index];
+        Math::Vec3 local = Math::RotateXZ(p - instance.Position, instance.RotationY);
+        if (mPrimitive == Primitive::Sphere) {
+            return local.Magnitude() - instance.Size.x();
+        }
+        return Math::BoxDistance(local, instance.Size);
+    }
+
+    Math::Interval InstanceDistanceRange(unsigned int index, const Math::AABB& box) const
+    {
+        const Instance& instance = mInstances[index];
+        Math::Interval3 local = Math::RotateXZ(Math::Interval3(box) - instance.Position, instance.RotationY);
+        if (mPrimitive == Primitive::Sphere) {
+            return local.Length() - instance.Size.x();
+        }
+        return Math::BoxDistance(local, instance.Size);
+    }
+
+    std::string DistFunctionName() const
+    {
+        return mName + "Dist";
+    }
+
+    std::string InstanceDistFunctionName() const
+    {
+        return mName + "InstanceDist";
+    }
+
+    std::string HitFunctionName() const
+    {
+        return mName + "Hit";
+    }
+private:
+    const Primitive mPrimitive;
+    const std::string mName;
+    const unsigned int mTextureSlot;
+    OpenGL::TextureBuffer mBuffer;
+    std::vector<Instance> mInstances;
+    bool mUploaded = false;
+};
@@ -2,6 +2,7 @@
 
 #include "RayMarchingWindow/IShapedObject.h"
 #include "RayMarchingWindow/IImGuiEditable.h"
+#include "Math/Math.h"
 
 
 class InterpolatedShapeWrapper : public IShapedObject, public IImGuiEditable {
@@ -23,11 +24,48 @@ public:
         return mFirst->UniformsDefinitions() + mSecond->UniformsDefinitions() + UNIFORM(float, "u_IterpolateGrade");
     }
 
+    virtual std::string SceneFunctionsDefinitions() const override
+    {
+        return mFirst->SceneFunctionsDefinitions() + mSecond->SceneFunctionsDefinitions();
+    }
+
     virtual std::string DistFunctionCall(const std::string& fixedParam) const override
     {
         return "mix(" + mFirst->DistFunctionCall(fixedParam) + ", " + mSecond->DistFunctionCall(fixedParam) + ", clamp(u_IterpolateGrade, 0.0, 1.0))";
     }
 
+    virtual std::string CppDistFunctionCall(const std::string& fixedParam, CppSceneSource& source) const override
+    {
+        return source.AddFunction("return Mix(" + mFirst->CppDistFunctionCall("p", source) + ", " + mSecond->CppDistFunctionCall("p", source) +
+            ", " + CppSceneSource::Literal(std::clamp(mGrade, 0.0f, 1.0f)) + ");", fixedParam);
+    }
+
+    virtual float Distance(const Math::Vec3& p, const DistanceContext& context) const override
+    {
+        return Math::Mix(mFirst->Distance(p, context), mSecond->Distance(p, context), std::clamp(mGrade, 0.0f, 1.0f));
+    }
+
+    virtual Math::Interval DistanceRange(const Math::AABB& box, const DistanceContext& context) const override
+    {
+        return Math::Mix(mFirst->DistanceRange(box, context), mSecond->DistanceRange(box, context), std::clamp(mGrade, 0.0f, 1.0f));
+    }
+
+    virtual bool IsAnimated() const override
+    {
+        return mFirst->IsAnimated() || mSecond->IsAnimated();
+    }
+
+    virtual std::optional<Math::AABB> Bounds() const override
+    {
+        // Blend of two distances is positive wherever both of them are
+        std::optional<Math::AABB> first = mFirst->Bounds();
+        std::optional<Math::AABB> second = mSecond->Bounds();
+        if (first && second) {
+            return first->Union(*second);
+        }
+        return std::nullopt;
+    }
+
     void RenderImGuiEditor()
     {
         ImGui::SliderFloat("grade", &mGrade, 0.0f, 1.0f);
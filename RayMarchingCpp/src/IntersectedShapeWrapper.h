@@ -1,6 +1,7 @@
 #pragma once
 
 #include "RayMarchingWindow/IShapedObject.h"
+#include "Math/Math.h"
 
 
 class IntersectedShapeWrapper : public IShapedObject {
@@ -21,10 +22,45 @@ public:
         return mFirst->UniformsDefinitions() + mSecond->UniformsDefinitions();
     }
 
+    virtual std::string SceneFunctionsDefinitions() const override
+    {
+        return mFirst->SceneFunctionsDefinitions() + mSecond->SceneFunctionsDefinitions();
+    }
+
     virtual std::string DistFunctionCall(const std::string& fixedParam) const override
     {
         return "smin(" + mFirst->DistFunctionCall(fixedParam) + ", " + mSecond->DistFunctionCall(fixedParam) + ", -u_SmoothMinValue)";
     }
+
+    virtual std::string CppDistFunctionCall(const std::string& fixedParam, CppSceneSource& source) const override
+    {
+        return source.AddFunction("return SmoothMin(" + mFirst->CppDistFunctionCall("p", source) + ", " +
+            mSecond->CppDistFunctionCall("p", source) + ", -c.SmoothMin);", fixedParam);
+    }
+    virtual float Distance(const Math::Vec3& p, const DistanceContext& context) const override
+    {
+        return Math::SmoothMin(mFirst->Distance(p, context), mSecond->Distance(p, context), -context.SmoothMin);
+    }
+
+    virtual Math::Interval DistanceRange(const Math::AABB& box, const DistanceContext& context) const override
+    {
+        return Math::SmoothMin(mFirst->DistanceRange(box, context), mSecond->DistanceRange(box, context), -context.SmoothMin);
+    }
+
+    virtual bool IsAnimated() const override
+    {
+        return mFirst->IsAnimated() || mSecond->IsAnimated();
+    }
+
+    virtual std::optional<Math::AABB> Bounds() const override
+    {
+        std::optional<Math::AABB> first = mFirst->Bounds();
+        std::optional<Math::AABB> second = mSecond->Bounds();
+        if (first && second) {
+            return first->Intersection(*second);
+        }
+        return first ? first : second;
+    }
 private:
     std::shared_ptr<IShapedObject> mFirst;
     std::shared_ptr<IShapedObject> mSecond;
@@ -8,11 +8,32 @@
 #include "InterpolatedShapeWrapper.h"
 #include "SinSphere.h"
 #include "VaseShape.h"
+#include "RepeatedSpaceWrapper.h"
+#include "InstancedShapeSet.h"
+#include "BrickMapShapeWrapper.h"
 
-int main(void)
-{
-    std::unique_ptr<RayMarchingWindow> window = RayMarchingWindow::Create("Ray Marching", 1280, 720);
+#include "RayMarchingWindow/SceneFile.h"
+#include "RayMarchingWindow/RenderServer.h"
+#include "RayMarchingWindow/TileCoordinator.h"
+#include "RayMarchingWindow/ImageWriter.h"
+
+#include "Benchmark/BenchmarkWindow.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string_view>
+
+/*
+    The benchmarks add a ring of instanced cubes to the scene, to measure
+    and check instanced sets in it
+*/
+static void BuildScene(RayMarchingWindow* window, bool cubeRing)
+{
     auto plane = std::make_shared<PlaneShape>(0.0f, "u_PlaneObj");
     float x = 0.0f;
     float y = 1.8f;
@@ -22,11 +43,17 @@ int main(void)
     auto cube = std::make_shared<CubeShape>(Math::Vec4(x, y, z, 0.75f), "u_CubeObj");
 
     auto vase = std::make_shared<VaseShape>(Math::Vec4(x, 0.0f, z, 1.0f), "u_VaseObj");
+    // Vase is static and costly to evaluate, so it's marched through a brick map cached between runs
+    auto bakedVase = std::make_shared<BrickMapShapeWrapper>(vase, "u_BakedVase", RayMarchingWindow::sFirstObjectTextureSlot + 1, 128, 8,
+        "cache/u_BakedVase.bricks");
 
     auto sinSphere1 = std::make_shared<SinSphereShape>(Math::Vec4(x, y, z, 1.0f), "u_SinSphereObj");
     auto croppedSin = std::make_shared<CroppedShapeWrapper>(sphere, sinSphere1);
     auto croppedSinCube = std::make_shared<InterpolatedShapeWrapper>(cube, croppedSin, 0.5f);
 
+    auto repeated = std::make_shared<RepeatedSpaceWrapper>(std::vector<std::shared_ptr<IShapedObject>>{ croppedSinCube, bakedVase },
+        Math::Vec4(x, 0.0f, z, 25.0f), "u_RepeatedSpace");
+
     window->RegisterNewShape<PlaneShape>();
     window->RegisterNewShape<SphereShape>();
     window->RegisterNewShape<CubeShape>();
@@ -34,15 +61,362 @@ int main(void)
     window->RegisterNewShape<VaseShape>();
 
     window->RegisterNewObject(plane);
-    window->RegisterNewObject(croppedSinCube);
-    window->RegisterNewObject(vase);
+    window->RegisterNewObject(repeated);
 
     window->RegisterEditableObject(sphere);
     window->RegisterEditableObject(cube);
     window->RegisterEditableObject(sinSphere1);
     window->RegisterEditableObject(croppedSinCube);
     window->RegisterEditableObject(vase);
+    window->RegisterEditableObject(bakedVase);
+    window->RegisterEditableObject(repeated);
+
+    window->RegisterBakedObject(bakedVase);
+
+    if (cubeRing) {
+        // Small cubes around the scene center facing it
+        auto ring = std::make_shared<InstancedShapeSet>(InstancedShapeSet::Primitive::Cube, "u_CubeRing", RayMarchingWindow::sFirstObjectTextureSlot);
+        const unsigned int ringSize = 32;
+        for (unsigned int i = 0; i < ringSize; i++) {
+            float angle = 6.2831853f * i / ringSize;
+            ring->AddInstance({ Math::Vec3(x + std::cos(angle) * 4.0f, 0.25f, z + std::sin(angle) * 4.0f), Math::Vec3(0.1f, 0.25f, 0.25f),
+                angle });
+        }
+        window->RegisterNewObject(ring);
+    }
+}
+
+/*
+    Scene of "--scene <file>" among the arguments or the built-in one. Text
+    scenes are kept in binary form under cache/ for the next runs
+*/
+static bool SetUpScene(RayMarchingWindow* window, int argc, char** argv, bool cubeRing = false)
+{
+    StartupProfiler::Scope scope = window->GetStartupProfiler().Measure("scene setup");
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::string_view(argv[i]) != "--scene") {
+            continue;
+        }
+        std::string path = argv[i + 1];
+        std::string log;
+        std::optional<SceneFile> scene = SceneFile::Load(path, SceneFile::CachePath(path, "cache"), &log);
+        if (!scene || !scene->Build(*window, &log)) {
+            std::cerr << "[SceneFile] " << path << ": " << log << '\n';
+            return false;
+        }
+        return true;
+    }
+    BuildScene(window, cubeRing);
+    return true;
+}
 
+int main(int argc, char** argv)
+{
+    if (argc > 1 && std::string_view(argv[1]) == "--benchmark") {
+        std::unique_ptr<BenchmarkWindow> window = RayMarchingWindow::Create<BenchmarkWindow>("Ray Marching Benchmark", 1280, 720);
+        if (!SetUpScene(window.get(), argc, argv, true)) {
+            return 1;
+        }
+        window->Run();
+        return window->Failed() ? 1 : 0;
+    }
+
+    if (argc > 3 && std::string_view(argv[1]) == "--compile-scene") {
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        std::string log;
+        std::optional<SceneFile> scene = SceneFile::Load(argv[2], "", &log);
+        if (!scene || !scene->Save(argv[3])) {
+            std::cerr << "Couldn't compile " << argv[2] << (log.empty() ? "" : ": " + log) << '\n';
+            return 1;
+        }
+        const SceneFile::Header& header = scene->GetHeader();
+        std::cout << "Compiled " << header.NodeCount << " objects, " << header.InstanceCount << " instances to " << scene->SizeInBytes()
+            << " bytes in " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count() << " ms\n";
+        return 0;
+    }
+
+    if (argc > 2 && std::string_view(argv[1]) == "--export-mesh") {
+        std::unique_ptr<RayMarchingWindow> window = RayMarchingWindow::Create("Ray Marching Mesh Export", 1280, 720);
+        if (!SetUpScene(window.get(), argc, argv)) {
+            return 1;
+        }
+        unsigned int resolution = argc > 3 ? static_cast<unsigned int>(std::strtoul(argv[3], nullptr, 10)) : 512;
+        bool dualContouring = false;
+        for (int i = 4; i < argc; i++) {
+            dualContouring = dualContouring || std::string_view(argv[i]) == "--dual";
+            if (std::string_view(argv[i]) == "--native") {
+                window->SetNativeCpuScene(true);
+            }
+        }
+        std::optional<MeshExporter::Stats> stats = window->ExportMesh(argv[2], resolution, dualContouring);
+        if (!stats) {
+            std::cerr << "Couldn't write " << argv[2] << '\n';
+            return 1;
+        }
+        std::cout << "Exported " << stats->VertexCount << " vertices, " << stats->TriangleCount << " triangles in "
+            << stats->Milliseconds << " ms\n";
+        return 0;
+    }
+
+    // --stream takes the same options as --render-sequence plus --rgba and --drop
+    // --aa or --ssaa antialias frames adaptively or by uniform supersampling, --aa-rays n caps rays --aa adds to a frame
+    bool stream = argc > 1 && std::string_view(argv[1]) == "--stream";
+    if (argc > 3 && (stream || std::string_view(argv[1]) == "--render-sequence")) {
+        RayMarchingWindow::SequenceSettings settings;
+        (stream ? settings.StreamPath : settings.Directory) = argv[2];
+        settings.FrameCount = static_cast<unsigned int>(std::strtoul(argv[3], nullptr, 10));
+        unsigned int width = 1280;
+        unsigned int height = 720;
+        bool native = false;
+        for (int i = 4; i < argc; i++) {
+            std::string_view option(argv[i]);
+            const char* value = i + 1 < argc ? argv[i + 1] : "0";
+            if (option == "--fps") {
+                float fps = std::strtof(value, nullptr);
+                if (!(fps > 0.0f) || !std::isfinite(fps)) {
+                    std::cerr << "--fps needs a frame rate above 0\n";
+                    return 1;
+                }
+                settings.TimeStep = 1.0f / fps;
+                i++;
+            } else if (option == "--start") {
+                settings.StartTime = std::strtof(value, nullptr);
+                i++;
+            } else if (option == "--size") {
+                width = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+                height = static_cast<unsigned int>(std::strtoul(i + 2 < argc ? argv[i + 2] : "0", nullptr, 10));
+                if (width == 0 || height == 0) {
+                    std::cerr << "--size needs a width and a height above 0\n";
+                    return 1;
+                }
+                i += 2;
+            } else if (option == "--tier") {
+                settings.QualityTierIndex = std::min(static_cast<unsigned int>(std::strtoul(value, nullptr, 10)),
+                    static_cast<unsigned int>(QualityTier::Tiers().size() - 1));
+                i++;
+            } else if (option == "--encoders") {
+                settings.EncoderThreads = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+                i++;
+            } else if (option == "--queue") {
+                settings.QueueCapacity = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+                i++;
+            } else if (option == "--aa-rays") {
+                settings.Antialias.MaxExtraRays = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+                i++;
+            } else {
+                settings.Antialias.Mode = option == "--aa" ? RayMarchingWindow::Antialiasing::Adaptive : settings.Antialias.Mode;
+                settings.Antialias.Mode = option == "--ssaa" ? RayMarchingWindow::Antialiasing::Uniform : settings.Antialias.Mode;
+                settings.Format = option == "--exr" ? FrameEncoderPool::Format::Exr : settings.Format;
+                settings.Cpu = settings.Cpu || option == "--cpu";
+                settings.Turntable = settings.Turntable || option == "--turntable";
+                settings.StreamFormat = option == "--rgba" ? FrameStreamer::Format::Rgba : settings.StreamFormat;
+                settings.StreamPolicy = option == "--drop" ? FrameStreamer::Policy::Drop : settings.StreamPolicy;
+                native = native || option == "--native";
+            }
+        }
+        if (settings.StreamPath == "-") {
+            // Logs go to stderr, stdout carries only frames
+            std::cout.rdbuf(std::cerr.rdbuf());
+        }
+#ifdef SIGPIPE
+        // A reader going away fails the next write instead of ending the process
+        std::signal(SIGPIPE, SIG_IGN);
+#endif
+        std::unique_ptr<RayMarchingWindow> window = RayMarchingWindow::Create("Ray Marching Sequence", width, height, false);
+        if (!SetUpScene(window.get(), argc, argv)) {
+            return 1;
+        }
+        window->SetNativeCpuScene(native);
+        std::optional<RayMarchingWindow::SequenceStats> stats = window->RenderSequence(settings);
+        if (!stats) {
+            std::cerr << "Couldn't render to " << argv[2] << '\n';
+            return 1;
+        }
+        if (stream) {
+            const FrameStreamer::Stats& streamed = stats->Stream;
+            uint64_t frames = std::max<uint64_t>(streamed.Frames, 1);
+            std::cout << "Streamed " << streamed.Frames << " frames, " << streamed.Bytes / (1024.0 * 1024.0) << " MB in "
+                << stats->Milliseconds << " ms, " << stats->FramesPerSecond() << " fps sustained\n"
+                << "  render " << stats->RenderMilliseconds / frames << " ms/frame, convert " << streamed.ConvertMilliseconds / frames
+                << " ms/frame, write " << streamed.WriteMilliseconds / frames << " ms/frame, " << stats->FrameSlots << " frame slots\n"
+                << "  back-pressure: " << streamed.StalledFrames << " frames waited " << streamed.WaitMilliseconds << " ms, "
+                << streamed.DroppedFrames << " dropped, queue peaked at " << streamed.MaxQueued << '\n';
+            if (streamed.Failures > 0) {
+                std::cerr << "Writing the stream failed\n";
+                return 1;
+            }
+            return 0;
+        }
+        const FrameEncoderPool::Stats& encoder = stats->Encoder;
+        std::cout << "Rendered " << encoder.Frames << " frames in " << stats->Milliseconds << " ms, " << stats->FramesPerSecond()
+            << " fps sustained\n"
+            << "  render " << stats->RenderMilliseconds / std::max<uint64_t>(encoder.Frames, 1) << " ms/frame, encode "
+            << encoder.EncodeMilliseconds / std::max<uint64_t>(encoder.Frames, 1) << " ms/frame on " << stats->EncoderThreads << " threads, "
+            << stats->FrameSlots << " frame slots\n"
+            << "  back-pressure: " << encoder.StalledFrames << " frames waited " << encoder.WaitMilliseconds
+            << " ms for a free slot, queue peaked at " << encoder.MaxQueued << '\n';
+        if (!settings.Cpu) {
+            std::cout << "  readback: " << stats->Readback.StalledFrames << " frames waited " << stats->Readback.WaitMilliseconds
+                << " ms for their copy\n";
+        }
+        if (encoder.Failures > 0) {
+            std::cerr << encoder.Failures << " frames couldn't be written\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    // --render-progressive <directory> [--size w h] [--tier n] [--time t] [--stop-after step] [--scene file]
+    if (argc > 2 && std::string_view(argv[1]) == "--render-progressive") {
+        unsigned int width = 1280;
+        unsigned int height = 720;
+        unsigned int tier = 1;
+        unsigned int stopStep = 1;
+        float time = 0.0f;
+        for (int i = 3; i + 1 < argc; i++) {
+            std::string_view option(argv[i]);
+            const char* value = argv[i + 1];
+            if (option == "--size" && i + 2 < argc) {
+                width = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+                height = static_cast<unsigned int>(std::strtoul(argv[++i + 1], nullptr, 10));
+            } else if (option == "--tier") {
+                tier = std::min(static_cast<unsigned int>(std::strtoul(value, nullptr, 10)), static_cast<unsigned int>(QualityTier::Tiers().size() - 1));
+            } else if (option == "--time") {
+                time = std::strtof(value, nullptr);
+            } else if (option == "--stop-after") {
+                stopStep = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+            } else {
+                continue;
+            }
+            i++;
+        }
+        std::error_code error;
+        std::filesystem::create_directories(argv[2], error);
+        std::unique_ptr<RayMarchingWindow> window = RayMarchingWindow::Create("Ray Marching Progressive", width, height, false);
+        if (!SetUpScene(window.get(), argc, argv)) {
+            return 1;
+        }
+        // Previews are written while finer levels render
+        FrameEncoderPool encoders(FrameEncoderPool::Format::Png);
+        std::optional<RayMarchingWindow::ProgressiveStats> stats = window->RenderProgressive(time, tier,
+            [&](unsigned int step, const unsigned char* pixels) {
+                FrameEncoderPool::Frame& frame = encoders.Acquire();
+                frame.Path = (std::filesystem::path(argv[2]) / ("preview_" + std::to_string(step) + ".png")).string();
+                frame.Width = width;
+                frame.Height = height;
+                frame.Pixels.assign(pixels, pixels + static_cast<size_t>(width) * height * 4);
+                encoders.Submit(frame);
+                return step > stopStep;
+            });
+        FrameEncoderPool::Stats written = encoders.Finish();
+        if (!stats || written.Failures > 0) {
+            std::cerr << "Couldn't render to " << argv[2] << '\n';
+            return 1;
+        }
+        for (size_t i = 0; i < stats->Steps.size(); i++) {
+            std::cout << "Every " << stats->Steps[i] << (stats->Steps[i] == 1 ? " pixel" : " pixels") << " ready in "
+                << stats->LevelMilliseconds[i] << " ms\n";
+        }
+        std::cout << (stats->Interrupted ? "Stopped" : "Finished") << " in " << stats->Milliseconds << " ms\n";
+        return 0;
+    }
+
+    // --serve <socket path|tcp:port> [--batch n] [--queue n] [--scenes n] [--programs n]
+    if (argc > 2 && std::string_view(argv[1]) == "--serve") {
+        RenderServer::Settings settings;
+        settings.Address = argv[2];
+        for (int i = 3; i + 1 < argc; i++) {
+            std::string_view option(argv[i]);
+            size_t value = std::strtoul(argv[i + 1], nullptr, 10);
+            if (option == "--batch") {
+                settings.MaxBatch = value;
+            } else if (option == "--queue") {
+                settings.QueueCapacity = value;
+            } else if (option == "--scenes") {
+                settings.SceneCapacity = value;
+            } else if (option == "--programs") {
+                settings.ProgramCapacity = value;
+            } else {
+                continue;
+            }
+            i++;
+        }
+#ifdef SIGPIPE
+        // A client going away fails the next write instead of ending the process
+        std::signal(SIGPIPE, SIG_IGN);
+#endif
+        std::unique_ptr<RayMarchingWindow> window = RayMarchingWindow::Create("Ray Marching Server", 1280, 720, false);
+        if (!SetUpScene(window.get(), argc, argv)) {
+            return 1;
+        }
+        RenderServer server(settings);
+        if (!server.IsOpen()) {
+            return 1;
+        }
+        std::cout << "Serving on " << settings.Address << '\n' << std::flush;
+        server.Run(*window);
+        server.Report(std::cout);
+        return 0;
+    }
+
+    // --render-tiles <png path> [--workers n] [--tile n] [--size w h] [--tier n] [--time t] [--scene file]
+    if (argc > 2 && std::string_view(argv[1]) == "--render-tiles") {
+        TileCoordinator::Settings settings;
+        TileCoordinator::Frame frame;
+        frame.Scene = "res/scenes/Main.scene";
+        frame.Width = 3840;
+        frame.Height = 2160;
+        frame.Camera = Math::Vec3(0.0f, 1.0f, 0.0f);
+        for (int i = 3; i + 1 < argc; i++) {
+            std::string_view option(argv[i]);
+            const char* value = argv[i + 1];
+            if (option == "--workers") {
+                settings.Workers = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+            } else if (option == "--tile") {
+                settings.TileSize = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+            } else if (option == "--size" && i + 2 < argc) {
+                frame.Width = static_cast<unsigned int>(std::strtoul(value, nullptr, 10));
+                frame.Height = static_cast<unsigned int>(std::strtoul(argv[++i + 1], nullptr, 10));
+            } else if (option == "--tier") {
+                frame.Tier = static_cast<int>(std::min(std::strtoul(value, nullptr, 10), QualityTier::Tiers().size() - 1));
+            } else if (option == "--time") {
+                frame.Time = std::strtof(value, nullptr);
+            } else if (option == "--scene") {
+                frame.Scene = value;
+            } else {
+                continue;
+            }
+            i++;
+        }
+#ifdef SIGPIPE
+        std::signal(SIGPIPE, SIG_IGN);
+#endif
+        TileCoordinator coordinator(settings);
+        if (coordinator.ConnectedWorkers() == 0) {
+            std::cerr << "No worker could be started\n";
+            return 1;
+        }
+        TileCoordinator::Stats stats;
+        std::optional<std::vector<uint8_t>> image = coordinator.Render(frame, &stats);
+        if (!image || !ImageWriter::WritePng(argv[2], frame.Width, frame.Height, image->data())) {
+            std::cerr << "Couldn't render to " << argv[2] << '\n';
+            return 1;
+        }
+        std::cout << "Rendered " << frame.Width << "x" << frame.Height << " as " << stats.Tiles << " tiles on "
+            << coordinator.ConnectedWorkers() << " workers in " << stats.Milliseconds << " ms, workers started in "
+            << coordinator.StartMilliseconds() << " ms\n  mean tile " << stats.MeanTileMilliseconds << " ms, tiles per worker";
+        for (unsigned int tiles : stats.WorkerTiles) {
+            std::cout << ' ' << tiles;
+        }
+        std::cout << ", " << stats.Reassigned << " reassigned (" << stats.ReassignedWon << " finished first), " << stats.LostWorkers
+            << " workers lost\n";
+        return 0;
+    }
+
+    std::unique_ptr<RayMarchingWindow> window = RayMarchingWindow::Create("Ray Marching", 1280, 720);
+    if (!SetUpScene(window.get(), argc, argv)) {
+        return 1;
+    }
     window->Run();
 
     return(0);
@@ -0,0 +1,113 @@
+#include "AABB.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace Math;
+
+AABB::AABB() : mMin(std::numeric_limits<float>::max()), mMax(std::numeric_limits<float>::lowest())
+{
+}
+
+AABB::AABB(const Vec3& min, const Vec3& max) : mMin(min), mMax(max)
+{
+}
+
+const Vec3& AABB::Min() const
+{
+    return mMin;
+}
+
+const Vec3& AABB::Max() const
+{
+    return mMax;
+}
+
+Vec3 AABB::Size() const
+{
+    return IsEmpty() ? Vec3(0.0f) : mMax - mMin;
+}
+
+Vec3 AABB::Center() const
+{
+    return (mMin + mMax) * 0.5f;
+}
+
+bool AABB::IsEmpty() const
+{
+    return mMin.x() > mMax.x() || mMin.y() > mMax.y() || mMin.z() > mMax.z();
+}
+
+bool AABB::operator==(const AABB& other) const
+{
+    for (unsigned int i = 0; i < 3; i++) {
+        if (mMin[i] != other.mMin[i] || mMax[i] != other.mMax[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool AABB::operator!=(const AABB& other) const
+{
+    return !(*this == other);
+}
+
+AABB AABB::Union(const AABB& other) const
+{
+    AABB result;
+    for (unsigned int i = 0; i < 3; i++) {
+        result.mMin[i] = std::min(mMin[i], other.mMin[i]);
+        result.mMax[i] = std::max(mMax[i], other.mMax[i]);
+    }
+    return result;
+}
+
+AABB AABB::Intersection(const AABB& other) const
+{
+    AABB result;
+    for (unsigned int i = 0; i < 3; i++) {
+        result.mMin[i] = std::max(mMin[i], other.mMin[i]);
+        result.mMax[i] = std::min(mMax[i], other.mMax[i]);
+    }
+    return result;
+}
+
+AABB AABB::Expand(float value) const
+{
+    if (IsEmpty()) {
+        return *this;
+    }
+    return AABB(mMin - value, mMax + value);
+}
+
+bool AABB::Contains(const Vec3& point) const
+{
+    for (unsigned int i = 0; i < 3; i++) {
+        if (point[i] < mMin[i] || point[i] > mMax[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool AABB::Overlaps(const AABB& other) const
+{
+    return !Intersection(other).IsEmpty();
+}
+
+float AABB::Distance(const Vec3& point) const
+{
+    Vec3 outside;
+    for (unsigned int i = 0; i < 3; i++) {
+        outside[i] = std::max({ mMin[i] - point[i], point[i] - mMax[i], 0.0f });
+    }
+    return outside.Magnitude();
+}
+
+std::ostream& Math::operator<<(std::ostream& out, const AABB& box)
+{
+    out << "[" << box.Min() << ", " << box.Max() << "]";
+    return out;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <iostream>
+
+#include "Vec3.h"
+
+namespace Math {
+
+    /*
+        Axis-aligned bounding box, default constructed box is empty
+    */
+    class AABB {
+    public:
+        AABB();
+        AABB(const Vec3& min, const Vec3& max);
+
+        const Vec3& Min() const;
+        const Vec3& Max() const;
+        Vec3 Size() const;
+        Vec3 Center() const;
+        bool IsEmpty() const;
+
+        bool operator==(const AABB& other) const;
+        bool operator!=(const AABB& other) const;
+
+        AABB Union(const AABB& other) const;
+        AABB Intersection(const AABB& other) const;
+        AABB Expand(float value) const;
+        bool Contains(const Vec3& point) const;
+        bool Overlaps(const AABB& other) const;
+        /*
+            Distance from point to the box, 0 for points inside
+        */
+        float Distance(const Vec3& point) const;
+    private:
+        Vec3 mMin;
+        Vec3 mMax;
+    };
+
+    std::ostream& operator<<(std::ostream& out, const AABB& box);
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#include <emmintrin.h>
+#define MATH_FLOAT4_SSE
+#endif
+
+namespace Math {
+
+    /*
+        Four floats computed at once with SSE, or one by one where it isn't
+        available. Abs, Min, Max and Sqrt have float overloads next to the
+        Float4 ones, so a kernel written as a generic lambda runs on both,
+        see PointBatch::Evaluate
+    */
+    class Float4 {
+    public:
+        Float4() = default;
+        Float4(float value)
+        {
+#ifdef MATH_FLOAT4_SSE
+            mValue = _mm_set1_ps(value);
+#else
+            std::fill(mValue, mValue + 4, value);
+#endif
+        }
+
+        static Float4 Load(const float* data)
+        {
+            Float4 result;
+#ifdef MATH_FLOAT4_SSE
+            result.mValue = _mm_loadu_ps(data);
+#else
+            std::copy(data, data + 4, result.mValue);
+#endif
+            return result;
+        }
+
+        void Store(float* data) const
+        {
+#ifdef MATH_FLOAT4_SSE
+            _mm_storeu_ps(data, mValue);
+#else
+            std::copy(mValue, mValue + 4, data);
+#endif
+        }
+
+#ifdef MATH_FLOAT4_SSE
+#define MATH_FLOAT4_BINARY(name, sseFunction, scalarCode) \
+        friend Float4 name(const Float4& a, const Float4& b) { Float4 r; r.mValue = sseFunction(a.mValue, b.mValue); return r; }
+#define MATH_FLOAT4_UNARY(name, sseCode, scalarCode) \
+        friend Float4 name(const Float4& a) { Float4 r; r.mValue = sseCode; return r; }
+#else
+#define MATH_FLOAT4_BINARY(name, sseFunction, scalarCode) \
+        friend Float4 name(const Float4& a, const Float4& b) \
+        { Float4 r; for (int i = 0; i < 4; i++) { float x = a.mValue[i], y = b.mValue[i]; r.mValue[i] = scalarCode; } return r; }
+#define MATH_FLOAT4_UNARY(name, sseCode, scalarCode) \
+        friend Float4 name(const Float4& a) { Float4 r; for (int i = 0; i < 4; i++) { float x = a.mValue[i]; r.mValue[i] = scalarCode; } return r; }
+#endif
+        MATH_FLOAT4_BINARY(operator+, _mm_add_ps, x + y)
+        MATH_FLOAT4_BINARY(operator-, _mm_sub_ps, x - y)
+        MATH_FLOAT4_BINARY(operator*, _mm_mul_ps, x * y)
+        MATH_FLOAT4_BINARY(operator/, _mm_div_ps, x / y)
+        // Same operand order as std::min and std::max, a is returned for NaN b
+        MATH_FLOAT4_BINARY(Min, [](__m128 x, __m128 y) { return _mm_min_ps(y, x); }, std::min(x, y))
+        MATH_FLOAT4_BINARY(Max, [](__m128 x, __m128 y) { return _mm_max_ps(y, x); }, std::max(x, y))
+        MATH_FLOAT4_UNARY(operator-, _mm_sub_ps(_mm_setzero_ps(), a.mValue), -x)
+        MATH_FLOAT4_UNARY(Abs, _mm_andnot_ps(_mm_set1_ps(-0.0f), a.mValue), std::abs(x))
+        MATH_FLOAT4_UNARY(Sqrt, _mm_sqrt_ps(a.mValue), std::sqrt(x))
+#undef MATH_FLOAT4_BINARY
+#undef MATH_FLOAT4_UNARY
+    private:
+#ifdef MATH_FLOAT4_SSE
+        __m128 mValue;
+#else
+        float mValue[4];
+#endif
+    };
+
+    // Friends are only found by argument lookup, these make Math::Sqrt(x) work too
+    Float4 Min(const Float4& a, const Float4& b);
+    Float4 Max(const Float4& a, const Float4& b);
+    Float4 Abs(const Float4& a);
+    Float4 Sqrt(const Float4& a);
+
+    /*
+        Lane by lane, SSE has no sine, so results are the same as for floats
+    */
+    inline Float4 Sin(const Float4& a)
+    {
+        float values[4];
+        a.Store(values);
+        for (float& value : values) {
+            value = std::sin(value);
+        }
+        return Float4::Load(values);
+    }
+
+    inline Float4 Cos(const Float4& a)
+    {
+        float values[4];
+        a.Store(values);
+        for (float& value : values) {
+            value = std::cos(value);
+        }
+        return Float4::Load(values);
+    }
+
+    inline float Min(float a, float b)
+    {
+        return std::min(a, b);
+    }
+
+    inline float Max(float a, float b)
+    {
+        return std::max(a, b);
+    }
+
+    inline float Abs(float x)
+    {
+        return std::abs(x);
+    }
+
+    inline float Sqrt(float x)
+    {
+        return std::sqrt(x);
+    }
+
+}
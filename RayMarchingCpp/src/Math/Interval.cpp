@@ -0,0 +1,252 @@
+#include "Interval.h"
+#include "ShaderFunctions.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace Math;
+
+static constexpr float sPi = 3.14159265f;
+static constexpr float sTwoPi = 2.0f * sPi;
+
+Interval::Interval() : mMin(0.0f), mMax(0.0f)
+{
+}
+
+Interval::Interval(float value) : mMin(value), mMax(value)
+{
+}
+
+Interval::Interval(float min, float max) : mMin(min), mMax(max)
+{
+}
+
+float Interval::Min() const
+{
+    return mMin;
+}
+
+float Interval::Max() const
+{
+    return mMax;
+}
+
+float Interval::Width() const
+{
+    return mMax - mMin;
+}
+
+bool Interval::Contains(float value) const
+{
+    return value >= mMin && value <= mMax;
+}
+
+bool Interval::Overlaps(const Interval& other) const
+{
+    return mMin <= other.mMax && other.mMin <= mMax;
+}
+
+Interval Interval::Union(const Interval& other) const
+{
+    return Interval(std::min(mMin, other.mMin), std::max(mMax, other.mMax));
+}
+
+Interval Interval::operator-() const
+{
+    return Interval(-mMax, -mMin);
+}
+
+Interval Interval::operator+(const Interval& other) const
+{
+    return Interval(mMin + other.mMin, mMax + other.mMax);
+}
+
+Interval Interval::operator-(const Interval& other) const
+{
+    return Interval(mMin - other.mMax, mMax - other.mMin);
+}
+
+Interval Interval::operator*(const Interval& other) const
+{
+    float products[] = { mMin * other.mMin, mMin * other.mMax, mMax * other.mMin, mMax * other.mMax };
+    return Interval(*std::min_element(std::begin(products), std::end(products)), *std::max_element(std::begin(products), std::end(products)));
+}
+
+Interval Interval::operator/(const Interval& other) const
+{
+    if (other.Contains(0.0f)) {
+        return Interval(-std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity());
+    }
+    return *this * Interval(1.0f / other.mMax, 1.0f / other.mMin);
+}
+
+std::ostream& Math::operator<<(std::ostream& out, const Interval& interval)
+{
+    out << "[" << interval.Min() << ", " << interval.Max() << "]";
+    return out;
+}
+
+Interval Math::Abs(const Interval& x)
+{
+    if (x.Min() >= 0.0f) {
+        return x;
+    }
+    if (x.Max() <= 0.0f) {
+        return -x;
+    }
+    return Interval(0.0f, std::max(-x.Min(), x.Max()));
+}
+
+Interval Math::Min(const Interval& a, const Interval& b)
+{
+    return Interval(std::min(a.Min(), b.Min()), std::min(a.Max(), b.Max()));
+}
+
+Interval Math::Max(const Interval& a, const Interval& b)
+{
+    return Interval(std::max(a.Min(), b.Min()), std::max(a.Max(), b.Max()));
+}
+
+Interval Math::Square(const Interval& x)
+{
+    Interval magnitude = Abs(x);
+    return Interval(magnitude.Min() * magnitude.Min(), magnitude.Max() * magnitude.Max());
+}
+
+Interval Math::Sqrt(const Interval& x)
+{
+    return Interval(std::sqrt(std::max(x.Min(), 0.0f)), std::sqrt(std::max(x.Max(), 0.0f)));
+}
+
+Interval Math::Floor(const Interval& x)
+{
+    return Interval(std::floor(x.Min()), std::floor(x.Max()));
+}
+
+Interval Math::Sin(const Interval& x)
+{
+    if (x.Width() >= sTwoPi) {
+        return Interval(-1.0f, 1.0f);
+    }
+
+    float first = std::sin(x.Min());
+    float last = std::sin(x.Max());
+    Interval result(std::min(first, last), std::max(first, last));
+
+    // Extremes inside the range are at pi/2 + 2k*pi and -pi/2 + 2k*pi
+    float maximum = sPi * 0.5f + sTwoPi * std::ceil((x.Min() - sPi * 0.5f) / sTwoPi);
+    if (maximum <= x.Max()) {
+        result = result.Union(1.0f);
+    }
+    float minimum = -sPi * 0.5f + sTwoPi * std::ceil((x.Min() + sPi * 0.5f) / sTwoPi);
+    if (minimum <= x.Max()) {
+        result = result.Union(-1.0f);
+    }
+    return result;
+}
+
+Interval Math::Cos(const Interval& x)
+{
+    return Sin(x + sPi * 0.5f);
+}
+
+Interval Math::Clamp(const Interval& x, float min, float max)
+{
+    return Interval(std::clamp(x.Min(), min, max), std::clamp(x.Max(), min, max));
+}
+
+Interval Math::Mod(const Interval& x, float y)
+{
+    float period = std::floor(x.Min() / y);
+    if (std::floor(x.Max() / y) != period) {
+        return Interval(0.0f, y);
+    }
+    return Interval(x.Min() - y * period, x.Max() - y * period);
+}
+
+Interval Math::Mix(const Interval& x, const Interval& y, const Interval& a)
+{
+    return x + (y - x) * a;
+}
+
+Interval Math::SmoothStep(float edge0, float edge1, const Interval& x)
+{
+    // Monotonic in x, increasing or decreasing depending on the edges order
+    float first = Math::SmoothStep(edge0, edge1, x.Min());
+    float last = Math::SmoothStep(edge0, edge1, x.Max());
+    return Interval(std::min(first, last), std::max(first, last));
+}
+
+Interval Math::SmoothMin(const Interval& a, const Interval& b, float d)
+{
+    return Interval(Math::SmoothMin(a.Min(), b.Min(), d), Math::SmoothMin(a.Max(), b.Max(), d));
+}
+
+Interval3::Interval3(const Interval& x, const Interval& y, const Interval& z) : mX(x), mY(y), mZ(z)
+{
+}
+
+Interval3::Interval3(const AABB& box)
+    : mX(box.Min().x(), box.Max().x()), mY(box.Min().y(), box.Max().y()), mZ(box.Min().z(), box.Max().z())
+{
+}
+
+Interval& Interval3::x()
+{
+    return mX;
+}
+
+const Interval& Interval3::x() const
+{
+    return mX;
+}
+
+Interval& Interval3::y()
+{
+    return mY;
+}
+
+const Interval& Interval3::y() const
+{
+    return mY;
+}
+
+Interval& Interval3::z()
+{
+    return mZ;
+}
+
+const Interval& Interval3::z() const
+{
+    return mZ;
+}
+
+Interval3 Interval3::operator+(const Vec3& offset) const
+{
+    return Interval3(mX + offset.x(), mY + offset.y(), mZ + offset.z());
+}
+
+Interval3 Interval3::operator-(const Vec3& offset) const
+{
+    return Interval3(mX - offset.x(), mY - offset.y(), mZ - offset.z());
+}
+
+Interval Interval3::Length() const
+{
+    return Sqrt(Square(mX) + Square(mY) + Square(mZ));
+}
+
+Interval3 Math::RotateXZ(const Interval3& p, const Interval& angle)
+{
+    Interval c = Cos(angle);
+    Interval s = Sin(angle);
+    return Interval3(p.x() * c - p.z() * s, p.y(), p.x() * s + p.z() * c);
+}
+
+Interval Math::BoxDistance(const Interval3& p, const Vec3& size)
+{
+    Interval3 d(Abs(p.x()) - size.x(), Abs(p.y()) - size.y(), Abs(p.z()) - size.z());
+    Interval3 outside(Max(d.x(), 0.0f), Max(d.y(), 0.0f), Max(d.z(), 0.0f));
+    return Min(Max(d.x(), Max(d.y(), d.z())), 0.0f) + outside.Length();
+}
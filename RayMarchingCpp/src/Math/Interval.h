@@ -0,0 +1,99 @@
+#pragma once
+
+#include <iostream>
+
+#include "Vec3.h"
+#include "AABB.h"
+
+namespace Math {
+
+    /*
+        Closed range of values. Every operation returns a range containing
+        the results for all values of its operands, so evaluating a distance
+        function over a box bounds the distance of every point in it.
+        Rounding isn't directed, bounds are exact up to float error
+    */
+    class Interval {
+    public:
+        Interval();
+        Interval(float value);
+        Interval(float min, float max);
+
+        float Min() const;
+        float Max() const;
+        float Width() const;
+        bool Contains(float value) const;
+        bool Overlaps(const Interval& other) const;
+        Interval Union(const Interval& other) const;
+
+        Interval operator-() const;
+        Interval operator+(const Interval& other) const;
+        Interval operator-(const Interval& other) const;
+        Interval operator*(const Interval& other) const;
+        /*
+            Unbounded if other contains 0
+        */
+        Interval operator/(const Interval& other) const;
+    private:
+        float mMin;
+        float mMax;
+    };
+
+    std::ostream& operator<<(std::ostream& out, const Interval& interval);
+
+    /*
+        Interval counterparts of the functions in ShaderFunctions.h and GLSL built-ins
+    */
+
+    Interval Abs(const Interval& x);
+    Interval Min(const Interval& a, const Interval& b);
+    Interval Max(const Interval& a, const Interval& b);
+    Interval Square(const Interval& x);
+    Interval Sqrt(const Interval& x);
+    Interval Floor(const Interval& x);
+    Interval Sin(const Interval& x);
+    Interval Cos(const Interval& x);
+    Interval Clamp(const Interval& x, float min, float max);
+    /*
+        y is a positive constant
+    */
+    Interval Mod(const Interval& x, float y);
+    Interval Mix(const Interval& x, const Interval& y, const Interval& a);
+    Interval SmoothStep(float edge0, float edge1, const Interval& x);
+    /*
+        Smooth min is non-decreasing in both arguments for either sign of d,
+        so its range is given by the ends of argument ranges
+    */
+    Interval SmoothMin(const Interval& a, const Interval& b, float d);
+
+    /*
+        Box of points, one interval per axis
+    */
+    class Interval3 {
+    public:
+        Interval3() = default;
+        Interval3(const Interval& x, const Interval& y, const Interval& z);
+        explicit Interval3(const AABB& box);
+
+        Interval& x();
+        const Interval& x() const;
+        Interval& y();
+        const Interval& y() const;
+        Interval& z();
+        const Interval& z() const;
+
+        Interval3 operator+(const Vec3& offset) const;
+        Interval3 operator-(const Vec3& offset) const;
+        Interval Length() const;
+    private:
+        Interval mX;
+        Interval mY;
+        Interval mZ;
+    };
+
+    /*
+        Same as RotateXZ for every point and angle in the ranges
+    */
+    Interval3 RotateXZ(const Interval3& p, const Interval& angle);
+    Interval BoxDistance(const Interval3& p, const Vec3& size);
+}
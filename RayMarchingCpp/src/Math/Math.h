@@ -6,4 +6,9 @@
 
 #include "Vec2.h"
 #include "Vec3.h"
-#include "Vec4.h"
\ No newline at end of file
+#include "Vec4.h"
+
+#include "AABB.h"
+#include "ShaderFunctions.h"
+#include "Interval.h"
+#include "Qef.h"
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+/*
+    Helpers defined once for Math and for the C++ that SceneCompiler
+    generates. MATH_PRELUDE_FUNCTIONS is expanded in namespace Math and
+    MATH_PRELUDE_SOURCE, its text, starts the prelude of compiled scenes,
+    so both compute the same float operations. Min and Max of the scope
+    they are expanded in are used, float or Math::Float4
+*/
+#define MATH_PRELUDE_FUNCTIONS \
+    inline float Mix(float x, float y, float a) \
+    { \
+        return x + (y - x) * a; \
+    } \
+    \
+    inline float SmoothStep(float edge0, float edge1, float x) \
+    { \
+        float t = std::clamp((x - edge0) / (edge1 - edge0), 0.0f, 1.0f); \
+        return t * t * (3.0f - 2.0f * t); \
+    } \
+    \
+    /* Equal distances would give 0 / 0 with no smoothing. Negative d smooths */ \
+    /* the maximum, as the shader's smin does for the -0.0 of no smoothing */ \
+    template <typename T> \
+    inline T SmoothMin(T v1, T v2, float d) \
+    { \
+        if (d == 0.0f) { \
+            return std::signbit(d) ? Max(v1, v2) : Min(v1, v2); \
+        } \
+        T h = Min(Max(0.5f + 0.5f * (v2 - v1) / d, 0.0f), 1.0f); \
+        return v2 + (v1 - v2) * h - d * h * (1.0f - h); \
+    }
+
+#define MATH_PRELUDE_STRINGIFY(...) #__VA_ARGS__
+#define MATH_PRELUDE_EXPAND_STRINGIFY(...) MATH_PRELUDE_STRINGIFY(__VA_ARGS__)
+#define MATH_PRELUDE_SOURCE MATH_PRELUDE_EXPAND_STRINGIFY(MATH_PRELUDE_FUNCTIONS)
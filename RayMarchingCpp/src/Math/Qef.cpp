@@ -0,0 +1,129 @@
+#include "Qef.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace Math;
+
+/*
+    Eigen decomposition of a symmetric 3x3 matrix by Jacobi rotations,
+    a is left diagonal with eigenvalues, columns of v are eigenvectors
+*/
+static void SymmetricEigen(double a[3][3], double v[3][3])
+{
+    for (unsigned int i = 0; i < 3; i++) {
+        for (unsigned int j = 0; j < 3; j++) {
+            v[i][j] = i == j ? 1.0 : 0.0;
+        }
+    }
+
+    for (unsigned int sweep = 0; sweep < 8; sweep++) {
+        for (unsigned int p = 0; p < 2; p++) {
+            for (unsigned int q = p + 1; q < 3; q++) {
+                if (std::abs(a[p][q]) < 1e-12) {
+                    continue;
+                }
+                double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+                double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+                double c = 1.0 / std::sqrt(t * t + 1.0);
+                double s = t * c;
+                for (unsigned int k = 0; k < 3; k++) {
+                    double akp = a[k][p];
+                    double akq = a[k][q];
+                    a[k][p] = c * akp - s * akq;
+                    a[k][q] = s * akp + c * akq;
+                }
+                for (unsigned int k = 0; k < 3; k++) {
+                    double apk = a[p][k];
+                    double aqk = a[q][k];
+                    a[p][k] = c * apk - s * aqk;
+                    a[q][k] = s * apk + c * aqk;
+                }
+                for (unsigned int k = 0; k < 3; k++) {
+                    double vkp = v[k][p];
+                    double vkq = v[k][q];
+                    v[k][p] = c * vkp - s * vkq;
+                    v[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+}
+
+void Qef::Add(const Vec3& point, const Vec3& normal)
+{
+    mAtA[0] += normal.x() * normal.x();
+    mAtA[1] += normal.x() * normal.y();
+    mAtA[2] += normal.x() * normal.z();
+    mAtA[3] += normal.y() * normal.y();
+    mAtA[4] += normal.y() * normal.z();
+    mAtA[5] += normal.z() * normal.z();
+
+    float b = normal.Dot(point);
+    mAtb = mAtb + normal * b;
+    mBtb += b * b;
+    mPointSum = mPointSum + point;
+    mCount++;
+}
+
+void Qef::Add(const Qef& other)
+{
+    for (unsigned int i = 0; i < 6; i++) {
+        mAtA[i] += other.mAtA[i];
+    }
+    mAtb = mAtb + other.mAtb;
+    mBtb += other.mBtb;
+    mPointSum = mPointSum + other.mPointSum;
+    mCount += other.mCount;
+}
+
+Vec3 Qef::Solve() const
+{
+    Vec3 massPoint = MassPoint();
+    double a[3][3] = {
+        { mAtA[0], mAtA[1], mAtA[2] },
+        { mAtA[1], mAtA[3], mAtA[4] },
+        { mAtA[2], mAtA[4], mAtA[5] }
+    };
+
+    // Solved around the mass point, so truncated directions keep its coordinates
+    double r[3];
+    for (unsigned int i = 0; i < 3; i++) {
+        r[i] = mAtb[i] - (a[i][0] * massPoint.x() + a[i][1] * massPoint.y() + a[i][2] * massPoint.z());
+    }
+
+    double v[3][3];
+    SymmetricEigen(a, v);
+    double largest = std::max(std::abs(a[0][0]), std::max(std::abs(a[1][1]), std::abs(a[2][2])));
+
+    Vec3 result = massPoint;
+    for (unsigned int k = 0; k < 3; k++) {
+        double eigenvalue = a[k][k];
+        if (std::abs(eigenvalue) <= sTruncation * largest || eigenvalue == 0.0) {
+            continue;
+        }
+        double projection = (v[0][k] * r[0] + v[1][k] * r[1] + v[2][k] * r[2]) / eigenvalue;
+        for (unsigned int i = 0; i < 3; i++) {
+            result[i] += static_cast<float>(v[i][k] * projection);
+        }
+    }
+    return result;
+}
+
+float Qef::Error(const Vec3& point) const
+{
+    Vec3 atAp(mAtA[0] * point.x() + mAtA[1] * point.y() + mAtA[2] * point.z(),
+        mAtA[1] * point.x() + mAtA[3] * point.y() + mAtA[4] * point.z(),
+        mAtA[2] * point.x() + mAtA[4] * point.y() + mAtA[5] * point.z());
+    return std::max(point.Dot(atAp) - 2.0f * point.Dot(mAtb) + mBtb, 0.0f);
+}
+
+Vec3 Qef::MassPoint() const
+{
+    return mCount > 0 ? mPointSum / static_cast<float>(mCount) : Vec3();
+}
+
+unsigned int Qef::Count() const
+{
+    return mCount;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Vec3.h"
+
+namespace Math {
+
+    /*
+        Quadratic error function of planes given by a point and a normal,
+        its minimizer is the point closest to all of them. Directions the
+        planes leave undetermined, like along an edge where two of them
+        meet, are filled in from the mean of the added points
+    */
+    class Qef {
+    public:
+        void Add(const Vec3& point, const Vec3& normal);
+        void Add(const Qef& other);
+
+        Vec3 Solve() const;
+        float Error(const Vec3& point) const;
+        Vec3 MassPoint() const;
+        unsigned int Count() const;
+    private:
+        // Eigenvalues below this part of the largest one are treated as zero
+        static constexpr float sTruncation = 0.1f;
+
+        // Upper triangle of AtA by rows: xx, xy, xz, yy, yz, zz
+        float mAtA[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+        Vec3 mAtb;
+        float mBtb = 0.0f;
+        Vec3 mPointSum;
+        unsigned int mCount = 0;
+    };
+}
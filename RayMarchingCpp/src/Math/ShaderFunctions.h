@@ -0,0 +1,77 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include "Vec3.h"
+#include "Float4.h"
+#include "PreludeFunctions.h"
+
+namespace Math {
+
+    /*
+        CPU counterparts of GLSL built-ins and of the helpers defined in
+        Fragment.shader, used to evaluate distance functions on CPU
+    */
+
+    MATH_PRELUDE_FUNCTIONS
+
+    /*
+        SmoothMin of count pairs into v1, four at a time
+    */
+    inline void SmoothMin(float* v1, const float* v2, size_t count, float d)
+    {
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            SmoothMin(Float4::Load(v1 + i), Float4::Load(v2 + i), d).Store(v1 + i);
+        }
+        for (; i < count; i++) {
+            v1[i] = SmoothMin(v1[i], v2[i], d);
+        }
+    }
+
+    /*
+        GLSL mod, result has the sign of y
+    */
+    inline float Mod(float x, float y)
+    {
+        return x - y * std::floor(x / y);
+    }
+
+    /*
+        Same as p.xz *= Rotate(angle) in shader
+    */
+    inline Vec3 RotateXZ(const Vec3& p, float angle)
+    {
+        float c = std::cos(angle);
+        float s = std::sin(angle);
+        return Vec3(p.x() * c - p.z() * s, p.y(), p.x() * s + p.z() * c);
+    }
+
+    /*
+        Distance to a box centered at origin with given half extents
+    */
+    inline float BoxDistance(const Vec3& p, const Vec3& size)
+    {
+        Vec3 d(std::abs(p.x()) - size.x(), std::abs(p.y()) - size.y(), std::abs(p.z()) - size.z());
+        Vec3 outside(std::max(d.x(), 0.0f), std::max(d.y(), 0.0f), std::max(d.z(), 0.0f));
+        return std::min(std::max(d.x(), std::max(d.y(), d.z())), 0.0f) + outside.Magnitude();
+    }
+
+    /*
+        BoxDistance of a point given by float or Float4 coordinates, used by batch kernels
+    */
+    template <typename T>
+    inline T BoxDistance(T x, T y, T z, float sizeX, float sizeY, float sizeZ)
+    {
+        T dx = Abs(x) - sizeX;
+        T dy = Abs(y) - sizeY;
+        T dz = Abs(z) - sizeZ;
+        T ox = Max(dx, 0.0f);
+        T oy = Max(dy, 0.0f);
+        T oz = Max(dz, 0.0f);
+        return Min(Max(dx, Max(dy, dz)), 0.0f) + Sqrt(ox * ox + oy * oy + oz * oz);
+    }
+
+}
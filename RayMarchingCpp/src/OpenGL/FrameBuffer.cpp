@@ -0,0 +1,97 @@
+#include "FrameBuffer.h"
+#include "GLCore.h"
+
+#include <iostream>
+
+using namespace OpenGL;
+
+FrameBuffer::FrameBuffer(unsigned int width, unsigned int height, bool floatColor /* = false */) : mWidth(width), mHeight(height)
+{
+    GLCall(glGenTextures(1, &mColorTextureID));
+    GLCall(glBindTexture(GL_TEXTURE_2D, mColorTextureID));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+    GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+    GLCall(glTexImage2D(GL_TEXTURE_2D, 0, floatColor ? GL_RGBA32F : GL_RGBA8, mWidth, mHeight, 0, GL_RGBA,
+        floatColor ? GL_FLOAT : GL_UNSIGNED_BYTE, nullptr));
+    GLCall(glBindTexture(GL_TEXTURE_2D, 0));
+
+    GLCall(glGenFramebuffers(1, &mOpenGLID));
+    GLCall(glBindFramebuffer(GL_FRAMEBUFFER, mOpenGLID));
+    GLCall(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mColorTextureID, 0));
+
+    GLCall(GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER));
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "[Error] OpenGL::FrameBuffer: framebuffer " << mWidth << 'x' << mHeight <<
+            " is incomplete (0x" << std::hex << status << std::dec << ")\n";
+    }
+    GLCall(glClearColor(0.0f, 0.0f, 0.0f, 1.0f));
+    GLCall(glClear(GL_COLOR_BUFFER_BIT));
+    GLCall(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+}
+
+void FrameBuffer::Bind() const
+{
+    GLCall(glBindFramebuffer(GL_FRAMEBUFFER, mOpenGLID));
+    GLCall(glViewport(0, 0, mWidth, mHeight));
+}
+
+void FrameBuffer::Unbind() const
+{
+    GLCall(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+}
+
+void FrameBuffer::Delete() const
+{
+    GLCall(glDeleteFramebuffers(1, &mOpenGLID));
+    GLCall(glDeleteTextures(1, &mColorTextureID));
+}
+
+void FrameBuffer::BindColorTexture(unsigned int slot /* = 0 */) const
+{
+    GLCall(glActiveTexture(GL_TEXTURE0 + slot));
+    GLCall(glBindTexture(GL_TEXTURE_2D, mColorTextureID));
+}
+
+void FrameBuffer::BlitToScreen(unsigned int width, unsigned int height) const
+{
+    GLCall(glBindFramebuffer(GL_READ_FRAMEBUFFER, mOpenGLID));
+    GLCall(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0));
+    GLCall(glBlitFramebuffer(0, 0, mWidth, mHeight, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST));
+    GLCall(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+}
+
+void FrameBuffer::ReadPixels(std::vector<unsigned char>& pixels) const
+{
+    pixels.resize(static_cast<size_t>(mWidth) * mHeight * 4);
+    GLCall(glBindFramebuffer(GL_READ_FRAMEBUFFER, mOpenGLID));
+    GLCall(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+    GLCall(glReadPixels(0, 0, mWidth, mHeight, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+    GLCall(glBindFramebuffer(GL_READ_FRAMEBUFFER, 0));
+}
+
+void FrameBuffer::ReadPixels(std::vector<float>& pixels) const
+{
+    pixels.resize(static_cast<size_t>(mWidth) * mHeight * 4);
+    GLCall(glBindFramebuffer(GL_READ_FRAMEBUFFER, mOpenGLID));
+    GLCall(glReadPixels(0, 0, mWidth, mHeight, GL_RGBA, GL_FLOAT, pixels.data()));
+    GLCall(glBindFramebuffer(GL_READ_FRAMEBUFFER, 0));
+}
+
+void FrameBuffer::ReadRedPixels(std::vector<unsigned char>& pixels) const
+{
+    pixels.resize(static_cast<size_t>(mWidth) * mHeight);
+    GLCall(glBindFramebuffer(GL_READ_FRAMEBUFFER, mOpenGLID));
+    GLCall(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+    GLCall(glReadPixels(0, 0, mWidth, mHeight, GL_RED, GL_UNSIGNED_BYTE, pixels.data()));
+    GLCall(glBindFramebuffer(GL_READ_FRAMEBUFFER, 0));
+}
+
+void FrameBuffer::ReadPixelsToPackBuffer() const
+{
+    GLCall(glBindFramebuffer(GL_READ_FRAMEBUFFER, mOpenGLID));
+    GLCall(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+    GLCall(glReadPixels(0, 0, mWidth, mHeight, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+    GLCall(glBindFramebuffer(GL_READ_FRAMEBUFFER, 0));
+}
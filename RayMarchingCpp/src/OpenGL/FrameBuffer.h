@@ -0,0 +1,51 @@
+#pragma once
+
+#include <vector>
+
+namespace OpenGL {
+
+    class FrameBuffer {
+    public:
+        FrameBuffer() = default;
+        /*
+            Float color keeps values outside of 0 to 1, such as distances
+        */
+        FrameBuffer(unsigned int width, unsigned int height, bool floatColor = false);
+
+        /*
+            Binds framebuffer as a render target and sets viewport to its size
+        */
+        void Bind() const;
+        void Unbind() const;
+        void Delete() const;
+
+        void BindColorTexture(unsigned int slot = 0) const;
+        void BlitToScreen(unsigned int width, unsigned int height) const;
+        /*
+            Reads color attachment as tightly packed RGBA8 rows
+        */
+        void ReadPixels(std::vector<unsigned char>& pixels) const;
+        /*
+            Reads color attachment as RGBA float rows, values of float targets unclamped
+        */
+        void ReadPixels(std::vector<float>& pixels) const;
+        /*
+            Reads red channel of color attachment as one byte per pixel
+        */
+        void ReadRedPixels(std::vector<unsigned char>& pixels) const;
+        /*
+            Same as ReadPixels into the bound GL_PIXEL_PACK_BUFFER, returns
+            without waiting for the copy, see PixelReadback
+        */
+        void ReadPixelsToPackBuffer() const;
+
+        unsigned int Width() const { return mWidth; }
+        unsigned int Height() const { return mHeight; }
+    private:
+        unsigned int mOpenGLID = 0;
+        unsigned int mColorTextureID = 0;
+        unsigned int mWidth = 0;
+        unsigned int mHeight = 0;
+    };
+
+}
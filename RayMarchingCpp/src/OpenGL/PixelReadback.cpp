@@ -0,0 +1,79 @@
+#include "PixelReadback.h"
+#include "GLCore.h"
+
+#include <chrono>
+#include <iostream>
+
+using namespace OpenGL;
+
+PixelReadback::PixelReadback(unsigned int width, unsigned int height, Callback callback, unsigned int latency /* = 2 */) :
+    mWidth(width), mHeight(height), mCallback(std::move(callback)), mSlots(latency + 1)
+{
+    for (Slot& slot : mSlots) {
+        GLCall(glGenBuffers(1, &slot.BufferID));
+        GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.BufferID));
+        GLCall(glBufferData(GL_PIXEL_PACK_BUFFER, SizeInBytes(), nullptr, GL_STREAM_READ));
+    }
+    GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+}
+
+void PixelReadback::Read(const FrameBuffer& framebuffer, uint64_t frame)
+{
+    // Reads in flight never fill the whole ring, so the next slot is free
+    Slot& slot = mSlots[mIssued % mSlots.size()];
+    GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.BufferID));
+    framebuffer.ReadPixelsToPackBuffer();
+    GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+    GLCall(slot.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+    slot.Frame = frame;
+    mIssued++;
+
+    if (mIssued - mDelivered > mSlots.size() - 1) {
+        Deliver(mSlots[mDelivered % mSlots.size()]);
+        mDelivered++;
+    }
+}
+
+void PixelReadback::Flush()
+{
+    while (mDelivered < mIssued) {
+        Deliver(mSlots[mDelivered % mSlots.size()]);
+        mDelivered++;
+    }
+}
+
+void PixelReadback::Delete() const
+{
+    for (const Slot& slot : mSlots) {
+        if (slot.Fence) {
+            GLCall(glDeleteSync(slot.Fence));
+        }
+        GLCall(glDeleteBuffers(1, &slot.BufferID));
+    }
+}
+
+void PixelReadback::Deliver(Slot& slot)
+{
+    GLCall(GLenum status = glClientWaitSync(slot.Fence, 0, 0));
+    if (status == GL_TIMEOUT_EXPIRED) {
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        GLCall(status = glClientWaitSync(slot.Fence, GL_SYNC_FLUSH_COMMANDS_BIT, sFenceTimeout));
+        mStats.StalledFrames++;
+        mStats.WaitMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    }
+    GLCall(glDeleteSync(slot.Fence));
+    slot.Fence = nullptr;
+    if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+        std::cerr << "[Error] OpenGL::PixelReadback: frame " << slot.Frame << " wasn't read back (0x" << std::hex << status << std::dec << ")\n";
+        return;
+    }
+
+    GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.BufferID));
+    GLCall(const void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, SizeInBytes(), GL_MAP_READ_BIT));
+    if (pixels) {
+        mCallback(static_cast<const unsigned char*>(pixels), slot.Frame);
+        mStats.Frames++;
+        GLCall(glUnmapBuffer(GL_PIXEL_PACK_BUFFER));
+    }
+    GLCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "FrameBuffer.h"
+
+struct __GLsync;
+
+namespace OpenGL {
+
+    /*
+        Reads framebuffers back without stalling the pipeline. Read starts a
+        copy of the color attachment into the next of a ring of pixel buffer
+        objects and puts a fence after it. Copies are picked up latency
+        reads later, so frame N is mapped while frame N + latency renders
+        and its fence has usually passed by then. Mapped pixels, rows bottom
+        to top, are handed to the callback in place and are valid only
+        during the call
+    */
+    class PixelReadback {
+    public:
+        using Callback = std::function<void(const unsigned char* pixels, uint64_t frame)>;
+
+        struct Stats {
+            uint64_t Frames = 0;
+            // Frames whose fence hadn't passed when they were picked up and the time spent waiting for them
+            uint64_t StalledFrames = 0;
+            double WaitMilliseconds = 0.0;
+        };
+    public:
+        PixelReadback() = default;
+        PixelReadback(unsigned int width, unsigned int height, Callback callback, unsigned int latency = 2);
+
+        /*
+            Starts reading framebuffer of the size given on construction,
+            frame is passed to the callback with its pixels
+        */
+        void Read(const FrameBuffer& framebuffer, uint64_t frame);
+        /*
+            Hands out all reads in flight, oldest first
+        */
+        void Flush();
+        void Delete() const;
+
+        const Stats& GetStats() const { return mStats; }
+        size_t SizeInBytes() const { return static_cast<size_t>(mWidth) * mHeight * 4; }
+    private:
+        struct Slot {
+            unsigned int BufferID = 0;
+            __GLsync* Fence = nullptr;
+            uint64_t Frame = 0;
+        };
+
+        void Deliver(Slot& slot);
+    private:
+        // Longest wait for a single fence, a lost context shouldn't hang the caller
+        static constexpr uint64_t sFenceTimeout = 5000000000ull;
+
+        unsigned int mWidth = 0;
+        unsigned int mHeight = 0;
+        Callback mCallback;
+        std::vector<Slot> mSlots;
+        uint64_t mIssued = 0;
+        uint64_t mDelivered = 0;
+        Stats mStats;
+    };
+
+}
@@ -34,6 +34,12 @@ void OpenGL::ShaderProgram::SetUniform1i(const std::string_view name, int v)
     GLCall(glUniform1i(location, v));
 }
 
+void OpenGL::ShaderProgram::SetUniform3i(const std::string_view name, int v1, int v2, int v3)
+{
+    int location = GetUniformLocation(name);
+    GLCall(glUniform3i(location, v1, v2, v3));
+}
+
 void OpenGL::ShaderProgram::SetUniform1f(const std::string_view name, float v1)
 {
     int location = GetUniformLocation(name);
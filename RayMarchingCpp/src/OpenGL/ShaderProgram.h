@@ -18,6 +18,7 @@ namespace OpenGL {
         void Delete() const;
 
         void SetUniform1i(const std::string_view name, int v);
+        void SetUniform3i(const std::string_view name, int v1, int v2, int v3);
         void SetUniform1f(const std::string_view name, float v1);
         void SetUniform2f(const std::string_view name, float v1, float v2);
         void SetUniform3f(const std::string_view name, float v1, float v2, float v3);
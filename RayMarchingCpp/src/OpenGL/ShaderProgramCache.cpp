@@ -0,0 +1,57 @@
+#include "ShaderProgramCache.h"
+
+using namespace OpenGL;
+
+ShaderProgramCache::ShaderProgramCache(size_t capacity) : mCapacity(capacity > 0 ? capacity : 1)
+{
+}
+
+std::shared_ptr<ShaderProgram> ShaderProgramCache::Find(const std::string& key)
+{
+    auto iter = mIndex.find(key);
+    if (iter == mIndex.end()) {
+        return nullptr;
+    }
+    mEntries.splice(mEntries.begin(), mEntries, iter->second);
+    return iter->second->second;
+}
+
+void ShaderProgramCache::Insert(const std::string& key, std::shared_ptr<ShaderProgram> program)
+{
+    auto iter = mIndex.find(key);
+    if (iter != mIndex.end()) {
+        iter->second->second->Delete();
+        iter->second->second = program;
+        mEntries.splice(mEntries.begin(), mEntries, iter->second);
+        return;
+    }
+
+    Evict(mCapacity - 1);
+
+    mEntries.emplace_front(key, program);
+    mIndex[key] = mEntries.begin();
+}
+
+void ShaderProgramCache::Clear()
+{
+    for (const Entry& entry : mEntries) {
+        entry.second->Delete();
+    }
+    mEntries.clear();
+    mIndex.clear();
+}
+
+void ShaderProgramCache::SetCapacity(size_t capacity)
+{
+    mCapacity = capacity > 0 ? capacity : 1;
+    Evict(mCapacity);
+}
+
+void ShaderProgramCache::Evict(size_t size)
+{
+    while (mEntries.size() > size) {
+        mEntries.back().second->Delete();
+        mIndex.erase(mEntries.back().first);
+        mEntries.pop_back();
+    }
+}
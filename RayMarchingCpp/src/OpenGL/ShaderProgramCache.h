@@ -0,0 +1,47 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "ShaderProgram.h"
+
+namespace OpenGL {
+
+    /*
+        Keeps up to capacity linked programs by key, least recently used
+        program is deleted when a new one doesn't fit
+    */
+    class ShaderProgramCache {
+    public:
+        explicit ShaderProgramCache(size_t capacity = 4);
+
+        /*
+            Returns nullptr when key isn't cached, otherwise marks program as most recently used
+        */
+        std::shared_ptr<ShaderProgram> Find(const std::string& key);
+        void Insert(const std::string& key, std::shared_ptr<ShaderProgram> program);
+        void Clear();
+        /*
+            Deletes least recently used programs that don't fit any more
+        */
+        void SetCapacity(size_t capacity);
+
+        size_t Size() const { return mEntries.size(); }
+        size_t Capacity() const { return mCapacity; }
+    private:
+        using Entry = std::pair<std::string, std::shared_ptr<ShaderProgram>>;
+
+        /*
+            Deletes least recently used programs until at most size are left
+        */
+        void Evict(size_t size);
+    private:
+        // Most recently used first
+        std::list<Entry> mEntries;
+        std::unordered_map<std::string, std::list<Entry>::iterator> mIndex;
+        size_t mCapacity;
+    };
+
+}
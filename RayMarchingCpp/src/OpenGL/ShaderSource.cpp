@@ -1,6 +1,7 @@
 #include "ShaderSource.h"
 
 #include <fstream>
+#include <sstream>
 
 using namespace OpenGL;
 
@@ -31,7 +32,8 @@ std::shared_ptr<ShaderSource> ShaderSource::LoadFrom(const std::string_view path
 	if (!in.is_open()) {
 		return nullptr;
 	}
-	std::string source;
-	std::copy(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>(), std::back_inserter(source));
-	return std::make_shared<ShaderSource>(source);
+	// Copies the file buffer at once instead of char by char, in text mode so line endings are unchanged
+	std::ostringstream source;
+	source << in.rdbuf();
+	return std::make_shared<ShaderSource>(source.str());
 }
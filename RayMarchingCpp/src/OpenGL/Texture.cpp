@@ -3,15 +3,18 @@
 
 #include <stb_image.h>
 
+#include <cmath>
+
 using namespace OpenGL;
 
-Texture::Texture(const std::string& path)
-	: mOpenGLID(0), mFilePath(path), mLocalBuffer(nullptr), 
-	  mWidth(0), mHeight(0), mBitDepth(0)
+Texture::Texture(const std::string& path) : Texture(path, Decode(path))
 {
-	stbi_set_flip_vertically_on_load(1);
-	mLocalBuffer = stbi_load(path.c_str(), &mWidth, &mHeight, &mBitDepth, 1);
+}
 
+Texture::Texture(const std::string& path, Image image)
+	: mOpenGLID(0), mFilePath(path), mPixels(std::move(image.Pixels)),
+	  mWidth(image.Width), mHeight(image.Height), mBitDepth(image.BitDepth)
+{
 	GLCall(glGenTextures(1, &mOpenGLID));
 	Bind();
 
@@ -20,12 +23,21 @@ Texture::Texture(const std::string& path)
 	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT));
 	GLCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT));
 
-	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, mWidth, mHeight, 0, GL_RED, GL_UNSIGNED_BYTE, mLocalBuffer));
+	GLCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, mWidth, mHeight, 0, GL_RED, GL_UNSIGNED_BYTE, mPixels.empty() ? nullptr : mPixels.data()));
 	Unbind();
+}
 
-	if (mLocalBuffer) {
-		stbi_image_free(mLocalBuffer);
+Texture::Image Texture::Decode(const std::string& path)
+{
+	Image image;
+	// The global flag would race with decodes on other threads
+	stbi_set_flip_vertically_on_load_thread(1);
+	unsigned char* pixels = stbi_load(path.c_str(), &image.Width, &image.Height, &image.BitDepth, 1);
+	if (pixels) {
+		image.Pixels.assign(pixels, pixels + static_cast<size_t>(image.Width) * image.Height);
+		stbi_image_free(pixels);
 	}
+	return image;
 }
 
 void Texture::Delete() const
@@ -43,3 +55,28 @@ void Texture::Unbind() const
 {
 	GLCall(glBindTexture(GL_TEXTURE_2D, 0));
 }
+
+float Texture::Sample(float u, float v) const
+{
+	if (mPixels.empty()) {
+		return 0.0f;
+	}
+
+	float x = u * mWidth - 0.5f;
+	float y = v * mHeight - 0.5f;
+	int x0 = static_cast<int>(std::floor(x));
+	int y0 = static_cast<int>(std::floor(y));
+	float fx = x - x0;
+	float fy = y - y0;
+
+	float bottom = Texel(x0, y0) * (1.0f - fx) + Texel(x0 + 1, y0) * fx;
+	float top = Texel(x0, y0 + 1) * (1.0f - fx) + Texel(x0 + 1, y0 + 1) * fx;
+	return bottom * (1.0f - fy) + top * fy;
+}
+
+float Texture::Texel(int x, int y) const
+{
+	x = (x % mWidth + mWidth) % mWidth;
+	y = (y % mHeight + mHeight) % mHeight;
+	return mPixels[static_cast<size_t>(y) * mWidth + x] / 255.0f;
+}
@@ -1,12 +1,28 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 namespace OpenGL {
 
 	class Texture {
+	public:
+		/*
+			Red channel of an image file, rows bottom to top as OpenGL expects
+		*/
+		struct Image {
+			int Width = 0;
+			int Height = 0;
+			int BitDepth = 0;
+			std::vector<unsigned char> Pixels;
+		};
 	public:
 		Texture(const std::string& path);
+		/*
+			Uploads an image decoded before, so decoding can happen off the
+			thread owning the context
+		*/
+		Texture(const std::string& path, Image image);
 		~Texture() {}
 
 		void Bind(unsigned int slot = 0) const;
@@ -16,10 +32,23 @@ namespace OpenGL {
 		int Width() const { return mWidth; }
 		int Height() const { return mHeight; }
 		int BitDepth() const { return mBitDepth; }
+
+		/*
+			Red channel at uv filtered on CPU the same way as texture() in
+			shader does: bilinear with repeat wrapping
+		*/
+		float Sample(float u, float v) const;
+
+		/*
+			Safe to call from any thread, empty if the file can't be decoded
+		*/
+		static Image Decode(const std::string& path);
+	private:
+		float Texel(int x, int y) const;
 	private:
 		unsigned int mOpenGLID;
 		std::string mFilePath;
-		unsigned char* mLocalBuffer;
+		std::vector<unsigned char> mPixels;
 		int mWidth, mHeight, mBitDepth;
 	};
 
@@ -0,0 +1,64 @@
+#include "Texture3D.h"
+#include "GLCore.h"
+
+using namespace OpenGL;
+
+Texture3D::Texture3D(unsigned int width, unsigned int height, unsigned int depth, unsigned int internalFormat, bool linear /* = true */)
+    : mWidth(width), mHeight(height), mDepth(depth), mBytesPerTexel(BytesPerTexel(internalFormat))
+{
+    GLCall(glGenTextures(1, &mOpenGLID));
+    GLCall(glBindTexture(GL_TEXTURE_3D, mOpenGLID));
+    GLCall(glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, linear ? GL_LINEAR : GL_NEAREST));
+    GLCall(glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, linear ? GL_LINEAR : GL_NEAREST));
+    GLCall(glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+    GLCall(glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+    GLCall(glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE));
+    // Format and type of the initial (empty) data only have to be valid for the internal format
+    GLenum format = internalFormat == GL_RGBA32F || internalFormat == GL_RGBA16F ? GL_RGBA : GL_RED;
+    GLCall(glTexImage3D(GL_TEXTURE_3D, 0, internalFormat, mWidth, mHeight, mDepth, 0, format, GL_FLOAT, nullptr));
+    GLCall(glBindTexture(GL_TEXTURE_3D, 0));
+}
+
+void Texture3D::Update(const void* data, unsigned int format, unsigned int type) const
+{
+    UpdateRegion(0, 0, 0, mWidth, mHeight, mDepth, data, format, type);
+}
+
+void Texture3D::UpdateRegion(unsigned int x, unsigned int y, unsigned int z, unsigned int width, unsigned int height, unsigned int depth,
+    const void* data, unsigned int format, unsigned int type) const
+{
+    GLCall(glBindTexture(GL_TEXTURE_3D, mOpenGLID));
+    GLCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+    GLCall(glTexSubImage3D(GL_TEXTURE_3D, 0, x, y, z, width, height, depth, format, type, data));
+    GLCall(glBindTexture(GL_TEXTURE_3D, 0));
+}
+
+void Texture3D::Bind(unsigned int slot /* = 0 */) const
+{
+    GLCall(glActiveTexture(GL_TEXTURE0 + slot));
+    GLCall(glBindTexture(GL_TEXTURE_3D, mOpenGLID));
+}
+
+void Texture3D::Delete() const
+{
+    GLCall(glDeleteTextures(1, &mOpenGLID));
+}
+
+size_t Texture3D::BytesPerTexel(unsigned int internalFormat)
+{
+    switch (internalFormat) {
+    case GL_R8:
+        return 1;
+    case GL_R16:
+    case GL_R16F:
+        return 2;
+    case GL_R32F:
+        return 4;
+    case GL_RGBA16F:
+        return 8;
+    case GL_RGBA32F:
+        return 16;
+    default:
+        return 4;
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+
+namespace OpenGL {
+
+    /*
+        Volume texture with given internal format, e.g. GL_R16F or GL_R8.
+        Linear textures are sampled with trilinear filtering, others are
+        meant for texelFetch
+    */
+    class Texture3D {
+    public:
+        Texture3D() = default;
+        Texture3D(unsigned int width, unsigned int height, unsigned int depth, unsigned int internalFormat, bool linear = true);
+
+        /*
+            data holds width * height * depth texels of given format and type, x changes fastest
+        */
+        void Update(const void* data, unsigned int format, unsigned int type) const;
+        /*
+            Same as Update for the box of given size at (x, y, z)
+        */
+        void UpdateRegion(unsigned int x, unsigned int y, unsigned int z, unsigned int width, unsigned int height, unsigned int depth,
+            const void* data, unsigned int format, unsigned int type) const;
+        void Bind(unsigned int slot = 0) const;
+        void Delete() const;
+
+        unsigned int Width() const { return mWidth; }
+        unsigned int Height() const { return mHeight; }
+        unsigned int Depth() const { return mDepth; }
+        size_t SizeInBytes() const { return static_cast<size_t>(mWidth) * mHeight * mDepth * mBytesPerTexel; }
+    private:
+        static size_t BytesPerTexel(unsigned int internalFormat);
+    private:
+        unsigned int mOpenGLID = 0;
+        unsigned int mWidth = 0;
+        unsigned int mHeight = 0;
+        unsigned int mDepth = 0;
+        size_t mBytesPerTexel = 0;
+    };
+
+}
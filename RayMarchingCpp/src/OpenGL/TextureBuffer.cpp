@@ -0,0 +1,39 @@
+#include "TextureBuffer.h"
+#include "GLCore.h"
+
+using namespace OpenGL;
+
+TextureBuffer::TextureBuffer(unsigned int internalFormat) : mInternalFormat(internalFormat)
+{
+    GLCall(glGenBuffers(1, &mBufferID));
+    GLCall(glGenTextures(1, &mTextureID));
+
+    // Texture keeps referring to the buffer when its data store is reallocated,
+    // so Update doesn't have to touch texture bindings
+    GLCall(glBindBuffer(GL_TEXTURE_BUFFER, mBufferID));
+    GLCall(glBufferData(GL_TEXTURE_BUFFER, 0, nullptr, GL_DYNAMIC_DRAW));
+    GLCall(glBindBuffer(GL_TEXTURE_BUFFER, 0));
+
+    GLCall(glBindTexture(GL_TEXTURE_BUFFER, mTextureID));
+    GLCall(glTexBuffer(GL_TEXTURE_BUFFER, mInternalFormat, mBufferID));
+    GLCall(glBindTexture(GL_TEXTURE_BUFFER, 0));
+}
+
+void TextureBuffer::Update(const void* data, size_t size) const
+{
+    GLCall(glBindBuffer(GL_TEXTURE_BUFFER, mBufferID));
+    GLCall(glBufferData(GL_TEXTURE_BUFFER, size, data, GL_DYNAMIC_DRAW));
+    GLCall(glBindBuffer(GL_TEXTURE_BUFFER, 0));
+}
+
+void TextureBuffer::Bind(unsigned int slot /* = 0 */) const
+{
+    GLCall(glActiveTexture(GL_TEXTURE0 + slot));
+    GLCall(glBindTexture(GL_TEXTURE_BUFFER, mTextureID));
+}
+
+void TextureBuffer::Delete() const
+{
+    GLCall(glDeleteTextures(1, &mTextureID));
+    GLCall(glDeleteBuffers(1, &mBufferID));
+}
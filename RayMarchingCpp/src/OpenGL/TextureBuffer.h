@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+
+namespace OpenGL {
+
+    /*
+        Buffer object exposed to shaders as samplerBuffer with given
+        internal format, e.g. GL_R32I or GL_RGBA32F
+    */
+    class TextureBuffer {
+    public:
+        TextureBuffer() = default;
+        explicit TextureBuffer(unsigned int internalFormat);
+
+        void Update(const void* data, size_t size) const;
+        void Bind(unsigned int slot = 0) const;
+        void Delete() const;
+    private:
+        unsigned int mBufferID = 0;
+        unsigned int mTextureID = 0;
+        unsigned int mInternalFormat = 0;
+    };
+
+}
@@ -2,6 +2,7 @@
 
 #include "RayMarchingWindow/IShapedObject.h"
 #include "RayMarchingWindow/IImGuiEditable.h"
+#include "RayMarchingWindow/ShapeCode.h"
 #include "Math/Math.h"
 #include <imgui.h>
 
@@ -26,19 +27,58 @@ public:
         return DistFunctionName()+'(' + fixedParam + ", " + Name() + ')';
     }
 
+    virtual std::string CppDistFunctionCall(const std::string& fixedParam, CppSceneSource& source) const override
+    {
+        return source.AddFunction(ShapeCode::CppBody<PlaneShape>(Params()), fixedParam);
+    }
+
     static std::string DistFunctionDefinition()
     {
-        return DIST_FUNCTION_PROTOTYPE(DistFunctionName(), vec3 p, float planeObj) DIST_FUNCTION_CODE(
-            p.y -= planeObj;
-            return dot(p, normalize(vec3(0, 1, 0))) - sin(p.x / 10);
-        );
+        return ShapeCode::GlslDefinition<PlaneShape>(DistFunctionName());
+    }
+
+    /*
+        Height in obj[0], waved along X
+    */
+    template <typename T, typename P>
+    static T Sdf(T x, T y, T, const std::array<P, 4>& obj, P)
+    {
+        return y - obj[0] - ShapeCode::Sin(x / 10.0f);
+    }
+
+    virtual float Distance(const Math::Vec3& p, const DistanceContext& context) const override
+    {
+        return Sdf(p.x(), p.y(), p.z(), Params(), context.Time);
+    }
+
+    virtual void Distances(const PointBatch& batch, float* out, const DistanceContext& context) const override
+    {
+        const std::array<float, 4> obj = Params();
+        const float time = context.Time;
+        batch.Evaluate(out, [&](auto x, auto y, auto z) {
+            return Sdf(x, y, z, obj, time);
+        });
+    }
+
+    virtual Math::Interval DistanceRange(const Math::AABB& box, const DistanceContext& context) const override
+    {
+        Math::Interval3 p(box);
+        return Sdf(p.x(), p.y(), p.z(), Params(), context.Time);
     }
 
     const std::string& Name() const
     {
         return mName;
     }
+
+    // Uniform of the shape is a float
+    static constexpr unsigned int sParamCount = 1;
 private:
+    std::array<float, 4> Params() const
+    {
+        return { mYTranslation, 0.0f, 0.0f, 0.0f };
+    }
+
     static std::string DistFunctionName()
     {
         return "PlaneDist";
@@ -0,0 +1,274 @@
+#include "BrickMap.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <thread>
+
+static_assert(sizeof(BrickMap::Header) == 80, "Header layout is part of the file format");
+static_assert(sizeof(BrickMap::Cell) == 8, "Cell layout is part of the file format");
+
+static constexpr char sMagic[4] = { 'R', 'M', 'B', 'M' };
+static constexpr float sSqrt3 = 1.73205081f;
+
+static uint64_t AlignOffset(uint64_t offset)
+{
+    return (offset + 15) & ~static_cast<uint64_t>(15);
+}
+
+BrickMap BrickMap::Bake(const IShapedObject& object, const Math::AABB& bounds, float voxelSize, float band, unsigned int bitsPerDistance,
+    uint64_t fingerprint, const DistanceContext& context, unsigned int threadCount /* = 0 */)
+{
+    Header header = {};
+    std::memcpy(header.Magic, sMagic, sizeof(sMagic));
+    header.Version = sVersion;
+    header.Fingerprint = fingerprint;
+    header.VoxelSize = voxelSize;
+    header.Band = band;
+    header.BitsPerDistance = bitsPerDistance > 8 ? 16 : 8;
+
+    const float cellSize = sBrickVoxels * voxelSize;
+    Math::Vec3 size = bounds.Size();
+    for (unsigned int i = 0; i < 3; i++) {
+        header.Min[i] = bounds.Min()[i];
+        header.Cells[i] = std::max(static_cast<uint32_t>(std::ceil(size[i] / cellSize)), 1u);
+    }
+
+    const size_t cellCount = static_cast<size_t>(header.Cells[0]) * header.Cells[1] * header.Cells[2];
+    const size_t brickBytes = sSamplesPerBrick * header.BitsPerDistance / 8;
+    const float maxQuantized = static_cast<float>((1u << header.BitsPerDistance) - 1);
+    const float halfVoxelDiagonal = voxelSize * sSqrt3 * 0.5f;
+
+    // Bricks of every slice of cells are collected separately and numbered in slice order afterwards,
+    // so the result doesn't depend on thread scheduling
+    std::vector<Cell> cells(cellCount);
+    std::vector<std::vector<unsigned char>> sliceBricks(header.Cells[2]);
+
+    std::atomic<unsigned int> nextSlice = 0;
+    auto worker = [&]() {
+        std::vector<float> samples(sSamplesPerBrick);
+        for (unsigned int z = nextSlice++; z < header.Cells[2]; z = nextSlice++) {
+            std::vector<unsigned char>& bricks = sliceBricks[z];
+            uint32_t sliceBrickCount = 0;
+
+            for (unsigned int y = 0; y < header.Cells[1]; y++) {
+                for (unsigned int x = 0; x < header.Cells[0]; x++) {
+                    Cell& cell = cells[(static_cast<size_t>(z) * header.Cells[1] + y) * header.Cells[0] + x];
+                    Math::Vec3 origin = bounds.Min() + Math::Vec3(static_cast<float>(x), static_cast<float>(y), static_cast<float>(z)) * cellSize;
+
+                    // Cells whose whole distance range is outside of the band aren't sampled
+                    Math::Interval range = object.DistanceRange(Math::AABB(origin, origin + Math::Vec3(cellSize)), context);
+                    if (range.Min() >= band || range.Max() <= -band) {
+                        cell = { sEmptyBrick, range.Min() >= band ? range.Min() : range.Max() };
+                        continue;
+                    }
+
+                    float minDistance = std::numeric_limits<float>::max();
+                    for (unsigned int k = 0; k < sBrickSamples; k++) {
+                        for (unsigned int j = 0; j < sBrickSamples; j++) {
+                            for (unsigned int i = 0; i < sBrickSamples; i++) {
+                                Math::Vec3 p = origin + Math::Vec3(static_cast<float>(i), static_cast<float>(j), static_cast<float>(k)) * voxelSize;
+                                float distance = object.Distance(p, context);
+                                samples[(k * sBrickSamples + j) * sBrickSamples + i] = distance;
+                                minDistance = std::min(minDistance, std::abs(distance));
+                            }
+                        }
+                    }
+
+                    // Surface can't pass between samples that are all this far from it
+                    if (minDistance - halfVoxelDiagonal >= band) {
+                        cell = { sEmptyBrick, std::copysign(minDistance - halfVoxelDiagonal, samples[0]) };
+                        continue;
+                    }
+
+                    cell = { sliceBrickCount++, 0.0f };
+                    size_t offset = bricks.size();
+                    bricks.resize(offset + brickBytes);
+                    for (unsigned int i = 0; i < sSamplesPerBrick; i++) {
+                        float normalized = std::clamp(samples[i] / band, -1.0f, 1.0f) * 0.5f + 0.5f;
+                        unsigned int quantized = static_cast<unsigned int>(std::lround(normalized * maxQuantized));
+                        if (header.BitsPerDistance == 8) {
+                            bricks[offset + i] = static_cast<unsigned char>(quantized);
+                        } else {
+                            uint16_t value = static_cast<uint16_t>(quantized);
+                            std::memcpy(&bricks[offset + i * 2], &value, sizeof(value));
+                        }
+                    }
+                }
+            }
+        }
+    };
+
+    if (threadCount == 0) {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < std::min(threadCount, header.Cells[2]); i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    std::vector<uint32_t> sliceFirstBrick(header.Cells[2]);
+    for (unsigned int z = 0; z < header.Cells[2]; z++) {
+        sliceFirstBrick[z] = header.BrickCount;
+        header.BrickCount += static_cast<uint32_t>(sliceBricks[z].size() / brickBytes);
+    }
+    const size_t sliceCellCount = static_cast<size_t>(header.Cells[0]) * header.Cells[1];
+    for (size_t i = 0; i < cellCount; i++) {
+        if (cells[i].Brick != sEmptyBrick) {
+            cells[i].Brick += sliceFirstBrick[i / sliceCellCount];
+        }
+    }
+
+    header.CellsOffset = AlignOffset(sizeof(Header));
+    header.BricksOffset = AlignOffset(header.CellsOffset + cellCount * sizeof(Cell));
+    header.FileSize = header.BricksOffset + header.BrickCount * brickBytes;
+
+    BrickMap map;
+    map.mData.resize(header.FileSize);
+    std::memcpy(map.mData.data(), &header, sizeof(header));
+    std::memcpy(map.mData.data() + header.CellsOffset, cells.data(), cellCount * sizeof(Cell));
+    unsigned char* bricks = map.mData.data() + header.BricksOffset;
+    for (const std::vector<unsigned char>& slice : sliceBricks) {
+        std::memcpy(bricks, slice.data(), slice.size());
+        bricks += slice.size();
+    }
+    return map;
+}
+
+std::optional<BrickMap> BrickMap::Load(const std::string& path)
+{
+    std::unique_ptr<MappedFile> file = MappedFile::Open(path);
+    if (!file || file->Size() < sizeof(Header)) {
+        return std::nullopt;
+    }
+
+    Header header;
+    std::memcpy(&header, file->Data(), sizeof(header));
+    if (std::memcmp(header.Magic, sMagic, sizeof(sMagic)) != 0 || header.Version != sVersion ||
+        (header.BitsPerDistance != 8 && header.BitsPerDistance != 16) || header.FileSize != file->Size()) {
+        return std::nullopt;
+    }
+
+    // Counts are checked against the file size before they are multiplied, so they can't overflow
+    uint64_t rowCells = static_cast<uint64_t>(header.Cells[0]) * header.Cells[1];
+    if (header.CellsOffset > header.FileSize || (rowCells != 0 && header.Cells[2] > header.FileSize / sizeof(Cell) / rowCells)) {
+        return std::nullopt;
+    }
+    uint64_t cellCount = rowCells * header.Cells[2];
+    uint64_t brickBytes = sSamplesPerBrick * header.BitsPerDistance / 8;
+    if (header.CellsOffset < sizeof(Header) || header.CellsOffset % 16 != 0 || header.BricksOffset % 16 != 0 ||
+        header.CellsOffset + cellCount * sizeof(Cell) > header.BricksOffset ||
+        header.BricksOffset + header.BrickCount * brickBytes != header.FileSize) {
+        return std::nullopt;
+    }
+
+    // Brick and the upload read bricks straight from the mapping, so every index has to be in the file
+    const Cell* cells = reinterpret_cast<const Cell*>(file->Data() + header.CellsOffset);
+    for (uint64_t i = 0; i < cellCount; i++) {
+        if (cells[i].Brick != sEmptyBrick && cells[i].Brick >= header.BrickCount) {
+            return std::nullopt;
+        }
+    }
+
+    BrickMap map;
+    map.mFile = std::move(file);
+    return map;
+}
+
+bool BrickMap::Save(const std::string& path) const
+{
+    std::filesystem::path filePath(path);
+    std::error_code error;
+    if (filePath.has_parent_path()) {
+        std::filesystem::create_directories(filePath.parent_path(), error);
+    }
+
+    // Written aside and renamed, so other runs never map a partially written file
+    std::filesystem::path temporaryPath = filePath;
+    temporaryPath += ".tmp";
+    {
+        std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(Data()), static_cast<std::streamsize>(SizeInBytes()));
+        if (!out) {
+            return false;
+        }
+    }
+    std::filesystem::rename(temporaryPath, filePath, error);
+    return !error;
+}
+
+uint64_t BrickMap::Fingerprint(const IShapedObject& object, const Math::AABB& bounds, const DistanceContext& context)
+{
+    // FNV-1a over bounds and distances at points of a low discrepancy sequence
+    uint64_t hash = 14695981039346656037ull;
+    auto hashFloat = [&hash](float value) {
+        unsigned char bytes[sizeof(float)];
+        std::memcpy(bytes, &value, sizeof(value));
+        for (unsigned char byte : bytes) {
+            hash = (hash ^ byte) * 1099511628211ull;
+        }
+    };
+
+    for (unsigned int i = 0; i < 3; i++) {
+        hashFloat(bounds.Min()[i]);
+        hashFloat(bounds.Max()[i]);
+    }
+    hashFloat(context.SmoothMin);
+
+    const unsigned int probeCount = 64;
+    Math::Vec3 size = bounds.Size();
+    for (unsigned int i = 1; i <= probeCount; i++) {
+        Math::Vec3 t(std::fmod(i * 0.8191725f, 1.0f), std::fmod(i * 0.6710436f, 1.0f), std::fmod(i * 0.5497005f, 1.0f));
+        Math::Vec3 p = bounds.Min() + Math::Vec3(t.x() * size.x(), t.y() * size.y(), t.z() * size.z());
+        hashFloat(object.Distance(p, context));
+    }
+    return hash;
+}
+
+const BrickMap::Header& BrickMap::GetHeader() const
+{
+    return *reinterpret_cast<const Header*>(Data());
+}
+
+Math::AABB BrickMap::Bounds() const
+{
+    const Header& header = GetHeader();
+    Math::Vec3 min(header.Min[0], header.Min[1], header.Min[2]);
+    Math::Vec3 cells(static_cast<float>(header.Cells[0]), static_cast<float>(header.Cells[1]), static_cast<float>(header.Cells[2]));
+    return Math::AABB(min, min + cells * (sBrickVoxels * header.VoxelSize));
+}
+
+const BrickMap::Cell& BrickMap::GetCell(unsigned int x, unsigned int y, unsigned int z) const
+{
+    const Header& header = GetHeader();
+    const Cell* cells = reinterpret_cast<const Cell*>(Data() + header.CellsOffset);
+    return cells[(static_cast<size_t>(z) * header.Cells[1] + y) * header.Cells[0] + x];
+}
+
+const void* BrickMap::Brick(unsigned int index) const
+{
+    return Data() + GetHeader().BricksOffset + index * BrickSizeInBytes();
+}
+
+size_t BrickMap::BrickSizeInBytes() const
+{
+    return sSamplesPerBrick * GetHeader().BitsPerDistance / 8;
+}
+
+size_t BrickMap::SizeInBytes() const
+{
+    return static_cast<size_t>(GetHeader().FileSize);
+}
+
+const unsigned char* BrickMap::Data() const
+{
+    return mFile ? mFile->Data() : mData.data();
+}
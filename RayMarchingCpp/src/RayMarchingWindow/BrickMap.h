@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "IShapedObject.h"
+#include "MappedFile.h"
+#include "Math/Math.h"
+
+/*
+    Sparse narrow band distance volume. Space is split into cells of
+    sBrickVoxels^3 voxels, cells the surface band passes through keep a
+    brick of sBrickSamples^3 distances quantized to 8 or 16 bits over
+    [-Band, Band]. Neighbour bricks share their border samples, so each
+    brick filters on its own. Other cells only keep a signed lower bound
+    of the distance inside them.
+    Memory layout is the cache file layout: header, cells, bricks. A loaded
+    map views the mapped file and its bricks are uploaded straight from it
+*/
+class BrickMap {
+public:
+    static constexpr unsigned int sBrickSamples = 8;
+    static constexpr unsigned int sBrickVoxels = sBrickSamples - 1;
+    static constexpr unsigned int sSamplesPerBrick = sBrickSamples * sBrickSamples * sBrickSamples;
+    static constexpr uint32_t sEmptyBrick = 0xffffffff;
+    static constexpr uint32_t sVersion = 2;
+
+    struct Header {
+        char Magic[4];
+        uint32_t Version;
+        // Identifies the baked object, see Fingerprint
+        uint64_t Fingerprint;
+        float Min[3];
+        float VoxelSize;
+        float Band;
+        uint32_t Cells[3];
+        uint32_t BitsPerDistance;
+        uint32_t BrickCount;
+        uint64_t CellsOffset;
+        uint64_t BricksOffset;
+        uint64_t FileSize;
+    };
+
+    struct Cell {
+        // Index of the cell brick or sEmptyBrick
+        uint32_t Brick;
+        // For empty cells |distance| inside the cell is at least |MinDistance|, sign tells the side
+        float MinDistance;
+    };
+public:
+    BrickMap(BrickMap&&) = default;
+    BrickMap& operator=(BrickMap&&) = default;
+
+    /*
+        Bakes bricks of cells within band of the surface. Cells whose
+        DistanceRange misses the band are skipped without sampling. bounds
+        are grown to a whole cell count, bitsPerDistance is 8 or 16
+    */
+    static BrickMap Bake(const IShapedObject& object, const Math::AABB& bounds, float voxelSize, float band, unsigned int bitsPerDistance,
+        uint64_t fingerprint, const DistanceContext& context, unsigned int threadCount = 0);
+    /*
+        Maps a cache file, returns nullopt if it's missing, truncated or of another version
+    */
+    static std::optional<BrickMap> Load(const std::string& path);
+    bool Save(const std::string& path) const;
+
+    /*
+        Hash of object bounds and its distance at fixed points inside them,
+        changes when object parameters do
+    */
+    static uint64_t Fingerprint(const IShapedObject& object, const Math::AABB& bounds, const DistanceContext& context);
+
+    const Header& GetHeader() const;
+    Math::AABB Bounds() const;
+    const Cell& GetCell(unsigned int x, unsigned int y, unsigned int z) const;
+    /*
+        sSamplesPerBrick quantized distances, x changes fastest
+    */
+    const void* Brick(unsigned int index) const;
+    size_t BrickSizeInBytes() const;
+    size_t SizeInBytes() const;
+private:
+    BrickMap() = default;
+    const unsigned char* Data() const;
+private:
+    // Either the map owns its data or it views a mapped file
+    std::vector<unsigned char> mData;
+    std::unique_ptr<MappedFile> mFile;
+};
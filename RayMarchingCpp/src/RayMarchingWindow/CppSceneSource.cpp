@@ -0,0 +1,46 @@
+#include "CppSceneSource.h"
+
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+
+std::string CppSceneSource::AddFunction(const std::string& body, const std::string& fixedParam)
+{
+    std::string name = "Object" + std::to_string(mFunctionCount++);
+    mFunctions += "static inline float " + name + "(vec3 p, const SceneContext& c)\n{\n";
+    std::stringstream lines(body);
+    for (std::string line; std::getline(lines, line);) {
+        mFunctions += "    " + line + '\n';
+    }
+    mFunctions += "}\n\n";
+    return name + '(' + fixedParam + ", c)";
+}
+
+std::string CppSceneSource::FallbackCall(const IShapedObject& object, const std::string& fixedParam)
+{
+    mFallbacks.push_back(&object);
+    return "Fallback(" + std::to_string(mFallbacks.size() - 1) + ", " + fixedParam + ", c)";
+}
+
+std::string CppSceneSource::Literal(float value)
+{
+    if (std::isnan(value)) {
+        return "std::numeric_limits<float>::quiet_NaN()";
+    }
+    if (std::isinf(value)) {
+        return value > 0.0f ? "std::numeric_limits<float>::infinity()" : "-std::numeric_limits<float>::infinity()";
+    }
+    // 9 significant digits are enough to get every float back exactly
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+    std::string literal = buffer;
+    if (literal.find_first_of(".e") == std::string::npos) {
+        literal += ".0";
+    }
+    return literal + 'f';
+}
+
+std::string CppSceneSource::Literal(const Math::Vec3& value)
+{
+    return "vec3{ " + Literal(value.x()) + ", " + Literal(value.y()) + ", " + Literal(value.z()) + " }";
+}
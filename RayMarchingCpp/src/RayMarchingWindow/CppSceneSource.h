@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Math/Math.h"
+
+struct IShapedObject;
+
+/*
+    C++ source of a scene being generated by SceneCompiler. Objects add a
+    function with their parameters written in as literals and return a
+    call of it, the same way they generate GLSL. Function bodies see
+    vec3 p and the SceneContext c, the prelude in SceneCompiler.cpp lists
+    the helpers they can use
+*/
+class CppSceneSource {
+public:
+    /*
+        Adds float ObjectN(vec3 p, const SceneContext& c) { body } and
+        returns its call with fixedParam
+    */
+    std::string AddFunction(const std::string& body, const std::string& fixedParam);
+    /*
+        Call of object's Distance on the host, for objects without C++ code
+    */
+    std::string FallbackCall(const IShapedObject& object, const std::string& fixedParam);
+
+    /*
+        Literals that read back as the same float
+    */
+    static std::string Literal(float value);
+    static std::string Literal(const Math::Vec3& value);
+
+    const std::string& Functions() const { return mFunctions; }
+    const std::vector<const IShapedObject*>& Fallbacks() const { return mFallbacks; }
+private:
+    std::string mFunctions;
+    std::vector<const IShapedObject*> mFallbacks;
+    unsigned int mFunctionCount = 0;
+};
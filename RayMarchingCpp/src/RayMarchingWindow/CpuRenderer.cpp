@@ -0,0 +1,158 @@
+#include "CpuRenderer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+void CpuRenderer::Render(const IShapedObject& object, const DistanceContext& context, const View& view, const QualityTier& tier,
+    bool shadows, unsigned int width, unsigned int height, float* outColors, unsigned int threadCount /* = 0 */)
+{
+    const size_t pixelCount = static_cast<size_t>(width) * height;
+    const size_t runCount = (pixelCount + PointBatch::sMaxCount - 1) / PointBatch::sMaxCount;
+    std::atomic<size_t> nextRun = 0;
+    auto worker = [&]() {
+        for (size_t run = nextRun++; run < runCount; run = nextRun++) {
+            size_t first = run * PointBatch::sMaxCount;
+            Shade(object, context, view, tier, shadows, width, height, first, std::min(pixelCount - first, PointBatch::sMaxCount),
+                outColors + first * 4);
+        }
+    };
+
+    if (threadCount == 0) {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < std::min<size_t>(threadCount, runCount); i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+void CpuRenderer::March(const IShapedObject& object, const DistanceContext& context, const QualityTier& tier, const float* origins[3],
+    const float* directions[3], size_t count, float* outDistances, float* outPoints[3])
+{
+    size_t active[PointBatch::sMaxCount];
+    float x[PointBatch::sMaxCount];
+    float y[PointBatch::sMaxCount];
+    float z[PointBatch::sMaxCount];
+    float distances[PointBatch::sMaxCount];
+    for (size_t i = 0; i < count; i++) {
+        outDistances[i] = 0.0f;
+        active[i] = i;
+    }
+
+    size_t activeCount = count;
+    for (int step = 0; step < tier.MaxSteps && activeCount > 0; step++) {
+        for (size_t k = 0; k < activeCount; k++) {
+            size_t i = active[k];
+            x[k] = outPoints[0][i] = origins[0][i] + directions[0][i] * outDistances[i];
+            y[k] = outPoints[1][i] = origins[1][i] + directions[1][i] * outDistances[i];
+            z[k] = outPoints[2][i] = origins[2][i] + directions[2][i] * outDistances[i];
+        }
+        PointBatch batch = { x, y, z, activeCount };
+        object.Distances(batch, distances, context);
+
+        // Finished rays drop out, the rest keep their order
+        size_t remaining = 0;
+        for (size_t k = 0; k < activeCount; k++) {
+            size_t i = active[k];
+            outDistances[i] += distances[k];
+            if (outDistances[i] > tier.MaxDistance || std::abs(distances[k]) < tier.SurfaceDistance) {
+                continue;
+            }
+            active[remaining++] = i;
+        }
+        activeCount = remaining;
+    }
+}
+
+void CpuRenderer::Shade(const IShapedObject& object, const DistanceContext& context, const View& view, const QualityTier& tier,
+    bool shadows, unsigned int width, unsigned int height, size_t first, size_t count, float* outColors)
+{
+    constexpr size_t sCount = PointBatch::sMaxCount;
+    float cameraX[sCount];
+    float cameraY[sCount];
+    float cameraZ[sCount];
+    float rayX[sCount];
+    float rayY[sCount];
+    float rayZ[sCount];
+
+    for (size_t i = 0; i < count; i++) {
+        size_t pixel = first + i;
+        float u = (static_cast<float>(pixel % width) + 0.5f - 0.5f * width) / height;
+        float v = (static_cast<float>(pixel / width) + 0.5f - 0.5f * height) / height;
+        Math::Vec3 direction = Math::RotateXZ(Math::Vec3(u, v, 1.0f), -view.CameraRotationY).Normalize();
+        cameraX[i] = view.CameraPosition.x();
+        cameraY[i] = view.CameraPosition.y();
+        cameraZ[i] = view.CameraPosition.z();
+        rayX[i] = direction.x();
+        rayY[i] = direction.y();
+        rayZ[i] = direction.z();
+    }
+
+    float distances[sCount];
+    float x[sCount];
+    float y[sCount];
+    float z[sCount];
+    const float* origins[3] = { cameraX, cameraY, cameraZ };
+    const float* directions[3] = { rayX, rayY, rayZ };
+    float* points[3] = { x, y, z };
+    March(object, context, tier, origins, directions, count, distances, points);
+
+    // GetNormal, each axis shifted back by SURFACE_DISTANCE in turn
+    float center[sCount];
+    float shifted[sCount];
+    float neighbours[3][sCount];
+    PointBatch batch = { x, y, z, count };
+    object.Distances(batch, center, context);
+    for (unsigned int axis = 0; axis < 3; axis++) {
+        for (size_t i = 0; i < count; i++) {
+            shifted[i] = points[axis][i] - tier.SurfaceDistance;
+        }
+        PointBatch shiftedBatch = { axis == 0 ? shifted : x, axis == 1 ? shifted : y, axis == 2 ? shifted : z, count };
+        object.Distances(shiftedBatch, neighbours[axis], context);
+    }
+
+    // GetLight, shadow rays start off the surface and go towards the light
+    float diffuse[sCount];
+    float lightDistances[sCount];
+    for (size_t i = 0; i < count; i++) {
+        Math::Vec3 normal(center[i] - neighbours[0][i], center[i] - neighbours[1][i], center[i] - neighbours[2][i]);
+        float length = normal.Magnitude();
+        normal = length > 0.0f ? normal / length : Math::Vec3(0.0f);
+        Math::Vec3 lightVector = view.LightPosition - Math::Vec3(x[i], y[i], z[i]);
+        lightDistances[i] = lightVector.Magnitude();
+        Math::Vec3 lightDirection = lightVector / lightDistances[i];
+        diffuse[i] = std::clamp(normal.Dot(lightDirection) * 0.5f + 0.5f, 0.0f, 1.0f);
+
+        cameraX[i] = x[i] + normal.x() * tier.SurfaceDistance;
+        cameraY[i] = y[i] + normal.y() * tier.SurfaceDistance;
+        cameraZ[i] = z[i] + normal.z() * tier.SurfaceDistance;
+        rayX[i] = lightDirection.x();
+        rayY[i] = lightDirection.y();
+        rayZ[i] = lightDirection.z();
+    }
+    if (shadows) {
+        float shadowDistances[sCount];
+        March(object, context, tier, origins, directions, count, shadowDistances, points);
+        for (size_t i = 0; i < count; i++) {
+            if (shadowDistances[i] < lightDistances[i]) {
+                diffuse[i] *= 0.2f;
+            }
+        }
+    }
+
+    // Fog
+    for (size_t i = 0; i < count; i++) {
+        float color = diffuse[i] * std::clamp(1.0f - distances[i] / tier.MaxDistance, 0.0f, 1.0f);
+        outColors[i * 4 + 0] = color;
+        outColors[i * 4 + 1] = color;
+        outColors[i * 4 + 2] = color;
+        outColors[i * 4 + 3] = 1.0f;
+    }
+}
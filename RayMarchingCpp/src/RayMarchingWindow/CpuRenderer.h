@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+
+#include "IShapedObject.h"
+#include "QualityTier.h"
+#include "Math/Math.h"
+
+/*
+    Fragment.shader on CPU, for rendering where there is no GPU: same
+    camera, march, normals, lighting, shadows and fog over an object such
+    as RayMarchingWindow::CpuScene. Rays of up to PointBatch::sMaxCount
+    pixels march in step through IShapedObject::Distances, these runs of
+    pixels are shared between worker threads
+*/
+class CpuRenderer {
+public:
+    struct View {
+        Math::Vec3 CameraPosition;
+        float CameraRotationY = 0.0f;
+        Math::Vec3 LightPosition;
+    };
+public:
+    /*
+        Writes width * height RGBA colors, rows go bottom to top as glReadPixels returns them
+    */
+    static void Render(const IShapedObject& object, const DistanceContext& context, const View& view, const QualityTier& tier,
+        bool shadows, unsigned int width, unsigned int height, float* outColors, unsigned int threadCount = 0);
+private:
+    /*
+        RayMarch of the shader for count rays. Writes the distance marched
+        and the last point the scene was evaluated at
+    */
+    static void March(const IShapedObject& object, const DistanceContext& context, const QualityTier& tier, const float* origins[3],
+        const float* directions[3], size_t count, float* outDistances, float* outPoints[3]);
+    static void Shade(const IShapedObject& object, const DistanceContext& context, const View& view, const QualityTier& tier,
+        bool shadows, unsigned int width, unsigned int height, size_t first, size_t count, float* outColors);
+};
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "OpenGL/Texture.h"
+
+/*
+    Values of shader globals read by distance functions, lets objects
+    evaluate their distance on CPU the same way the shader does
+*/
+struct DistanceContext {
+    float SmoothMin = 0.0f;
+    float Time = 0.0f;
+    const OpenGL::Texture* NoiseTexture = nullptr;
+};
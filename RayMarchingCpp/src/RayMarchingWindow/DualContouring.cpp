@@ -0,0 +1,377 @@
+#include "DualContouring.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+// Contouring tables of Ju et al., corner index is (x << 2) | (y << 1) | z and directions are X, Y, Z
+static constexpr int sEdgeCorners[12][2] = {
+    { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 },
+    { 0, 2 }, { 1, 3 }, { 4, 6 }, { 5, 7 },
+    { 0, 1 }, { 2, 3 }, { 4, 5 }, { 6, 7 }
+};
+static constexpr int sCellProcFaceMask[12][3] = {
+    { 0, 4, 0 }, { 1, 5, 0 }, { 2, 6, 0 }, { 3, 7, 0 }, { 0, 2, 1 }, { 4, 6, 1 },
+    { 1, 3, 1 }, { 5, 7, 1 }, { 0, 1, 2 }, { 2, 3, 2 }, { 4, 5, 2 }, { 6, 7, 2 }
+};
+static constexpr int sCellProcEdgeMask[6][5] = {
+    { 0, 1, 2, 3, 0 }, { 4, 5, 6, 7, 0 }, { 0, 4, 1, 5, 1 }, { 2, 6, 3, 7, 1 }, { 0, 2, 4, 6, 2 }, { 1, 3, 5, 7, 2 }
+};
+static constexpr int sFaceProcFaceMask[3][4][3] = {
+    { { 4, 0, 0 }, { 5, 1, 0 }, { 6, 2, 0 }, { 7, 3, 0 } },
+    { { 2, 0, 1 }, { 6, 4, 1 }, { 3, 1, 1 }, { 7, 5, 1 } },
+    { { 1, 0, 2 }, { 3, 2, 2 }, { 5, 4, 2 }, { 7, 6, 2 } }
+};
+static constexpr int sFaceProcEdgeMask[3][4][6] = {
+    { { 1, 4, 0, 5, 1, 1 }, { 1, 6, 2, 7, 3, 1 }, { 0, 4, 6, 0, 2, 2 }, { 0, 5, 7, 1, 3, 2 } },
+    { { 0, 2, 3, 0, 1, 0 }, { 0, 6, 7, 4, 5, 0 }, { 1, 2, 0, 6, 4, 2 }, { 1, 3, 1, 7, 5, 2 } },
+    { { 1, 1, 0, 3, 2, 0 }, { 1, 5, 4, 7, 6, 0 }, { 0, 1, 5, 0, 4, 1 }, { 0, 3, 7, 2, 6, 1 } }
+};
+static constexpr int sEdgeProcEdgeMask[3][2][5] = {
+    { { 3, 2, 1, 0, 0 }, { 7, 6, 5, 4, 0 } },
+    { { 5, 1, 4, 0, 1 }, { 7, 3, 6, 2, 1 } },
+    { { 6, 4, 2, 0, 2 }, { 7, 5, 3, 1, 2 } }
+};
+static constexpr int sProcessEdgeMask[3][4] = { { 3, 2, 1, 0 }, { 7, 5, 6, 4 }, { 11, 10, 9, 8 } };
+
+/*
+    Index of the same corner in SdfOctree order, (z << 2) | (y << 1) | x
+*/
+static unsigned int OctreeIndex(unsigned int index)
+{
+    return ((index & 1) << 2) | (index & 2) | ((index >> 2) & 1);
+}
+
+/*
+    True if the inside corners and the outside corners of a cell are each
+    connected along cell edges, the only case where one vertex can stand
+    for the surface in the cell without pinching it
+*/
+static bool IsManifold(uint8_t signs)
+{
+    for (uint8_t side : { signs, static_cast<uint8_t>(~signs) }) {
+        if (side == 0) {
+            continue;
+        }
+        uint8_t reached = side & -side;
+        for (uint8_t previous = 0; previous != reached;) {
+            previous = reached;
+            for (const int* edge : sEdgeCorners) {
+                if ((side >> edge[0]) & (side >> edge[1]) & ((reached >> edge[0]) | (reached >> edge[1])) & 1) {
+                    reached |= 1 << edge[0] | 1 << edge[1];
+                }
+            }
+        }
+        if (reached != side) {
+            return false;
+        }
+    }
+    return true;
+}
+
+DualContouring::DualContouring(const IShapedObject& object, const DistanceContext& context) : mObject(object), mContext(context)
+{
+}
+
+Mesh DualContouring::Extract(const IShapedObject& object, const SdfOctree& octree, const DistanceContext& context, float maxError,
+    Stats* stats /* = nullptr */, unsigned int threadCount /* = 0 */)
+{
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+    DualContouring contouring(object, context);
+    std::vector<int32_t> leaves;
+    contouring.mNodes.emplace_back();
+    contouring.AddNode(0, octree, octree.Root(), octree.Bounds(), leaves);
+
+    // Vertices of leaves are independent and the costly part, they're shared between worker threads
+    std::atomic<size_t> nextLeaf = 0;
+    auto worker = [&]() {
+        for (size_t i = nextLeaf++; i < leaves.size(); i = nextLeaf++) {
+            contouring.PlaceVertex(contouring.mNodes[leaves[i]]);
+        }
+    };
+    if (threadCount == 0) {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < std::min<size_t>(threadCount, leaves.size()); i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    Stats result;
+    result.LeafVertices = leaves.size();
+    contouring.Collapse(0, maxError, result);
+    contouring.CellProc(0);
+
+    result.Milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    if (stats) {
+        *stats = result;
+    }
+    return std::move(contouring.mMesh);
+}
+
+void DualContouring::AddNode(int32_t index, const SdfOctree& octree, uint32_t octreeNode, const Math::AABB& box, std::vector<int32_t>& leaves)
+{
+    mNodes[index].Box = box;
+    if (SdfOctree::IsLeaf(octreeNode)) {
+        Node& node = mNodes[index];
+        const std::array<float, 8>& corners = octree.Corners(octreeNode);
+        for (unsigned int i = 0; i < 8; i++) {
+            node.Distances[i] = corners[OctreeIndex(i)];
+            node.Signs |= (node.Distances[i] < 0.0f ? 1 : 0) << i;
+        }
+        if (node.Signs != 0 && node.Signs != 0xff) {
+            leaves.push_back(index);
+        }
+        return;
+    }
+
+    int32_t first = static_cast<int32_t>(mNodes.size());
+    mNodes.resize(mNodes.size() + 8);
+    mNodes[index].Children = first;
+    for (unsigned int i = 0; i < 8; i++) {
+        unsigned int octant = OctreeIndex(i);
+        AddNode(first + i, octree, octree.Child(octreeNode, octant), SdfOctree::Octant(box, octant), leaves);
+    }
+}
+
+void DualContouring::PlaceVertex(Node& node) const
+{
+    const float step = std::max(node.Box.Size().x() * 0.01f, 1e-4f);
+    for (unsigned int edge = 0; edge < 12; edge++) {
+        unsigned int c0 = sEdgeCorners[edge][0];
+        unsigned int c1 = sEdgeCorners[edge][1];
+        if (((node.Signs >> c0) & 1) == ((node.Signs >> c1) & 1)) {
+            continue;
+        }
+
+        // False position keeps the crossing bracketed while moving it onto the surface
+        Math::Vec3 p0 = Corner(node.Box, c0);
+        Math::Vec3 p1 = Corner(node.Box, c1);
+        float t0 = 0.0f, t1 = 1.0f;
+        float d0 = node.Distances[c0], d1 = node.Distances[c1];
+        float t = d0 / (d0 - d1);
+        for (unsigned int i = 0; i < sCrossingSteps; i++) {
+            float d = mObject.Distance(p0 + (p1 - p0) * t, mContext);
+            if ((d < 0.0f) == (d0 < 0.0f)) {
+                t0 = t;
+                d0 = d;
+            } else {
+                t1 = t;
+                d1 = d;
+            }
+            t = d0 == d1 ? t0 : t0 + (t1 - t0) * d0 / (d0 - d1);
+        }
+        Math::Vec3 p = p0 + (p1 - p0) * t;
+
+        Math::Vec3 gradient;
+        for (unsigned int axis = 0; axis < 3; axis++) {
+            Math::Vec3 offset;
+            offset[axis] = step;
+            gradient[axis] = mObject.Distance(p + offset, mContext) - mObject.Distance(p - offset, mContext);
+        }
+        float length = gradient.Magnitude();
+        if (length > 0.0f) {
+            node.Qef.Add(p, gradient / length);
+        }
+    }
+
+    // Vertices outside of their cell make folded triangles, the mass point is always inside
+    node.Vertex = node.Qef.Solve();
+    if (!node.Box.Expand(step).Contains(node.Vertex)) {
+        node.Vertex = node.Qef.MassPoint();
+    }
+    node.HasVertex = node.Qef.Count() > 0;
+}
+
+bool DualContouring::Collapse(int32_t index, float maxError, Stats& stats)
+{
+    // A leaf that isn't manifold keeps its neighbourhood from collapsing over it
+    if (mNodes[index].Children < 0) {
+        return IsManifold(mNodes[index].Signs);
+    }
+
+    const int32_t first = mNodes[index].Children;
+    bool childrenCollapsed = true;
+    for (unsigned int i = 0; i < 8; i++) {
+        childrenCollapsed = Collapse(first + i, maxError, stats) && childrenCollapsed;
+    }
+    if (!childrenCollapsed || maxError <= 0.0f) {
+        return false;
+    }
+
+    // Sign of every child corner, a 3x3x3 lattice over the node. A lattice point on a coarse edge,
+    // face or in the center with a sign none of the coarse corners around it has is a feature the
+    // coarse cell can't represent
+    auto latticeSign = [&](unsigned int x, unsigned int y, unsigned int z) {
+        unsigned int child = (x / 2) << 2 | (y / 2) << 1 | z / 2;
+        unsigned int corner = (x - x / 2) << 2 | (y - y / 2) << 1 | (z - z / 2);
+        return (mNodes[first + child].Signs >> corner) & 1;
+    };
+    uint8_t signs = 0;
+    for (unsigned int i = 0; i < 8; i++) {
+        signs |= latticeSign((i >> 2) * 2, ((i >> 1) & 1) * 2, (i & 1) * 2) << i;
+    }
+    if (!IsManifold(signs)) {
+        return false;
+    }
+    for (unsigned int i = 0; i < 27; i++) {
+        unsigned int x = i / 9, y = i / 3 % 3, z = i % 3;
+        if (x != 1 && y != 1 && z != 1) {
+            continue;
+        }
+        bool matches = false;
+        for (unsigned int corner = 0; corner < 8; corner++) {
+            bool around = (x == 1 || (corner >> 2) * 2 == x) && (y == 1 || ((corner >> 1) & 1) * 2 == y) && (z == 1 || (corner & 1) * 2 == z);
+            matches = matches || (around && ((signs >> corner) & 1) == latticeSign(x, y, z));
+        }
+        if (!matches) {
+            return false;
+        }
+    }
+
+    Math::Qef qef;
+    for (unsigned int i = 0; i < 8; i++) {
+        if (mNodes[first + i].HasVertex) {
+            qef.Add(mNodes[first + i].Qef);
+        }
+    }
+    Node& node = mNodes[index];
+    if (qef.Count() > 0) {
+        Math::Vec3 vertex = qef.Solve();
+        if (!node.Box.Contains(vertex) || std::sqrt(qef.Error(vertex) / qef.Count()) > maxError) {
+            return false;
+        }
+        node.Vertex = vertex;
+        node.HasVertex = true;
+        node.Qef = qef;
+    }
+    node.Signs = signs;
+    node.Children = -1;
+    stats.CollapsedNodes++;
+    return true;
+}
+
+void DualContouring::CellProc(int32_t index)
+{
+    const int32_t first = mNodes[index].Children;
+    if (first < 0) {
+        return;
+    }
+
+    for (unsigned int i = 0; i < 8; i++) {
+        CellProc(first + i);
+    }
+    for (unsigned int i = 0; i < 12; i++) {
+        FaceProc({ first + sCellProcFaceMask[i][0], first + sCellProcFaceMask[i][1] }, sCellProcFaceMask[i][2]);
+    }
+    for (unsigned int i = 0; i < 6; i++) {
+        EdgeProc({ first + sCellProcEdgeMask[i][0], first + sCellProcEdgeMask[i][1], first + sCellProcEdgeMask[i][2],
+            first + sCellProcEdgeMask[i][3] }, sCellProcEdgeMask[i][4]);
+    }
+}
+
+void DualContouring::FaceProc(const std::array<int32_t, 2>& nodes, unsigned int dir)
+{
+    if (mNodes[nodes[0]].Children < 0 && mNodes[nodes[1]].Children < 0) {
+        return;
+    }
+
+    // Leaves stand in for all of their would be children
+    auto child = [&](int32_t node, int index) {
+        return mNodes[node].Children < 0 ? node : mNodes[node].Children + index;
+    };
+    for (unsigned int i = 0; i < 4; i++) {
+        const int* mask = sFaceProcFaceMask[dir][i];
+        FaceProc({ child(nodes[0], mask[0]), child(nodes[1], mask[1]) }, mask[2]);
+    }
+
+    const unsigned int orders[2][4] = { { 0, 0, 1, 1 }, { 0, 1, 0, 1 } };
+    for (unsigned int i = 0; i < 4; i++) {
+        const int* mask = sFaceProcEdgeMask[dir][i];
+        const unsigned int* order = orders[mask[0]];
+        std::array<int32_t, 4> edgeNodes;
+        for (unsigned int j = 0; j < 4; j++) {
+            edgeNodes[j] = child(nodes[order[j]], mask[j + 1]);
+        }
+        EdgeProc(edgeNodes, mask[5]);
+    }
+}
+
+void DualContouring::EdgeProc(const std::array<int32_t, 4>& nodes, unsigned int dir)
+{
+    bool leaves = std::all_of(nodes.begin(), nodes.end(), [this](int32_t node) { return mNodes[node].Children < 0; });
+    if (leaves) {
+        ProcessEdge(nodes, dir);
+        return;
+    }
+
+    for (unsigned int i = 0; i < 2; i++) {
+        const int* mask = sEdgeProcEdgeMask[dir][i];
+        std::array<int32_t, 4> edgeNodes;
+        for (unsigned int j = 0; j < 4; j++) {
+            edgeNodes[j] = mNodes[nodes[j]].Children < 0 ? nodes[j] : mNodes[nodes[j]].Children + mask[j];
+        }
+        EdgeProc(edgeNodes, mask[4]);
+    }
+}
+
+void DualContouring::ProcessEdge(const std::array<int32_t, 4>& nodes, unsigned int dir)
+{
+    // The smallest cell around the edge holds the shortest piece of it, its signs decide the quad
+    unsigned int smallest = 0;
+    for (unsigned int i = 1; i < 4; i++) {
+        if (mNodes[nodes[i]].Box.Size().x() < mNodes[nodes[smallest]].Box.Size().x()) {
+            smallest = i;
+        }
+    }
+    const Node& node = mNodes[nodes[smallest]];
+    const int edge = sProcessEdgeMask[dir][smallest];
+    bool inside0 = (node.Signs >> sEdgeCorners[edge][0]) & 1;
+    bool inside1 = (node.Signs >> sEdgeCorners[edge][1]) & 1;
+    if (inside0 == inside1) {
+        return;
+    }
+    for (int32_t index : nodes) {
+        if (!mNodes[index].HasVertex) {
+            return;
+        }
+    }
+
+    uint32_t indices[4];
+    for (unsigned int i = 0; i < 4; i++) {
+        indices[i] = MeshIndex(mNodes[nodes[i]]);
+    }
+    const unsigned int triangles[2][2][3] = {
+        { { 0, 3, 1 }, { 0, 2, 3 } },
+        { { 0, 1, 3 }, { 0, 3, 2 } }
+    };
+    for (const unsigned int* triangle : triangles[inside0 ? 0 : 1]) {
+        uint32_t a = indices[triangle[0]], b = indices[triangle[1]], c = indices[triangle[2]];
+        // Cells sharing a collapsed vertex turn their quad into a single triangle
+        if (a != b && b != c && a != c) {
+            mMesh.Triangles.insert(mMesh.Triangles.end(), { a, b, c });
+        }
+    }
+}
+
+uint32_t DualContouring::MeshIndex(Node& node)
+{
+    if (node.MeshIndex < 0) {
+        node.MeshIndex = static_cast<int32_t>(mMesh.VertexCount());
+        mMesh.Vertices.insert(mMesh.Vertices.end(), { node.Vertex.x(), node.Vertex.y(), node.Vertex.z() });
+    }
+    return static_cast<uint32_t>(node.MeshIndex);
+}
+
+Math::Vec3 DualContouring::Corner(const Math::AABB& box, unsigned int index)
+{
+    Math::Vec3 size = box.Size();
+    return box.Min() + Math::Vec3((index >> 2) & 1 ? size.x() : 0.0f, (index >> 1) & 1 ? size.y() : 0.0f, index & 1 ? size.z() : 0.0f);
+}
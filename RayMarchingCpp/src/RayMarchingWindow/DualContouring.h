@@ -0,0 +1,74 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "IShapedObject.h"
+#include "Mesh.h"
+#include "SdfOctree.h"
+#include "Math/Math.h"
+
+/*
+    Dual contouring over an SdfOctree. Every leaf the surface passes
+    through gets one vertex at the minimizer of the QEF of its edge
+    crossings and the object's gradients there, so vertices land on edges
+    and corners of the surface instead of cutting them like marching cubes
+    does. Subtrees whose merged QEF still fits the surface within maxError
+    are collapsed into a single vertex, unless that would change the
+    signs seen on the coarse cell or pinch its surface, and flat parts end
+    up with few large triangles. Quads are emitted for every edge with a sign change
+    shared by four cells, using the smallest of them (Ju et al. 2002)
+*/
+class DualContouring {
+public:
+    struct Stats {
+        size_t LeafVertices = 0;
+        size_t CollapsedNodes = 0;
+        double Milliseconds = 0.0;
+    };
+public:
+    /*
+        maxError is the RMS distance of a collapsed vertex from the planes
+        of its crossings, 0 keeps every leaf vertex
+    */
+    static Mesh Extract(const IShapedObject& object, const SdfOctree& octree, const DistanceContext& context, float maxError,
+        Stats* stats = nullptr, unsigned int threadCount = 0);
+private:
+    struct Node {
+        Math::AABB Box;
+        // Index of the first of eight children in mNodes or -1. Children and corners follow the order of
+        // the contouring tables, index (x << 2) | (y << 1) | z, unlike SdfOctree
+        int32_t Children = -1;
+        // Bit i set if corner i is inside
+        uint8_t Signs = 0;
+        // Corner distances of octree leaves
+        std::array<float, 8> Distances = {};
+        bool HasVertex = false;
+        Math::Vec3 Vertex;
+        int32_t MeshIndex = -1;
+        Math::Qef Qef;
+    };
+
+    DualContouring(const IShapedObject& object, const DistanceContext& context);
+
+    void AddNode(int32_t index, const SdfOctree& octree, uint32_t octreeNode, const Math::AABB& box, std::vector<int32_t>& leaves);
+    void PlaceVertex(Node& node) const;
+    bool Collapse(int32_t index, float maxError, Stats& stats);
+
+    void CellProc(int32_t node);
+    void FaceProc(const std::array<int32_t, 2>& nodes, unsigned int dir);
+    void EdgeProc(const std::array<int32_t, 4>& nodes, unsigned int dir);
+    void ProcessEdge(const std::array<int32_t, 4>& nodes, unsigned int dir);
+    uint32_t MeshIndex(Node& node);
+
+    static Math::Vec3 Corner(const Math::AABB& box, unsigned int index);
+private:
+    // False position steps refining an edge crossing after the linear guess
+    static constexpr unsigned int sCrossingSteps = 4;
+
+    const IShapedObject& mObject;
+    const DistanceContext& mContext;
+    std::vector<Node> mNodes;
+    Mesh mMesh;
+};
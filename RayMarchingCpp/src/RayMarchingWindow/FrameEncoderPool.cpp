@@ -0,0 +1,97 @@
+#include "FrameEncoderPool.h"
+
+#include "ImageWriter.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+    unsigned int EncoderCount(unsigned int threadCount)
+    {
+        return threadCount != 0 ? threadCount : std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+
+}
+
+FrameEncoderPool::FrameEncoderPool(Format format, unsigned int threadCount /* = 0 */, unsigned int capacity /* = 0 */) :
+    mFormat(format), mFrames(capacity != 0 ? capacity : EncoderCount(threadCount) * 2), mSlots(mFrames.size())
+{
+    for (unsigned int i = 0; i < EncoderCount(threadCount); i++) {
+        mThreads.emplace_back(&FrameEncoderPool::Work, this);
+    }
+}
+
+FrameEncoderPool::~FrameEncoderPool()
+{
+    Finish();
+}
+
+FrameEncoderPool::Frame& FrameEncoderPool::Acquire()
+{
+    return mFrames[*mSlots.Acquire()];
+}
+
+void FrameEncoderPool::Submit(Frame& frame)
+{
+    mSlots.Submit(static_cast<size_t>(&frame - mFrames.data()));
+}
+
+FrameEncoderPool::Stats FrameEncoderPool::Finish()
+{
+    mSlots.Close();
+    for (std::thread& thread : mThreads) {
+        thread.join();
+    }
+    mThreads.clear();
+
+    FrameSlotQueue::Stats slots = mSlots.GetStats();
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStats.StalledFrames = slots.StalledFrames;
+    mStats.WaitMilliseconds = slots.WaitMilliseconds;
+    mStats.MaxQueued = slots.MaxQueued;
+    return mStats;
+}
+
+void FrameEncoderPool::Work()
+{
+    // Conversion scratch of this encoder, kept between frames
+    std::vector<unsigned char> pixels;
+    std::vector<float> colors;
+
+    while (std::optional<size_t> slot = mSlots.Take()) {
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        bool written = Encode(mFrames[*slot], pixels, colors);
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStats.Frames++;
+            mStats.Failures += written ? 0 : 1;
+            mStats.EncodeMilliseconds += milliseconds;
+        }
+        mSlots.Release(*slot);
+    }
+}
+
+bool FrameEncoderPool::Encode(Frame& frame, std::vector<unsigned char>& pixels, std::vector<float>& colors) const
+{
+    const size_t count = static_cast<size_t>(frame.Width) * frame.Height * 4;
+    if (mFormat == Format::Png) {
+        if (frame.Pixels.size() != count) {
+            pixels.resize(count);
+            for (size_t i = 0; i < count; i++) {
+                pixels[i] = static_cast<unsigned char>(std::clamp(frame.Colors[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+            }
+        }
+        return ImageWriter::WritePng(frame.Path, frame.Width, frame.Height, frame.Pixels.size() == count ? frame.Pixels.data() : pixels.data());
+    }
+
+    if (frame.Colors.size() != count) {
+        colors.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            colors[i] = frame.Pixels[i] / 255.0f;
+        }
+    }
+    return ImageWriter::WriteExr(frame.Path, frame.Width, frame.Height, frame.Colors.size() == count ? frame.Colors.data() : colors.data());
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FrameSlotQueue.h"
+
+/*
+    Encodes and writes rendered frames on worker threads, so the render
+    thread only fills pixels, see ImageWriter. Frames live in a fixed set
+    of capacity slots of a FrameSlotQueue reused for the whole sequence,
+    encoders give a slot back once its file is written
+*/
+class FrameEncoderPool {
+public:
+    enum class Format {
+        Png,
+        Exr
+    };
+
+    /*
+        Rows go bottom to top. Only one of Pixels and Colors is filled,
+        the other one is converted from it if the format needs it
+    */
+    struct Frame {
+        std::string Path;
+        unsigned int Width = 0;
+        unsigned int Height = 0;
+        std::vector<unsigned char> Pixels;
+        std::vector<float> Colors;
+    };
+
+    struct Stats {
+        uint64_t Frames = 0;
+        uint64_t Failures = 0;
+        // Frames whose Acquire waited for a free slot and the time it took
+        uint64_t StalledFrames = 0;
+        double WaitMilliseconds = 0.0;
+        // Summed over all encoders
+        double EncodeMilliseconds = 0.0;
+        size_t MaxQueued = 0;
+    };
+public:
+    /*
+        Zero threadCount leaves one hardware thread to the renderer, zero
+        capacity gives two slots per encoder
+    */
+    FrameEncoderPool(Format format, unsigned int threadCount = 0, unsigned int capacity = 0);
+    ~FrameEncoderPool();
+
+    FrameEncoderPool(const FrameEncoderPool&) = delete;
+    FrameEncoderPool& operator=(const FrameEncoderPool&) = delete;
+
+    Frame& Acquire();
+    void Submit(Frame& frame);
+    /*
+        Waits until every submitted frame is written and stops the encoders
+    */
+    Stats Finish();
+
+    unsigned int ThreadCount() const { return static_cast<unsigned int>(mThreads.size()); }
+    size_t Capacity() const { return mFrames.size(); }
+private:
+    void Work();
+    bool Encode(Frame& frame, std::vector<unsigned char>& pixels, std::vector<float>& colors) const;
+private:
+    Format mFormat;
+    std::vector<Frame> mFrames;
+    FrameSlotQueue mSlots;
+    // Guards mStats, which every encoder adds to
+    std::mutex mMutex;
+    Stats mStats;
+    std::vector<std::thread> mThreads;
+};
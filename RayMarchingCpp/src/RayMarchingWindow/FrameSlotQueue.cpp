@@ -0,0 +1,74 @@
+#include "FrameSlotQueue.h"
+
+#include <algorithm>
+#include <chrono>
+
+FrameSlotQueue::FrameSlotQueue(size_t capacity) : mCapacity(capacity)
+{
+    for (size_t slot = 0; slot < capacity; slot++) {
+        mFree.push_back(slot);
+    }
+}
+
+std::optional<size_t> FrameSlotQueue::Acquire(bool wait /* = true */)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    if (mFree.empty()) {
+        if (!wait) {
+            return std::nullopt;
+        }
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        mSlotFreed.wait(lock, [this]() { return !mFree.empty(); });
+        mStats.StalledFrames++;
+        mStats.WaitMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    }
+    size_t slot = mFree.back();
+    mFree.pop_back();
+    return slot;
+}
+
+void FrameSlotQueue::Submit(size_t slot)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mQueue.push_back(slot);
+        mStats.MaxQueued = std::max(mStats.MaxQueued, mQueue.size());
+    }
+    mSlotQueued.notify_one();
+}
+
+std::optional<size_t> FrameSlotQueue::Take()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mSlotQueued.wait(lock, [this]() { return mClosed || !mQueue.empty(); });
+    if (mQueue.empty()) {
+        return std::nullopt;
+    }
+    size_t slot = mQueue.front();
+    mQueue.pop_front();
+    return slot;
+}
+
+void FrameSlotQueue::Release(size_t slot)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mFree.push_back(slot);
+    }
+    mSlotFreed.notify_one();
+}
+
+void FrameSlotQueue::Close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mClosed = true;
+    }
+    mSlotQueued.notify_all();
+}
+
+FrameSlotQueue::Stats FrameSlotQueue::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mStats;
+}
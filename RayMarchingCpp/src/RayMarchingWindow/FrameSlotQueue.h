@@ -0,0 +1,58 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+/*
+    Bounded queue of frame slots shared by a render thread and the threads
+    writing its frames out, see FrameEncoderPool and FrameStreamer. Slots
+    are indices into frames the owner keeps for the whole sequence: the
+    render thread acquires a free one, fills it and submits it, a worker
+    takes it, writes it and releases it. Acquire waits only when every
+    slot is queued or being written, that wait is reported as back-pressure
+*/
+class FrameSlotQueue {
+public:
+    struct Stats {
+        // Acquires that waited for a free slot and the time it took
+        uint64_t StalledFrames = 0;
+        double WaitMilliseconds = 0.0;
+        size_t MaxQueued = 0;
+    };
+public:
+    explicit FrameSlotQueue(size_t capacity);
+
+    FrameSlotQueue(const FrameSlotQueue&) = delete;
+    FrameSlotQueue& operator=(const FrameSlotQueue&) = delete;
+
+    /*
+        A free slot. When none is free, waits for one if wait or returns
+        nullopt at once otherwise
+    */
+    std::optional<size_t> Acquire(bool wait = true);
+    void Submit(size_t slot);
+    /*
+        Next submitted slot, waiting for one. Nullopt once Close was called
+        and every submitted slot was taken
+    */
+    std::optional<size_t> Take();
+    void Release(size_t slot);
+    void Close();
+
+    size_t Capacity() const { return mCapacity; }
+    Stats GetStats() const;
+private:
+    size_t mCapacity;
+    std::vector<size_t> mFree;
+    std::deque<size_t> mQueue;
+    mutable std::mutex mMutex;
+    std::condition_variable mSlotFreed;
+    std::condition_variable mSlotQueued;
+    bool mClosed = false;
+    Stats mStats;
+};
@@ -0,0 +1,281 @@
+#include "FrameStreamer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#include <emmintrin.h>
+#define FRAME_STREAMER_SSE2
+#endif
+
+namespace {
+
+    const char sFrameMarker[] = "FRAME\n";
+    constexpr size_t sFrameMarkerSize = sizeof(sFrameMarker) - 1;
+
+    // BT.601 studio range in 8 bit fixed point
+    unsigned char Luma(int r, int g, int b)
+    {
+        return static_cast<unsigned char>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+    }
+
+    unsigned char ChromaBlue(int r, int g, int b)
+    {
+        return static_cast<unsigned char>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+    }
+
+    unsigned char ChromaRed(int r, int g, int b)
+    {
+        return static_cast<unsigned char>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+    }
+
+#ifdef FRAME_STREAMER_SSE2
+    /*
+        Red, green and blue of 8 pixels as 16 bit lanes
+    */
+    void LoadChannels(const unsigned char* rgba, __m128i& r, __m128i& g, __m128i& b)
+    {
+        const __m128i mask = _mm_set1_epi32(0xFF);
+        __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba));
+        __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + 16));
+        r = _mm_packs_epi32(_mm_and_si128(first, mask), _mm_and_si128(second, mask));
+        g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(first, 8), mask), _mm_and_si128(_mm_srli_epi32(second, 8), mask));
+        b = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(first, 16), mask), _mm_and_si128(_mm_srli_epi32(second, 16), mask));
+    }
+
+    /*
+        Luma sums stay below 2^16, so they wrap as signed lanes but shift right correctly as unsigned ones
+    */
+    void StoreLuma(const __m128i& r, const __m128i& g, const __m128i& b, unsigned char* out)
+    {
+        __m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(66)), _mm_mullo_epi16(g, _mm_set1_epi16(129))),
+            _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(25)), _mm_set1_epi16(128)));
+        __m128i luma = _mm_add_epi16(_mm_srli_epi16(sum, 8), _mm_set1_epi16(16));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(luma, luma));
+    }
+
+    /*
+        Means of horizontal pairs of two row sums, in the low 4 lanes
+    */
+    __m128i BlockMeans(const __m128i& row0, const __m128i& row1)
+    {
+        __m128i sums = _mm_madd_epi16(_mm_add_epi16(row0, row1), _mm_set1_epi16(1));
+        __m128i means = _mm_srli_epi32(_mm_add_epi32(sums, _mm_set1_epi32(2)), 2);
+        return _mm_packs_epi32(means, means);
+    }
+
+    void StoreChroma(const __m128i& r, const __m128i& g, const __m128i& b, short cr, short cg, short cb, unsigned char* out)
+    {
+        __m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(cr)), _mm_mullo_epi16(g, _mm_set1_epi16(cg))),
+            _mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(cb)), _mm_set1_epi16(128)));
+        __m128i chroma = _mm_add_epi16(_mm_srai_epi16(sum, 8), _mm_set1_epi16(128));
+        int packed = _mm_cvtsi128_si32(_mm_packus_epi16(chroma, chroma));
+        std::memcpy(out, &packed, 4);
+    }
+
+    void Convert8(const unsigned char* row0, const unsigned char* row1, unsigned char* luma0, unsigned char* luma1,
+        unsigned char* blue, unsigned char* red)
+    {
+        __m128i r0, g0, b0, r1, g1, b1;
+        LoadChannels(row0, r0, g0, b0);
+        LoadChannels(row1, r1, g1, b1);
+        StoreLuma(r0, g0, b0, luma0);
+        StoreLuma(r1, g1, b1, luma1);
+
+        __m128i r = BlockMeans(r0, r1);
+        __m128i g = BlockMeans(g0, g1);
+        __m128i b = BlockMeans(b0, b1);
+        StoreChroma(r, g, b, -38, -74, 112, blue);
+        StoreChroma(r, g, b, 112, -94, -18, red);
+    }
+#endif
+
+}
+
+FrameStreamer::FrameStreamer(const std::string& path, Format format, Policy policy, unsigned int width, unsigned int height,
+    unsigned int rateNumerator, unsigned int rateDenominator /* = 1 */, unsigned int capacity /* = 4 */) :
+    mFormat(format), mPolicy(policy), mWidth(width), mHeight(height), mFrames(std::max(capacity, 1u)), mSlots(mFrames.size())
+{
+    if (path == "-") {
+        mFile = stdout;
+#ifdef _WIN32
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    } else {
+        mFile = std::fopen(path.c_str(), "wb");
+        mOwnsFile = true;
+    }
+    if (!mFile) {
+        return;
+    }
+    if (mFormat == Format::Y4m) {
+        mBroken = std::fprintf(mFile, "YUV4MPEG2 W%u H%u F%u:%u Ip A1:1 C420jpeg\n", width, height, rateNumerator, rateDenominator) < 0;
+    }
+    mThread = std::thread(&FrameStreamer::Work, this);
+}
+
+FrameStreamer::~FrameStreamer()
+{
+    Finish();
+}
+
+FrameStreamer::Frame* FrameStreamer::Acquire()
+{
+    // Without a writer no slot is ever given back
+    std::optional<size_t> slot;
+    if (mThread.joinable()) {
+        slot = mSlots.Acquire(mPolicy == Policy::Block);
+    }
+    if (!slot) {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStats.DroppedFrames++;
+        return nullptr;
+    }
+    return &mFrames[*slot];
+}
+
+void FrameStreamer::Submit(Frame& frame)
+{
+    mSlots.Submit(static_cast<size_t>(&frame - mFrames.data()));
+}
+
+FrameStreamer::Stats FrameStreamer::Finish()
+{
+    mSlots.Close();
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+
+    FrameSlotQueue::Stats slots = mSlots.GetStats();
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStats.StalledFrames = slots.StalledFrames;
+    mStats.WaitMilliseconds = slots.WaitMilliseconds;
+    mStats.MaxQueued = slots.MaxQueued;
+    if (mFile) {
+        mStats.Failures += std::fflush(mFile) != 0 && !mBroken ? 1 : 0;
+        if (mOwnsFile) {
+            std::fclose(mFile);
+        }
+        mFile = nullptr;
+    }
+    return mStats;
+}
+
+size_t FrameStreamer::FrameSizeInBytes() const
+{
+    if (mFormat == Format::Rgba) {
+        return static_cast<size_t>(mWidth) * mHeight * 4;
+    }
+    size_t chromaSize = static_cast<size_t>((mWidth + 1) / 2) * ((mHeight + 1) / 2);
+    return sFrameMarkerSize + static_cast<size_t>(mWidth) * mHeight + chromaSize * 2;
+}
+
+void FrameStreamer::ConvertToYuv420(const unsigned char* rgba, unsigned int width, unsigned int height, unsigned char* out,
+    bool simd /* = true */)
+{
+    const unsigned int chromaWidth = (width + 1) / 2;
+    const unsigned int chromaHeight = (height + 1) / 2;
+    unsigned char* bluePlane = out + static_cast<size_t>(width) * height;
+    unsigned char* redPlane = bluePlane + static_cast<size_t>(chromaWidth) * chromaHeight;
+
+    for (unsigned int chromaY = 0; chromaY < chromaHeight; chromaY++) {
+        // The last row of an odd height is its own pair
+        unsigned int y0 = chromaY * 2;
+        unsigned int y1 = std::min(y0 + 1, height - 1);
+        const unsigned char* row0 = rgba + static_cast<size_t>(height - 1 - y0) * width * 4;
+        const unsigned char* row1 = rgba + static_cast<size_t>(height - 1 - y1) * width * 4;
+        unsigned char* luma0 = out + static_cast<size_t>(y0) * width;
+        unsigned char* luma1 = out + static_cast<size_t>(y1) * width;
+        unsigned char* blue = bluePlane + static_cast<size_t>(chromaY) * chromaWidth;
+        unsigned char* red = redPlane + static_cast<size_t>(chromaY) * chromaWidth;
+
+        unsigned int x = 0;
+#ifdef FRAME_STREAMER_SSE2
+        for (; simd && x + 8 <= width; x += 8) {
+            Convert8(row0 + x * 4, row1 + x * 4, luma0 + x, luma1 + x, blue + x / 2, red + x / 2);
+        }
+#endif
+        for (; x < width; x += 2) {
+            unsigned int x1 = std::min(x + 1, width - 1);
+            const unsigned char* pixels[4] = { row0 + x * 4, row0 + x1 * 4, row1 + x * 4, row1 + x1 * 4 };
+            int sums[3] = { 0, 0, 0 };
+            for (const unsigned char* pixel : pixels) {
+                for (int channel = 0; channel < 3; channel++) {
+                    sums[channel] += pixel[channel];
+                }
+            }
+            luma0[x] = Luma(pixels[0][0], pixels[0][1], pixels[0][2]);
+            luma0[x1] = Luma(pixels[1][0], pixels[1][1], pixels[1][2]);
+            luma1[x] = Luma(pixels[2][0], pixels[2][1], pixels[2][2]);
+            luma1[x1] = Luma(pixels[3][0], pixels[3][1], pixels[3][2]);
+            int r = (sums[0] + 2) >> 2;
+            int g = (sums[1] + 2) >> 2;
+            int b = (sums[2] + 2) >> 2;
+            blue[x / 2] = ChromaBlue(r, g, b);
+            red[x / 2] = ChromaRed(r, g, b);
+        }
+    }
+}
+
+void FrameStreamer::Work()
+{
+    // Conversion buffers of the writer, kept between frames
+    std::vector<unsigned char> pixels;
+    std::vector<unsigned char> scratch;
+
+    while (std::optional<size_t> slot = mSlots.Take()) {
+        bool written = !mBroken && Write(mFrames[*slot], pixels, scratch);
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStats.Frames += written ? 1 : 0;
+            mStats.DroppedFrames += mBroken ? 1 : 0;
+            mStats.Failures += !mBroken && !written ? 1 : 0;
+        }
+        mBroken = mBroken || !written;
+        mSlots.Release(*slot);
+    }
+}
+
+bool FrameStreamer::Write(Frame& frame, std::vector<unsigned char>& pixels, std::vector<unsigned char>& scratch)
+{
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    const size_t count = static_cast<size_t>(mWidth) * mHeight * 4;
+    const unsigned char* rgba = frame.Pixels.data();
+    if (frame.Pixels.size() != count) {
+        pixels.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            pixels[i] = static_cast<unsigned char>(std::clamp(frame.Colors[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+        }
+        rgba = pixels.data();
+    }
+    if (mFormat == Format::Y4m) {
+        scratch.resize(FrameSizeInBytes());
+        std::memcpy(scratch.data(), sFrameMarker, sFrameMarkerSize);
+        ConvertToYuv420(rgba, mWidth, mHeight, scratch.data() + sFrameMarkerSize);
+    }
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+
+    bool written = true;
+    if (mFormat == Format::Y4m) {
+        written = std::fwrite(scratch.data(), 1, scratch.size(), mFile) == scratch.size();
+    } else {
+        const size_t rowSize = static_cast<size_t>(mWidth) * 4;
+        for (unsigned int y = mHeight; written && y > 0; y--) {
+            written = std::fwrite(rgba + (y - 1) * rowSize, 1, rowSize, mFile) == rowSize;
+        }
+    }
+    std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStats.ConvertMilliseconds += std::chrono::duration<double, std::milli>(t1 - t0).count();
+    mStats.WriteMilliseconds += std::chrono::duration<double, std::milli>(t2 - t1).count();
+    mStats.Bytes += written ? FrameSizeInBytes() : 0;
+    return written;
+}
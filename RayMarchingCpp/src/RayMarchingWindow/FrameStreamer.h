@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FrameSlotQueue.h"
+
+/*
+    Writes rendered frames as one uncompressed stream to a file, a named
+    pipe or stdout for an external encoder, from a writer thread. Y4m is
+    YUV 4:2:0 with BT.601 studio range colors, Rgba is raw top to bottom
+    rows as "-f rawvideo -pix_fmt rgba" reads them. Frames live in
+    capacity slots of a FrameSlotQueue. When all of them wait for the
+    writer the Block policy makes Acquire wait, the Drop policy skips the
+    frame instead so a slow reader doesn't slow the renderer
+*/
+class FrameStreamer {
+public:
+    enum class Format {
+        Y4m,
+        Rgba
+    };
+
+    enum class Policy {
+        Block,
+        Drop
+    };
+
+    /*
+        Rows go bottom to top. Only one of Pixels and Colors is filled,
+        Colors are converted to bytes by the writer
+    */
+    struct Frame {
+        std::vector<unsigned char> Pixels;
+        std::vector<float> Colors;
+    };
+
+    struct Stats {
+        uint64_t Frames = 0;
+        // Frames skipped by the Drop policy or lost once the stream broke
+        uint64_t DroppedFrames = 0;
+        uint64_t Failures = 0;
+        // Frames whose Acquire waited for a free slot and the time it took
+        uint64_t StalledFrames = 0;
+        double WaitMilliseconds = 0.0;
+        double ConvertMilliseconds = 0.0;
+        double WriteMilliseconds = 0.0;
+        uint64_t Bytes = 0;
+        size_t MaxQueued = 0;
+    };
+public:
+    /*
+        "-" is stdout. Opening a named pipe waits until the other end opens
+        it. Frame rate goes to the Y4M header as rateNumerator:rateDenominator
+    */
+    FrameStreamer(const std::string& path, Format format, Policy policy, unsigned int width, unsigned int height,
+        unsigned int rateNumerator, unsigned int rateDenominator = 1, unsigned int capacity = 4);
+    ~FrameStreamer();
+
+    FrameStreamer(const FrameStreamer&) = delete;
+    FrameStreamer& operator=(const FrameStreamer&) = delete;
+
+    bool IsOpen() const { return mFile != nullptr; }
+    /*
+        Null when the frame is dropped
+    */
+    Frame* Acquire();
+    void Submit(Frame& frame);
+    /*
+        Waits until every submitted frame is written, stops the writer and
+        closes the stream
+    */
+    Stats Finish();
+
+    size_t Capacity() const { return mFrames.size(); }
+    size_t FrameSizeInBytes() const;
+
+    /*
+        Y plane then U and V planes of (width + 1) / 2 by (height + 1) / 2
+        samples, each of them the mean color of a 2x2 block. rgba rows go
+        bottom to top, planes top to bottom. SSE2 converts 8 pixels of two
+        rows at once and gives the same bytes as the scalar code
+    */
+    static void ConvertToYuv420(const unsigned char* rgba, unsigned int width, unsigned int height, unsigned char* out,
+        bool simd = true);
+private:
+    void Work();
+    bool Write(Frame& frame, std::vector<unsigned char>& pixels, std::vector<unsigned char>& scratch);
+private:
+    Format mFormat;
+    Policy mPolicy;
+    unsigned int mWidth;
+    unsigned int mHeight;
+    std::FILE* mFile = nullptr;
+    bool mOwnsFile = false;
+    std::vector<Frame> mFrames;
+    FrameSlotQueue mSlots;
+    // Set and read by the writer only, once the stream can't be written anymore
+    bool mBroken = false;
+    // Guards mStats, which the render thread and the writer add to
+    std::mutex mMutex;
+    Stats mStats;
+    std::thread mThread;
+};
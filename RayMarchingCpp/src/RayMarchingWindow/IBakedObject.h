@@ -0,0 +1,30 @@
+#pragma once
+
+#include "DistanceContext.h"
+
+#include <cstddef>
+
+/*
+    Object that replaces part of the scene with a precomputed distance volume
+*/
+struct IBakedObject {
+    virtual ~IBakedObject() {}
+
+    /*
+        Bakes the volume if it's missing or outdated for given context
+    */
+    virtual void UpdateBake(const DistanceContext& context) = 0;
+    /*
+        Optional CPU half of UpdateBake, run on a job thread during startup
+        so the next UpdateBake only uploads. Must not touch OpenGL
+    */
+    virtual void PrepareBake(const DistanceContext&) {}
+    /*
+        Disabled volume makes the shader evaluate the wrapped object directly
+    */
+    virtual void SetVolumeEnabled(bool enabled) = 0;
+    virtual bool VolumeEnabled() const = 0;
+
+    virtual double BakeMilliseconds() const = 0;
+    virtual size_t VolumeSizeInBytes() const = 0;
+};
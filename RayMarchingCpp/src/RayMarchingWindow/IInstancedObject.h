@@ -0,0 +1,20 @@
+#pragma once
+
+#include "Math/AABB.h"
+
+#include <string>
+
+/*
+    Shaped object made of many instances of one primitive. Instances can be
+    placed into the object grid one by one and are evaluated by index
+*/
+struct IInstancedObject {
+    virtual ~IInstancedObject() {}
+
+    virtual unsigned int InstanceCount() const = 0;
+    virtual Math::AABB InstanceBounds(unsigned int index) const = 0;
+    /*
+        GLSL expression evaluating a single instance, indexParam is an int expression
+    */
+    virtual std::string InstanceDistFunctionCall(const std::string& indexParam, const std::string& fixedParam) const = 0;
+};
@@ -1,6 +1,13 @@
 #pragma once
 
 #include "OpenGL/ShaderProgram.h"
+#include "Math/AABB.h"
+#include "Math/Interval.h"
+#include "DistanceContext.h"
+#include "PointBatch.h"
+#include "CppSceneSource.h"
+
+#include <optional>
 
 #define UNIFORM(type, name) "uniform " #type " " + name + ";\n"
 #define DIST_FUNCTION_PROTOTYPE(name, ...) "float " + name + "(" #__VA_ARGS__ ")"
@@ -11,4 +18,49 @@ struct IShapedObject {
     virtual void PassToShader(OpenGL::ShaderProgram& shader) = 0;
     virtual std::string UniformsDefinitions() const = 0;
     virtual std::string DistFunctionCall(const std::string& fixedParam) const = 0;
+    /*
+        Object specific GLSL functions used by DistFunctionCall, placed after all shape dist functions
+    */
+    virtual std::string SceneFunctionsDefinitions() const { return ""; }
+    /*
+        GLSL call giving how far along the normalized ray from the origin
+        in the direction given as GLSL expressions the object's surface is,
+        0 from inside it and NO_HIT if the ray misses. Empty for objects
+        without a closed form intersection. It's used only while unions are
+        hard, so objects may take their parts' union as min
+    */
+    virtual std::string RayHitCall(const std::string&, const std::string&) const { return ""; }
+    /*
+        Box enclosing the object's surface, std::nullopt for unbounded objects
+    */
+    virtual std::optional<Math::AABB> Bounds() const { return std::nullopt; }
+    /*
+        Distance evaluated on CPU, must match the code of DistFunctionCall
+    */
+    virtual float Distance(const Math::Vec3& p, const DistanceContext& context) const = 0;
+    /*
+        Distance of every point of batch into out, overridden by shapes that can evaluate it without a call per point
+    */
+    virtual void Distances(const PointBatch& batch, float* out, const DistanceContext& context) const
+    {
+        for (size_t i = 0; i < batch.Count; i++) {
+            out[i] = Distance(Math::Vec3(batch.X[i], batch.Y[i], batch.Z[i]), context);
+        }
+    }
+    /*
+        C++ counterpart of DistFunctionCall for SceneCompiler, must match Distance.
+        Objects that don't generate C++ are called back on the host
+    */
+    virtual std::string CppDistFunctionCall(const std::string& fixedParam, CppSceneSource& source) const
+    {
+        return source.FallbackCall(*this, fixedParam);
+    }
+    /*
+        Range containing Distance of every point of box, used to skip space far from the surface
+    */
+    virtual Math::Interval DistanceRange(const Math::AABB& box, const DistanceContext& context) const = 0;
+    /*
+        Whether distance depends on u_Time, animated objects can't be baked
+    */
+    virtual bool IsAnimated() const { return false; }
 };
\ No newline at end of file
@@ -0,0 +1,470 @@
+#include "ImageWriter.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+namespace {
+    /*
+        Deflate output, bits are packed starting from the lowest one of a byte
+    */
+    class BitWriter {
+    public:
+        explicit BitWriter(std::vector<uint8_t>& out) : mOut(out)
+        {
+        }
+
+        void Put(uint32_t bits, unsigned int count)
+        {
+            mBuffer |= static_cast<uint64_t>(bits) << mCount;
+            mCount += count;
+            while (mCount >= 8) {
+                mOut.push_back(static_cast<uint8_t>(mBuffer));
+                mBuffer >>= 8;
+                mCount -= 8;
+            }
+        }
+
+        void Flush()
+        {
+            if (mCount > 0) {
+                mOut.push_back(static_cast<uint8_t>(mBuffer));
+            }
+            mBuffer = 0;
+            mCount = 0;
+        }
+    private:
+        std::vector<uint8_t>& mOut;
+        uint64_t mBuffer = 0;
+        unsigned int mCount = 0;
+    };
+
+    struct HuffmanCode {
+        uint16_t Bits = 0;
+        uint8_t Length = 0;
+    };
+
+    /*
+        Fixed Huffman codes of deflate and the length and distance symbols
+        of every match length and distance, built once
+    */
+    struct DeflateTables {
+        std::array<HuffmanCode, 288> Literals;
+        std::array<HuffmanCode, 30> Distances;
+        // Symbol - 257 of lengths 3-258
+        std::array<uint8_t, 259> LengthSymbols;
+        // Symbols of distances 1-32768, see DistanceSymbol
+        std::array<uint8_t, 512> DistanceSymbols;
+    };
+}
+
+static constexpr uint16_t sLengthBase[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static constexpr uint8_t sLengthExtra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static constexpr uint16_t sDistanceBase[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+    8193, 12289, 16385, 24577
+};
+static constexpr uint8_t sDistanceExtra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+static constexpr size_t sWindowSize = 32768;
+static constexpr size_t sMinMatch = 3;
+static constexpr size_t sMaxMatch = 258;
+static constexpr unsigned int sHashBits = 15;
+
+/*
+    Codes are sent from their highest bit, BitWriter from the lowest one
+*/
+static uint16_t ReverseBits(uint16_t bits, unsigned int length)
+{
+    uint16_t reversed = 0;
+    for (unsigned int i = 0; i < length; i++) {
+        reversed = static_cast<uint16_t>((reversed << 1) | ((bits >> i) & 1));
+    }
+    return reversed;
+}
+
+static const DeflateTables& Tables()
+{
+    static const DeflateTables sTables = []() {
+        DeflateTables tables;
+        for (unsigned int symbol = 0; symbol < 288; symbol++) {
+            HuffmanCode& code = tables.Literals[symbol];
+            if (symbol < 144) {
+                code = { static_cast<uint16_t>(0x30 + symbol), 8 };
+            } else if (symbol < 256) {
+                code = { static_cast<uint16_t>(0x190 + symbol - 144), 9 };
+            } else if (symbol < 280) {
+                code = { static_cast<uint16_t>(symbol - 256), 7 };
+            } else {
+                code = { static_cast<uint16_t>(0xC0 + symbol - 280), 8 };
+            }
+            code.Bits = ReverseBits(code.Bits, code.Length);
+        }
+        for (unsigned int symbol = 0; symbol < 30; symbol++) {
+            tables.Distances[symbol] = { ReverseBits(static_cast<uint16_t>(symbol), 5), 5 };
+        }
+        for (unsigned int symbol = 0; symbol < 29; symbol++) {
+            unsigned int end = symbol + 1 < 29 ? sLengthBase[symbol + 1] : 259;
+            for (unsigned int length = sLengthBase[symbol]; length < end; length++) {
+                tables.LengthSymbols[length] = static_cast<uint8_t>(symbol);
+            }
+        }
+        // Distances up to 256 by themselves, larger ones by multiples of 128
+        for (unsigned int symbol = 0; symbol < 30; symbol++) {
+            unsigned int end = symbol + 1 < 30 ? sDistanceBase[symbol + 1] : 32769;
+            for (unsigned int distance = sDistanceBase[symbol]; distance < end; distance++) {
+                unsigned int index = distance <= 256 ? distance - 1 : 256 + ((distance - 1) >> 7);
+                tables.DistanceSymbols[index] = static_cast<uint8_t>(symbol);
+            }
+        }
+        return tables;
+    }();
+    return sTables;
+}
+
+static unsigned int DistanceSymbol(const DeflateTables& tables, size_t distance)
+{
+    return tables.DistanceSymbols[distance <= 256 ? distance - 1 : 256 + ((distance - 1) >> 7)];
+}
+
+static uint32_t Hash(const uint8_t* data)
+{
+    uint32_t value = data[0] | (data[1] << 8) | (data[2] << 16);
+    return (value * 2654435761u) >> (32 - sHashBits);
+}
+
+static uint32_t Adler32(const uint8_t* data, size_t size)
+{
+    uint32_t a = 1;
+    uint32_t b = 0;
+    while (size > 0) {
+        // Largest run whose sums can't overflow before the modulo
+        size_t run = std::min<size_t>(size, 5552);
+        for (size_t i = 0; i < run; i++) {
+            a += data[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+        data += run;
+        size -= run;
+    }
+    return (b << 16) | a;
+}
+
+static uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc = 0)
+{
+    static const std::array<uint32_t, 256> sTable = []() {
+        std::array<uint32_t, 256> table;
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t value = i;
+            for (unsigned int bit = 0; bit < 8; bit++) {
+                value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+            }
+            table[i] = value;
+        }
+        return table;
+    }();
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = sTable[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+static void PutBigEndian(std::vector<uint8_t>& out, uint32_t value)
+{
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out.push_back(static_cast<uint8_t>(value >> shift));
+    }
+}
+
+static void PutPngChunk(std::vector<uint8_t>& out, const char* type, const uint8_t* data, size_t size)
+{
+    PutBigEndian(out, static_cast<uint32_t>(size));
+    size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data, data + size);
+    PutBigEndian(out, Crc32(out.data() + start, out.size() - start));
+}
+
+static uint8_t Paeth(int a, int b, int c)
+{
+    int p = a + b - c;
+    int pa = std::abs(p - a);
+    int pb = std::abs(p - b);
+    int pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) {
+        return static_cast<uint8_t>(a);
+    }
+    return static_cast<uint8_t>(pb <= pc ? b : c);
+}
+
+template <typename T>
+static void PutLittleEndian(std::vector<uint8_t>& out, T value)
+{
+    uint8_t bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+static void PutExrAttribute(std::vector<uint8_t>& out, const char* name, const char* type, const std::vector<uint8_t>& value)
+{
+    out.insert(out.end(), name, name + std::strlen(name) + 1);
+    out.insert(out.end(), type, type + std::strlen(type) + 1);
+    PutLittleEndian(out, static_cast<int32_t>(value.size()));
+    out.insert(out.end(), value.begin(), value.end());
+}
+
+static bool WriteFile(const std::string& path, const std::vector<uint8_t>& data)
+{
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    return static_cast<bool>(file);
+}
+
+void ImageWriter::Compress(const uint8_t* data, size_t size, std::vector<uint8_t>& out)
+{
+    // Deflate with a 32K window, no preset dictionary, fastest compression level hint
+    out.push_back(0x78);
+    out.push_back(0x01);
+
+    const DeflateTables& tables = Tables();
+    BitWriter writer(out);
+    // One final block of fixed codes
+    writer.Put(1, 1);
+    writer.Put(1, 2);
+
+    // Position + 1 of the last occurrence of each hash and of the previous one with the same hash
+    std::vector<uint32_t> head(size_t(1) << sHashBits, 0);
+    std::vector<uint32_t> previous(sWindowSize, 0);
+    auto insert = [&](size_t position) {
+        uint32_t hash = Hash(data + position);
+        previous[position & (sWindowSize - 1)] = head[hash];
+        head[hash] = static_cast<uint32_t>(position + 1);
+    };
+
+    size_t position = 0;
+    while (position < size) {
+        size_t bestLength = 0;
+        size_t bestDistance = 0;
+        if (position + sMinMatch <= size) {
+            size_t maxLength = std::min(sMaxMatch, size - position);
+            uint32_t candidate = head[Hash(data + position)];
+            for (unsigned int chain = 0; candidate != 0 && chain < sMaxChain; chain++) {
+                size_t start = candidate - 1;
+                if (position - start > sWindowSize) {
+                    break;
+                }
+                size_t length = 0;
+                while (length < maxLength && data[start + length] == data[position + length]) {
+                    length++;
+                }
+                if (length > bestLength) {
+                    bestLength = length;
+                    bestDistance = position - start;
+                    if (length >= sGoodMatch || length == maxLength) {
+                        break;
+                    }
+                }
+                // Still the link of start, a newer position in its slot would be out of the window
+                candidate = previous[start & (sWindowSize - 1)];
+            }
+        }
+
+        if (bestLength >= sMinMatch) {
+            unsigned int lengthSymbol = tables.LengthSymbols[bestLength];
+            const HuffmanCode& lengthCode = tables.Literals[257 + lengthSymbol];
+            writer.Put(lengthCode.Bits, lengthCode.Length);
+            writer.Put(static_cast<uint32_t>(bestLength - sLengthBase[lengthSymbol]), sLengthExtra[lengthSymbol]);
+            unsigned int distanceSymbol = DistanceSymbol(tables, bestDistance);
+            const HuffmanCode& distanceCode = tables.Distances[distanceSymbol];
+            writer.Put(distanceCode.Bits, distanceCode.Length);
+            writer.Put(static_cast<uint32_t>(bestDistance - sDistanceBase[distanceSymbol]), sDistanceExtra[distanceSymbol]);
+
+            size_t end = position + bestLength;
+            for (; position < end; position++) {
+                if (position + sMinMatch <= size) {
+                    insert(position);
+                }
+            }
+        } else {
+            const HuffmanCode& code = tables.Literals[data[position]];
+            writer.Put(code.Bits, code.Length);
+            if (position + sMinMatch <= size) {
+                insert(position);
+            }
+            position++;
+        }
+    }
+
+    const HuffmanCode& endOfBlock = tables.Literals[256];
+    writer.Put(endOfBlock.Bits, endOfBlock.Length);
+    writer.Flush();
+    PutBigEndian(out, Adler32(data, size));
+}
+
+uint16_t ImageWriter::ToHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+    uint32_t floatExponent = (bits >> 23) & 0xFF;
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    if (floatExponent == 0xFF) {
+        return sign | 0x7C00 | (mantissa ? 0x200 : 0);
+    }
+    int exponent = static_cast<int>(floatExponent) - 127 + 15;
+    if (exponent >= 31) {
+        return sign | 0x7C00;
+    }
+    if (exponent <= 0) {
+        if (exponent < -10) {
+            return sign;
+        }
+        // Subnormal, the implicit one becomes explicit
+        mantissa |= 0x800000;
+        unsigned int shift = static_cast<unsigned int>(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        uint32_t rest = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1))) {
+            half++;
+        }
+        return sign | static_cast<uint16_t>(half);
+    }
+
+    // Rounding to nearest even may carry into the exponent, which is still right
+    uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+    uint32_t rest = mantissa & 0x1FFF;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) {
+        half++;
+    }
+    return sign | static_cast<uint16_t>(half);
+}
+
+bool ImageWriter::WritePng(const std::string& path, unsigned int width, unsigned int height, const uint8_t* rgba)
+{
+    return WriteFile(path, EncodePng(width, height, rgba));
+}
+
+std::vector<uint8_t> ImageWriter::EncodePng(unsigned int width, unsigned int height, const uint8_t* rgba)
+{
+    const size_t rowSize = static_cast<size_t>(width) * 4;
+    std::vector<uint8_t> filtered(static_cast<size_t>(height) * (rowSize + 1));
+    std::vector<uint8_t> candidate(rowSize);
+    std::vector<uint8_t> zeros(rowSize, 0);
+
+    for (unsigned int y = 0; y < height; y++) {
+        const uint8_t* row = rgba + (height - 1 - y) * rowSize;
+        const uint8_t* above = y > 0 ? rgba + (height - y) * rowSize : zeros.data();
+        uint8_t* out = filtered.data() + y * (rowSize + 1);
+
+        uint64_t bestCost = UINT64_MAX;
+        for (uint8_t filter = 0; filter < 5; filter++) {
+            uint64_t cost = 0;
+            for (size_t i = 0; i < rowSize; i++) {
+                int left = i >= 4 ? row[i - 4] : 0;
+                int up = above[i];
+                int upperLeft = i >= 4 ? above[i - 4] : 0;
+                uint8_t predicted = 0;
+                switch (filter) {
+                case 1: predicted = static_cast<uint8_t>(left); break;
+                case 2: predicted = static_cast<uint8_t>(up); break;
+                case 3: predicted = static_cast<uint8_t>((left + up) / 2); break;
+                case 4: predicted = Paeth(left, up, upperLeft); break;
+                }
+                candidate[i] = static_cast<uint8_t>(row[i] - predicted);
+                cost += std::abs(static_cast<int8_t>(candidate[i]));
+            }
+            if (cost < bestCost) {
+                bestCost = cost;
+                out[0] = filter;
+                std::copy(candidate.begin(), candidate.end(), out + 1);
+            }
+        }
+    }
+
+    std::vector<uint8_t> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    std::vector<uint8_t> header;
+    PutBigEndian(header, width);
+    PutBigEndian(header, height);
+    // 8 bits, RGBA, deflate, adaptive filtering, not interlaced
+    header.insert(header.end(), { 8, 6, 0, 0, 0 });
+    PutPngChunk(png, "IHDR", header.data(), header.size());
+
+    std::vector<uint8_t> compressed;
+    compressed.reserve(filtered.size() / 2);
+    Compress(filtered.data(), filtered.size(), compressed);
+    PutPngChunk(png, "IDAT", compressed.data(), compressed.size());
+    PutPngChunk(png, "IEND", nullptr, 0);
+    return png;
+}
+
+bool ImageWriter::WriteExr(const std::string& path, unsigned int width, unsigned int height, const float* rgba)
+{
+    std::vector<uint8_t> exr = { 0x76, 0x2F, 0x31, 0x01, 2, 0, 0, 0 };
+
+    // Channels are stored in alphabetical order, each as half floats sampled at every pixel
+    const char* channelNames[] = { "A", "B", "G", "R" };
+    const unsigned int channelOffsets[] = { 3, 2, 1, 0 };
+    std::vector<uint8_t> channels;
+    for (const char* name : channelNames) {
+        channels.insert(channels.end(), name, name + 2);
+        PutLittleEndian(channels, int32_t(1));
+        channels.insert(channels.end(), { 0, 0, 0, 0 });
+        PutLittleEndian(channels, int32_t(1));
+        PutLittleEndian(channels, int32_t(1));
+    }
+    channels.push_back(0);
+
+    std::vector<uint8_t> window;
+    for (int32_t value : { 0, 0, static_cast<int32_t>(width) - 1, static_cast<int32_t>(height) - 1 }) {
+        PutLittleEndian(window, value);
+    }
+    std::vector<uint8_t> one;
+    PutLittleEndian(one, 1.0f);
+    std::vector<uint8_t> center;
+    PutLittleEndian(center, 0.0f);
+    PutLittleEndian(center, 0.0f);
+
+    PutExrAttribute(exr, "channels", "chlist", channels);
+    PutExrAttribute(exr, "compression", "compression", { 0 });
+    PutExrAttribute(exr, "dataWindow", "box2i", window);
+    PutExrAttribute(exr, "displayWindow", "box2i", window);
+    PutExrAttribute(exr, "lineOrder", "lineOrder", { 0 });
+    PutExrAttribute(exr, "pixelAspectRatio", "float", one);
+    PutExrAttribute(exr, "screenWindowCenter", "v2f", center);
+    PutExrAttribute(exr, "screenWindowWidth", "float", one);
+    exr.push_back(0);
+
+    // Uncompressed files hold one scanline per chunk, the offset table points at each of them
+    const size_t lineSize = static_cast<size_t>(width) * 4 * sizeof(uint16_t);
+    const size_t chunkSize = 2 * sizeof(int32_t) + lineSize;
+    uint64_t firstChunk = exr.size() + static_cast<size_t>(height) * sizeof(uint64_t);
+    exr.reserve(firstChunk + chunkSize * height);
+    for (unsigned int y = 0; y < height; y++) {
+        PutLittleEndian(exr, firstChunk + y * chunkSize);
+    }
+    for (unsigned int y = 0; y < height; y++) {
+        const float* row = rgba + static_cast<size_t>(height - 1 - y) * width * 4;
+        PutLittleEndian(exr, static_cast<int32_t>(y));
+        PutLittleEndian(exr, static_cast<int32_t>(lineSize));
+        for (unsigned int offset : channelOffsets) {
+            for (unsigned int x = 0; x < width; x++) {
+                PutLittleEndian(exr, ToHalf(row[x * 4 + offset]));
+            }
+        }
+    }
+    return WriteFile(path, exr);
+}
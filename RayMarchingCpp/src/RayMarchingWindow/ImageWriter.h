@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+    Writes RGBA images whose rows go bottom to top, as glReadPixels returns
+    them, so they're flipped on the way out. PNG data is deflated here with
+    LZ77 and the fixed Huffman codes, EXR is written uncompressed with
+    half float channels
+*/
+class ImageWriter {
+public:
+    /*
+        8 bits per channel, every row gets the PNG filter giving the
+        smallest sum of absolute filtered bytes
+    */
+    static bool WritePng(const std::string& path, unsigned int width, unsigned int height, const uint8_t* rgba);
+    /*
+        PNG file data WritePng writes
+    */
+    static std::vector<uint8_t> EncodePng(unsigned int width, unsigned int height, const uint8_t* rgba);
+    static bool WriteExr(const std::string& path, unsigned int width, unsigned int height, const float* rgba);
+
+    /*
+        zlib stream of size bytes of data, appended to out
+    */
+    static void Compress(const uint8_t* data, size_t size, std::vector<uint8_t>& out);
+    /*
+        Nearest half float, overflowing values become infinity
+    */
+    static uint16_t ToHalf(float value);
+private:
+    // Hash chain links followed looking for a match, and match length that ends the search
+    static constexpr unsigned int sMaxChain = 16;
+    static constexpr unsigned int sGoodMatch = 64;
+};
@@ -0,0 +1,51 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+
+JobSystem::JobSystem(unsigned int threadCount /* = 0 */)
+{
+    if (threadCount == 0) {
+        threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+    for (unsigned int i = 0; i < threadCount; i++) {
+        mThreads.emplace_back(&JobSystem::Work, this);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mJobQueued.notify_all();
+    for (std::thread& thread : mThreads) {
+        thread.join();
+    }
+}
+
+void JobSystem::Push(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mQueue.push_back(std::move(job));
+    }
+    mJobQueued.notify_one();
+}
+
+void JobSystem::Work()
+{
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mJobQueued.wait(lock, [this]() { return mStopping || !mQueue.empty(); });
+            if (mQueue.empty()) {
+                return;
+            }
+            job = std::move(mQueue.front());
+            mQueue.pop_front();
+        }
+        job();
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/*
+    Fixed pool of worker threads running jobs in submission order. Jobs
+    must not touch the OpenGL context, which belongs to the main thread
+*/
+class JobSystem {
+public:
+    /*
+        Zero leaves one hardware thread to the caller, there is always at
+        least one worker
+    */
+    explicit JobSystem(unsigned int threadCount = 0);
+    /*
+        Runs the jobs still queued, then joins the workers
+    */
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    /*
+        The future holds the result of job or the exception it threw
+    */
+    template <typename Job>
+    auto Submit(Job&& job) -> std::future<std::invoke_result_t<std::decay_t<Job>&>>
+    {
+        using Result = std::invoke_result_t<std::decay_t<Job>&>;
+        std::shared_ptr<std::packaged_task<Result()>> task = std::make_shared<std::packaged_task<Result()>>(std::forward<Job>(job));
+        std::future<Result> future = task->get_future();
+        Push([task]() { (*task)(); });
+        return future;
+    }
+
+    unsigned int ThreadCount() const { return static_cast<unsigned int>(mThreads.size()); }
+private:
+    void Push(std::function<void()> job);
+    void Work();
+private:
+    std::vector<std::thread> mThreads;
+    std::deque<std::function<void()>> mQueue;
+    std::mutex mMutex;
+    std::condition_variable mJobQueued;
+    bool mStopping = false;
+};
@@ -0,0 +1,83 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+std::unique_ptr<MappedFile> MappedFile::Open(const std::string& path)
+{
+    std::unique_ptr<MappedFile> file(new MappedFile());
+    file->mFileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file->mFileHandle == INVALID_HANDLE_VALUE) {
+        file->mFileHandle = nullptr;
+        return nullptr;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file->mFileHandle, &size) || size.QuadPart == 0) {
+        return nullptr;
+    }
+    file->mSize = static_cast<size_t>(size.QuadPart);
+
+    file->mMappingHandle = CreateFileMappingA(file->mFileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!file->mMappingHandle) {
+        return nullptr;
+    }
+    file->mData = static_cast<const unsigned char*>(MapViewOfFile(file->mMappingHandle, FILE_MAP_READ, 0, 0, 0));
+    return file->mData ? std::move(file) : nullptr;
+}
+
+MappedFile::~MappedFile()
+{
+    if (mData) {
+        UnmapViewOfFile(mData);
+    }
+    if (mMappingHandle) {
+        CloseHandle(mMappingHandle);
+    }
+    if (mFileHandle) {
+        CloseHandle(mFileHandle);
+    }
+}
+
+#else
+
+std::unique_ptr<MappedFile> MappedFile::Open(const std::string& path)
+{
+    int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        return nullptr;
+    }
+
+    std::unique_ptr<MappedFile> file;
+    struct stat status;
+    if (fstat(descriptor, &status) == 0 && status.st_size > 0) {
+        void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (data != MAP_FAILED) {
+            file.reset(new MappedFile());
+            file->mData = static_cast<const unsigned char*>(data);
+            file->mSize = static_cast<size_t>(status.st_size);
+        }
+    }
+    // Mapping stays valid after the descriptor is closed
+    close(descriptor);
+    return file;
+}
+
+MappedFile::~MappedFile()
+{
+    if (mData) {
+        munmap(const_cast<unsigned char*>(mData), mSize);
+    }
+}
+
+#endif
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+/*
+    Read-only memory mapping of a whole file, unmapped on destruction
+*/
+class MappedFile {
+public:
+    /*
+        Returns nullptr if the file can't be opened or is empty
+    */
+    static std::unique_ptr<MappedFile> Open(const std::string& path);
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    const unsigned char* Data() const { return mData; }
+    size_t Size() const { return mSize; }
+private:
+    MappedFile() = default;
+private:
+    const unsigned char* mData = nullptr;
+    size_t mSize = 0;
+#ifdef _WIN32
+    void* mFileHandle = nullptr;
+    void* mMappingHandle = nullptr;
+#endif
+};
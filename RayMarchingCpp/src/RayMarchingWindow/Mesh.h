@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+/*
+    Indexed triangle mesh, triangles are wound counterclockwise seen from
+    outside of the surface
+*/
+struct Mesh {
+    // x, y, z of every vertex
+    std::vector<float> Vertices;
+    // Three vertex indices per triangle
+    std::vector<uint32_t> Triangles;
+
+    size_t VertexCount() const { return Vertices.size() / 3; }
+    size_t TriangleCount() const { return Triangles.size() / 3; }
+};
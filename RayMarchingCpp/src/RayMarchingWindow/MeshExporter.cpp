@@ -0,0 +1,545 @@
+#include "MeshExporter.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace {
+    /*
+        Triangles of one corner sign configuration as cube edge triplets
+    */
+    struct CubeCase {
+        uint8_t TriangleCount = 0;
+        std::array<uint8_t, 15> Edges = {};
+    };
+}
+
+// Corner i of a cell is at (i & 1, (i >> 1) & 1, i >> 2). Edges 0-3 go along X, 4-7 along Y, 8-11 along Z
+static constexpr uint8_t sEdgeCorners[12][2] = {
+    { 0, 1 }, { 2, 3 }, { 4, 5 }, { 6, 7 },
+    { 0, 2 }, { 1, 3 }, { 4, 6 }, { 5, 7 },
+    { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 }
+};
+
+static unsigned int EdgeBetween(unsigned int corner0, unsigned int corner1)
+{
+    for (unsigned int edge = 0; edge < 12; edge++) {
+        if ((sEdgeCorners[edge][0] == corner0 && sEdgeCorners[edge][1] == corner1) ||
+            (sEdgeCorners[edge][0] == corner1 && sEdgeCorners[edge][1] == corner0)) {
+            return edge;
+        }
+    }
+    return 0;
+}
+
+/*
+    Builds the triangle table instead of spelling it out. The boundary of
+    every cube face is walked counterclockwise seen from outside, a crossing
+    into the inside is joined with the next crossing out of it. This keeps
+    inside corners of ambiguous faces apart in both cells sharing the face,
+    so the mesh has no holes, and the loops are wound with normals facing
+    positive distances. Loops are split into triangle fans
+*/
+static std::array<CubeCase, 256> BuildCubeCases()
+{
+    std::array<CubeCase, 256> cases;
+    for (unsigned int config = 0; config < 256; config++) {
+        std::array<int, 12> next;
+        next.fill(-1);
+
+        for (unsigned int axis = 0; axis < 3; axis++) {
+            for (unsigned int side = 0; side < 2; side++) {
+                unsigned int corners[4];
+                const unsigned int cycle[4][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+                for (unsigned int i = 0; i < 4; i++) {
+                    unsigned int index = side == 1 ? i : 3 - i;
+                    unsigned int coords[3];
+                    coords[axis] = side;
+                    coords[(axis + 1) % 3] = cycle[index][0];
+                    coords[(axis + 2) % 3] = cycle[index][1];
+                    corners[i] = coords[0] | coords[1] << 1 | coords[2] << 2;
+                }
+
+                unsigned int crossings[4];
+                bool entering[4];
+                unsigned int crossingCount = 0;
+                for (unsigned int i = 0; i < 4; i++) {
+                    bool inside0 = (config >> corners[i]) & 1;
+                    bool inside1 = (config >> corners[(i + 1) % 4]) & 1;
+                    if (inside0 != inside1) {
+                        crossings[crossingCount] = EdgeBetween(corners[i], corners[(i + 1) % 4]);
+                        entering[crossingCount++] = inside1;
+                    }
+                }
+                for (unsigned int i = 0; i < crossingCount; i++) {
+                    if (entering[i]) {
+                        unsigned int j = (i + 1) % crossingCount;
+                        while (entering[j]) {
+                            j = (j + 1) % crossingCount;
+                        }
+                        next[crossings[i]] = crossings[j];
+                    }
+                }
+            }
+        }
+
+        CubeCase& cubeCase = cases[config];
+        std::array<bool, 12> visited = {};
+        for (unsigned int start = 0; start < 12; start++) {
+            if (next[start] < 0 || visited[start]) {
+                continue;
+            }
+            std::vector<unsigned int> loop;
+            for (unsigned int edge = start; !visited[edge]; edge = next[edge]) {
+                visited[edge] = true;
+                loop.push_back(edge);
+            }
+            for (unsigned int i = 1; i + 1 < loop.size(); i++) {
+                uint8_t* triangle = &cubeCase.Edges[cubeCase.TriangleCount++ * 3];
+                triangle[0] = static_cast<uint8_t>(loop[0]);
+                triangle[1] = static_cast<uint8_t>(loop[i]);
+                triangle[2] = static_cast<uint8_t>(loop[i + 1]);
+            }
+        }
+    }
+    return cases;
+}
+
+static const std::array<CubeCase, 256>& CubeCases()
+{
+    static const std::array<CubeCase, 256> cases = BuildCubeCases();
+    return cases;
+}
+
+/*
+    Key of the grid edge starting at point (x, y, z), 20 bits per coordinate
+*/
+static uint64_t EdgeKey(unsigned int axis, uint32_t x, uint32_t y, uint32_t z)
+{
+    return axis | static_cast<uint64_t>(x) << 2 | static_cast<uint64_t>(y) << 22 | static_cast<uint64_t>(z) << 42;
+}
+
+/*
+    Streams slabs in order to a file or appends them to a mesh. PLY needs
+    counts and all vertices before faces, so faces go to a side file
+    appended at the end and the header counts are left padded to be
+    patched in place
+*/
+class MeshExporter::Writer {
+public:
+    void Open(Mesh& mesh)
+    {
+        mMesh = &mesh;
+        mMesh->Vertices.clear();
+        mMesh->Triangles.clear();
+    }
+
+    bool Open(const std::string& path)
+    {
+        std::filesystem::path filePath(path);
+        std::string extension = filePath.extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(std::tolower(c)); });
+        mObj = extension == ".obj";
+
+        std::error_code error;
+        if (filePath.has_parent_path()) {
+            std::filesystem::create_directories(filePath.parent_path(), error);
+        }
+        mOut.open(filePath, std::ios::binary | std::ios::trunc);
+        if (mObj) {
+            mOut << "# Exported by RayMarchingCpp\n";
+            return static_cast<bool>(mOut);
+        }
+
+        mFacesPath = filePath;
+        mFacesPath += ".faces.tmp";
+        mFaces.open(mFacesPath, std::ios::binary | std::ios::trunc);
+        mOut << "ply\nformat binary_little_endian 1.0\ncomment Exported by RayMarchingCpp\nelement vertex ";
+        mVertexCountPosition = mOut.tellp();
+        mOut << "0000000000\nproperty float x\nproperty float y\nproperty float z\nelement face ";
+        mFaceCountPosition = mOut.tellp();
+        mOut << "0000000000\nproperty list uchar uint vertex_indices\nend_header\n";
+        return mOut && mFaces;
+    }
+
+    /*
+        previous is the slab written before, its vertices own the bottom plane of slab
+    */
+    void Write(const Slab& slab, const Slab* previous)
+    {
+        // Foreign vertices the previous slab doesn't have are added after the slab's own ones
+        std::vector<float> vertices = slab.Vertices;
+        std::vector<uint64_t> foreign(slab.ForeignEdges.size());
+        for (size_t i = 0; i < foreign.size(); i++) {
+            std::optional<uint32_t> owned;
+            if (previous) {
+                auto iter = previous->Edges.find(slab.ForeignEdges[i]);
+                if (iter != previous->Edges.end() && !(iter->second & sForeignBit)) {
+                    owned = iter->second;
+                }
+            }
+            if (owned) {
+                foreign[i] = mPreviousOffset + *owned;
+            } else {
+                foreign[i] = mVertexCount + vertices.size() / 3;
+                vertices.insert(vertices.end(), slab.ForeignVertices.begin() + i * 3, slab.ForeignVertices.begin() + i * 3 + 3);
+            }
+        }
+        auto globalIndex = [&](uint32_t index) {
+            return (index & sForeignBit) ? foreign[index & ~sForeignBit] : mVertexCount + index;
+        };
+
+        std::string buffer;
+        if (mMesh) {
+            mMesh->Vertices.insert(mMesh->Vertices.end(), vertices.begin(), vertices.end());
+            for (uint32_t index : slab.Triangles) {
+                mMesh->Triangles.push_back(static_cast<uint32_t>(globalIndex(index)));
+            }
+        } else if (mObj) {
+            char line[96];
+            for (size_t i = 0; i < vertices.size(); i += 3) {
+                int length = std::snprintf(line, sizeof(line), "v %.6g %.6g %.6g\n", vertices[i], vertices[i + 1], vertices[i + 2]);
+                buffer.append(line, length);
+            }
+            for (size_t i = 0; i < slab.Triangles.size(); i += 3) {
+                int length = std::snprintf(line, sizeof(line), "f %llu %llu %llu\n",
+                    static_cast<unsigned long long>(globalIndex(slab.Triangles[i]) + 1),
+                    static_cast<unsigned long long>(globalIndex(slab.Triangles[i + 1]) + 1),
+                    static_cast<unsigned long long>(globalIndex(slab.Triangles[i + 2]) + 1));
+                buffer.append(line, length);
+            }
+            mOut.write(buffer.data(), buffer.size());
+        } else {
+            mOut.write(reinterpret_cast<const char*>(vertices.data()), vertices.size() * sizeof(float));
+            buffer.resize(slab.Triangles.size() / 3 * (1 + 3 * sizeof(uint32_t)));
+            char* face = buffer.data();
+            for (size_t i = 0; i < slab.Triangles.size(); i += 3) {
+                *face++ = 3;
+                for (size_t j = 0; j < 3; j++) {
+                    uint32_t index = static_cast<uint32_t>(globalIndex(slab.Triangles[i + j]));
+                    std::memcpy(face, &index, sizeof(index));
+                    face += sizeof(index);
+                }
+            }
+            mFaces.write(buffer.data(), buffer.size());
+        }
+
+        mPreviousOffset = mVertexCount;
+        mVertexCount += vertices.size() / 3;
+        mTriangleCount += slab.Triangles.size() / 3;
+    }
+
+    bool Close()
+    {
+        if (mMesh) {
+            return true;
+        }
+        if (!mObj) {
+            mFaces.close();
+            std::ifstream faces(mFacesPath, std::ios::binary);
+            if (mTriangleCount > 0) {
+                mOut << faces.rdbuf();
+            }
+            faces.close();
+            std::error_code error;
+            std::filesystem::remove(mFacesPath, error);
+
+            char count[11];
+            std::snprintf(count, sizeof(count), "%010llu", static_cast<unsigned long long>(mVertexCount));
+            mOut.seekp(mVertexCountPosition);
+            mOut.write(count, 10);
+            std::snprintf(count, sizeof(count), "%010llu", static_cast<unsigned long long>(mTriangleCount));
+            mOut.seekp(mFaceCountPosition);
+            mOut.write(count, 10);
+        }
+        mOut.close();
+        return !mOut.fail();
+    }
+
+    uint64_t VertexCount() const { return mVertexCount; }
+    uint64_t TriangleCount() const { return mTriangleCount; }
+private:
+    Mesh* mMesh = nullptr;
+    bool mObj = false;
+    std::ofstream mOut;
+    std::ofstream mFaces;
+    std::filesystem::path mFacesPath;
+    std::streampos mVertexCountPosition;
+    std::streampos mFaceCountPosition;
+    uint64_t mVertexCount = 0;
+    // Index of the first vertex of the previous slab
+    uint64_t mPreviousOffset = 0;
+    uint64_t mTriangleCount = 0;
+};
+
+std::optional<MeshExporter::Stats> MeshExporter::Export(const IShapedObject& object, const Math::AABB& bounds, unsigned int resolution,
+    const DistanceContext& context, const std::string& path, unsigned int threadCount /* = 0 */)
+{
+    Writer writer;
+    if (!writer.Open(path)) {
+        return std::nullopt;
+    }
+    Stats stats = Run(object, bounds, resolution, context, writer, threadCount);
+    if (!writer.Close()) {
+        return std::nullopt;
+    }
+    return stats;
+}
+
+MeshExporter::Stats MeshExporter::Extract(const IShapedObject& object, const Math::AABB& bounds, unsigned int resolution,
+    const DistanceContext& context, Mesh& mesh, unsigned int threadCount /* = 0 */)
+{
+    Writer writer;
+    writer.Open(mesh);
+    return Run(object, bounds, resolution, context, writer, threadCount);
+}
+
+bool MeshExporter::Save(const Mesh& mesh, const std::string& path)
+{
+    Writer writer;
+    if (!writer.Open(path)) {
+        return false;
+    }
+    Slab slab;
+    slab.Vertices = mesh.Vertices;
+    slab.Triangles = mesh.Triangles;
+    writer.Write(slab, nullptr);
+    return writer.Close();
+}
+
+MeshExporter::Stats MeshExporter::Run(const IShapedObject& object, const Math::AABB& bounds, unsigned int resolution,
+    const DistanceContext& context, Writer& writer, unsigned int threadCount)
+{
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+    Grid grid;
+    grid.Min = bounds.Min();
+    Math::Vec3 size = bounds.Size();
+    grid.CellSize = std::max(size.x(), std::max(size.y(), size.z())) / std::max(resolution, 1u);
+    for (unsigned int i = 0; i < 3; i++) {
+        uint32_t cells = std::max(static_cast<uint32_t>(std::ceil(size[i] / grid.CellSize - 0.001f)), 1u);
+        grid.Cells[i] = (cells + sBlockCells - 1) / sBlockCells * sBlockCells;
+    }
+
+    // Slabs are handed out in order and at most maxInFlight of them wait to be written
+    const unsigned int slabCount = grid.Cells[2] / sBlockCells;
+    if (threadCount == 0) {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    const unsigned int maxInFlight = threadCount * 2;
+    std::vector<std::unique_ptr<Slab>> slabs(slabCount);
+    std::mutex mutex;
+    std::condition_variable condition;
+    unsigned int nextSlab = 0;
+    unsigned int writtenSlabs = 0;
+
+    auto worker = [&]() {
+        while (true) {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [&]() { return nextSlab >= slabCount || nextSlab < writtenSlabs + maxInFlight; });
+            if (nextSlab >= slabCount) {
+                return;
+            }
+            unsigned int index = nextSlab++;
+            slabs[index] = std::make_unique<Slab>();
+            Slab& slab = *slabs[index];
+            lock.unlock();
+
+            ExtractSlab(object, context, grid, index, slab);
+
+            lock.lock();
+            slab.Done = true;
+            condition.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 0; i < std::min(threadCount, slabCount); i++) {
+        threads.emplace_back(worker);
+    }
+
+    Stats stats;
+    std::unique_ptr<Slab> previous;
+    for (unsigned int i = 0; i < slabCount; i++) {
+        std::unique_ptr<Slab> slab;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [&]() { return slabs[i] && slabs[i]->Done; });
+            slab = std::move(slabs[i]);
+        }
+
+        writer.Write(*slab, previous.get());
+        stats.SampledBlocks += slab->SampledBlocks;
+        previous = std::move(slab);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        writtenSlabs = i + 1;
+        condition.notify_all();
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    stats.VertexCount = writer.VertexCount();
+    stats.TriangleCount = writer.TriangleCount();
+    stats.TotalBlocks = static_cast<uint64_t>(grid.Cells[0] / sBlockCells) * (grid.Cells[1] / sBlockCells) * slabCount;
+    stats.Milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    return stats;
+}
+
+void MeshExporter::ExtractSlab(const IShapedObject& object, const DistanceContext& context, const Grid& grid, unsigned int slab, Slab& result)
+{
+    uint32_t size = sBlockCells;
+    while (size < grid.Cells[0] || size < grid.Cells[1]) {
+        size *= 2;
+    }
+    Block block;
+    block.Samples.resize((sBlockCells + 1) * (sBlockCells + 1) * (sBlockCells + 1));
+    ExtractBlocks(object, context, grid, slab, 0, 0, size, result, block);
+}
+
+void MeshExporter::ExtractBlocks(const IShapedObject& object, const DistanceContext& context, const Grid& grid, unsigned int slab,
+    uint32_t x, uint32_t y, uint32_t size, Slab& result, Block& block)
+{
+    if (x >= grid.Cells[0] || y >= grid.Cells[1]) {
+        return;
+    }
+
+    // Skips squares of blocks the surface can't pass through, splitting the rest down to single blocks
+    const uint32_t z = slab * sBlockCells;
+    Math::Vec3 min = grid.Min + Math::Vec3(static_cast<float>(x), static_cast<float>(y), static_cast<float>(z)) * grid.CellSize;
+    Math::Vec3 max = grid.Min + Math::Vec3(static_cast<float>(std::min(x + size, grid.Cells[0])),
+        static_cast<float>(std::min(y + size, grid.Cells[1])), static_cast<float>(z + sBlockCells)) * grid.CellSize;
+    Math::Interval range = object.DistanceRange(Math::AABB(min, max), context);
+    if (range.Min() > 0.0f || range.Max() < 0.0f) {
+        return;
+    }
+
+    if (size == sBlockCells) {
+        ExtractBlock(object, context, grid, slab, x, y, result, block);
+        return;
+    }
+    const uint32_t half = size / 2;
+    ExtractBlocks(object, context, grid, slab, x, y, half, result, block);
+    ExtractBlocks(object, context, grid, slab, x + half, y, half, result, block);
+    ExtractBlocks(object, context, grid, slab, x, y + half, half, result, block);
+    ExtractBlocks(object, context, grid, slab, x + half, y + half, half, result, block);
+}
+
+void MeshExporter::ExtractBlock(const IShapedObject& object, const DistanceContext& context, const Grid& grid, unsigned int slab,
+    uint32_t x, uint32_t y, Slab& result, Block& block)
+{
+    const uint32_t z = slab * sBlockCells;
+    const uint32_t side = sBlockCells + 1;
+    auto point = [&](uint32_t px, uint32_t py, uint32_t pz) {
+        return grid.Min + Math::Vec3(static_cast<float>(px), static_cast<float>(py), static_cast<float>(pz)) * grid.CellSize;
+    };
+
+    const uint32_t blockMin[3] = { x, y, z };
+    block.Sampled.assign(block.Samples.size(), false);
+    block.ActiveCells.assign(sBlockCells * sBlockCells * sBlockCells, false);
+    ActivateCells(object, context, grid, blockMin, 0, 0, 0, sBlockCells, block);
+    result.SampledBlocks++;
+
+    const std::array<CubeCase, 256>& cases = CubeCases();
+    for (uint32_t k = 0; k < sBlockCells; k++) {
+        for (uint32_t j = 0; j < sBlockCells; j++) {
+            for (uint32_t i = 0; i < sBlockCells; i++) {
+                if (!block.ActiveCells[(k * sBlockCells + j) * sBlockCells + i]) {
+                    continue;
+                }
+                float distances[8];
+                unsigned int config = 0;
+                for (unsigned int corner = 0; corner < 8; corner++) {
+                    distances[corner] = block.Samples[((k + (corner >> 2)) * side + j + ((corner >> 1) & 1)) * side + i + (corner & 1)];
+                    config |= (distances[corner] < 0.0f ? 1u : 0u) << corner;
+                }
+
+                const CubeCase& cubeCase = cases[config];
+                for (unsigned int t = 0; t < cubeCase.TriangleCount * 3u; t++) {
+                    unsigned int edge = cubeCase.Edges[t];
+                    unsigned int axis = edge / 4;
+                    unsigned int corner = sEdgeCorners[edge][0];
+                    uint32_t px = x + i + (corner & 1);
+                    uint32_t py = y + j + ((corner >> 1) & 1);
+                    uint32_t pz = z + k + (corner >> 2);
+                    uint64_t key = EdgeKey(axis, px, py, pz);
+
+                    auto iter = result.Edges.find(key);
+                    if (iter == result.Edges.end()) {
+                        float d0 = distances[corner];
+                        float d1 = distances[sEdgeCorners[edge][1]];
+                        Math::Vec3 position = point(px, py, pz);
+                        position[axis] += d0 / (d0 - d1) * grid.CellSize;
+
+                        uint32_t index;
+                        std::vector<float>* vertices;
+                        if (slab > 0 && axis != 2 && pz == z) {
+                            index = sForeignBit | static_cast<uint32_t>(result.ForeignEdges.size());
+                            result.ForeignEdges.push_back(key);
+                            vertices = &result.ForeignVertices;
+                        } else {
+                            index = static_cast<uint32_t>(result.Vertices.size() / 3);
+                            vertices = &result.Vertices;
+                        }
+                        vertices->insert(vertices->end(), { position.x(), position.y(), position.z() });
+                        iter = result.Edges.emplace(key, index).first;
+                    }
+                    result.Triangles.push_back(iter->second);
+                }
+            }
+        }
+    }
+}
+
+void MeshExporter::ActivateCells(const IShapedObject& object, const DistanceContext& context, const Grid& grid, const uint32_t blockMin[3],
+    uint32_t x, uint32_t y, uint32_t z, uint32_t size, Block& block)
+{
+    auto point = [&](uint32_t px, uint32_t py, uint32_t pz) {
+        return grid.Min + Math::Vec3(static_cast<float>(blockMin[0] + px), static_cast<float>(blockMin[1] + py),
+            static_cast<float>(blockMin[2] + pz)) * grid.CellSize;
+    };
+
+    // The whole block already passed the test in ExtractBlocks
+    if (size < sBlockCells) {
+        Math::Interval range = object.DistanceRange(Math::AABB(point(x, y, z), point(x + size, y + size, z + size)), context);
+        if (range.Min() > 0.0f || range.Max() < 0.0f) {
+            return;
+        }
+    }
+
+    if (size > sMinCells) {
+        const uint32_t half = size / 2;
+        for (unsigned int i = 0; i < 8; i++) {
+            ActivateCells(object, context, grid, blockMin, x + (i & 1) * half, y + ((i >> 1) & 1) * half, z + (i >> 2) * half, half, block);
+        }
+        return;
+    }
+
+    // Points are computed from global indices, so neighbour blocks and slabs get bitwise equal distances
+    const uint32_t side = sBlockCells + 1;
+    for (uint32_t k = z; k <= z + size; k++) {
+        for (uint32_t j = y; j <= y + size; j++) {
+            for (uint32_t i = x; i <= x + size; i++) {
+                size_t index = (k * side + j) * side + i;
+                if (!block.Sampled[index]) {
+                    block.Samples[index] = object.Distance(point(i, j, k), context);
+                    block.Sampled[index] = true;
+                }
+                if (i < x + size && j < y + size && k < z + size) {
+                    block.ActiveCells[(k * sBlockCells + j) * sBlockCells + i] = true;
+                }
+            }
+        }
+    }
+}
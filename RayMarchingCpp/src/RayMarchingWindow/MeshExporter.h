@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "IShapedObject.h"
+#include "Mesh.h"
+#include "Math/Math.h"
+
+/*
+    Extracts the zero surface of an object with marching cubes and streams
+    it to a binary PLY or an OBJ file, picked by the path extension.
+    The grid is walked in slabs of sBlockCells cell layers shared between
+    worker threads. Inside a slab, blocks whose DistanceRange can't contain
+    the surface are skipped and the rest are split down to sMinCells cubes,
+    so only cells around the surface are sampled and the grid itself is
+    never stored. Vertices on shared cell edges are welded, slabs are
+    written in order as soon as they're done
+*/
+class MeshExporter {
+public:
+    struct Stats {
+        uint64_t VertexCount = 0;
+        uint64_t TriangleCount = 0;
+        uint64_t SampledBlocks = 0;
+        uint64_t TotalBlocks = 0;
+        double Milliseconds = 0.0;
+    };
+public:
+    /*
+        Longest axis of bounds gets resolution cells, the others as many as
+        needed to keep cells cubic. Returns nullopt if the file can't be written
+    */
+    static std::optional<Stats> Export(const IShapedObject& object, const Math::AABB& bounds, unsigned int resolution,
+        const DistanceContext& context, const std::string& path, unsigned int threadCount = 0);
+    /*
+        Same as Export, but keeps the mesh in memory
+    */
+    static Stats Extract(const IShapedObject& object, const Math::AABB& bounds, unsigned int resolution,
+        const DistanceContext& context, Mesh& mesh, unsigned int threadCount = 0);
+    /*
+        Writes a mesh built elsewhere in the format of the path extension
+    */
+    static bool Save(const Mesh& mesh, const std::string& path);
+private:
+    /*
+        Part of the mesh from one slab. Triangle corners are indices into
+        Vertices, or sForeignBit | index into ForeignEdges for vertices on
+        the slab bottom plane owned by the previous slab
+    */
+    struct Slab {
+        std::vector<float> Vertices;
+        std::vector<uint32_t> Triangles;
+        std::vector<uint64_t> ForeignEdges;
+        // Foreign vertex positions, used if the previous slab hasn't made them
+        std::vector<float> ForeignVertices;
+        // Edge key to index into Vertices
+        std::unordered_map<uint64_t, uint32_t> Edges;
+        uint64_t SampledBlocks = 0;
+        bool Done = false;
+    };
+
+    /*
+        Scratch of the block being extracted, indexed by point or cell
+        offset in the block, x changes fastest
+    */
+    struct Block {
+        std::vector<float> Samples;
+        std::vector<bool> Sampled;
+        std::vector<bool> ActiveCells;
+    };
+
+    struct Grid {
+        Math::Vec3 Min;
+        float CellSize;
+        // Cells along each axis, multiple of sBlockCells
+        uint32_t Cells[3];
+    };
+
+    class Writer;
+
+    static Stats Run(const IShapedObject& object, const Math::AABB& bounds, unsigned int resolution,
+        const DistanceContext& context, Writer& writer, unsigned int threadCount);
+    static void ExtractSlab(const IShapedObject& object, const DistanceContext& context, const Grid& grid, unsigned int slab, Slab& result);
+    static void ExtractBlocks(const IShapedObject& object, const DistanceContext& context, const Grid& grid, unsigned int slab,
+        uint32_t x, uint32_t y, uint32_t size, Slab& result, Block& block);
+    static void ExtractBlock(const IShapedObject& object, const DistanceContext& context, const Grid& grid, unsigned int slab,
+        uint32_t x, uint32_t y, Slab& result, Block& block);
+    /*
+        Samples cells of the cube at offset (x, y, z) of the block at blockMin that DistanceRange can't rule out
+    */
+    static void ActivateCells(const IShapedObject& object, const DistanceContext& context, const Grid& grid, const uint32_t blockMin[3],
+        uint32_t x, uint32_t y, uint32_t z, uint32_t size, Block& block);
+private:
+    static constexpr uint32_t sBlockCells = 8;
+    static constexpr uint32_t sMinCells = 2;
+    static constexpr uint32_t sForeignBit = 0x80000000;
+};
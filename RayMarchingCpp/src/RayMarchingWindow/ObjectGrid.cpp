@@ -0,0 +1,76 @@
+#include "ObjectGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+void ObjectGrid::Build(const std::vector<Math::AABB>& bounds, const std::vector<int32_t>& ids)
+{
+    mBounds = Math::AABB();
+    for (const Math::AABB& box : bounds) {
+        mBounds = mBounds.Union(box);
+    }
+
+    mCells.clear();
+    mObjects.clear();
+    mDimensions = { 1, 1, 1 };
+    if (mBounds.IsEmpty()) {
+        mBounds = Math::AABB(Math::Vec3(0.0f), Math::Vec3(0.0f));
+        mCellSize = Math::Vec3(1.0f);
+        mCells.assign(2, 0);
+        return;
+    }
+
+    // Aim for about one cell per object, flat scenes get a single layer
+    Math::Vec3 size = mBounds.Size();
+    float minExtent = std::max({ size.x(), size.y(), size.z() }) * 1e-3f + 1e-4f;
+    float volume = std::max(size.x(), minExtent) * std::max(size.y(), minExtent) * std::max(size.z(), minExtent);
+    float targetCell = std::cbrt(volume / static_cast<float>(bounds.size()));
+    for (unsigned int i = 0; i < 3; i++) {
+        mDimensions[i] = std::clamp(static_cast<int>(std::ceil(size[i] / targetCell)), 1, sMaxDimension);
+        mCellSize[i] = std::max(size[i], minExtent) / mDimensions[i];
+    }
+
+    std::vector<int32_t> counts(static_cast<size_t>(mDimensions[0]) * mDimensions[1] * mDimensions[2], 0);
+    std::array<int, 3> first;
+    std::array<int, 3> last;
+
+    for (const Math::AABB& box : bounds) {
+        CellRange(box, first, last);
+        for (int z = first[2]; z <= last[2]; z++)
+            for (int y = first[1]; y <= last[1]; y++)
+                for (int x = first[0]; x <= last[0]; x++)
+                    counts[CellIndex(x, y, z)]++;
+    }
+
+    mCells.resize(counts.size() * 2);
+    int32_t offset = 0;
+    for (size_t i = 0; i < counts.size(); i++) {
+        mCells[i * 2] = offset;
+        mCells[i * 2 + 1] = 0;
+        offset += counts[i];
+    }
+    mObjects.resize(offset);
+
+    for (size_t object = 0; object < bounds.size(); object++) {
+        CellRange(bounds[object], first, last);
+        for (int z = first[2]; z <= last[2]; z++)
+            for (int y = first[1]; y <= last[1]; y++)
+                for (int x = first[0]; x <= last[0]; x++) {
+                    int cell = CellIndex(x, y, z);
+                    mObjects[mCells[cell * 2] + mCells[cell * 2 + 1]++] = ids[object];
+                }
+    }
+}
+
+int ObjectGrid::CellIndex(int x, int y, int z) const
+{
+    return (z * mDimensions[1] + y) * mDimensions[0] + x;
+}
+
+void ObjectGrid::CellRange(const Math::AABB& box, std::array<int, 3>& first, std::array<int, 3>& last) const
+{
+    for (unsigned int i = 0; i < 3; i++) {
+        first[i] = std::clamp(static_cast<int>(std::floor((box.Min()[i] - mBounds.Min()[i]) / mCellSize[i])), 0, mDimensions[i] - 1);
+        last[i] = std::clamp(static_cast<int>(std::floor((box.Max()[i] - mBounds.Min()[i]) / mCellSize[i])), 0, mDimensions[i] - 1);
+    }
+}
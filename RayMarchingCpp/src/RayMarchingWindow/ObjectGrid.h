@@ -0,0 +1,37 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "Math/Math.h"
+
+/*
+    Uniform grid over object bounds. Every cell lists the objects whose box
+    overlaps it, so the shader evaluates only nearby objects. Cells are
+    stored as (first, count) pairs into the flat list of object ids
+*/
+class ObjectGrid {
+public:
+    /*
+        ids[i] is the shader id of the object bounded by bounds[i]
+    */
+    void Build(const std::vector<Math::AABB>& bounds, const std::vector<int32_t>& ids);
+
+    const Math::AABB& Bounds() const { return mBounds; }
+    const Math::Vec3& CellSize() const { return mCellSize; }
+    const std::array<int, 3>& Dimensions() const { return mDimensions; }
+    const std::vector<int32_t>& Cells() const { return mCells; }
+    const std::vector<int32_t>& Objects() const { return mObjects; }
+private:
+    int CellIndex(int x, int y, int z) const;
+    void CellRange(const Math::AABB& box, std::array<int, 3>& first, std::array<int, 3>& last) const;
+private:
+    static constexpr int sMaxDimension = 64;
+
+    Math::AABB mBounds;
+    Math::Vec3 mCellSize;
+    std::array<int, 3> mDimensions = { 1, 1, 1 };
+    std::vector<int32_t> mCells;
+    std::vector<int32_t> mObjects;
+};
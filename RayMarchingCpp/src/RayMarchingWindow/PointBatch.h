@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+
+#include "Math/Float4.h"
+
+/*
+    Points of a batched distance query, one array per coordinate so shapes
+    can evaluate four of them at once. Holds at most sMaxCount points,
+    which lets wrappers keep their scratch on the stack
+*/
+struct PointBatch {
+    static constexpr size_t sMaxCount = 256;
+
+    const float* X = nullptr;
+    const float* Y = nullptr;
+    const float* Z = nullptr;
+    size_t Count = 0;
+
+    /*
+        Writes kernel(x, y, z) of every point to out, called with
+        Math::Float4 coordinates of four points and with float ones for
+        the remainder
+    */
+    template <typename Kernel>
+    void Evaluate(float* out, const Kernel& kernel) const
+    {
+        size_t i = 0;
+        for (; i + 4 <= Count; i += 4) {
+            kernel(Math::Float4::Load(X + i), Math::Float4::Load(Y + i), Math::Float4::Load(Z + i)).Store(out + i);
+        }
+        for (; i < Count; i++) {
+            out[i] = kernel(X[i], Y[i], Z[i]);
+        }
+    }
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <string_view>
+
+/*
+    Compile-time settings of the fragment shader. Every tier is built as its
+    own program permutation, see RayMarchingWindow::UseQualityTier
+*/
+struct QualityTier {
+    std::string_view Name;
+    int MaxSteps;
+    float MaxDistance;
+    float SurfaceDistance;
+    bool Shadows;
+
+    std::string ShaderDefines(bool shadows) const
+    {
+        std::string defines = "#define MAX_STEPS " + std::to_string(MaxSteps) + '\n' +
+            "#define MAX_DISTANCE " + std::to_string(MaxDistance) + '\n' +
+            "#define SURFACE_DISTANCE " + std::to_string(SurfaceDistance) + '\n';
+        if (shadows) {
+            defines += "#define ENABLE_SHADOWS\n";
+        }
+        return defines;
+    }
+
+    std::string PermutationKey(bool shadows) const
+    {
+        return std::string(Name) + (shadows ? "+shadows" : "");
+    }
+
+    static const std::array<QualityTier, 3>& Tiers()
+    {
+        static const std::array<QualityTier, 3> sTiers = { {
+            { "preview",     48,  60.0f,  0.01f,   false },
+            { "interactive", 100, 150.0f, 0.001f,  false },
+            { "final",       256, 250.0f, 0.0005f, true  },
+        } };
+        return sTiers;
+    }
+};
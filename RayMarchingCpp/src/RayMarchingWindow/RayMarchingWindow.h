@@ -9,40 +9,224 @@
 #include "OpenGL/VertexLayout.h"
 #include "OpenGL/ShaderSource.h"
 #include "OpenGL/ShaderProgram.h"
+#include "OpenGL/ShaderProgramCache.h"
 #include "OpenGL/Renderer.h"
 #include "OpenGL/Texture.h"
+#include "OpenGL/FrameBuffer.h"
+#include "OpenGL/TextureBuffer.h"
+#include "OpenGL/PixelReadback.h"
 
 #include "Math/Math.h"
 #include "IShapedObject.h"
 #include "IImGuiEditable.h"
+#include "IBakedObject.h"
+#include "DistanceContext.h"
 #include "ShapeRegistrar.h"
+#include "QualityTier.h"
+#include "ObjectGrid.h"
+#include "MeshExporter.h"
+#include "DualContouring.h"
+#include "SceneQuery.h"
+#include "CpuRenderer.h"
+#include "FrameEncoderPool.h"
+#include "FrameStreamer.h"
+#include "JobSystem.h"
+#include "StartupProfiler.h"
+#include "UnitedShapeWrapper.h"
+#include "CompiledShapeWrapper.h"
 
 #include <functional>
 #include <vector>
 #include <array>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <future>
+#include <numeric>
 
 #include <imgui.h>
 
 class RayMarchingWindow : public Window {
     using Window::Window;
-    
-    void Init()
+
+    /*
+        Files being read and decoded on job threads while the window is created
+    */
+    struct StartupAssets {
+        std::future<std::shared_ptr<OpenGL::ShaderSource>> VertexShader;
+        std::future<std::shared_ptr<OpenGL::ShaderSource>> FragmentShader;
+        std::future<std::shared_ptr<OpenGL::ShaderSource>> ReconstructShader;
+        std::future<OpenGL::Texture::Image> Noise;
+    };
+
+    static StartupAssets LoadAssets(JobSystem& jobs, StartupProfiler& profiler)
+    {
+        auto loadShader = [&jobs, &profiler](std::string path) {
+            return jobs.Submit([&profiler, path]() {
+                StartupProfiler::Scope scope = profiler.Measure("read " + path);
+                return OpenGL::ShaderSource::LoadFrom(path);
+            });
+        };
+
+        StartupAssets assets;
+        assets.VertexShader = loadShader("res/shaders/Vertex.shader");
+        assets.FragmentShader = loadShader("res/shaders/Fragment.shader");
+        assets.ReconstructShader = loadShader("res/shaders/Reconstruct.shader");
+        assets.Noise = jobs.Submit([&profiler]() {
+            StartupProfiler::Scope scope = profiler.Measure("decode noise texture");
+            return OpenGL::Texture::Decode(sNoiseTexturePath);
+        });
+        return assets;
+    }
+
+    void Init(std::unique_ptr<StartupProfiler> profiler, std::unique_ptr<JobSystem> jobs, StartupAssets& assets)
     {
-        mVShaderSource = OpenGL::ShaderSource::LoadFrom("res/shaders/Vertex.shader");
-        mFShaderSource = OpenGL::ShaderSource::LoadFrom("res/shaders/Fragment.shader");
-        mNoiseTexture = std::shared_ptr<OpenGL::Texture>(new OpenGL::Texture("res/textures/noise.bmp"));
+        mStartupProfiler = std::move(profiler);
+        mJobs = std::move(jobs);
+
+        StartupProfiler::Scope scope = mStartupProfiler->Measure("wait for assets and upload");
+        mVShaderSource = assets.VertexShader.get();
+        mFShaderSource = assets.FragmentShader.get();
+        mFShaderTemplate = std::make_shared<OpenGL::ShaderSource>(*mFShaderSource);
+        mReconstructShaderSource = assets.ReconstructShader.get();
+        mNoiseTexture = std::make_shared<OpenGL::Texture>(sNoiseTexturePath, assets.Noise.get());
     }
 public:
-    static std::unique_ptr<RayMarchingWindow> Create(const std::string& title, unsigned int width = 640, unsigned int height = 480)
+    /*
+        Full marches every pixel each frame, Checkerboard marches half of them
+        and Interleaved one pixel of each 2x2 block. Skipped pixels are
+        reconstructed from marched neighbours and the previous frame.
+        Progressive marches a level of RenderProgressive, FirstPass and
+        Supersample the passes of DrawAntialiased and StepCount a frame of
+        CountMarchSteps, they aren't modes for SetRenderMode
+    */
+    enum class RenderMode : int {
+        Full = 0,
+        Checkerboard = 1,
+        Interleaved = 2,
+        Progressive = 3,
+        FirstPass = 4,
+        Supersample = 5,
+        StepCount = 6
+    };
+
+    /*
+        Antialiasing of Full mode frames. Adaptive marches 4 rays more only
+        for pixels on edges of a first pass, Uniform marches 4 rays for
+        every pixel
+    */
+    enum class Antialiasing : int {
+        Off = 0,
+        Adaptive = 1,
+        Uniform = 2
+    };
+
+    struct AntialiasSettings {
+        Antialiasing Mode = Antialiasing::Off;
+        // Weakest edge strength supersampled, from 0 to 1
+        float EdgeThreshold = 0.1f;
+        // Rays a frame may march beyond the first pass, the weakest edges over it are left as they are
+        unsigned int MaxExtraRays = 1u << 20;
+    };
+
+    struct AntialiasStats {
+        // Pixels at least as strong as the threshold, and how many of them were supersampled within the cap
+        unsigned int EdgePixels = 0;
+        unsigned int SupersampledPixels = 0;
+        // Camera rays of the frame, first pass included
+        uint64_t Rays = 0;
+    };
+
+    /*
+        Offline render of frames at fixed time steps, see RenderSequence
+    */
+    struct SequenceSettings {
+        std::string Directory;
+        unsigned int FrameCount = 1;
+        float StartTime = 0.0f;
+        float TimeStep = 1.0f / 30.0f;
+        FrameEncoderPool::Format Format = FrameEncoderPool::Format::Png;
+        unsigned int QualityTierIndex = 1;
+        // Marches frames with CpuRenderer instead of the GPU
+        bool Cpu = false;
+        // The camera circles once around the point sTurntableRadius in front of it
+        bool Turntable = false;
+        // Zero picks the FrameEncoderPool or FrameStreamer defaults
+        unsigned int EncoderThreads = 0;
+        unsigned int QueueCapacity = 0;
+        // Unless empty frames go to this file, named pipe or "-" for stdout instead of Directory
+        std::string StreamPath;
+        FrameStreamer::Format StreamFormat = FrameStreamer::Format::Y4m;
+        FrameStreamer::Policy StreamPolicy = FrameStreamer::Policy::Block;
+        AntialiasSettings Antialias;
+    };
+
+    struct SequenceStats {
+        double Milliseconds = 0.0;
+        // Spent by the render thread rendering frames and handing them to the encoders
+        double RenderMilliseconds = 0.0;
+        unsigned int EncoderThreads = 0;
+        size_t FrameSlots = 0;
+        FrameEncoderPool::Stats Encoder;
+        FrameStreamer::Stats Stream;
+        // GPU frames only
+        OpenGL::PixelReadback::Stats Readback;
+
+        double FramesPerSecond() const
+        {
+            return Milliseconds > 0.0 ? (Encoder.Frames + Stream.Frames) * 1000.0 / Milliseconds : 0.0;
+        }
+    };
+
+    struct ProgressiveStats {
+        // Pixels apart of the samples of each level rendered and when it was ready, coarsest first. Times leave out the callback
+        std::vector<unsigned int> Steps;
+        std::vector<double> LevelMilliseconds;
+        double Milliseconds = 0.0;
+        // Stopped by the callback before the full resolution level
+        bool Interrupted = false;
+    };
+
+    /*
+        Called with each finished level of RenderProgressive, returns false
+        to stop rendering finer levels
+    */
+    using ProgressiveCallback = std::function<bool(unsigned int step, const unsigned char* pixels)>;
+
+    // Texture units from this one on aren't used by the window and are free for objects
+    static constexpr unsigned int sFirstObjectTextureSlot = 5;
+
+    template <typename WindowType = RayMarchingWindow>
+    static std::unique_ptr<WindowType> Create(const std::string& title, unsigned int width = 640, unsigned int height = 480,
+        bool visible = true)
     {
-        std::unique_ptr<RayMarchingWindow> window(Window::Create<RayMarchingWindow>(title, width, height));
-        window->Init();
-        return std::move(window);
+        std::unique_ptr<StartupProfiler> profiler = std::make_unique<StartupProfiler>();
+        std::unique_ptr<JobSystem> jobs = std::make_unique<JobSystem>();
+        StartupAssets assets = LoadAssets(*jobs, *profiler);
+
+        std::unique_ptr<WindowType> window;
+        {
+            StartupProfiler::Scope scope = profiler->Measure("window and context");
+            window.reset(Window::Create<WindowType>(title, width, height, visible));
+        }
+        window->Init(std::move(profiler), std::move(jobs), assets);
+        return window;
     }
 
     virtual ~RayMarchingWindow()
     {
-        mShader.Delete();
+        mProgramCache.Clear();
+        mReconstructShader.Delete();
+        for (const OpenGL::FrameBuffer& buffer : mHistoryBuffers) {
+            buffer.Delete();
+        }
+        mCheckerboardBuffer.Delete();
+        mInterleavedBuffer.Delete();
+        mFirstPassBuffer.Delete();
+        mEdgeBuffer.Delete();
+        mGridCellsBuffer.Delete();
+        mGridObjectsBuffer.Delete();
         mIbo.Delete();
         mVbo.Delete();
         mVao.Delete();
@@ -64,9 +248,597 @@ public:
     {
         mEditableObjects.push_back(object);
     }
+
+    void RegisterBakedObject(std::shared_ptr<IBakedObject> object)
+    {
+        mBakedObjects.push_back(object);
+    }
+
+    /*
+        Writes the surface of the whole scene inside a cube of sMeshExportSize
+        around the camera to a .ply or .obj file, see MeshExporter. Dual
+        contouring runs over an octree of the smallest depth giving at
+        least resolution cells and simplifies flat parts, see DualContouring
+    */
+    std::optional<MeshExporter::Stats> ExportMesh(const std::string& path, unsigned int resolution, bool dualContouring = false)
+    {
+        std::shared_ptr<IShapedObject> sceneObject = CpuScene();
+        const IShapedObject& scene = *sceneObject;
+        DistanceContext context = { mSmoothMin, 0.0f, mNoiseTexture.get() };
+        Math::Vec3 halfSize(sMeshExportSize * 0.5f);
+        Math::AABB bounds(mCameraPos - halfSize, mCameraPos + halfSize);
+        if (!dualContouring) {
+            return MeshExporter::Export(scene, bounds, resolution, context, path);
+        }
+
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        unsigned int depth = 0;
+        while ((1u << depth) < resolution) {
+            depth++;
+        }
+        SdfOctree octree = SdfOctree::Build(scene, bounds, depth, context);
+        Mesh mesh = DualContouring::Extract(scene, octree, context, sMeshExportSize / (1u << depth) * sDualContouringError);
+        if (!MeshExporter::Save(mesh, path)) {
+            return std::nullopt;
+        }
+
+        MeshExporter::Stats stats;
+        stats.VertexCount = mesh.VertexCount();
+        stats.TriangleCount = mesh.TriangleCount();
+        stats.Milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        return stats;
+    }
+
+    /*
+        Distances and normals of points against the rendered scene at the
+        current animation time, see SceneQuery. outNormals may be null
+    */
+    void QueryDistances(const Math::Vec3* points, size_t count, float* outDistances, Math::Vec3* outNormals)
+    {
+        std::shared_ptr<IShapedObject> scene = CpuScene();
+        float time = std::chrono::duration_cast<std::chrono::duration<float, std::ratio<1, 1>>>
+            (std::chrono::steady_clock::now() - mStartTime).count();
+        DistanceContext context = { mSmoothMin, time, mNoiseTexture.get() };
+        SceneQuery::QueryDistances(*scene, context, points, count, outDistances, outNormals);
+    }
+
+    /*
+        Renders settings.FrameCount frames at full rate and writes them to
+        frame_00000.png (or .exr) and on in settings.Directory. The window
+        may be hidden, GPU frames are rendered offscreen and read back
+        through a PixelReadback. Files are encoded by a FrameEncoderPool
+        while next frames render, with settings.StreamPath frames are
+        written to one stream by a FrameStreamer instead. Returns nullopt
+        if the directory or stream can't be opened or the scene doesn't
+        build
+    */
+    std::optional<SequenceStats> RenderSequence(const SequenceSettings& settings)
+    {
+        std::optional<FrameStreamer> streamer;
+        if (!settings.StreamPath.empty()) {
+            // Frame rate as a fraction of thousandths, 1 / 60 gives 60:1
+            unsigned int rate = static_cast<unsigned int>(std::lround(1000.0 / settings.TimeStep));
+            unsigned int divisor = std::gcd(rate, 1000u);
+            streamer.emplace(settings.StreamPath, settings.StreamFormat, settings.StreamPolicy, mWidth, mHeight, rate / divisor,
+                1000u / divisor, settings.QueueCapacity == 0 ? 4 : settings.QueueCapacity);
+            if (!streamer->IsOpen()) {
+                return std::nullopt;
+            }
+        } else {
+            std::error_code error;
+            std::filesystem::create_directories(settings.Directory, error);
+            if (!std::filesystem::is_directory(settings.Directory)) {
+                return std::nullopt;
+            }
+        }
+        const QualityTier& tier = QualityTier::Tiers()[settings.QualityTierIndex];
+        std::shared_ptr<IShapedObject> cpuScene;
+        RenderMode previousMode = mRenderMode;
+        AntialiasSettings previousAntialias = mAntialias;
+        unsigned int previousTier = mQualityTierIndex;
+        bool previousShadows = mEnableShadows;
+        if (settings.Cpu) {
+            cpuScene = CpuScene();
+        } else {
+            if (!CreateOffscreen() || !UseQualityTier(settings.QualityTierIndex, tier.Shadows)) {
+                return std::nullopt;
+            }
+            SetRenderMode(RenderMode::Full);
+            SetAntialiasing(settings.Antialias);
+        }
+
+        Math::Vec3 cameraPos = mCameraPos;
+        float cameraRotationY = mCameraRotationY;
+        Math::Vec3 forward(std::sin(cameraRotationY), 0.0f, std::cos(cameraRotationY));
+        Math::Vec3 pivot = cameraPos + forward * sTurntableRadius;
+        const char* extension = settings.Format == FrameEncoderPool::Format::Png ? "png" : "exr";
+
+        SequenceStats stats;
+        std::optional<FrameEncoderPool> encoders;
+        if (!streamer) {
+            encoders.emplace(settings.Format, settings.EncoderThreads, settings.QueueCapacity);
+        }
+        stats.EncoderThreads = encoders ? encoders->ThreadCount() : 0;
+        stats.FrameSlots = encoders ? encoders->Capacity() : streamer->Capacity();
+        auto framePath = [&](uint64_t index) {
+            char name[32];
+            std::snprintf(name, sizeof(name), "frame_%05u.%s", static_cast<unsigned int>(index), extension);
+            return (std::filesystem::path(settings.Directory) / name).string();
+        };
+        // GPU frames reach the encoders a few frames late, when their readback is done
+        OpenGL::PixelReadback readback;
+        if (!settings.Cpu) {
+            readback = OpenGL::PixelReadback(mWidth, mHeight, [&](const unsigned char* pixels, uint64_t index) {
+                if (streamer) {
+                    if (FrameStreamer::Frame* frame = streamer->Acquire()) {
+                        frame->Pixels.assign(pixels, pixels + readback.SizeInBytes());
+                        streamer->Submit(*frame);
+                    }
+                    return;
+                }
+                FrameEncoderPool::Frame& frame = encoders->Acquire();
+                frame.Path = framePath(index);
+                frame.Width = mWidth;
+                frame.Height = mHeight;
+                frame.Pixels.assign(pixels, pixels + readback.SizeInBytes());
+                encoders->Submit(frame);
+            });
+        }
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (unsigned int i = 0; i < settings.FrameCount; i++) {
+            float time = settings.StartTime + settings.TimeStep * i;
+            if (settings.Turntable) {
+                mCameraRotationY = cameraRotationY + static_cast<float>(2.0 * sPI) * i / settings.FrameCount;
+                mCameraPos = pivot - Math::Vec3(std::sin(mCameraRotationY), 0.0f, std::cos(mCameraRotationY)) * sTurntableRadius;
+            }
+
+            if (!settings.Cpu) {
+                std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+                ReadFrame(time, readback, i);
+                stats.RenderMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+                continue;
+            }
+
+            // A dropped stream frame isn't rendered at all
+            FrameStreamer::Frame* streamFrame = streamer ? streamer->Acquire() : nullptr;
+            if (streamer && !streamFrame) {
+                continue;
+            }
+            FrameEncoderPool::Frame* frame = streamer ? nullptr : &encoders->Acquire();
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            std::vector<float>& colors = streamer ? streamFrame->Colors : frame->Colors;
+            colors.resize(static_cast<size_t>(mWidth) * mHeight * 4);
+            CpuRenderer::View view = { mCameraPos, mCameraRotationY, Math::Vec3(mLightPos.x(), mLightPos.y(), mLightPos.z()) };
+            DistanceContext context = { mSmoothMin, time, mNoiseTexture.get() };
+            CpuRenderer::Render(*cpuScene, context, view, tier, tier.Shadows, mWidth, mHeight, colors.data());
+            stats.RenderMilliseconds += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            if (streamer) {
+                streamer->Submit(*streamFrame);
+                continue;
+            }
+            frame->Path = framePath(i);
+            frame->Width = mWidth;
+            frame->Height = mHeight;
+            encoders->Submit(*frame);
+        }
+        if (!settings.Cpu) {
+            readback.Flush();
+            stats.Readback = readback.GetStats();
+            readback.Delete();
+        }
+        if (encoders) {
+            stats.Encoder = encoders->Finish();
+        } else {
+            stats.Stream = streamer->Finish();
+        }
+        stats.Milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        mCameraPos = cameraPos;
+        mCameraRotationY = cameraRotationY;
+        if (!settings.Cpu) {
+            SetRenderMode(previousMode);
+            SetAntialiasing(previousAntialias);
+            UseQualityTier(previousTier, previousShadows);
+        }
+        return stats;
+    }
+
+    /*
+        Renders one frame coarse to fine for previews: every 8th pixel of
+        rows and columns first, then every 4th, 2nd and every pixel. Each
+        level marches only the pixels coarser levels didn't and its rays
+        start where cones marched by the coarser samples around them found
+        the scene empty. Cone marches and rays that miss and march again
+        from the camera still make the whole frame slower than one full
+        pass. The callback gets the step of each level and the frame so far
+        at full resolution, rows bottom to top. Nullopt if the scene doesn't
+        build
+    */
+    std::optional<ProgressiveStats> RenderProgressive(float time, unsigned int tierIndex, const ProgressiveCallback& levelDone)
+    {
+        unsigned int previousTier = mQualityTierIndex;
+        bool previousShadows = mEnableShadows;
+        if (!CreateOffscreen() || !UseQualityTier(tierIndex, QualityTier::Tiers()[tierIndex].Shadows)) {
+            return std::nullopt;
+        }
+
+        ProgressiveStats stats;
+        std::vector<unsigned char> pixels;
+        OpenGL::FrameBuffer coarser;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::chrono::duration<double, std::milli> callbackTime(0.0);
+        for (unsigned int step = sProgressiveCoarsestStep; step >= 1; step /= 2) {
+            // Distances in alpha would be clamped by an RGBA8 target
+            OpenGL::FrameBuffer level((mWidth + step - 1) / step, (mHeight + step - 1) / step, true);
+            mProgressiveStep = step;
+            mProgressiveHasCoarse = step < sProgressiveCoarsestStep;
+            if (mProgressiveHasCoarse) {
+                coarser.BindColorTexture(sSampleTextureSlot);
+            }
+            MarchScene(level, RenderMode::Progressive, time);
+
+            mHistoryBuffers[mHistoryIndex].Bind();
+            level.BindColorTexture(sSampleTextureSlot);
+            mReconstructShader.Bind();
+            mReconstructShader.SetUniform1i("u_InterleaveMode", static_cast<int>(RenderMode::Progressive));
+            mReconstructShader.SetUniform1i("u_ProgressiveStep", static_cast<int>(step));
+            mRenderer.Draw(mVao, mIbo, mReconstructShader);
+            mHistoryBuffers[mHistoryIndex].ReadPixels(pixels);
+            mHistoryBuffers[mHistoryIndex].Unbind();
+            stats.Steps.push_back(step);
+            stats.LevelMilliseconds.push_back((std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start) - callbackTime).count());
+
+            if (mProgressiveHasCoarse) {
+                coarser.Delete();
+            }
+            coarser = level;
+            std::chrono::steady_clock::time_point callbackStart = std::chrono::steady_clock::now();
+            bool proceed = levelDone(step, pixels.data());
+            callbackTime += std::chrono::steady_clock::now() - callbackStart;
+            if (!proceed) {
+                stats.Interrupted = step > 1;
+                break;
+            }
+        }
+        coarser.Delete();
+        stats.Milliseconds = (std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start) - callbackTime).count();
+
+        GLCall(glViewport(0, 0, mWidth, mHeight));
+        mHistoryValid = false;
+        UseQualityTier(previousTier, previousShadows);
+        return stats;
+    }
+
+    /*
+        Sets up the OpenGL objects of a window that isn't run, for rendering
+        offscreen. Does nothing once they are set up
+    */
+    bool CreateOffscreen()
+    {
+        return mShader || OnCreate();
+    }
+
+    /*
+        Draws a frame of current mode at time and queues its readback as
+        frame number frame
+    */
+    void ReadFrame(float time, OpenGL::PixelReadback& readback, uint64_t frame)
+    {
+        DrawFrame(time);
+        readback.Read(mHistoryBuffers[mHistoryIndex], frame);
+    }
+
+    /*
+        Reallocates the framebuffers of a window rendering offscreen, the
+        window itself keeps its size
+    */
+    void Resize(unsigned int width, unsigned int height)
+    {
+        if (width == mWidth && height == mHeight) {
+            return;
+        }
+        mWidth = width;
+        mHeight = height;
+        for (OpenGL::FrameBuffer& buffer : mHistoryBuffers) {
+            buffer.Delete();
+            buffer = OpenGL::FrameBuffer(mWidth, mHeight);
+        }
+        mCheckerboardBuffer.Delete();
+        mCheckerboardBuffer = OpenGL::FrameBuffer((mWidth + 1) / 2, mHeight);
+        mInterleavedBuffer.Delete();
+        mInterleavedBuffer = OpenGL::FrameBuffer((mWidth + 1) / 2, (mHeight + 1) / 2);
+        mFrameIndex = 0;
+        mHistoryValid = false;
+    }
+
+    /*
+        Unregisters all objects and shape types and resets the settings a
+        scene may give, so another scene can be registered. Programs stay
+        in the program cache, see UseScene
+    */
+    void ClearScene()
+    {
+        size_t gridThreshold = mRegistrar.GridThreshold();
+        mRegistrar = ShapeRegistrar();
+        mRegistrar.SetGridThreshold(gridThreshold);
+        mFShaderSource = std::make_shared<OpenGL::ShaderSource>(*mFShaderTemplate);
+        mShapes.clear();
+        mEditableObjects.clear();
+        mBakedObjects.clear();
+        mCurrentEditableIndex = -1;
+        mCompiledScene.reset();
+        mSmoothMin = 0.0f;
+        mQualityTierIndex = sDefaultQualityTier;
+        mLightPos = DefaultLightPosition();
+        mFrameIndex = 0;
+        mHistoryValid = false;
+    }
+
+    /*
+        Generates the source of the registered scene and switches to its
+        program of given tier. Unlike BuildScene it keeps programs of other
+        scenes: cache keys start with sceneKey, so a scene registered again
+        under the same key doesn't compile. Only this permutation compiles
+    */
+    bool UseScene(const std::string& sceneKey, unsigned int tierIndex, bool shadows)
+    {
+        mSceneKey = sceneKey;
+        mSceneShaderSource = GenerateSceneSource();
+        mGridBounds.clear();
+        mGridIds.clear();
+        return UseQualityTier(tierIndex, shadows);
+    }
+
+    /*
+        Renders frames as the region at x, y from the bottom left of a frame
+        of frameWidth by frameHeight, the region has the framebuffer size.
+        A frame size of 0 renders whole frames again
+    */
+    void SetTile(unsigned int frameWidth, unsigned int frameHeight, unsigned int x, unsigned int y)
+    {
+        mTileFrameWidth = frameWidth;
+        mTileFrameHeight = frameHeight;
+        mTileX = frameWidth > 0 ? x : 0;
+        mTileY = frameHeight > 0 ? y : 0;
+    }
+
+    void SetProgramCacheCapacity(size_t capacity)
+    {
+        mProgramCache.SetCapacity(capacity);
+    }
+
+    /*
+        Programs linked so far, cache hits don't count
+    */
+    uint64_t ProgramCompiles() const
+    {
+        return mProgramCompiles;
+    }
+
+    /*
+        Union of registered objects evaluated by CPU features. With
+        SetNativeCpuScene it's compiled to native code, see SceneCompiler,
+        and compiled again whenever objects change. Falls back to the
+        interpreted union if the compiler fails
+    */
+    std::shared_ptr<IShapedObject> CpuScene()
+    {
+        auto scene = std::make_shared<UnitedShapeWrapper>(mShapes);
+        if (!mNativeCpuScene) {
+            return scene;
+        }
+        if (!mCompiledScene || !mCompiledScene->IsCurrent()) {
+            std::string log;
+            std::optional<SceneCompiler::Program> program = SceneCompiler::Compile(*scene, &log);
+            if (!program) {
+                std::cerr << "[SceneCompiler] " << log << '\n';
+                mNativeCpuScene = false;
+                mCompiledScene.reset();
+                return scene;
+            }
+            mCompiledScene = std::make_shared<CompiledShapeWrapper>(scene, std::move(*program));
+        }
+        return mCompiledScene;
+    }
+
+    void SetNativeCpuScene(bool native)
+    {
+        mNativeCpuScene = native;
+    }
+
+    /*
+        Scene settings of SceneFile, set before Run. The quality tier
+        comes with its default shadow setting
+    */
+    void SetSmoothMin(float smoothMin)
+    {
+        mSmoothMin = smoothMin;
+    }
+
+    void SetQualityTier(unsigned int tierIndex)
+    {
+        mQualityTierIndex = std::min(tierIndex, static_cast<unsigned int>(QualityTier::Tiers().size() - 1));
+    }
+
+    unsigned int QualityTierIndex() const
+    {
+        return mQualityTierIndex;
+    }
+
+    void SetLightPosition(const Math::Vec3& position)
+    {
+        mLightPos = { position.x(), position.y(), position.z(), 1.0f };
+    }
+
+    void SetCamera(const Math::Vec3& position, float rotationY)
+    {
+        mCameraPos = position;
+        mCameraRotationY = rotationY;
+    }
+
+    /*
+        Phases of the startup up to the first frame, more of them can be
+        measured until it's drawn
+    */
+    StartupProfiler& GetStartupProfiler()
+    {
+        return *mStartupProfiler;
+    }
+
+    void SetRenderMode(RenderMode mode)
+    {
+        mRenderMode = mode;
+        mFrameIndex = 0;
+        mHistoryValid = false;
+    }
+
+    /*
+        Applies to frames of Full mode only
+    */
+    void SetAntialiasing(const AntialiasSettings& settings)
+    {
+        mAntialias = settings;
+        mAntialiasStats = AntialiasStats();
+    }
+
+    const AntialiasStats& LastAntialiasStats() const
+    {
+        return mAntialiasStats;
+    }
+
+    /*
+        While the smooth union radius is 0, objects with closed form ray
+        intersections are intersected instead of marched, see RayMarchFrom.
+        Not while the object grid holds more than sMaxAnalyticGridEntries
+        of them
+    */
+    void SetAnalyticHits(bool enabled)
+    {
+        mAnalyticHits = enabled;
+    }
+
+    /*
+        Steps all rays of a Full mode frame at time take through the scene,
+        shadow rays included
+    */
+    uint64_t CountMarchSteps(float time)
+    {
+        OpenGL::FrameBuffer target(mWidth, mHeight, true);
+        MarchScene(target, RenderMode::StepCount, time);
+        std::vector<float> pixels;
+        target.ReadPixels(pixels);
+        target.Delete();
+
+        uint64_t steps = 0;
+        for (size_t i = 3; i < pixels.size(); i += 4) {
+            steps += static_cast<uint64_t>(pixels[i]);
+        }
+        return steps;
+    }
+
+    /*
+        Generates scene source from registered objects and relinks programs of
+        all quality tiers. Needed only when the set of objects changes
+    */
+    bool BuildScene()
+    {
+        return CompileScene(GenerateSceneSource());
+    }
+
+    /*
+        Generates scene source from registered objects, doesn't touch OpenGL
+    */
+    std::shared_ptr<OpenGL::ShaderSource> GenerateSceneSource()
+    {
+        std::shared_ptr<OpenGL::ShaderSource> source = std::make_shared<OpenGL::ShaderSource>(*mFShaderSource);
+        mRegistrar.RegisterObjects(mShapes, *source);
+        mRegistrar.GenerateSceneDistanceFunction(*source);
+        return source;
+    }
+
+    /*
+        Relinks programs of all quality tiers from source given by
+        GenerateSceneSource
+    */
+    bool CompileScene(std::shared_ptr<OpenGL::ShaderSource> source)
+    {
+        mSceneShaderSource = source;
+        mGridBounds.clear();
+        mGridIds.clear();
+
+        unsigned int currentTier = mQualityTierIndex;
+        bool currentShadows = mEnableShadows;
+        mProgramCache.Clear();
+
+        // Warm up default permutation of every tier so switching between them doesn't compile
+        for (unsigned int i = 0; i < QualityTier::Tiers().size(); i++) {
+            const QualityTier& tier = QualityTier::Tiers()[i];
+            StartupProfiler::Scope scope = mStartupProfiler->Measure("compile " + tier.PermutationKey(tier.Shadows));
+            if (!UseQualityTier(i, tier.Shadows)) {
+                return false;
+            }
+        }
+
+        return UseQualityTier(currentTier, currentShadows);
+    }
+
+    /*
+        Switches to the program permutation of given tier, compiling it only
+        if it isn't in the program cache yet
+    */
+    bool UseQualityTier(unsigned int tierIndex, bool shadows)
+    {
+        const QualityTier& tier = QualityTier::Tiers()[tierIndex];
+        std::string key = mSceneKey + tier.PermutationKey(shadows);
+
+        std::shared_ptr<OpenGL::ShaderProgram> program = mProgramCache.Find(key);
+        if (!program) {
+            OpenGL::ShaderSource permutation = *mSceneShaderSource;
+            permutation.Substitute(sDefinesMarker, tier.ShaderDefines(shadows));
+
+            program = OpenGL::ShaderProgram::FromSources(mVShaderSource, std::make_shared<OpenGL::ShaderSource>(permutation));
+            if (!program) {
+                return false;
+            }
+            mProgramCompiles++;
+
+            program->Bind();
+            program->SetUniform2f("u_Resolution", static_cast<float>(mWidth), static_cast<float>(mHeight));
+            program->SetUniform3f("u_LightPos", mLightPos.x(), mLightPos.y(), mLightPos.z());
+            program->SetUniform1i("u_NoiseTex", 0);
+            program->SetUniform1f("u_Time", 0.0f);
+            if (mRegistrar.UsesGrid()) {
+                program->SetUniform1i("u_GridCells", sGridCellsTextureSlot);
+                program->SetUniform1i("u_GridObjects", sGridObjectsTextureSlot);
+            }
+
+            mProgramCache.Insert(key, program);
+        }
+
+        mShader = program;
+        mQualityTierIndex = tierIndex;
+        mEnableShadows = shadows;
+        return true;
+    }
 protected:
     virtual bool OnCreate() override
     {
+        // Codegen goes first, so it isn't queued behind the bakes the main thread waits for last
+        std::future<std::shared_ptr<OpenGL::ShaderSource>> sceneSource = mJobs->Submit([this]() {
+            StartupProfiler::Scope scope = mStartupProfiler->Measure("scene codegen");
+            return GenerateSceneSource();
+        });
+        std::vector<std::future<void>> bakes;
+        DistanceContext context = { mSmoothMin, 0.0f, mNoiseTexture.get() };
+        for (size_t i = 0; i < mBakedObjects.size(); i++) {
+            bakes.push_back(mJobs->Submit([this, i, context]() {
+                StartupProfiler::Scope scope = mStartupProfiler->Measure("prepare bake " + std::to_string(i));
+                mBakedObjects[i]->PrepareBake(context);
+            }));
+        }
+
+        StartupProfiler::Scope createScope = mStartupProfiler->Measure("OnCreate");
         std::array<float, 8> mVertices = {
             -1.0f, -1.0f,
              1.0f, -1.0f,
@@ -83,23 +855,47 @@ protected:
 
         mIbo = OpenGL::IndexBuffer(mIndices.data(), mIndices.size());
 
-        mRegistrar.RegisterObjects(mShapes, *mFShaderSource);
-        mRegistrar.GenerateSceneDistanceFunction(*mFShaderSource);
+        mGridCellsBuffer = OpenGL::TextureBuffer(GL_RG32I);
+        mGridObjectsBuffer = OpenGL::TextureBuffer(GL_R32I);
+
+        std::shared_ptr<OpenGL::ShaderProgram> reconstruct_ptr;
+        {
+            StartupProfiler::Scope scope = mStartupProfiler->Measure("compile reconstruct");
+            reconstruct_ptr = OpenGL::ShaderProgram::FromSources(mVShaderSource, mReconstructShaderSource);
+        }
+
+        mEnableShadows = QualityTier::Tiers()[mQualityTierIndex].Shadows;
+        {
+            StartupProfiler::Scope scope = mStartupProfiler->Measure("wait for scene codegen");
+            mSceneShaderSource = sceneSource.get();
+        }
+        bool built = CompileScene(mSceneShaderSource);
 
-        std::shared_ptr<OpenGL::ShaderProgram> shader_ptr = OpenGL::ShaderProgram::FromSources(mVShaderSource, mFShaderSource);
+        // Jobs refer to the objects, so they have to finish even if compiling failed
+        {
+            StartupProfiler::Scope scope = mStartupProfiler->Measure("wait for bakes");
+            for (std::future<void>& bake : bakes) {
+                bake.get();
+            }
+        }
 
-        if (!shader_ptr) {
+        if (!built || !reconstruct_ptr) {
             return false;
         }
 
-        mShader = *shader_ptr;
+        mReconstructShader = *reconstruct_ptr;
 
-        mShader.Bind();
         mNoiseTexture->Bind();
-        mShader.SetUniform2f("u_Resolution", static_cast<float>(mWidth), static_cast<float>(mHeight));
-        mShader.SetUniform3f("u_LightPos", mLightPos.x(), mLightPos.y(), mLightPos.z());
-        mShader.SetUniform1i("u_NoiseTex", 0);
-        mShader.SetUniform1f("u_Time", 0.0f);
+
+        mReconstructShader.Bind();
+        mReconstructShader.SetUniform1i("u_SampleTex", sSampleTextureSlot);
+        mReconstructShader.SetUniform1i("u_HistoryTex", sHistoryTextureSlot);
+
+        for (OpenGL::FrameBuffer& buffer : mHistoryBuffers) {
+            buffer = OpenGL::FrameBuffer(mWidth, mHeight);
+        }
+        mCheckerboardBuffer = OpenGL::FrameBuffer((mWidth + 1) / 2, mHeight);
+        mInterleavedBuffer = OpenGL::FrameBuffer((mWidth + 1) / 2, (mHeight + 1) / 2);
 
         mKeyHandlers = {
             {GLFW_KEY_D, [this](int action, int mods) {
@@ -133,6 +929,22 @@ protected:
         return true;
     }
 
+    /*
+        Waits until the first frame is finished and reports the startup
+        phases, later calls do nothing
+    */
+    void FinishStartup()
+    {
+        if (mStartupProfiler->FirstFrameMarked()) {
+            return;
+        }
+        GLCall(glFinish());
+        // OnCreate ends by setting the start time of the animation
+        mStartupProfiler->Record("first frame", mStartTime, std::chrono::steady_clock::now());
+        mStartupProfiler->MarkFirstFrame();
+        mStartupProfiler->Report(std::cout);
+    }
+
     virtual bool OnUpdate(FrameDuration elapsedTime) override
     {
         float elapsed = elapsedTime.count();
@@ -145,21 +957,209 @@ protected:
         direction = direction.RotateY(mCameraRotationY);
         mCameraPos = mCameraPos + direction;
 
-        mShader.Bind();
-        mShader.SetUniform3f("u_CameraPos", mCameraPos.x(), mCameraPos.y(), mCameraPos.z());
-        mShader.SetUniform1f("u_CameraRotY", mCameraRotationY);
-        mShader.SetUniformBool("u_EnableShadows", mEnableShadows);
-        mShader.SetUniform1f("u_SmoothMinValue", mSmoothMin);
-        mShader.SetUniform1f("u_Time", std::chrono::duration_cast<std::chrono::duration<float, std::ratio<1, 1>>>
+        DrawFrame(std::chrono::duration_cast<std::chrono::duration<float, std::ratio<1, 1>>>
             (std::chrono::steady_clock::now() - mStartTime).count());
+        mHistoryBuffers[mHistoryIndex].BlitToScreen(mWidth, mHeight);
+        FinishStartup();
+
+        return true;
+    }
+
+    /*
+        Marches the scene into target. Reduced targets of Checkerboard and
+        Interleaved modes receive only pixels scheduled for current frame
+    */
+    void MarchScene(const OpenGL::FrameBuffer& target, RenderMode mode, float time)
+    {
+        target.Bind();
+
+        UpdateObjectGrid();
+
+        DistanceContext context = { mSmoothMin, time, mNoiseTexture.get() };
+        for (const std::shared_ptr<IBakedObject>& object : mBakedObjects) {
+            object->UpdateBake(context);
+        }
+
+        // Creating framebuffers and textures rebinds unit 0, so the noise is bound again every frame
+        mNoiseTexture->Bind();
+        mShader->Bind();
+        // Programs of the cache may have been linked for another size, see Resize
+        mShader->SetUniform2f("u_Resolution", static_cast<float>(mTileFrameWidth > 0 ? mTileFrameWidth : mWidth),
+            static_cast<float>(mTileFrameHeight > 0 ? mTileFrameHeight : mHeight));
+        mShader->SetUniform2f("u_PixelOffset", static_cast<float>(mTileX), static_cast<float>(mTileY));
+        mShader->SetUniform3f("u_CameraPos", mCameraPos.x(), mCameraPos.y(), mCameraPos.z());
+        mShader->SetUniform1f("u_CameraRotY", mCameraRotationY);
+        mShader->SetUniform1f("u_SmoothMinValue", mSmoothMin);
+        mShader->SetUniform1f("u_Time", time);
+        mShader->SetUniform1i("u_InterleaveMode", static_cast<int>(mode));
+        mShader->SetUniform1i("u_FrameIndex", mFrameIndex);
+        mShader->SetUniformBool("u_AnalyticHits", mAnalyticHits && mRegistrar.AnalyticGridEntries() <= sMaxAnalyticGridEntries);
+        if (mode == RenderMode::Progressive) {
+            mShader->SetUniform1i("u_ProgressiveStep", static_cast<int>(mProgressiveStep));
+            // The coarser level is bound where the reconstruct pass takes its samples
+            mShader->SetUniform1i("u_CoarseTex", sSampleTextureSlot);
+            mShader->SetUniformBool("u_HasCoarse", mProgressiveHasCoarse);
+        } else if (mode == RenderMode::Supersample) {
+            // Edge strengths are bound where the reconstruct pass takes its samples
+            mShader->SetUniform1i("u_EdgeTex", sSampleTextureSlot);
+            mShader->SetUniform1i("u_EdgeThreshold", mEdgeThreshold);
+        }
+
+        if (mRegistrar.UsesGrid()) {
+            const ObjectGrid& grid = mObjectGrid;
+            mShader->SetUniform3f("u_GridMin", grid.Bounds().Min().x(), grid.Bounds().Min().y(), grid.Bounds().Min().z());
+            mShader->SetUniform3f("u_GridCellSize", grid.CellSize().x(), grid.CellSize().y(), grid.CellSize().z());
+            mShader->SetUniform3i("u_GridDims", grid.Dimensions()[0], grid.Dimensions()[1], grid.Dimensions()[2]);
+            mShader->SetUniform1f("u_GridMargin", mGridMargin);
+            mGridCellsBuffer.Bind(sGridCellsTextureSlot);
+            mGridObjectsBuffer.Bind(sGridObjectsTextureSlot);
+        }
 
         for (unsigned int i = 0; i < mShapes.size(); i++) {
-            mShapes[i]->PassToShader(mShader);
+            mShapes[i]->PassToShader(*mShader);
         }
 
-        mRenderer.Draw(mVao, mIbo, mShader);
+        mRenderer.Draw(mVao, mIbo, *mShader);
 
-        return true;
+        target.Unbind();
+    }
+
+    /*
+        Rebuilds and uploads the object grid when bounds of grid objects, the
+        set of instances or the smooth union radius changed since the last frame
+    */
+    void UpdateObjectGrid()
+    {
+        if (!mRegistrar.UsesGrid()) {
+            return;
+        }
+
+        std::vector<Math::AABB> bounds;
+        std::vector<int32_t> ids;
+        mRegistrar.GridEntries(bounds, ids);
+
+        // Margin must cover smooth union radius to keep the surface exact near cell faces,
+        // smooth union may grow objects by a quarter of it
+        float margin = sGridMargin + mSmoothMin;
+        for (Math::AABB& box : bounds) {
+            box = box.Expand(margin + mSmoothMin * 0.25f);
+        }
+
+        if (bounds == mGridBounds && ids == mGridIds && margin == mGridMargin) {
+            return;
+        }
+
+        mObjectGrid.Build(bounds, ids);
+        mGridCellsBuffer.Update(mObjectGrid.Cells().data(), mObjectGrid.Cells().size() * sizeof(int32_t));
+        mGridObjectsBuffer.Update(mObjectGrid.Objects().data(), mObjectGrid.Objects().size() * sizeof(int32_t));
+        mGridBounds = std::move(bounds);
+        mGridIds = std::move(ids);
+        mGridMargin = margin;
+    }
+
+    /*
+        Renders one frame of current mode into mHistoryBuffers[mHistoryIndex]
+    */
+    void DrawFrame(float time)
+    {
+        unsigned int previous = mHistoryIndex;
+        mHistoryIndex = (mHistoryIndex + 1) % mHistoryBuffers.size();
+
+        if (mRenderMode == RenderMode::Full && mAntialias.Mode != Antialiasing::Off) {
+            DrawAntialiased(time);
+        } else if (mRenderMode == RenderMode::Full) {
+            MarchScene(mHistoryBuffers[mHistoryIndex], mRenderMode, time);
+        } else {
+            const OpenGL::FrameBuffer& samples = (mRenderMode == RenderMode::Checkerboard) ? mCheckerboardBuffer : mInterleavedBuffer;
+            MarchScene(samples, mRenderMode, time);
+
+            mHistoryBuffers[mHistoryIndex].Bind();
+            samples.BindColorTexture(sSampleTextureSlot);
+            mHistoryBuffers[previous].BindColorTexture(sHistoryTextureSlot);
+            mReconstructShader.Bind();
+            mReconstructShader.SetUniform1i("u_InterleaveMode", static_cast<int>(mRenderMode));
+            mReconstructShader.SetUniform1i("u_FrameIndex", mFrameIndex);
+            mReconstructShader.SetUniformBool("u_HistoryValid", mHistoryValid);
+            mRenderer.Draw(mVao, mIbo, mReconstructShader);
+            mHistoryBuffers[mHistoryIndex].Unbind();
+        }
+
+        GLCall(glViewport(0, 0, mWidth, mHeight));
+        mHistoryValid = true;
+        mFrameIndex = (mFrameIndex + 1) % 4;
+    }
+
+    /*
+        Full mode frame into mHistoryBuffers[mHistoryIndex], antialiased.
+        Adaptive marches a first pass keeping hit distances and finds edge
+        strengths of its pixels, see Reconstruct.shader. Their histogram
+        gives the weakest strength whose pixels fit in MaxExtraRays, only
+        those are marched again by Supersample, the rest keep the first pass.
+        Only the red channel of the edges is read back, the cap holds for the
+        frame being drawn
+    */
+    void DrawAntialiased(float time)
+    {
+        const OpenGL::FrameBuffer& target = mHistoryBuffers[mHistoryIndex];
+        uint64_t pixelCount = static_cast<uint64_t>(mWidth) * mHeight;
+        mAntialiasStats = AntialiasStats();
+        if (mAntialias.Mode == Antialiasing::Uniform) {
+            mEdgeThreshold = -1;
+            MarchScene(target, RenderMode::Supersample, time);
+            mAntialiasStats.EdgePixels = static_cast<unsigned int>(pixelCount);
+            mAntialiasStats.SupersampledPixels = static_cast<unsigned int>(pixelCount);
+            mAntialiasStats.Rays = pixelCount * sSupersampleRays;
+            return;
+        }
+
+        if (mFirstPassBuffer.Width() != mWidth || mFirstPassBuffer.Height() != mHeight) {
+            mFirstPassBuffer.Delete();
+            mEdgeBuffer.Delete();
+            // Distances in alpha would be clamped by an RGBA8 target
+            mFirstPassBuffer = OpenGL::FrameBuffer(mWidth, mHeight, true);
+            mEdgeBuffer = OpenGL::FrameBuffer(mWidth, mHeight);
+        }
+        MarchScene(mFirstPassBuffer, RenderMode::FirstPass, time);
+
+        mEdgeBuffer.Bind();
+        mFirstPassBuffer.BindColorTexture(sSampleTextureSlot);
+        mReconstructShader.Bind();
+        mReconstructShader.SetUniform1i("u_InterleaveMode", static_cast<int>(RenderMode::FirstPass));
+        mRenderer.Draw(mVao, mIbo, mReconstructShader);
+        mEdgeBuffer.ReadRedPixels(mEdgeStrengths);
+        mEdgeBuffer.Unbind();
+
+        std::array<uint64_t, 256> histogram = {};
+        for (unsigned char strength : mEdgeStrengths) {
+            histogram[strength]++;
+        }
+        int threshold = std::clamp(static_cast<int>(std::ceil(mAntialias.EdgeThreshold * 255.0f)), 1, 256);
+        uint64_t edgePixels = 0;
+        for (int strength = threshold; strength < 256; strength++) {
+            edgePixels += histogram[strength];
+        }
+        // Raised past the weakest strengths until the rest fits the cap
+        uint64_t maxPixels = mAntialias.MaxExtraRays / sSupersampleRays;
+        uint64_t supersampled = edgePixels;
+        while (threshold < 256 && supersampled > maxPixels) {
+            supersampled -= histogram[threshold++];
+        }
+
+        // The first pass with opaque alpha, as a progressive level of step 1 is
+        target.Bind();
+        mReconstructShader.SetUniform1i("u_InterleaveMode", static_cast<int>(RenderMode::Progressive));
+        mReconstructShader.SetUniform1i("u_ProgressiveStep", 1);
+        mRenderer.Draw(mVao, mIbo, mReconstructShader);
+        target.Unbind();
+
+        if (supersampled > 0) {
+            mEdgeBuffer.BindColorTexture(sSampleTextureSlot);
+            mEdgeThreshold = threshold;
+            MarchScene(target, RenderMode::Supersample, time);
+        }
+        mAntialiasStats.EdgePixels = static_cast<unsigned int>(edgePixels);
+        mAntialiasStats.SupersampledPixels = static_cast<unsigned int>(supersampled);
+        mAntialiasStats.Rays = pixelCount + supersampled * sSupersampleRays;
     }
 
     virtual void OnImGuiUpdate()
@@ -172,8 +1172,54 @@ protected:
             }
             ImGui::SameLine();
         }
-        ImGui::Checkbox("Shadows", &mEnableShadows);
+        int qualityTier = static_cast<int>(mQualityTierIndex);
+        bool shadows = mEnableShadows;
+        if (ImGui::BeginCombo("Quality", QualityTier::Tiers()[mQualityTierIndex].Name.data())) {
+            for (unsigned int i = 0; i < QualityTier::Tiers().size(); i++) {
+                if (ImGui::Selectable(QualityTier::Tiers()[i].Name.data(), qualityTier == static_cast<int>(i))) {
+                    qualityTier = i;
+                    shadows = QualityTier::Tiers()[i].Shadows;
+                }
+            }
+            ImGui::EndCombo();
+        }
+        ImGui::Checkbox("Shadows", &shadows);
+        if (qualityTier != static_cast<int>(mQualityTierIndex) || shadows != mEnableShadows) {
+            UseQualityTier(qualityTier, shadows);
+        }
+        ImGui::Text("Cached programs: %u/%u", static_cast<unsigned int>(mProgramCache.Size()), static_cast<unsigned int>(mProgramCache.Capacity()));
+        if (mRegistrar.UsesGrid()) {
+            const std::array<int, 3>& dims = mObjectGrid.Dimensions();
+            ImGui::Text("Object grid: %u objects, %dx%dx%d cells", static_cast<unsigned int>(mGridIds.size()), dims[0], dims[1], dims[2]);
+        }
+        int renderMode = static_cast<int>(mRenderMode);
+        if (ImGui::Combo("Render mode", &renderMode, "Full\0Checkerboard\0Interleaved 2x2\0")) {
+            SetRenderMode(static_cast<RenderMode>(renderMode));
+        }
+        if (mRegistrar.AnalyticCount() > 0) {
+            ImGui::Checkbox("Analytic hits", &mAnalyticHits);
+            ImGui::SameLine();
+            ImGui::Text("%u objects, while smoothing is 0", static_cast<unsigned int>(mRegistrar.AnalyticCount()));
+        }
+        int antialiasing = static_cast<int>(mAntialias.Mode);
+        if (ImGui::Combo("Antialiasing", &antialiasing, "Off\0Adaptive\0Uniform 4x\0")) {
+            mAntialias.Mode = static_cast<Antialiasing>(antialiasing);
+        }
+        if (mAntialias.Mode == Antialiasing::Adaptive) {
+            ImGui::Text("Supersampled %u of %u edge pixels", mAntialiasStats.SupersampledPixels, mAntialiasStats.EdgePixels);
+        }
         ImGui::SliderFloat("Smooth %", &mSmoothMin, 0.0f, 1.0f);
+        ImGui::SliderInt("Mesh resolution", &mMeshResolution, 64, 1024);
+        ImGui::Checkbox("Dual contouring", &mMeshDualContouring);
+        ImGui::SameLine();
+        ImGui::Checkbox("Native CPU scene", &mNativeCpuScene);
+        if (ImGui::Button("Export mesh")) {
+            std::optional<MeshExporter::Stats> stats = ExportMesh(std::string(sMeshExportPath), mMeshResolution, mMeshDualContouring);
+            mMeshExportStatus = stats ? "Exported " + std::to_string(stats->TriangleCount) + " triangles in " +
+                std::to_string(static_cast<int>(stats->Milliseconds)) + " ms" : "Couldn't write " + std::string(sMeshExportPath);
+        }
+        ImGui::SameLine();
+        ImGui::Text("%s", mMeshExportStatus.c_str());
 
         if (mCurrentEditableIndex >= 0 && mCurrentEditableIndex < mEditableObjects.size()) {
             mEditableObjects[mCurrentEditableIndex]->RenderImGuiEditor();
@@ -192,24 +1238,90 @@ protected:
         }
         return;
     }
-private:
+protected:
     static constexpr double sPI = 3.14159265358979323846;
+    static constexpr unsigned int sProgressiveCoarsestStep = 8;
+    // Rays of a pixel of the Supersample pass, must match Fragment.shader
+    static constexpr unsigned int sSupersampleRays = 4;
+    static constexpr unsigned int sSampleTextureSlot = 1;
+    static constexpr unsigned int sHistoryTextureSlot = 2;
+    static constexpr unsigned int sGridCellsTextureSlot = 3;
+    static constexpr unsigned int sGridObjectsTextureSlot = 4;
+    // Above this many analytic objects in the grid marching it is cheaper than intersecting them all
+    static constexpr size_t sMaxAnalyticGridEntries = 64;
+    static constexpr float sGridMargin = 0.25f;
+    static constexpr unsigned int sDefaultQualityTier = 1;
+    static constexpr size_t sProgramCacheCapacity = 4;
+    static constexpr std::string_view sDefinesMarker = "/*<defines>*/";
+    static constexpr const char* sNoiseTexturePath = "res/textures/noise.bmp";
+
+    static Math::Vec4 DefaultLightPosition()
+    {
+        return { (float)std::sin(40) * 3, 50.0f + (float)std::cos(40) * 3, 6.0f, 1.0f };
+    }
+    static constexpr float sMeshExportSize = 32.0f;
+    static constexpr std::string_view sMeshExportPath = "export/scene.ply";
+    // Largest RMS plane distance of a simplified dual contouring vertex, in cells
+    static constexpr float sDualContouringError = 0.05f;
+    static constexpr float sTurntableRadius = 6.0f;
 
     OpenGL::VertexArray mVao;
     OpenGL::VertexBuffer mVbo;
     OpenGL::IndexBuffer mIbo;
-    OpenGL::ShaderProgram mShader;
+    std::shared_ptr<OpenGL::ShaderProgram> mShader;
+    OpenGL::ShaderProgramCache mProgramCache = OpenGL::ShaderProgramCache(sProgramCacheCapacity);
+    // Prefix of program cache keys, see UseScene
+    std::string mSceneKey;
+    uint64_t mProgramCompiles = 0;
+    OpenGL::ShaderProgram mReconstructShader;
 
     std::shared_ptr<OpenGL::ShaderSource> mVShaderSource;
     std::shared_ptr<OpenGL::ShaderSource> mFShaderSource;
+    // Fragment shader before any shape type is registered
+    std::shared_ptr<OpenGL::ShaderSource> mFShaderTemplate;
+    std::shared_ptr<OpenGL::ShaderSource> mSceneShaderSource;
+    std::shared_ptr<OpenGL::ShaderSource> mReconstructShaderSource;
     std::shared_ptr<OpenGL::Texture> mNoiseTexture;
 
+    std::array<OpenGL::FrameBuffer, 2> mHistoryBuffers;
+    OpenGL::FrameBuffer mCheckerboardBuffer;
+    OpenGL::FrameBuffer mInterleavedBuffer;
+    unsigned int mHistoryIndex = 0;
+    int mFrameIndex = 0;
+    bool mHistoryValid = false;
+    RenderMode mRenderMode = RenderMode::Full;
+    // Frame the framebuffers are a tile of, see SetTile
+    unsigned int mTileFrameWidth = 0;
+    unsigned int mTileFrameHeight = 0;
+    unsigned int mTileX = 0;
+    unsigned int mTileY = 0;
+    // Level MarchScene renders in Progressive mode, see RenderProgressive
+    unsigned int mProgressiveStep = 1;
+    bool mProgressiveHasCoarse = false;
+    AntialiasSettings mAntialias;
+    AntialiasStats mAntialiasStats;
+    // First pass with hit distances and edge strengths of adaptive antialiasing, see DrawAntialiased
+    OpenGL::FrameBuffer mFirstPassBuffer;
+    OpenGL::FrameBuffer mEdgeBuffer;
+    std::vector<unsigned char> mEdgeStrengths;
+    // Weakest edge strength MarchScene supersamples in Supersample mode, negative for every pixel
+    int mEdgeThreshold = -1;
+    bool mAnalyticHits = true;
+
+    OpenGL::TextureBuffer mGridCellsBuffer;
+    OpenGL::TextureBuffer mGridObjectsBuffer;
+    ObjectGrid mObjectGrid;
+    std::vector<Math::AABB> mGridBounds;
+    std::vector<int32_t> mGridIds;
+    float mGridMargin = sGridMargin;
+
     std::unordered_map<int, std::function<void(int, int)>> mKeyHandlers;
 
     std::vector<std::shared_ptr<IShapedObject>> mShapes;
     std::vector<std::shared_ptr<IImGuiEditable>> mEditableObjects;
+    std::vector<std::shared_ptr<IBakedObject>> mBakedObjects;
 
-    Math::Vec4 mLightPos = { (float)std::sin(40) * 3, 50.0f + (float)std::cos(40) * 3, 6.0f, 1.0f };
+    Math::Vec4 mLightPos = DefaultLightPosition();
 
     Math::Vec3 mCameraPos = { 0.0f, 1.0f, 0.0f, 1.0f };
     Math::Vec3 mCameraDir = { 0.0f, 0.0f, 0.0f, 1.0f };
@@ -219,10 +1331,19 @@ private:
     float mMoveVelocity = 7.5f;
 
     int mCurrentEditableIndex = -1;
+    unsigned int mQualityTierIndex = sDefaultQualityTier;
     bool mEnableShadows = false;
     float mSmoothMin = 0.0f;
+    int mMeshResolution = 256;
+    bool mMeshDualContouring = false;
+    std::string mMeshExportStatus;
+    bool mNativeCpuScene = false;
+    std::shared_ptr<CompiledShapeWrapper> mCompiledScene;
 
     ShapeRegistrar mRegistrar;
 
     std::chrono::steady_clock::time_point mStartTime;
+
+    std::unique_ptr<StartupProfiler> mStartupProfiler;
+    std::unique_ptr<JobSystem> mJobs;
 };
\ No newline at end of file
@@ -0,0 +1,778 @@
+#include "RenderServer.h"
+#include "RayMarchingWindow.h"
+#include "ImageWriter.h"
+#include "QualityTier.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <tuple>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace {
+
+#ifdef _WIN32
+    void CloseSocket(uintptr_t socket)
+    {
+        closesocket(static_cast<SOCKET>(socket));
+    }
+
+    // Ends blocking reads of another thread, answers can still be sent
+    void StopReceiving(uintptr_t socket)
+    {
+        shutdown(static_cast<SOCKET>(socket), SD_RECEIVE);
+    }
+
+    int PollReadable(uintptr_t socket, int timeoutMilliseconds)
+    {
+        WSAPOLLFD descriptor = { static_cast<SOCKET>(socket), POLLRDNORM, 0 };
+        return WSAPoll(&descriptor, 1, timeoutMilliseconds);
+    }
+#else
+    void CloseSocket(int socket)
+    {
+        close(socket);
+    }
+
+    // Ends blocking reads of another thread, answers can still be sent
+    void StopReceiving(int socket)
+    {
+        shutdown(socket, SHUT_RD);
+    }
+
+    int PollReadable(int socket, int timeoutMilliseconds)
+    {
+        pollfd descriptor = { socket, POLLIN, 0 };
+        return poll(&descriptor, 1, timeoutMilliseconds);
+    }
+#endif
+
+    template <typename Socket>
+    bool SendAll(Socket socket, const void* data, size_t size)
+    {
+        const char* bytes = static_cast<const char*>(data);
+        size_t sent = 0;
+        while (sent < size) {
+#ifdef _WIN32
+            int count = send(static_cast<SOCKET>(socket), bytes + sent, static_cast<int>(std::min<size_t>(size - sent, 1 << 30)), 0);
+#elif defined(MSG_NOSIGNAL)
+            ssize_t count = send(socket, bytes + sent, size - sent, MSG_NOSIGNAL);
+#else
+            ssize_t count = send(socket, bytes + sent, size - sent, 0);
+#endif
+            if (count <= 0) {
+#ifndef _WIN32
+                if (count < 0 && errno == EINTR) {
+                    continue;
+                }
+#endif
+                return false;
+            }
+            sent += static_cast<size_t>(count);
+        }
+        return true;
+    }
+
+    /*
+        Port of "tcp:<port>" addresses, nullopt unless the text after the
+        prefix is only digits of a port from 1 to 65535
+    */
+    std::optional<uint16_t> ParsePort(const std::string& text)
+    {
+        if (text.empty() || text.size() > 5 || text.find_first_not_of("0123456789") != std::string::npos) {
+            return std::nullopt;
+        }
+        unsigned long port = std::strtoul(text.c_str(), nullptr, 10);
+        if (port == 0 || port > 65535) {
+            return std::nullopt;
+        }
+        return static_cast<uint16_t>(port);
+    }
+
+    // How often the acceptor looks whether the server stops
+    constexpr int sAcceptPollMilliseconds = 100;
+
+    /*
+        FNV-1a of the scene data, without the size and time of the text it
+        was made from, so equal scenes of different files share programs
+    */
+    std::string SceneKey(const SceneFile& scene)
+    {
+        const size_t skipped = offsetof(SceneFile::Header, Settings);
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t i = skipped; i < scene.SizeInBytes(); i++) {
+            hash = (hash ^ scene.Data()[i]) * 1099511628211ull;
+        }
+        char key[20];
+        std::snprintf(key, sizeof(key), "%016llx/", static_cast<unsigned long long>(hash));
+        return key;
+    }
+
+    double Since(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+}
+
+RenderServer::Connection::~Connection()
+{
+    if (Handle != sInvalidSocket) {
+        CloseSocket(Handle);
+    }
+}
+
+bool RenderServer::Connection::Send(const std::string& head, const std::vector<uint8_t>& body /* = {} */)
+{
+    std::lock_guard<std::mutex> lock(WriteMutex);
+    return SendAll(Handle, head.data(), head.size()) && SendAll(Handle, body.data(), body.size());
+}
+
+RenderServer::RenderServer(const Settings& settings) : mSettings(settings), mStart(std::chrono::steady_clock::now())
+{
+#ifdef _WIN32
+    WSADATA data;
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+        std::cerr << "[Error] RenderServer: can't initialize sockets\n";
+        return;
+    }
+    mSocketsStarted = true;
+#endif
+
+    const std::string tcpPrefix = "tcp:";
+    if (settings.Address.compare(0, tcpPrefix.size(), tcpPrefix) == 0) {
+        std::optional<uint16_t> port = ParsePort(settings.Address.substr(tcpPrefix.size()));
+        if (!port) {
+            std::cerr << "[Error] RenderServer: '" << settings.Address << "' isn't a valid address, the port goes from 1 to 65535\n";
+            return;
+        }
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(*port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        mListener = static_cast<Socket>(socket(AF_INET, SOCK_STREAM, 0));
+        if (mListener != sInvalidSocket) {
+            int reuse = 1;
+            setsockopt(mListener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+            if (bind(mListener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+                CloseSocket(mListener);
+                mListener = sInvalidSocket;
+            }
+        }
+    } else {
+#ifdef _WIN32
+        std::cerr << "[Error] RenderServer: Unix domain sockets aren't supported here, use tcp:<port>\n";
+        return;
+#else
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        if (settings.Address.empty() || settings.Address.size() >= sizeof(address.sun_path)) {
+            std::cerr << "[Error] RenderServer: '" << settings.Address << "' isn't a valid socket path\n";
+            return;
+        }
+        std::memcpy(address.sun_path, settings.Address.c_str(), settings.Address.size() + 1);
+        // A socket file left by a server that didn't exit cleanly would make bind fail
+        unlink(settings.Address.c_str());
+        mListener = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (mListener != sInvalidSocket && bind(mListener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+            CloseSocket(mListener);
+            mListener = sInvalidSocket;
+        }
+        mSocketPath = settings.Address;
+#endif
+    }
+
+    if (mListener == sInvalidSocket || listen(mListener, SOMAXCONN) != 0) {
+        std::cerr << "[Error] RenderServer: can't listen on '" << settings.Address << "'\n";
+        if (mListener != sInvalidSocket) {
+            CloseSocket(mListener);
+            mListener = sInvalidSocket;
+        }
+        return;
+    }
+    mLatencies.reserve(sLatencyWindow);
+    mAcceptor = std::thread(&RenderServer::Accept, this);
+}
+
+RenderServer::~RenderServer()
+{
+    mStopping = true;
+    Shutdown();
+    if (mAcceptor.joinable()) {
+        mAcceptor.join();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mConnectionsMutex);
+        for (const std::shared_ptr<Connection>& connection : mConnections) {
+            StopReceiving(connection->Handle);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mRequestTaken.notify_all();
+    }
+    for (const std::shared_ptr<Connection>& connection : mConnections) {
+        connection->Reader.join();
+    }
+
+    if (mListener != sInvalidSocket) {
+        CloseSocket(mListener);
+        if (!mSocketPath.empty()) {
+            std::remove(mSocketPath.c_str());
+        }
+    }
+#ifdef _WIN32
+    if (mSocketsStarted) {
+        WSACleanup();
+    }
+#endif
+}
+
+void RenderServer::Shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mShuttingDown = true;
+    }
+    mRequestQueued.notify_all();
+}
+
+void RenderServer::Accept()
+{
+    while (!mStopping) {
+        if (PollReadable(mListener, sAcceptPollMilliseconds) <= 0) {
+            continue;
+        }
+        Socket handle = static_cast<Socket>(accept(mListener, nullptr, nullptr));
+        if (handle == sInvalidSocket) {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(mConnectionsMutex);
+        // Readers of closed connections are joined here, their sockets close with their last answer
+        for (auto iter = mConnections.begin(); iter != mConnections.end();) {
+            if ((*iter)->Finished) {
+                (*iter)->Reader.join();
+                iter = mConnections.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+        std::shared_ptr<Connection> connection = std::make_shared<Connection>();
+        connection->Handle = handle;
+        connection->Reader = std::thread(&RenderServer::Read, this, connection);
+        mConnections.push_back(connection);
+    }
+}
+
+void RenderServer::Read(std::shared_ptr<Connection> connection)
+{
+    std::string buffer;
+    char chunk[4096];
+    uint64_t number = 0;
+    bool reading = true;
+    while (reading && !mStopping) {
+        int count = static_cast<int>(recv(connection->Handle, chunk, sizeof(chunk), 0));
+        if (count <= 0) {
+            break;
+        }
+        buffer.append(chunk, static_cast<size_t>(count));
+
+        size_t lineStart = 0;
+        for (size_t lineEnd = buffer.find('\n'); reading && lineEnd != std::string::npos; lineEnd = buffer.find('\n', lineStart)) {
+            std::string line = buffer.substr(lineStart, lineEnd - lineStart);
+            lineStart = lineEnd + 1;
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (line.empty()) {
+                continue;
+            }
+
+            if (line == "stats") {
+                std::ostringstream text;
+                Report(text);
+                reading = connection->Send("stats " + std::to_string(text.str().size()) + "\n" + text.str());
+                continue;
+            }
+            if (line == "shutdown") {
+                Shutdown();
+                continue;
+            }
+
+            Request request;
+            request.Client = connection;
+            request.Number = number++;
+            request.Received = std::chrono::steady_clock::now();
+            std::string error;
+            if (!Parse(line, request, error)) {
+                Fail(request, error);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(mMutex);
+            // A full queue stops reading, so the client waits instead of the queue growing
+            mRequestTaken.wait(lock, [this]() { return mQueue.size() < mSettings.QueueCapacity || mStopping; });
+            if (mStopping) {
+                reading = false;
+                break;
+            }
+            mQueue.push_back(std::move(request));
+            mStats.MaxQueued = std::max(mStats.MaxQueued, mQueue.size());
+            lock.unlock();
+            mRequestQueued.notify_one();
+        }
+        buffer.erase(0, lineStart);
+        if (buffer.size() > sMaxLineLength) {
+            connection->Send("error " + std::to_string(number) + " request line too long\n");
+            break;
+        }
+    }
+    connection->Finished = true;
+}
+
+bool RenderServer::Parse(const std::string& line, Request& request, std::string& error) const
+{
+    std::istringstream in(line);
+    std::string command;
+    float x = 0.0f, y = 0.0f, z = 0.0f;
+    in >> command >> request.Scene >> request.Width >> request.Height >> request.Time >> x >> y >> z >> request.RotationY;
+    if (command != "render") {
+        error = "unknown command '" + command + "'";
+        return false;
+    }
+    if (!in) {
+        error = "expected render <scene> <width> <height> <time> <x> <y> <z> <rotation y> [tier] [png|rgba] [tile <x> <y> <width> <height>]";
+        return false;
+    }
+    request.Camera = Math::Vec3(x, y, z);
+
+    std::string word;
+    while (in >> word) {
+        if (word == "png") {
+            request.Format = Encoding::Png;
+        } else if (word == "rgba") {
+            request.Format = Encoding::Rgba;
+        } else if (word.size() == 1 && word[0] >= '0' && word[0] < '0' + static_cast<int>(QualityTier::Tiers().size())) {
+            request.Tier = word[0] - '0';
+        } else if (word == "tile") {
+            request.FrameWidth = request.Width;
+            request.FrameHeight = request.Height;
+            if (!(in >> request.TileX >> request.TileY >> request.Width >> request.Height)) {
+                error = "expected tile <x> <y> <width> <height>";
+                return false;
+            }
+        } else {
+            error = "unexpected '" + word + "'";
+            return false;
+        }
+    }
+    if (request.Width == 0 || request.Height == 0 || request.Width > mSettings.MaxResolution || request.Height > mSettings.MaxResolution) {
+        error = "resolution must be from 1 to " + std::to_string(mSettings.MaxResolution);
+        return false;
+    }
+    if (request.FrameWidth > 0 && (request.TileX + static_cast<uint64_t>(request.Width) > request.FrameWidth ||
+        request.TileY + static_cast<uint64_t>(request.Height) > request.FrameHeight)) {
+        error = "tile is outside of the frame";
+        return false;
+    }
+    return true;
+}
+
+bool RenderServer::NextBatch(std::vector<Request>& batch)
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mRequestQueued.wait(lock, [this]() { return !mQueue.empty() || mShuttingDown; });
+    if (mQueue.empty()) {
+        return false;
+    }
+    size_t count = std::min(mQueue.size(), std::max<size_t>(mSettings.MaxBatch, 1));
+    batch.assign(std::make_move_iterator(mQueue.begin()), std::make_move_iterator(mQueue.begin() + count));
+    mQueue.erase(mQueue.begin(), mQueue.begin() + count);
+    mStats.Batches++;
+    lock.unlock();
+    mRequestTaken.notify_all();
+    return true;
+}
+
+void RenderServer::Run(RayMarchingWindow& window)
+{
+    window.SetProgramCacheCapacity(mSettings.ProgramCapacity);
+    window.SetRenderMode(RayMarchingWindow::RenderMode::Full);
+    if (!window.CreateOffscreen()) {
+        std::cerr << "[Error] RenderServer: the window's scene doesn't build\n";
+        return;
+    }
+
+    std::vector<Request> batch;
+    while (NextBatch(batch)) {
+        // Requests sharing a program render one after another, in arrival order otherwise
+        auto compatible = [](const Request& a, const Request& b) {
+            return std::tie(a.Scene, a.Width, a.Height, a.Tier) < std::tie(b.Scene, b.Width, b.Height, b.Tier);
+        };
+        std::stable_sort(batch.begin(), batch.end(), compatible);
+        for (auto begin = batch.begin(); begin != batch.end();) {
+            auto end = std::find_if(begin, batch.end(), [&](const Request& request) { return compatible(*begin, request); });
+            RenderGroup(window, begin, end);
+            begin = end;
+        }
+        mAnswers.erase(std::remove_if(mAnswers.begin(), mAnswers.end(), [](const std::future<void>& answer) {
+            return answer.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        }), mAnswers.end());
+    }
+    // Stats are complete once Run returns
+    for (std::future<void>& answer : mAnswers) {
+        answer.get();
+    }
+    mAnswers.clear();
+}
+
+void RenderServer::RenderGroup(RayMarchingWindow& window, std::vector<Request>::iterator begin, std::vector<Request>::iterator end)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::string log;
+    ServedScene* scene = FindScene(begin->Scene, log);
+    if (!scene) {
+        for (auto request = begin; request != end; ++request) {
+            Fail(*request, "scene '" + request->Scene + "' can't be loaded: " + log);
+        }
+        return;
+    }
+    if (scene != mCurrentScene) {
+        window.ClearScene();
+        scene->File.Apply(window, scene->Objects);
+        mCurrentScene = scene;
+    }
+
+    unsigned int tier = begin->Tier >= 0 ? static_cast<unsigned int>(begin->Tier) : window.QualityTierIndex();
+    uint64_t compiles = window.ProgramCompiles();
+    window.Resize(begin->Width, begin->Height);
+    if (!window.UseScene(scene->Key, tier, QualityTier::Tiers()[tier].Shadows)) {
+        for (auto request = begin; request != end; ++request) {
+            Fail(*request, "scene '" + request->Scene + "' doesn't compile");
+        }
+        return;
+    }
+
+    OpenGL::PixelReadback readback(begin->Width, begin->Height, [&](const unsigned char* pixels, uint64_t index) {
+        Answer(begin[static_cast<ptrdiff_t>(index)], pixels);
+    });
+    for (auto request = begin; request != end; ++request) {
+        // Tiles are given from the top left, rendered from the bottom left
+        if (request->FrameWidth > 0) {
+            window.SetTile(request->FrameWidth, request->FrameHeight, request->TileX, request->FrameHeight - request->TileY - request->Height);
+        } else {
+            window.SetTile(0, 0, 0, 0);
+        }
+        window.SetCamera(request->Camera, request->RotationY);
+        window.ReadFrame(request->Time, readback, static_cast<uint64_t>(request - begin));
+    }
+    readback.Flush();
+    readback.Delete();
+    window.SetTile(0, 0, 0, 0);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStats.Groups++;
+    mStats.ProgramCompiles += window.ProgramCompiles() - compiles;
+    mStats.ProgramHits += window.ProgramCompiles() == compiles ? 1 : 0;
+    mStats.RenderMilliseconds += Since(start);
+}
+
+RenderServer::ServedScene* RenderServer::FindScene(const std::string& path, std::string& log)
+{
+    std::error_code error;
+    uint64_t size = std::filesystem::file_size(path, error);
+    if (error) {
+        log = error.message();
+        return nullptr;
+    }
+    int64_t time = static_cast<int64_t>(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+
+    for (auto iter = mScenes.begin(); iter != mScenes.end(); ++iter) {
+        if (iter->Path != path) {
+            continue;
+        }
+        if (iter->SourceSize == size && iter->SourceTime == time) {
+            mScenes.splice(mScenes.begin(), mScenes, iter);
+            return &mScenes.front();
+        }
+        // Changed since it was loaded, its objects may still be registered with the window
+        if (&*iter == mCurrentScene) {
+            continue;
+        }
+        mScenes.erase(iter);
+        break;
+    }
+
+    std::optional<SceneFile> file = SceneFile::Load(path, "", &log);
+    std::optional<SceneFile::Objects> objects = file ? file->Instantiate(RayMarchingWindow::sFirstObjectTextureSlot, &log) : std::nullopt;
+    if (!objects) {
+        return nullptr;
+    }
+    std::string key = SceneKey(*file);
+    mScenes.push_front(ServedScene{ path, key, size, time, std::move(*file), std::move(*objects) });
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStats.SceneLoads++;
+    }
+
+    // Least recently used scenes go first, never the one registered with the window
+    for (auto iter = mScenes.end(); mScenes.size() > std::max<size_t>(mSettings.SceneCapacity, 1) && iter != mScenes.begin();) {
+        --iter;
+        if (&*iter != mCurrentScene && iter != mScenes.begin()) {
+            iter = mScenes.erase(iter);
+        }
+    }
+    return &mScenes.front();
+}
+
+void RenderServer::Answer(const Request& request, const unsigned char* pixels)
+{
+    // A client that stops reading blocks its answers, rendering waits for the oldest instead of queuing more
+    mAnswers.erase(std::remove_if(mAnswers.begin(), mAnswers.end(), [](const std::future<void>& answer) {
+        return answer.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }), mAnswers.end());
+    while (mAnswers.size() >= std::max<size_t>(mSettings.QueueCapacity, 1)) {
+        mAnswers.front().get();
+        mAnswers.erase(mAnswers.begin());
+    }
+    std::vector<uint8_t> image(pixels, pixels + static_cast<size_t>(request.Width) * request.Height * 4);
+    mAnswers.push_back(mJobs.Submit([this, request, image = std::move(image)]() {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::vector<uint8_t> data;
+        if (request.Format == Encoding::Png) {
+            data = ImageWriter::EncodePng(request.Width, request.Height, image.data());
+        } else {
+            // Rows of readbacks go bottom to top
+            const size_t rowSize = static_cast<size_t>(request.Width) * 4;
+            data.resize(image.size());
+            for (unsigned int y = 0; y < request.Height; y++) {
+                std::memcpy(data.data() + y * rowSize, image.data() + (request.Height - 1 - y) * rowSize, rowSize);
+            }
+        }
+        double encodeMilliseconds = Since(start);
+
+        char head[96];
+        std::snprintf(head, sizeof(head), "ok %llu %zu %.3f\n", static_cast<unsigned long long>(request.Number), data.size(),
+            Since(request.Received));
+        bool sent = request.Client->Send(head, data);
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStats.EncodeMilliseconds += encodeMilliseconds;
+        if (sent) {
+            mStats.Requests++;
+        } else {
+            mStats.Failures++;
+        }
+        RecordLatency(request.Received);
+    }));
+}
+
+void RenderServer::Fail(const Request& request, const std::string& message)
+{
+    request.Client->Send("error " + std::to_string(request.Number) + " " + message + "\n");
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStats.Failures++;
+}
+
+void RenderServer::RecordLatency(std::chrono::steady_clock::time_point received)
+{
+    double latency = Since(received);
+    if (mLatencies.size() < sLatencyWindow) {
+        mLatencies.push_back(latency);
+    } else {
+        mLatencies[mNextLatency] = latency;
+    }
+    mNextLatency = (mNextLatency + 1) % sLatencyWindow;
+}
+
+RenderServer::Stats RenderServer::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    Stats stats = mStats;
+    stats.Seconds = Since(mStart) / 1000.0;
+    if (!mLatencies.empty()) {
+        std::vector<double> latencies = mLatencies;
+        std::sort(latencies.begin(), latencies.end());
+        stats.LatencyMedianMilliseconds = latencies[latencies.size() / 2];
+        stats.LatencyP95Milliseconds = latencies[std::min(latencies.size() - 1, latencies.size() * 95 / 100)];
+        stats.LatencyMaxMilliseconds = latencies.back();
+    }
+    return stats;
+}
+
+void RenderServer::Report(std::ostream& out) const
+{
+    Stats stats = GetStats();
+    char text[512];
+    std::snprintf(text, sizeof(text),
+        "requests %llu, failures %llu, %.2f requests/s over %.1f s\n"
+        "latency median %.2f ms, p95 %.2f ms, max %.2f ms\n"
+        "batches %llu, groups %llu, at most %zu queued\n"
+        "scenes loaded %llu, programs compiled %llu, groups on cached programs %llu\n"
+        "render %.1f ms, encode %.1f ms\n",
+        static_cast<unsigned long long>(stats.Requests), static_cast<unsigned long long>(stats.Failures), stats.RequestsPerSecond(),
+        stats.Seconds, stats.LatencyMedianMilliseconds, stats.LatencyP95Milliseconds, stats.LatencyMaxMilliseconds,
+        static_cast<unsigned long long>(stats.Batches), static_cast<unsigned long long>(stats.Groups), stats.MaxQueued,
+        static_cast<unsigned long long>(stats.SceneLoads), static_cast<unsigned long long>(stats.ProgramCompiles),
+        static_cast<unsigned long long>(stats.ProgramHits), stats.RenderMilliseconds, stats.EncodeMilliseconds);
+    out << text;
+}
+
+RenderClient::RenderClient(const std::string& address)
+{
+#ifdef _WIN32
+    WSADATA data;
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+        return;
+    }
+    mSocketsStarted = true;
+#endif
+    const std::string tcpPrefix = "tcp:";
+    if (address.compare(0, tcpPrefix.size(), tcpPrefix) == 0) {
+        std::optional<uint16_t> port = ParsePort(address.substr(tcpPrefix.size()));
+        if (!port) {
+            std::cerr << "[Error] RenderClient: '" << address << "' isn't a valid address, the port goes from 1 to 65535\n";
+            return;
+        }
+        sockaddr_in tcpAddress = {};
+        tcpAddress.sin_family = AF_INET;
+        tcpAddress.sin_port = htons(*port);
+        tcpAddress.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        mSocket = static_cast<RenderServer::Socket>(socket(AF_INET, SOCK_STREAM, 0));
+        if (IsConnected() && connect(mSocket, reinterpret_cast<const sockaddr*>(&tcpAddress), sizeof(tcpAddress)) != 0) {
+            CloseSocket(mSocket);
+            mSocket = RenderServer::sInvalidSocket;
+        }
+        return;
+    }
+#ifndef _WIN32
+    sockaddr_un unixAddress = {};
+    unixAddress.sun_family = AF_UNIX;
+    if (address.size() >= sizeof(unixAddress.sun_path)) {
+        return;
+    }
+    std::memcpy(unixAddress.sun_path, address.c_str(), address.size() + 1);
+    mSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (IsConnected() && connect(mSocket, reinterpret_cast<const sockaddr*>(&unixAddress), sizeof(unixAddress)) != 0) {
+        CloseSocket(mSocket);
+        mSocket = RenderServer::sInvalidSocket;
+    }
+#endif
+}
+
+RenderClient::~RenderClient()
+{
+    if (IsConnected()) {
+        CloseSocket(mSocket);
+    }
+#ifdef _WIN32
+    if (mSocketsStarted) {
+        WSACleanup();
+    }
+#endif
+}
+
+bool RenderClient::IsConnected() const
+{
+    return mSocket != RenderServer::sInvalidSocket;
+}
+
+bool RenderClient::Send(const std::string& line)
+{
+    return IsConnected() && SendAll(mSocket, (line + "\n").data(), line.size() + 1);
+}
+
+void RenderClient::Disconnect()
+{
+    if (!IsConnected()) {
+        return;
+    }
+#ifdef _WIN32
+    shutdown(static_cast<SOCKET>(mSocket), SD_BOTH);
+#else
+    shutdown(mSocket, SHUT_RDWR);
+#endif
+}
+
+std::optional<RenderClient::Answer> RenderClient::Receive()
+{
+    std::string line;
+    if (!ReadLine(line)) {
+        return std::nullopt;
+    }
+    std::istringstream in(line);
+    std::string status;
+    Answer answer;
+    in >> status;
+    if (status == "stats") {
+        size_t size = 0;
+        in >> size;
+        answer.Ok = ReadBytes(size, answer.Data);
+        return answer;
+    }
+    in >> answer.Number;
+    if (status == "ok") {
+        size_t size = 0;
+        in >> size >> answer.Milliseconds;
+        if (!ReadBytes(size, answer.Data)) {
+            return std::nullopt;
+        }
+        answer.Ok = true;
+        return answer;
+    }
+    std::getline(in >> std::ws, answer.Message);
+    return answer;
+}
+
+bool RenderClient::ReadLine(std::string& line)
+{
+    for (size_t end = mBuffer.find('\n'); end == std::string::npos; end = mBuffer.find('\n')) {
+        char chunk[4096];
+        int count = IsConnected() ? static_cast<int>(recv(mSocket, chunk, sizeof(chunk), 0)) : 0;
+        if (count <= 0) {
+            return false;
+        }
+        mBuffer.append(chunk, static_cast<size_t>(count));
+    }
+    size_t end = mBuffer.find('\n');
+    line = mBuffer.substr(0, end);
+    mBuffer.erase(0, end + 1);
+    return true;
+}
+
+bool RenderClient::ReadBytes(size_t size, std::vector<uint8_t>& out)
+{
+    out.assign(mBuffer.begin(), mBuffer.begin() + std::min(size, mBuffer.size()));
+    mBuffer.erase(0, out.size());
+    while (out.size() < size) {
+        char chunk[65536];
+        int count = static_cast<int>(recv(mSocket, chunk, static_cast<int>(std::min(sizeof(chunk), size - out.size())), 0));
+        if (count <= 0) {
+            return false;
+        }
+        out.insert(out.end(), chunk, chunk + count);
+    }
+    return true;
+}
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "JobSystem.h"
+#include "SceneFile.h"
+#include "Math/Math.h"
+
+class RayMarchingWindow;
+
+/*
+    Serves render requests of other processes from one warm OpenGL context,
+    so programs compiled for a scene are reused by every later request of
+    it. Listens on a Unix domain socket or on localhost TCP. A request is
+    one line
+
+        render <scene file> <width> <height> <time> <x> <y> <z> <rotation y> [tier] [png|rgba] [tile <x> <y> <width> <height>]
+
+    answered by "ok <n> <bytes> <milliseconds>" and a line break followed
+    by the image, or by "error <n> <message>". n counts the requests of a
+    connection from 0, pipelined requests may be answered out of order.
+    Rgba images are raw top to bottom rows. A tile request is answered by
+    only that region of the frame, x and y from its top left corner.
+    "stats" is answered by "stats <bytes>" and the metrics as text,
+    "shutdown" stops Run once every queued request is answered.
+
+    Connections have reader threads filling one queue. Run takes batches
+    of queued requests on the thread owning the context and renders the
+    requests of one scene, size and tier one after another on the same
+    program, reading frames back through a PixelReadback. Images are
+    encoded and sent by jobs while the next ones render
+*/
+class RenderServer {
+public:
+    enum class Encoding {
+        Png,
+        Rgba
+    };
+
+    struct Settings {
+        // "tcp:<port>" listens on 127.0.0.1, anything else is a socket path
+        std::string Address;
+        // Requests taken from the queue at once and reordered by scene, size and tier
+        size_t MaxBatch = 16;
+        // Readers stop reading when this many requests wait, rendering when this many answers are being sent
+        size_t QueueCapacity = 64;
+        // Loaded scenes whose objects are kept, and programs compiled for them
+        size_t SceneCapacity = 8;
+        size_t ProgramCapacity = 16;
+        unsigned int MaxResolution = 4096;
+    };
+
+    struct Stats {
+        uint64_t Requests = 0;
+        uint64_t Failures = 0;
+        uint64_t Batches = 0;
+        // Runs of requests rendered with the same scene, size and tier
+        uint64_t Groups = 0;
+        uint64_t SceneLoads = 0;
+        uint64_t ProgramCompiles = 0;
+        uint64_t ProgramHits = 0;
+        size_t MaxQueued = 0;
+        double RenderMilliseconds = 0.0;
+        double EncodeMilliseconds = 0.0;
+        // From reading a request to sending its answer, over the last sLatencyWindow requests
+        double LatencyMedianMilliseconds = 0.0;
+        double LatencyP95Milliseconds = 0.0;
+        double LatencyMaxMilliseconds = 0.0;
+        double Seconds = 0.0;
+
+        double RequestsPerSecond() const
+        {
+            return Seconds > 0.0 ? Requests / Seconds : 0.0;
+        }
+    };
+public:
+    explicit RenderServer(const Settings& settings);
+    /*
+        Waits until answers being encoded are sent and closes every connection
+    */
+    ~RenderServer();
+
+    RenderServer(const RenderServer&) = delete;
+    RenderServer& operator=(const RenderServer&) = delete;
+
+    bool IsOpen() const { return mListener != sInvalidSocket; }
+    /*
+        Serves requests until a shutdown request. Must be called by the
+        thread owning the context of window, which is left with the scene
+        of the last request registered
+    */
+    void Run(RayMarchingWindow& window);
+    /*
+        Makes Run return once queued requests are answered
+    */
+    void Shutdown();
+
+    Stats GetStats() const;
+    void Report(std::ostream& out) const;
+
+    // Native socket handle, SOCKET on Windows, also used by RenderClient
+#ifdef _WIN32
+    using Socket = uintptr_t;
+    static constexpr Socket sInvalidSocket = ~static_cast<uintptr_t>(0);
+#else
+    using Socket = int;
+    static constexpr Socket sInvalidSocket = -1;
+#endif
+private:
+    struct Connection {
+        Socket Handle = sInvalidSocket;
+        // Answers are written whole, by readers and encoding jobs
+        std::mutex WriteMutex;
+        std::thread Reader;
+        std::atomic<bool> Finished = false;
+
+        ~Connection();
+        bool Send(const std::string& head, const std::vector<uint8_t>& body = {});
+    };
+
+    struct Request {
+        std::shared_ptr<Connection> Client;
+        uint64_t Number = 0;
+        std::string Scene;
+        // Size of the answered image, the tile of tile requests
+        unsigned int Width = 0;
+        unsigned int Height = 0;
+        // Whole frame of tile requests, 0 otherwise
+        unsigned int FrameWidth = 0;
+        unsigned int FrameHeight = 0;
+        unsigned int TileX = 0;
+        unsigned int TileY = 0;
+        float Time = 0.0f;
+        Math::Vec3 Camera;
+        float RotationY = 0.0f;
+        // Negative takes the tier of the scene
+        int Tier = -1;
+        Encoding Format = Encoding::Png;
+        std::chrono::steady_clock::time_point Received;
+    };
+
+    /*
+        Scene file with its objects, which keep their baked volumes while
+        the scene is cached. Key is the hash of the scene content
+    */
+    struct ServedScene {
+        std::string Path;
+        std::string Key;
+        uint64_t SourceSize = 0;
+        int64_t SourceTime = 0;
+        SceneFile File;
+        SceneFile::Objects Objects;
+    };
+private:
+    void Accept();
+    void Read(std::shared_ptr<Connection> connection);
+    /*
+        Parses a request line, false with the reason in error if it's invalid
+    */
+    bool Parse(const std::string& line, Request& request, std::string& error) const;
+    bool NextBatch(std::vector<Request>& batch);
+    void RenderGroup(RayMarchingWindow& window, std::vector<Request>::iterator begin, std::vector<Request>::iterator end);
+    /*
+        Most recently used scene of path, loaded again if the file changed.
+        Null with the reason in log if it can't be loaded
+    */
+    ServedScene* FindScene(const std::string& path, std::string& log);
+    void Answer(const Request& request, const unsigned char* pixels);
+    void Fail(const Request& request, const std::string& message);
+    void RecordLatency(std::chrono::steady_clock::time_point received);
+private:
+    static constexpr size_t sMaxLineLength = 4096;
+    static constexpr size_t sLatencyWindow = 4096;
+
+    Settings mSettings;
+    Socket mListener = sInvalidSocket;
+    std::string mSocketPath;
+#ifdef _WIN32
+    // WSACleanup is called only after a WSAStartup that succeeded
+    bool mSocketsStarted = false;
+#endif
+    std::chrono::steady_clock::time_point mStart;
+
+    std::thread mAcceptor;
+    std::list<std::shared_ptr<Connection>> mConnections;
+    std::mutex mConnectionsMutex;
+
+    std::deque<Request> mQueue;
+    mutable std::mutex mMutex;
+    std::condition_variable mRequestQueued;
+    std::condition_variable mRequestTaken;
+    std::atomic<bool> mStopping = false;
+    bool mShuttingDown = false;
+    Stats mStats;
+    std::vector<double> mLatencies;
+    size_t mNextLatency = 0;
+
+    // Used by Run only
+    std::vector<std::future<void>> mAnswers;
+    std::list<ServedScene> mScenes;
+    const ServedScene* mCurrentScene = nullptr;
+
+    // Destroyed first, so jobs finish while connections and stats still exist
+    JobSystem mJobs;
+};
+
+/*
+    Blocking client of a RenderServer, one request line at a time
+*/
+class RenderClient {
+public:
+    struct Answer {
+        bool Ok = false;
+        uint64_t Number = 0;
+        // Error message of failed requests
+        std::string Message;
+        // Image or the text of stats
+        std::vector<uint8_t> Data;
+        double Milliseconds = 0.0;
+    };
+public:
+    explicit RenderClient(const std::string& address);
+    ~RenderClient();
+
+    RenderClient(const RenderClient&) = delete;
+    RenderClient& operator=(const RenderClient&) = delete;
+
+    bool IsConnected() const;
+    bool Send(const std::string& line);
+    /*
+        Ends a Receive blocked on another thread, later calls fail
+    */
+    void Disconnect();
+    /*
+        Next answer to a render or stats request, nullopt once the
+        connection is closed
+    */
+    std::optional<Answer> Receive();
+private:
+    bool ReadLine(std::string& line);
+    bool ReadBytes(size_t size, std::vector<uint8_t>& out);
+private:
+    RenderServer::Socket mSocket = RenderServer::sInvalidSocket;
+#ifdef _WIN32
+    bool mSocketsStarted = false;
+#endif
+    std::string mBuffer;
+};
@@ -0,0 +1,188 @@
+#include "SceneCompiler.h"
+#include "Math/PreludeFunctions.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+// Helpers of generated functions, each computes the same float operations as its counterpart in Math.
+// Those of MATH_PRELUDE_FUNCTIONS are the same code
+const char* SceneCompiler::sPrelude = R"(#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+#ifdef _WIN32
+#define SCENE_EXPORT extern "C" __declspec(dllexport)
+#else
+#define SCENE_EXPORT extern "C"
+#endif
+
+struct vec3 {
+    float x, y, z;
+};
+
+static inline vec3 operator+(vec3 a, vec3 b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+static inline vec3 operator-(vec3 a, vec3 b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+static inline vec3 operator*(vec3 a, float b) { return { a.x * b, a.y * b, a.z * b }; }
+static inline vec3 operator/(vec3 a, float b) { return { a.x / b, a.y / b, a.z / b }; }
+static inline float length(vec3 a) { return std::sqrt(a.x * a.x + a.y * a.y + a.z * a.z); }
+
+static inline float Min(float a, float b) { return std::min(a, b); }
+static inline float Max(float a, float b) { return std::max(a, b); }
+
+)" MATH_PRELUDE_SOURCE R"(
+
+static inline vec3 RotateXZ(vec3 p, float angle)
+{
+    float c = std::cos(angle);
+    float s = std::sin(angle);
+    return { p.x * c - p.z * s, p.y, p.x * s + p.z * c };
+}
+
+static inline float BoxDistance(vec3 p, vec3 size)
+{
+    vec3 d = { std::abs(p.x) - size.x, std::abs(p.y) - size.y, std::abs(p.z) - size.z };
+    vec3 outside = { std::max(d.x, 0.0f), std::max(d.y, 0.0f), std::max(d.z, 0.0f) };
+    return std::min(std::max(d.x, std::max(d.y, d.z)), 0.0f) + length(outside);
+}
+
+struct SceneContext {
+    float SmoothMin;
+    float Time;
+    float (*Fallback)(const void* object, float x, float y, float z, const void* context);
+    const void* const* Objects;
+    const void* DistanceContext;
+};
+
+static inline float Fallback(int index, vec3 p, const SceneContext& c)
+{
+    return c.Fallback(c.Objects[index], p.x, p.y, p.z, c.DistanceContext);
+}
+
+)";
+
+std::optional<SceneCompiler::Program> SceneCompiler::Compile(const IShapedObject& object, std::string* log /* = nullptr */)
+{
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+
+    Program program;
+    std::string source = GenerateSource(object, program.Fallbacks);
+    program.Hash = Hash(source);
+    program.Library = Build(source, log, &program.Cached);
+    if (!program.Library) {
+        return std::nullopt;
+    }
+    program.Distance = reinterpret_cast<DistanceFunction>(program.Library->Symbol("SceneDistance"));
+    program.Distances = reinterpret_cast<DistancesFunction>(program.Library->Symbol("SceneDistances"));
+    if (!program.Distance || !program.Distances) {
+        return std::nullopt;
+    }
+
+    program.Milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    return program;
+}
+
+std::shared_ptr<SharedLibrary> SceneCompiler::Build(const std::string& source, std::string* log /* = nullptr */, bool* cached /* = nullptr */)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "scene_%016llx", static_cast<unsigned long long>(Hash(source)));
+    std::filesystem::path directory(sCacheDirectory);
+    std::filesystem::path libraryPath = directory / (name + std::string(SharedLibrary::Extension()));
+    std::filesystem::path logPath = directory / (name + std::string(".log"));
+
+    std::error_code error;
+    bool exists = std::filesystem::exists(libraryPath, error);
+    if (cached) {
+        *cached = exists;
+    }
+    if (!exists) {
+        std::filesystem::create_directories(directory, error);
+        std::filesystem::path sourcePath = directory / (name + std::string(".cpp"));
+        std::ofstream(sourcePath) << source;
+
+        // Built under a temporary name, so a library that exists is always complete
+        std::filesystem::path temporaryPath = directory / (name + std::string("_tmp") + SharedLibrary::Extension());
+        int status = std::system(CompileCommand(sourcePath.string(), temporaryPath.string(), logPath.string()).c_str());
+        if (log) {
+            std::stringstream output;
+            output << std::ifstream(logPath).rdbuf();
+            *log = output.str();
+        }
+        if (status != 0 || !std::filesystem::exists(temporaryPath, error)) {
+            return nullptr;
+        }
+        std::filesystem::rename(temporaryPath, libraryPath, error);
+        if (error) {
+            return nullptr;
+        }
+    }
+    return SharedLibrary::Open(libraryPath.string());
+}
+
+std::string SceneCompiler::GenerateSource(const IShapedObject& object, std::vector<const IShapedObject*>& fallbacks)
+{
+    CppSceneSource source;
+    std::string call = object.CppDistFunctionCall("p", source);
+    fallbacks = source.Fallbacks();
+
+    return sPrelude + source.Functions() +
+        "static inline float Scene(vec3 p, const SceneContext& c)\n{\n    return " + call + ";\n}\n\n"
+        "SCENE_EXPORT float SceneDistance(float x, float y, float z, const SceneContext* c)\n{\n"
+        "    return Scene(vec3{ x, y, z }, *c);\n}\n\n"
+        "SCENE_EXPORT void SceneDistances(const float* x, const float* y, const float* z, size_t count, float* out, const SceneContext* c)\n{\n"
+        "    for (size_t i = 0; i < count; i++) {\n"
+        "        out[i] = Scene(vec3{ x[i], y[i], z[i] }, *c);\n"
+        "    }\n}\n";
+}
+
+uint64_t SceneCompiler::Hash(const IShapedObject& object)
+{
+    std::vector<const IShapedObject*> fallbacks;
+    return Hash(GenerateSource(object, fallbacks));
+}
+
+SceneCompiler::Context SceneCompiler::MakeContext(const DistanceContext& context, const std::vector<const IShapedObject*>& fallbacks)
+{
+    return { context.SmoothMin, context.Time, &SceneCompiler::Fallback, reinterpret_cast<const void* const*>(fallbacks.data()), &context };
+}
+
+uint64_t SceneCompiler::Hash(const std::string& source)
+{
+    // FNV-1a over the compiler and the source
+    uint64_t hash = 14695981039346656037ull;
+    for (const std::string& part : { Compiler(), source }) {
+        for (char c : part) {
+            hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+        }
+    }
+    return hash;
+}
+
+std::string SceneCompiler::Compiler()
+{
+    const char* compiler = std::getenv(sCompilerVariable);
+#ifdef _WIN32
+    return std::string(compiler ? compiler : "cl") + " /nologo /O2 /LD /std:c++17";
+#else
+    return std::string(compiler ? compiler : "c++") + " -std=c++17 -O2 -shared -fPIC";
+#endif
+}
+
+std::string SceneCompiler::CompileCommand(const std::string& sourcePath, const std::string& libraryPath, const std::string& logPath)
+{
+#ifdef _WIN32
+    std::string objectPath = libraryPath.substr(0, libraryPath.size() - 4) + ".obj";
+    return Compiler() + " \"" + sourcePath + "\" /Fe\"" + libraryPath + "\" /Fo\"" + objectPath + "\" > \"" + logPath + "\" 2>&1";
+#else
+    return Compiler() + " \"" + sourcePath + "\" -o \"" + libraryPath + "\" > \"" + logPath + "\" 2>&1";
+#endif
+}
+
+float SceneCompiler::Fallback(const void* object, float x, float y, float z, const void* context)
+{
+    return static_cast<const IShapedObject*>(object)->Distance(Math::Vec3(x, y, z), *static_cast<const DistanceContext*>(context));
+}
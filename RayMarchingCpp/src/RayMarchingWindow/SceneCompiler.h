@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "IShapedObject.h"
+#include "SharedLibrary.h"
+
+/*
+    Native code backend of CPU distance queries. Generates C++ of an object
+    through IShapedObject::CppDistFunctionCall, the way ShapeRegistrar
+    generates GLSL, compiles it with the system compiler into a shared
+    library and loads it. Libraries are kept in sCacheDirectory named by
+    the hash of their source and compile command, so a scene compiled
+    before, in this run or an earlier one, is only loaded
+*/
+class SceneCompiler {
+public:
+    /*
+        Arguments of the generated functions, same layout as SceneContext
+        in the generated code
+    */
+    struct Context {
+        float SmoothMin;
+        float Time;
+        float (*Fallback)(const void* object, float x, float y, float z, const void* context);
+        const void* const* Objects;
+        const void* DistanceContext;
+    };
+    using DistanceFunction = float (*)(float x, float y, float z, const Context* context);
+    using DistancesFunction = void (*)(const float* x, const float* y, const float* z, size_t count, float* out, const Context* context);
+
+    struct Program {
+        std::shared_ptr<SharedLibrary> Library;
+        DistanceFunction Distance = nullptr;
+        DistancesFunction Distances = nullptr;
+        // Objects called back on the host, in the order of Context::Objects
+        std::vector<const IShapedObject*> Fallbacks;
+        uint64_t Hash = 0;
+        // Loaded from the cache without running the compiler
+        bool Cached = false;
+        double Milliseconds = 0.0;
+    };
+public:
+    /*
+        Returns nullopt if the compiler fails or can't be run, log gets its output
+    */
+    static std::optional<Program> Compile(const IShapedObject& object, std::string* log = nullptr);
+
+    /*
+        Builds source into a shared library of the cache, or opens the one
+        built from the same source before. Returns nullptr if the compiler
+        fails or can't be run, log gets its output
+    */
+    static std::shared_ptr<SharedLibrary> Build(const std::string& source, std::string* log = nullptr, bool* cached = nullptr);
+
+    static std::string GenerateSource(const IShapedObject& object, std::vector<const IShapedObject*>& fallbacks);
+    /*
+        Hash Compile would give the library of object now, tells whether a program is out of date
+    */
+    static uint64_t Hash(const IShapedObject& object);
+
+    /*
+        Context for the generated functions evaluating with context, fallbacks are those of the program
+    */
+    static Context MakeContext(const DistanceContext& context, const std::vector<const IShapedObject*>& fallbacks);
+private:
+    static uint64_t Hash(const std::string& source);
+    /*
+        Compiler and flags making a shared library, the part of the command hashed with the source
+    */
+    static std::string Compiler();
+    static std::string CompileCommand(const std::string& sourcePath, const std::string& libraryPath, const std::string& logPath);
+    static float Fallback(const void* object, float x, float y, float z, const void* context);
+private:
+    static constexpr std::string_view sCacheDirectory = "jit";
+    // Overrides the compiler of CompileCommand
+    static constexpr const char* sCompilerVariable = "SCENE_COMPILER";
+    static const char* sPrelude;
+};
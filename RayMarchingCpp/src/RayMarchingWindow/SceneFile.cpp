@@ -0,0 +1,616 @@
+#include "SceneFile.h"
+#include "RayMarchingWindow.h"
+
+#include "PlaneShape.h"
+#include "SphereShape.h"
+#include "CubeShape.h"
+#include "SinSphere.h"
+#include "VaseShape.h"
+#include "CroppedShapeWrapper.h"
+#include "IntersectedShapeWrapper.h"
+#include "InterpolatedShapeWrapper.h"
+#include "RepeatedSpaceWrapper.h"
+#include "InstancedShapeSet.h"
+#include "BrickMapShapeWrapper.h"
+#include "BakedShapeWrapper.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+
+static_assert(sizeof(SceneFile::Header) == 136, "Header layout is part of the file format");
+static_assert(sizeof(SceneFile::Node) == 48, "Node layout is part of the file format");
+static_assert(sizeof(SceneFile::Instance) == 28, "Instance layout is part of the file format");
+
+namespace {
+
+    constexpr char sMagic[4] = { 'R', 'M', 'S', 'C' };
+    // Texture units every OpenGL 3.3 fragment shader has
+    constexpr unsigned int sTextureSlotCount = 16;
+
+    struct NodeSyntax {
+        std::string_view Keyword;
+        SceneFile::NodeType Type;
+        std::string_view Usage;
+    };
+
+    constexpr NodeSyntax sNodeSyntax[] = {
+        { "plane", SceneFile::NodeType::Plane, "plane <name> <height>" },
+        { "sphere", SceneFile::NodeType::Sphere, "sphere <name> <x> <y> <z> <radius>" },
+        { "cube", SceneFile::NodeType::Cube, "cube <name> <x> <y> <z> <half size>" },
+        { "sin_sphere", SceneFile::NodeType::SinSphere, "sin_sphere <name> <x> <y> <z> <radius>" },
+        { "vase", SceneFile::NodeType::Vase, "vase <name> <x> <y> <z> <size>" },
+        { "cropped", SceneFile::NodeType::Cropped, "cropped <name> <shape> <cropping shape>" },
+        { "intersected", SceneFile::NodeType::Intersected, "intersected <name> <first> <second>" },
+        { "interpolated", SceneFile::NodeType::Interpolated, "interpolated <name> <first> <second> <grade>" },
+        { "repeated", SceneFile::NodeType::Repeated, "repeated <name> <x> <y> <z> <cell size> <object>..." },
+        { "instances", SceneFile::NodeType::Instances, "instances <name> sphere|cube" },
+        { "brick_map", SceneFile::NodeType::BrickMap, "brick_map <name> <object> <resolution> <bits per distance> [cache path]" },
+        { "baked", SceneFile::NodeType::Baked, "baked <name> <object> <resolution>" },
+    };
+
+    uint64_t AlignOffset(uint64_t offset)
+    {
+        return (offset + 15) & ~static_cast<uint64_t>(15);
+    }
+
+    bool ParseFloat(std::string_view token, float& value)
+    {
+        std::string text(token);
+        char* end = nullptr;
+        value = std::strtof(text.c_str(), &end);
+        return !text.empty() && end == text.c_str() + text.size();
+    }
+
+    bool ParseUnsigned(std::string_view token, uint32_t& value)
+    {
+        std::string text(token);
+        char* end = nullptr;
+        unsigned long parsed = std::strtoul(text.c_str(), &end, 10);
+        value = static_cast<uint32_t>(parsed);
+        return !text.empty() && text[0] != '-' && end == text.c_str() + text.size() && parsed <= 0xffffffffu;
+    }
+
+    bool IsSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    void Split(std::string_view line, std::vector<std::string_view>& tokens)
+    {
+        tokens.clear();
+        size_t i = 0;
+        while (i < line.size()) {
+            while (i < line.size() && IsSpace(line[i])) {
+                i++;
+            }
+            size_t start = i;
+            while (i < line.size() && !IsSpace(line[i])) {
+                i++;
+            }
+            if (i > start) {
+                tokens.push_back(line.substr(start, i - start));
+            }
+        }
+    }
+
+    /*
+        Copies a table into the file and returns its offset
+    */
+    template <typename T>
+    uint64_t Append(std::vector<unsigned char>& data, const T* items, size_t count)
+    {
+        uint64_t offset = AlignOffset(data.size());
+        data.resize(offset + count * sizeof(T));
+        if (count > 0) {
+            std::memcpy(data.data() + offset, items, count * sizeof(T));
+        }
+        return offset;
+    }
+
+}
+
+std::optional<SceneFile> SceneFile::Parse(std::string_view text, std::string* log /* = nullptr */)
+{
+    Header header = {};
+    std::memcpy(header.Magic, sMagic, sizeof(sMagic));
+    header.Version = sVersion;
+
+    std::vector<Node> nodes;
+    std::vector<uint32_t> children;
+    std::vector<uint32_t> draw;
+    // Instances of every Instances node, laid out one set after another at the end
+    std::unordered_map<uint32_t, std::vector<Instance>> nodeInstances;
+    // Offset 0 is the empty name
+    std::string names(1, '\0');
+    std::unordered_map<std::string_view, uint32_t> ids;
+
+    std::vector<std::string_view> tokens;
+    size_t lineNumber = 0;
+    std::string error;
+    auto fail = [&](const std::string& message) {
+        error = "line " + std::to_string(lineNumber) + ": " + message;
+        return false;
+    };
+    auto addName = [&](std::string_view name) {
+        uint32_t offset = static_cast<uint32_t>(names.size());
+        names.append(name);
+        names.push_back('\0');
+        return offset;
+    };
+    auto find = [&](std::string_view name, uint32_t& id) {
+        auto it = ids.find(name);
+        if (it == ids.end()) {
+            return fail("unknown object '" + std::string(name) + "'");
+        }
+        id = it->second;
+        return true;
+    };
+    auto parseFloats = [&](size_t first, size_t count, float* out) {
+        for (size_t i = 0; i < count; i++) {
+            if (!ParseFloat(tokens[first + i], out[i])) {
+                return fail("'" + std::string(tokens[first + i]) + "' isn't a number");
+            }
+        }
+        return true;
+    };
+
+    auto parseLine = [&]() {
+        std::string_view keyword = tokens[0];
+        if (keyword == "smooth_min" || keyword == "tier") {
+            header.Settings |= keyword == "tier" ? QualityTierSetting : SmoothMinSetting;
+            if (tokens.size() != 2) {
+                return fail(std::string(keyword) + " takes one value");
+            }
+            return keyword == "tier" ? ParseUnsigned(tokens[1], header.QualityTier) || fail("tier takes an index") :
+                parseFloats(1, 1, &header.SmoothMin);
+        }
+        if (keyword == "light") {
+            header.Settings |= LightSetting;
+            return (tokens.size() == 4 || fail("usage: light <x> <y> <z>")) && parseFloats(1, 3, header.Light);
+        }
+        if (keyword == "camera") {
+            header.Settings |= CameraSetting;
+            return ((tokens.size() == 4 || tokens.size() == 5) || fail("usage: camera <x> <y> <z> [rotation]")) &&
+                parseFloats(1, 3, header.Camera) && (tokens.size() == 4 || parseFloats(4, 1, &header.CameraRotationY));
+        }
+        if (keyword == "instance") {
+            uint32_t id = 0;
+            Instance instance = {};
+            if (tokens.size() != 9) {
+                return fail("usage: instance <instances> <x> <y> <z> <size x> <size y> <size z> <rotation>");
+            }
+            if (!find(tokens[1], id) || !parseFloats(2, 3, instance.Position) || !parseFloats(5, 3, instance.Size) ||
+                !parseFloats(8, 1, &instance.RotationY)) {
+                return false;
+            }
+            if (nodes[id].Type != NodeType::Instances) {
+                return fail("'" + std::string(tokens[1]) + "' isn't an instances object");
+            }
+            nodeInstances[id].push_back(instance);
+            return true;
+        }
+        if (keyword == "draw") {
+            for (size_t i = 1; i < tokens.size(); i++) {
+                uint32_t id = 0;
+                if (!find(tokens[i], id)) {
+                    return false;
+                }
+                draw.push_back(id);
+            }
+            return true;
+        }
+
+        const NodeSyntax* syntax = nullptr;
+        for (const NodeSyntax& candidate : sNodeSyntax) {
+            syntax = candidate.Keyword == keyword ? &candidate : syntax;
+        }
+        if (!syntax) {
+            return fail("unknown keyword '" + std::string(keyword) + "'");
+        }
+        auto usage = [&]() { return fail("usage: " + std::string(syntax->Usage)); };
+        if (tokens.size() < 2) {
+            return usage();
+        }
+        if (ids.count(tokens[1]) > 0) {
+            return fail("'" + std::string(tokens[1]) + "' is already defined");
+        }
+
+        Node node = {};
+        node.Type = syntax->Type;
+        node.Name = addName(tokens[1]);
+        node.First = static_cast<uint32_t>(children.size());
+        auto addChildren = [&](size_t first, size_t count) {
+            for (size_t i = first; i < first + count; i++) {
+                uint32_t id = 0;
+                if (!find(tokens[i], id)) {
+                    return false;
+                }
+                children.push_back(id);
+                node.Count++;
+            }
+            return true;
+        };
+
+        bool parsed = false;
+        switch (node.Type) {
+        case NodeType::Plane:
+            parsed = (tokens.size() == 3 || usage()) && parseFloats(2, 1, node.Values);
+            break;
+        case NodeType::Sphere:
+        case NodeType::Cube:
+        case NodeType::SinSphere:
+        case NodeType::Vase:
+            parsed = (tokens.size() == 6 || usage()) && parseFloats(2, 4, node.Values);
+            break;
+        case NodeType::Cropped:
+        case NodeType::Intersected:
+            parsed = (tokens.size() == 4 || usage()) && addChildren(2, 2);
+            break;
+        case NodeType::Interpolated:
+            parsed = (tokens.size() == 5 || usage()) && addChildren(2, 2) && parseFloats(4, 1, node.Values);
+            break;
+        case NodeType::Repeated:
+            parsed = (tokens.size() >= 7 || usage()) && parseFloats(2, 4, node.Values) && addChildren(6, tokens.size() - 6);
+            break;
+        case NodeType::Instances:
+            parsed = (tokens.size() == 3 && (tokens[2] == "sphere" || tokens[2] == "cube")) || usage();
+            node.Integers[0] = tokens.size() == 3 && tokens[2] == "cube" ? 1 : 0;
+            break;
+        case NodeType::BrickMap:
+            parsed = (tokens.size() == 5 || tokens.size() == 6 || usage()) && addChildren(2, 1) &&
+                ((ParseUnsigned(tokens[3], node.Integers[0]) && ParseUnsigned(tokens[4], node.Integers[1])) || usage());
+            node.Path = tokens.size() == 6 ? addName(tokens[5]) : 0;
+            break;
+        case NodeType::Baked:
+            parsed = (tokens.size() == 4 || usage()) && addChildren(2, 1) && (ParseUnsigned(tokens[3], node.Integers[0]) || usage());
+            break;
+        default:
+            break;
+        }
+        if (parsed) {
+            ids[tokens[1]] = static_cast<uint32_t>(nodes.size());
+            nodes.push_back(node);
+        }
+        return parsed;
+    };
+
+    size_t position = 0;
+    while (position < text.size()) {
+        size_t end = std::min(text.find('\n', position), text.size());
+        std::string_view line = text.substr(position, end - position);
+        position = end + 1;
+        lineNumber++;
+
+        Split(line.substr(0, line.find('#')), tokens);
+        if (!tokens.empty() && !parseLine()) {
+            if (log) {
+                *log = error;
+            }
+            return std::nullopt;
+        }
+    }
+
+    std::vector<Instance> instances;
+    for (uint32_t i = 0; i < nodes.size(); i++) {
+        if (nodes[i].Type != NodeType::Instances) {
+            continue;
+        }
+        std::vector<Instance>& set = nodeInstances[i];
+        nodes[i].First = static_cast<uint32_t>(instances.size());
+        nodes[i].Count = static_cast<uint32_t>(set.size());
+        instances.insert(instances.end(), set.begin(), set.end());
+        std::vector<Instance>().swap(set);
+    }
+
+    header.NodeCount = static_cast<uint32_t>(nodes.size());
+    header.ChildCount = static_cast<uint32_t>(children.size());
+    header.InstanceCount = static_cast<uint32_t>(instances.size());
+    header.DrawCount = static_cast<uint32_t>(draw.size());
+    header.NameBytes = static_cast<uint32_t>(names.size());
+
+    SceneFile scene;
+    scene.mData.resize(sizeof(Header));
+    header.NodesOffset = Append(scene.mData, nodes.data(), nodes.size());
+    header.ChildrenOffset = Append(scene.mData, children.data(), children.size());
+    header.InstancesOffset = Append(scene.mData, instances.data(), instances.size());
+    header.DrawOffset = Append(scene.mData, draw.data(), draw.size());
+    header.NamesOffset = Append(scene.mData, names.data(), names.size());
+    header.FileSize = scene.mData.size();
+    std::memcpy(scene.mData.data(), &header, sizeof(header));
+    return scene;
+}
+
+std::optional<SceneFile> SceneFile::LoadBinary(const std::string& path)
+{
+    std::unique_ptr<MappedFile> file = MappedFile::Open(path);
+    if (!file || file->Size() < sizeof(Header) || std::memcmp(file->Data(), sMagic, sizeof(sMagic)) != 0) {
+        return std::nullopt;
+    }
+
+    SceneFile scene;
+    scene.mFile = std::move(file);
+    if (!scene.Validate()) {
+        return std::nullopt;
+    }
+    return scene;
+}
+
+std::string SceneFile::CachePath(const std::string& path, const std::string& directory)
+{
+    std::error_code error;
+    std::filesystem::path fullPath = std::filesystem::weakly_canonical(path, error);
+    if (error) {
+        fullPath = std::filesystem::absolute(path, error).lexically_normal();
+    }
+
+    // FNV-1a over the full path
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : fullPath.generic_string()) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+    }
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+    return (std::filesystem::path(directory) / (fullPath.filename().string() + '.' + hex + ".bin")).string();
+}
+
+std::optional<SceneFile> SceneFile::Load(const std::string& path, const std::string& cachePath, std::string* log /* = nullptr */)
+{
+    if (std::optional<SceneFile> binary = LoadBinary(path)) {
+        return binary;
+    }
+
+    std::error_code error;
+    uint64_t size = std::filesystem::file_size(path, error);
+    int64_t time = error ? 0 : static_cast<int64_t>(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+    if (error) {
+        if (log) {
+            *log = "can't read " + path;
+        }
+        return std::nullopt;
+    }
+    if (!cachePath.empty()) {
+        std::optional<SceneFile> cached = LoadBinary(cachePath);
+        if (cached && cached->GetHeader().SourceSize == size && cached->GetHeader().SourceTime == time) {
+            return cached;
+        }
+    }
+
+    std::string text(size, '\0');
+    std::ifstream in(path, std::ios::binary);
+    in.read(text.data(), static_cast<std::streamsize>(size));
+    if (!in) {
+        if (log) {
+            *log = "can't read " + path;
+        }
+        return std::nullopt;
+    }
+    std::optional<SceneFile> scene = Parse(text, log);
+    if (!scene) {
+        return std::nullopt;
+    }
+
+    Header& header = *reinterpret_cast<Header*>(scene->mData.data());
+    header.SourceSize = size;
+    header.SourceTime = time;
+    if (!cachePath.empty()) {
+        scene->Save(cachePath);
+    }
+    return scene;
+}
+
+bool SceneFile::Save(const std::string& path) const
+{
+    std::filesystem::path filePath(path);
+    std::error_code error;
+    if (filePath.has_parent_path()) {
+        std::filesystem::create_directories(filePath.parent_path(), error);
+    }
+
+    // Written aside and renamed, so other runs never map a partially written file
+    std::filesystem::path temporaryPath = filePath;
+    temporaryPath += ".tmp";
+    {
+        std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(Data()), static_cast<std::streamsize>(SizeInBytes()));
+        if (!out) {
+            return false;
+        }
+    }
+    std::filesystem::rename(temporaryPath, filePath, error);
+    return !error;
+}
+
+bool SceneFile::Validate() const
+{
+    Header header;
+    std::memcpy(&header, Data(), sizeof(header));
+    if (std::memcmp(header.Magic, sMagic, sizeof(sMagic)) != 0 || header.Version != sVersion || header.FileSize != SizeInBytes()) {
+        return false;
+    }
+    auto inside = [&](uint64_t offset, uint64_t count, uint64_t itemSize) {
+        return offset % 16 == 0 && offset >= sizeof(Header) && offset <= header.FileSize &&
+            count <= (header.FileSize - offset) / itemSize;
+    };
+    if (!inside(header.NodesOffset, header.NodeCount, sizeof(Node)) || !inside(header.ChildrenOffset, header.ChildCount, sizeof(uint32_t)) ||
+        !inside(header.InstancesOffset, header.InstanceCount, sizeof(Instance)) ||
+        !inside(header.DrawOffset, header.DrawCount, sizeof(uint32_t)) || !inside(header.NamesOffset, header.NameBytes, 1) ||
+        header.NameBytes == 0 || Name(header.NameBytes - 1)[0] != '\0') {
+        return false;
+    }
+
+    const Node* nodes = Nodes();
+    const uint32_t* children = Children();
+    for (uint32_t i = 0; i < header.NodeCount; i++) {
+        const Node& node = nodes[i];
+        if (node.Type >= NodeType::Count || node.Name >= header.NameBytes || node.Path >= header.NameBytes) {
+            return false;
+        }
+        uint64_t end = static_cast<uint64_t>(node.First) + node.Count;
+        if (node.Type == NodeType::Instances) {
+            if (end > header.InstanceCount) {
+                return false;
+            }
+            continue;
+        }
+        unsigned int required = node.Type == NodeType::Cropped || node.Type == NodeType::Intersected || node.Type == NodeType::Interpolated ? 2 :
+            node.Type == NodeType::Repeated || node.Type == NodeType::BrickMap || node.Type == NodeType::Baked ? 1 : 0;
+        if (end > header.ChildCount || node.Count < required) {
+            return false;
+        }
+        for (uint32_t k = node.First; k < end; k++) {
+            if (children[k] >= i) {
+                return false;
+            }
+        }
+    }
+    const uint32_t* draw = DrawList();
+    for (uint32_t i = 0; i < header.DrawCount; i++) {
+        if (draw[i] >= header.NodeCount) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::optional<SceneFile::Objects> SceneFile::Instantiate(unsigned int firstTextureSlot, std::string* log /* = nullptr */) const
+{
+    const Header& header = GetHeader();
+    const Node* nodes = Nodes();
+    const uint32_t* children = Children();
+    std::vector<std::shared_ptr<IShapedObject>> objects(header.NodeCount);
+    unsigned int textureSlot = firstTextureSlot;
+
+    for (uint32_t i = 0; i < header.NodeCount; i++) {
+        const Node& node = nodes[i];
+        std::string name = Name(node.Name);
+        Math::Vec4 values(node.Values[0], node.Values[1], node.Values[2], node.Values[3]);
+        auto child = [&](uint32_t k) { return objects[children[node.First + k]]; };
+
+        switch (node.Type) {
+        case NodeType::Plane:
+            objects[i] = std::make_shared<PlaneShape>(node.Values[0], name);
+            break;
+        case NodeType::Sphere:
+            objects[i] = std::make_shared<SphereShape>(values, name);
+            break;
+        case NodeType::Cube:
+            objects[i] = std::make_shared<CubeShape>(values, name);
+            break;
+        case NodeType::SinSphere:
+            objects[i] = std::make_shared<SinSphereShape>(values, name);
+            break;
+        case NodeType::Vase:
+            objects[i] = std::make_shared<VaseShape>(values, name);
+            break;
+        case NodeType::Cropped:
+            objects[i] = std::make_shared<CroppedShapeWrapper>(child(0), child(1));
+            break;
+        case NodeType::Intersected:
+            objects[i] = std::make_shared<IntersectedShapeWrapper>(child(0), child(1));
+            break;
+        case NodeType::Interpolated:
+            objects[i] = std::make_shared<InterpolatedShapeWrapper>(child(0), child(1), node.Values[0]);
+            break;
+        case NodeType::Repeated: {
+            std::vector<std::shared_ptr<IShapedObject>> shapes;
+            for (uint32_t k = 0; k < node.Count; k++) {
+                shapes.push_back(child(k));
+            }
+            objects[i] = std::make_shared<RepeatedSpaceWrapper>(shapes, values, name);
+            break;
+        }
+        case NodeType::Instances: {
+            auto set = std::make_shared<InstancedShapeSet>(node.Integers[0] == 1 ? InstancedShapeSet::Primitive::Cube :
+                InstancedShapeSet::Primitive::Sphere, name, textureSlot++);
+            std::vector<InstancedShapeSet::Instance> instances(node.Count);
+            const Instance* source = Instances() + node.First;
+            for (uint32_t k = 0; k < node.Count; k++) {
+                instances[k].Position = Math::Vec3(source[k].Position[0], source[k].Position[1], source[k].Position[2]);
+                instances[k].Size = Math::Vec3(source[k].Size[0], source[k].Size[1], source[k].Size[2]);
+                instances[k].RotationY = source[k].RotationY;
+            }
+            set->SetInstances(std::move(instances));
+            objects[i] = set;
+            break;
+        }
+        case NodeType::BrickMap:
+            objects[i] = std::make_shared<BrickMapShapeWrapper>(child(0), name, textureSlot, node.Integers[0], node.Integers[1], Name(node.Path));
+            textureSlot += 2;
+            break;
+        case NodeType::Baked:
+            objects[i] = std::make_shared<BakedShapeWrapper>(child(0), name, textureSlot++, node.Integers[0]);
+            break;
+        default:
+            break;
+        }
+    }
+    if (textureSlot > sTextureSlotCount) {
+        if (log) {
+            *log = "instanced and baked objects need " + std::to_string(textureSlot) + " texture units, there are " +
+                std::to_string(sTextureSlotCount);
+        }
+        return std::nullopt;
+    }
+
+    Objects result;
+    const uint32_t* draw = DrawList();
+    for (uint32_t i = 0; i < header.DrawCount; i++) {
+        result.Drawn.push_back(objects[draw[i]]);
+    }
+    for (const std::shared_ptr<IShapedObject>& object : objects) {
+        if (auto editable = std::dynamic_pointer_cast<IImGuiEditable>(object)) {
+            result.Editable.push_back(editable);
+        }
+        if (auto baked = std::dynamic_pointer_cast<IBakedObject>(object)) {
+            result.Baked.push_back(baked);
+        }
+    }
+    return result;
+}
+
+bool SceneFile::Build(RayMarchingWindow& window, std::string* log /* = nullptr */) const
+{
+    std::optional<Objects> objects = Instantiate(RayMarchingWindow::sFirstObjectTextureSlot, log);
+    if (!objects) {
+        return false;
+    }
+    Apply(window, *objects);
+    return true;
+}
+
+void SceneFile::Apply(RayMarchingWindow& window, const Objects& objects) const
+{
+    // Every shape function goes to the shader like in the built-in scene, unused ones cost nothing
+    window.RegisterNewShape<PlaneShape>();
+    window.RegisterNewShape<SphereShape>();
+    window.RegisterNewShape<CubeShape>();
+    window.RegisterNewShape<SinSphereShape>();
+    window.RegisterNewShape<VaseShape>();
+    for (const std::shared_ptr<IShapedObject>& object : objects.Drawn) {
+        window.RegisterNewObject(object);
+    }
+    for (const std::shared_ptr<IImGuiEditable>& object : objects.Editable) {
+        window.RegisterEditableObject(object);
+    }
+    for (const std::shared_ptr<IBakedObject>& object : objects.Baked) {
+        window.RegisterBakedObject(object);
+    }
+
+    const Header& header = GetHeader();
+    if (header.Settings & SmoothMinSetting) {
+        window.SetSmoothMin(header.SmoothMin);
+    }
+    if (header.Settings & QualityTierSetting) {
+        window.SetQualityTier(header.QualityTier);
+    }
+    if (header.Settings & LightSetting) {
+        window.SetLightPosition(Math::Vec3(header.Light[0], header.Light[1], header.Light[2]));
+    }
+    if (header.Settings & CameraSetting) {
+        window.SetCamera(Math::Vec3(header.Camera[0], header.Camera[1], header.Camera[2]), header.CameraRotationY);
+    }
+}
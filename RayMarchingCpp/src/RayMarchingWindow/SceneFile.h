@@ -0,0 +1,174 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "IShapedObject.h"
+#include "IImGuiEditable.h"
+#include "IBakedObject.h"
+#include "MappedFile.h"
+
+class RayMarchingWindow;
+
+/*
+    Scene of objects, wrappers and window settings described by a text
+    file instead of code, res/scenes/Main.scene shows the format. A parsed
+    scene is kept in its binary form, which is also the file layout of
+    Save: header, nodes, child indices, instances, draw list and names.
+    Binary files are memory mapped and used in place, so a generated scene
+    of millions of instances loads without being parsed again
+*/
+class SceneFile {
+public:
+    static constexpr uint32_t sVersion = 1;
+
+    enum class NodeType : uint32_t {
+        Plane,
+        Sphere,
+        Cube,
+        SinSphere,
+        Vase,
+        Cropped,
+        Intersected,
+        Interpolated,
+        Repeated,
+        Instances,
+        BrickMap,
+        Baked,
+        Count
+    };
+
+    // Bits of Header::Settings telling which settings the scene gives
+    enum SettingsBits : uint32_t {
+        SmoothMinSetting = 1,
+        QualityTierSetting = 2,
+        LightSetting = 4,
+        CameraSetting = 8
+    };
+
+    struct Header {
+        char Magic[4];
+        uint32_t Version;
+        // Size and modification time of the text file the binary was made from
+        uint64_t SourceSize;
+        int64_t SourceTime;
+        uint32_t Settings;
+        float SmoothMin;
+        uint32_t QualityTier;
+        float Light[3];
+        float Camera[3];
+        float CameraRotationY;
+        uint32_t NodeCount;
+        uint32_t ChildCount;
+        uint32_t InstanceCount;
+        uint32_t DrawCount;
+        uint32_t NameBytes;
+        uint32_t Padding;
+        uint64_t NodesOffset;
+        uint64_t ChildrenOffset;
+        uint64_t InstancesOffset;
+        uint64_t DrawOffset;
+        uint64_t NamesOffset;
+        uint64_t FileSize;
+    };
+
+    /*
+        Nodes only refer to nodes before them, so they are built in order
+    */
+    struct Node {
+        NodeType Type;
+        // Offset in names, every name ends with '\0'
+        uint32_t Name;
+        // Range of child indices of wrappers or of instances of Instances
+        uint32_t First;
+        uint32_t Count;
+        // Shape coordinates, plane height, cell of Repeated or grade of Interpolated
+        float Values[4];
+        // Primitive of Instances, resolution and bits per distance of BrickMap, resolution of Baked
+        uint32_t Integers[2];
+        // Offset in names of the BrickMap cache path
+        uint32_t Path;
+        uint32_t Padding;
+    };
+
+    struct Instance {
+        float Position[3];
+        float Size[3];
+        float RotationY;
+    };
+
+    /*
+        Built objects, Drawn are registered with the window in order
+    */
+    struct Objects {
+        std::vector<std::shared_ptr<IShapedObject>> Drawn;
+        std::vector<std::shared_ptr<IImGuiEditable>> Editable;
+        std::vector<std::shared_ptr<IBakedObject>> Baked;
+    };
+public:
+    SceneFile(SceneFile&&) = default;
+    SceneFile& operator=(SceneFile&&) = default;
+
+    static std::optional<SceneFile> Parse(std::string_view text, std::string* log = nullptr);
+    /*
+        Maps a file written by Save, nullopt if it isn't one or is damaged
+    */
+    static std::optional<SceneFile> LoadBinary(const std::string& path);
+    /*
+        Loads path as a binary scene or parses it as text. A text scene is
+        taken from cachePath while the binary there was made from the text
+        of the same size and modification time, otherwise it's parsed and
+        saved there. Empty cachePath disables the cache
+    */
+    static std::optional<SceneFile> Load(const std::string& path, const std::string& cachePath, std::string* log = nullptr);
+    /*
+        Cache file under directory for the text scene at path, named after
+        the file and a hash of its normalized full path, so scenes of the
+        same name in other directories don't share it
+    */
+    static std::string CachePath(const std::string& path, const std::string& directory);
+    bool Save(const std::string& path) const;
+
+    /*
+        Creates the objects, instanced and baked ones take texture units
+        from firstTextureSlot on
+    */
+    std::optional<Objects> Instantiate(unsigned int firstTextureSlot, std::string* log = nullptr) const;
+    /*
+        Registers shape types, objects and settings with a window that
+        hasn't been run yet
+    */
+    bool Build(RayMarchingWindow& window, std::string* log = nullptr) const;
+    /*
+        Registers objects made by Instantiate with the window, and the
+        shape types and settings of the scene
+    */
+    void Apply(RayMarchingWindow& window, const Objects& objects) const;
+
+    const Header& GetHeader() const { return *reinterpret_cast<const Header*>(Data()); }
+    const Node* Nodes() const { return reinterpret_cast<const Node*>(Data() + GetHeader().NodesOffset); }
+    const uint32_t* Children() const { return reinterpret_cast<const uint32_t*>(Data() + GetHeader().ChildrenOffset); }
+    const Instance* Instances() const { return reinterpret_cast<const Instance*>(Data() + GetHeader().InstancesOffset); }
+    const uint32_t* DrawList() const { return reinterpret_cast<const uint32_t*>(Data() + GetHeader().DrawOffset); }
+    const char* Name(uint32_t offset) const { return reinterpret_cast<const char*>(Data() + GetHeader().NamesOffset + offset); }
+
+    const unsigned char* Data() const { return mFile ? mFile->Data() : mData.data(); }
+    size_t SizeInBytes() const { return mFile ? mFile->Size() : mData.size(); }
+    bool IsMapped() const { return mFile != nullptr; }
+private:
+    SceneFile() = default;
+
+    /*
+        Checks offsets, sizes and references of the data, so nodes of a
+        damaged file are never followed out of it
+    */
+    bool Validate() const;
+private:
+    // Parsed scenes own their data, loaded ones view the mapped file
+    std::vector<unsigned char> mData;
+    std::unique_ptr<MappedFile> mFile;
+};
@@ -0,0 +1,70 @@
+#include "SceneQuery.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+void SceneQuery::QueryDistances(const IShapedObject& object, const DistanceContext& context, const Math::Vec3* points, size_t count,
+    float* outDistances, Math::Vec3* outNormals, unsigned int threadCount /* = 0 */)
+{
+    const size_t chunkCount = (count + PointBatch::sMaxCount - 1) / PointBatch::sMaxCount;
+    std::atomic<size_t> nextChunk = 0;
+    auto worker = [&]() {
+        for (size_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++) {
+            size_t first = chunk * PointBatch::sMaxCount;
+            QueryChunk(object, context, points + first, std::min(count - first, PointBatch::sMaxCount), outDistances + first,
+                outNormals ? outNormals + first : nullptr);
+        }
+    };
+
+    if (threadCount == 0) {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    if (count < sParallelPoints) {
+        threadCount = 1;
+    }
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < std::min<size_t>(threadCount, chunkCount); i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+void SceneQuery::QueryChunk(const IShapedObject& object, const DistanceContext& context, const Math::Vec3* points, size_t count,
+    float* outDistances, Math::Vec3* outNormals)
+{
+    float x[PointBatch::sMaxCount];
+    float y[PointBatch::sMaxCount];
+    float z[PointBatch::sMaxCount];
+    for (size_t i = 0; i < count; i++) {
+        x[i] = points[i].x();
+        y[i] = points[i].y();
+        z[i] = points[i].z();
+    }
+    PointBatch batch = { x, y, z, count };
+    object.Distances(batch, outDistances, context);
+    if (!outNormals) {
+        return;
+    }
+
+    // Each axis is shifted back by the offset in turn, the other two arrays are shared
+    float shifted[PointBatch::sMaxCount];
+    float neighbours[3][PointBatch::sMaxCount];
+    const float* axes[3] = { x, y, z };
+    for (unsigned int axis = 0; axis < 3; axis++) {
+        for (size_t i = 0; i < count; i++) {
+            shifted[i] = axes[axis][i] - sNormalOffset;
+        }
+        PointBatch shiftedBatch = { axis == 0 ? shifted : x, axis == 1 ? shifted : y, axis == 2 ? shifted : z, count };
+        object.Distances(shiftedBatch, neighbours[axis], context);
+    }
+    for (size_t i = 0; i < count; i++) {
+        Math::Vec3 normal(outDistances[i] - neighbours[0][i], outDistances[i] - neighbours[1][i], outDistances[i] - neighbours[2][i]);
+        float length = normal.Magnitude();
+        outNormals[i] = length > 0.0f ? normal / length : Math::Vec3(0.0f);
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+
+#include "IShapedObject.h"
+#include "Math/Math.h"
+
+/*
+    Distance and normal queries of many points against an object on CPU,
+    e.g. against the scene the shader renders for collisions. Points are
+    regrouped into PointBatch chunks and evaluated through
+    IShapedObject::Distances, normals are the one sided differences
+    GetNormal takes in Fragment.shader. Calls with at least sParallelPoints
+    points share their chunks between worker threads
+*/
+class SceneQuery {
+public:
+    /*
+        Writes count distances, and count normals unless outNormals is null.
+        Normals where the field is flat are zero
+    */
+    static void QueryDistances(const IShapedObject& object, const DistanceContext& context, const Math::Vec3* points, size_t count,
+        float* outDistances, Math::Vec3* outNormals, unsigned int threadCount = 0);
+private:
+    static void QueryChunk(const IShapedObject& object, const DistanceContext& context, const Math::Vec3* points, size_t count,
+        float* outDistances, Math::Vec3* outNormals);
+private:
+    // SURFACE_DISTANCE of the shader
+    static constexpr float sNormalOffset = 0.001f;
+    // Fewer points are cheaper to evaluate than to start threads for
+    static constexpr size_t sParallelPoints = 8192;
+};
@@ -0,0 +1,53 @@
+#include "SdfBaker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+SdfBaker::Volume SdfBaker::Bake(const IShapedObject& object, const Math::AABB& bounds, unsigned int resolution,
+    const DistanceContext& context, unsigned int threadCount /* = 0 */)
+{
+    Volume volume;
+    Math::Vec3 size = bounds.Size();
+    float voxelSize = std::max({ size.x(), size.y(), size.z() }) / (std::max(resolution, 2u) - 1);
+
+    Math::Vec3 max = bounds.Min();
+    for (unsigned int i = 0; i < 3; i++) {
+        volume.Dimensions[i] = std::max(static_cast<unsigned int>(std::ceil(size[i] / voxelSize)), 1u) + 1;
+        max[i] += (volume.Dimensions[i] - 1) * voxelSize;
+    }
+    volume.Bounds = Math::AABB(bounds.Min(), max);
+
+    const unsigned int width = volume.Dimensions[0];
+    const unsigned int height = volume.Dimensions[1];
+    const unsigned int depth = volume.Dimensions[2];
+    volume.Distances.resize(static_cast<size_t>(width) * height * depth);
+
+    std::atomic<unsigned int> nextSlice = 0;
+    auto worker = [&]() {
+        for (unsigned int z = nextSlice++; z < depth; z = nextSlice++) {
+            float* slice = volume.Distances.data() + static_cast<size_t>(z) * width * height;
+            for (unsigned int y = 0; y < height; y++) {
+                for (unsigned int x = 0; x < width; x++) {
+                    Math::Vec3 p = bounds.Min() + Math::Vec3(static_cast<float>(x), static_cast<float>(y), static_cast<float>(z)) * voxelSize;
+                    slice[y * width + x] = object.Distance(p, context);
+                }
+            }
+        }
+    };
+
+    if (threadCount == 0) {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < std::min(threadCount, depth); i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    return volume;
+}
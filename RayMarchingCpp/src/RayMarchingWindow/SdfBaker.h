@@ -0,0 +1,29 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "IShapedObject.h"
+#include "Math/Math.h"
+
+/*
+    Samples distance of an object on a regular grid of points covering the
+    bounds, first and last points of each axis lie on the box faces. Slices
+    along Z are shared between worker threads
+*/
+class SdfBaker {
+public:
+    struct Volume {
+        Math::AABB Bounds;
+        std::array<unsigned int, 3> Dimensions = { 0, 0, 0 };
+        // x changes fastest, then y, then z
+        std::vector<float> Distances;
+    };
+public:
+    /*
+        Longest axis of bounds gets resolution points, the others as many as
+        needed to keep voxels cubic, bounds are grown to a whole voxel count
+    */
+    static Volume Bake(const IShapedObject& object, const Math::AABB& bounds, unsigned int resolution,
+        const DistanceContext& context, unsigned int threadCount = 0);
+};
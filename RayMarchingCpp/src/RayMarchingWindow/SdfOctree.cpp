@@ -0,0 +1,157 @@
+#include "SdfOctree.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+SdfOctree SdfOctree::Build(const IShapedObject& object, const Math::AABB& bounds, unsigned int maxDepth,
+    const DistanceContext& context, unsigned int threadCount /* = 0 */)
+{
+    BuildState state = { object, context, maxDepth };
+    Subtree top;
+    std::vector<Task> tasks;
+    top.Root = BuildNode(state, bounds, 0, SampleCorners(state, bounds), top, &tasks);
+
+    std::vector<Subtree> subtrees(tasks.size());
+    std::atomic<size_t> nextTask = 0;
+    auto worker = [&]() {
+        for (size_t i = nextTask++; i < tasks.size(); i = nextTask++) {
+            subtrees[i].Root = BuildNode(state, tasks[i].Box, tasks[i].Depth, tasks[i].Corners, subtrees[i], nullptr);
+        }
+    };
+
+    if (threadCount == 0) {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < std::min<size_t>(threadCount, tasks.size()); i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    SdfOctree octree;
+    octree.mBounds = bounds;
+    octree.mMaxDepth = maxDepth;
+    octree.mNodes = std::move(top.Nodes);
+    octree.mLeaves = std::move(top.Leaves);
+    const size_t topNodeCount = octree.mNodes.size();
+
+    // Subtrees are appended in task order and their references moved past what's already there
+    std::vector<uint32_t> taskRoots(tasks.size());
+    for (size_t i = 0; i < subtrees.size(); i++) {
+        uint32_t nodeOffset = static_cast<uint32_t>(octree.mNodes.size());
+        uint32_t leafOffset = static_cast<uint32_t>(octree.mLeaves.size());
+        auto relocate = [=](uint32_t node) {
+            return (node & sLeafBit) ? sLeafBit | ((node & ~sLeafBit) + leafOffset) : node + nodeOffset;
+        };
+
+        for (uint32_t node : subtrees[i].Nodes) {
+            octree.mNodes.push_back(relocate(node));
+        }
+        octree.mLeaves.insert(octree.mLeaves.end(), subtrees[i].Leaves.begin(), subtrees[i].Leaves.end());
+        taskRoots[i] = relocate(subtrees[i].Root);
+    }
+
+    auto resolve = [&](uint32_t node) {
+        return !(node & sLeafBit) && (node & sTaskBit) ? taskRoots[node & ~sTaskBit] : node;
+    };
+    for (size_t i = 0; i < topNodeCount; i++) {
+        octree.mNodes[i] = resolve(octree.mNodes[i]);
+    }
+    octree.mRoot = resolve(top.Root);
+    return octree;
+}
+
+float SdfOctree::Distance(const Math::Vec3& p) const
+{
+    Math::Vec3 q;
+    for (unsigned int i = 0; i < 3; i++) {
+        q[i] = std::clamp(p[i], mBounds.Min()[i], mBounds.Max()[i]);
+    }
+
+    Math::AABB box = mBounds;
+    uint32_t node = mRoot;
+    while (!(node & sLeafBit)) {
+        Math::Vec3 center = box.Center();
+        unsigned int octant = (q.x() >= center.x() ? 1 : 0) | (q.y() >= center.y() ? 2 : 0) | (q.z() >= center.z() ? 4 : 0);
+        box = Octant(box, octant);
+        node = mNodes[node + octant];
+    }
+
+    const std::array<float, 8>& corners = mLeaves[node & ~sLeafBit].Corners;
+    Math::Vec3 size = box.Size();
+    float tx = size.x() > 0.0f ? (q.x() - box.Min().x()) / size.x() : 0.0f;
+    float ty = size.y() > 0.0f ? (q.y() - box.Min().y()) / size.y() : 0.0f;
+    float tz = size.z() > 0.0f ? (q.z() - box.Min().z()) / size.z() : 0.0f;
+
+    float bottom = Math::Mix(Math::Mix(corners[0], corners[1], tx), Math::Mix(corners[2], corners[3], tx), ty);
+    float top = Math::Mix(Math::Mix(corners[4], corners[5], tx), Math::Mix(corners[6], corners[7], tx), ty);
+    float dist = Math::Mix(bottom, top, tz);
+
+    float outside = (p - q).Magnitude();
+    return outside > 0.0f ? std::max(outside, dist - outside) : dist;
+}
+
+uint32_t SdfOctree::BuildNode(const BuildState& state, const Math::AABB& box, unsigned int depth, const std::array<float, 8>& corners,
+    Subtree& tree, std::vector<Task>* tasks)
+{
+    if (tasks && depth == sTaskDepth) {
+        tasks->push_back({ box, depth, corners });
+        return sTaskBit | static_cast<uint32_t>(tasks->size() - 1);
+    }
+
+    if (depth < state.MaxDepth) {
+        Math::Interval range = state.Object.DistanceRange(box, state.Context);
+        if (range.Min() <= 0.0f && range.Max() >= 0.0f) {
+            // Lattice of 3^3 points at the children corners, x changes fastest
+            std::array<float, 27> lattice;
+            Math::Vec3 half = box.Size() * 0.5f;
+            for (unsigned int i = 0; i < 27; i++) {
+                unsigned int x = i % 3, y = i / 3 % 3, z = i / 9;
+                if (x != 1 && y != 1 && z != 1) {
+                    lattice[i] = corners[x / 2 | (y / 2) << 1 | (z / 2) << 2];
+                    continue;
+                }
+                Math::Vec3 p = box.Min() + Math::Vec3(x * half.x(), y * half.y(), z * half.z());
+                lattice[i] = state.Object.Distance(p, state.Context);
+            }
+
+            uint32_t first = static_cast<uint32_t>(tree.Nodes.size());
+            tree.Nodes.resize(first + 8);
+            for (unsigned int i = 0; i < 8; i++) {
+                std::array<float, 8> childCorners;
+                for (unsigned int j = 0; j < 8; j++) {
+                    unsigned int x = (i & 1) + (j & 1), y = ((i >> 1) & 1) + ((j >> 1) & 1), z = (i >> 2) + (j >> 2);
+                    childCorners[j] = lattice[(z * 3 + y) * 3 + x];
+                }
+                uint32_t child = BuildNode(state, Octant(box, i), depth + 1, childCorners, tree, tasks);
+                tree.Nodes[first + i] = child;
+            }
+            return first;
+        }
+    }
+
+    tree.Leaves.push_back({ corners });
+    return sLeafBit | static_cast<uint32_t>(tree.Leaves.size() - 1);
+}
+
+std::array<float, 8> SdfOctree::SampleCorners(const BuildState& state, const Math::AABB& box)
+{
+    std::array<float, 8> corners;
+    Math::Vec3 size = box.Size();
+    for (unsigned int i = 0; i < 8; i++) {
+        Math::Vec3 corner = box.Min() + Math::Vec3(i & 1 ? size.x() : 0.0f, (i >> 1) & 1 ? size.y() : 0.0f, i >> 2 ? size.z() : 0.0f);
+        corners[i] = state.Object.Distance(corner, state.Context);
+    }
+    return corners;
+}
+
+Math::AABB SdfOctree::Octant(const Math::AABB& box, unsigned int index)
+{
+    Math::Vec3 half = box.Size() * 0.5f;
+    Math::Vec3 min = box.Min() + Math::Vec3(index & 1 ? half.x() : 0.0f, (index >> 1) & 1 ? half.y() : 0.0f, index >> 2 ? half.z() : 0.0f);
+    return Math::AABB(min, min + half);
+}
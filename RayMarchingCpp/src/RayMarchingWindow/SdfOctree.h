@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "IShapedObject.h"
+#include "Math/Math.h"
+
+/*
+    Adaptive distance field of an object. A cell is split while the object's
+    DistanceRange over it says the surface may pass through it, so cells
+    shrink towards the surface and node count grows with surface area
+    instead of volume. Leaves keep distances at their corners
+    and are interpolated trilinearly. A split cell samples the 27 corners of
+    its children once, so siblings don't evaluate shared corners again.
+    Subtrees below sTaskDepth are built as independent tasks shared between
+    worker threads and merged in a fixed order afterwards
+*/
+class SdfOctree {
+public:
+    /*
+        Leaves of maxDepth have the size of bounds / 2^maxDepth
+    */
+    static SdfOctree Build(const IShapedObject& object, const Math::AABB& bounds, unsigned int maxDepth,
+        const DistanceContext& context, unsigned int threadCount = 0);
+
+    /*
+        Interpolated distance of the leaf containing p. Outside of bounds a
+        lower bound from the closest point of bounds is returned, which holds
+        for objects lying inside bounds
+    */
+    float Distance(const Math::Vec3& p) const;
+
+    const Math::AABB& Bounds() const { return mBounds; }
+    unsigned int MaxDepth() const { return mMaxDepth; }
+    size_t NodeCount() const { return mNodes.size() + 1; }
+    size_t LeafCount() const { return mLeaves.size(); }
+    size_t SizeInBytes() const { return mNodes.size() * sizeof(uint32_t) + mLeaves.size() * sizeof(Leaf); }
+
+    /*
+        Walks the tree from Root(). Children of a node are ordered like leaf
+        corners, Octant gives their boxes
+    */
+    uint32_t Root() const { return mRoot; }
+    static bool IsLeaf(uint32_t node) { return (node & sLeafBit) != 0; }
+    uint32_t Child(uint32_t node, unsigned int index) const { return mNodes[node + index]; }
+    const std::array<float, 8>& Corners(uint32_t leaf) const { return mLeaves[leaf & ~sLeafBit].Corners; }
+    static Math::AABB Octant(const Math::AABB& box, unsigned int index);
+private:
+    struct Leaf {
+        // Corner i is at (i & 1, (i >> 1) & 1, i >> 2) of the cell
+        std::array<float, 8> Corners;
+    };
+
+    /*
+        Tree built from one cell, node references are local to it
+    */
+    struct Subtree {
+        std::vector<uint32_t> Nodes;
+        std::vector<Leaf> Leaves;
+        uint32_t Root = 0;
+    };
+
+    struct Task {
+        Math::AABB Box;
+        unsigned int Depth;
+        std::array<float, 8> Corners;
+    };
+
+    struct BuildState {
+        const IShapedObject& Object;
+        const DistanceContext& Context;
+        unsigned int MaxDepth;
+    };
+
+    /*
+        corners are distances at the box corners, ordered as in Leaf
+    */
+    static uint32_t BuildNode(const BuildState& state, const Math::AABB& box, unsigned int depth, const std::array<float, 8>& corners,
+        Subtree& tree, std::vector<Task>* tasks);
+    static std::array<float, 8> SampleCorners(const BuildState& state, const Math::AABB& box);
+private:
+    // Values of mNodes and mRoot: index of the first of eight children in mNodes, or sLeafBit | index into mLeaves
+    static constexpr uint32_t sLeafBit = 0x80000000;
+    // Placeholder of a subtree that's being built by a task, only exists during Build
+    static constexpr uint32_t sTaskBit = 0x40000000;
+    static constexpr unsigned int sTaskDepth = 2;
+
+    Math::AABB mBounds;
+    unsigned int mMaxDepth = 0;
+    std::vector<uint32_t> mNodes;
+    std::vector<Leaf> mLeaves;
+    uint32_t mRoot = 0;
+};
@@ -0,0 +1,94 @@
+#include "ShapeCode.h"
+
+#include <cstdio>
+#include <unordered_map>
+
+const char* ShapeCode::sGlslAsCppPrelude = R"(#include <cmath>
+
+#ifdef _WIN32
+#define SHAPE_EXPORT extern "C" __declspec(dllexport)
+#else
+#define SHAPE_EXPORT extern "C"
+#endif
+
+namespace glsl {
+
+struct vec3 {
+    float x, y, z;
+};
+
+struct vec4 {
+    float x, y, z, w;
+};
+
+static float u_Time = 0.0f;
+
+static inline float sin(float x) { return std::sin(x); }
+static inline float cos(float x) { return std::cos(x); }
+static inline float sqrt(float x) { return std::sqrt(x); }
+static inline float abs(float x) { return std::abs(x); }
+static inline float min(float x, float y) { return y < x ? y : x; }
+static inline float max(float x, float y) { return x < y ? y : x; }
+static inline float clamp(float x, float minVal, float maxVal) { return min(max(x, minVal), maxVal); }
+static inline float mix(float x, float y, float a) { return x * (1.0f - a) + y * a; }
+
+static inline float smoothstep(float edge0, float edge1, float x)
+{
+    float t = clamp((x - edge0) / (edge1 - edge0), 0.0f, 1.0f);
+    return t * t * (3.0f - 2.0f * t);
+}
+
+)";
+
+std::string ShapeCode::Writer::Declare(const std::string& code)
+{
+    std::string name = "v" + std::to_string(mVariableCount++);
+    mStatements += mIndent + "float " + name + " = " + code + ";\n";
+    return name;
+}
+
+std::string ShapeCode::Writer::Function(const std::string& name) const
+{
+    // GLSL built-ins and the functions of the SceneCompiler prelude computing the same as those of Math
+    static const std::unordered_map<std::string, std::pair<const char*, const char*>> functions = {
+        { "Sin", { "sin", "std::sin" } },
+        { "Cos", { "cos", "std::cos" } },
+        { "Sqrt", { "sqrt", "std::sqrt" } },
+        { "Abs", { "abs", "std::abs" } },
+        { "Min", { "min", "std::min" } },
+        { "Max", { "max", "std::max" } },
+        { "Clamp", { "clamp", "std::clamp" } },
+        { "Mix", { "mix", "Mix" } },
+        { "SmoothStep", { "smoothstep", "SmoothStep" } },
+    };
+    const auto& spellings = functions.at(name);
+    return mLanguage == Language::Glsl ? spellings.first : spellings.second;
+}
+
+std::string ShapeCode::Expression::Literal(float value)
+{
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+    std::string literal(buffer);
+    if (literal.find_first_of(".e") == std::string::npos) {
+        literal += ".0";
+    }
+    return literal + 'f';
+}
+
+ShapeCode::Expression ShapeCode::Expression::Binary(const Expression& a, const char* op, const Expression& b, float value)
+{
+    if (a.IsConstant() && b.IsConstant()) {
+        return Expression(value);
+    }
+    Writer& writer = a.IsConstant() ? *b.mWriter : *a.mWriter;
+    return Expression(writer, writer.Declare(a.Code() + ' ' + op + ' ' + b.Code()));
+}
+
+ShapeCode::Expression ShapeCode::operator-(const Expression& a)
+{
+    if (a.IsConstant()) {
+        return Expression(-a.Value());
+    }
+    return Expression(*a.GetWriter(), a.GetWriter()->Declare('-' + a.Code()));
+}
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <array>
+#include <string>
+
+#include "Math/Math.h"
+
+/*
+    Lets a shape write its distance function once, as
+    template <typename T, typename P> static T Sdf(T x, T y, T z, const std::array<P, 4>& obj, P time)
+    using the operators and functions of this namespace. Evaluated with
+    float for a point, Math::Float4 for four points, Math::Interval for a
+    box and with Expression, which writes every operation down, to get
+    its GLSL definition and its C++ for SceneCompiler. Shapes give
+    sParamCount, 1 passes obj[0] as a float uniform, 4 as a vec4
+*/
+namespace ShapeCode {
+
+    enum class Language {
+        Glsl,
+        Cpp
+    };
+
+    /*
+        Statements of a traced function, each operation declares a new variable
+    */
+    class Writer {
+    public:
+        Writer(Language language, const std::string& indent) : mLanguage(language), mIndent(indent)
+        {
+        }
+
+        /*
+            Declares a float initialized with code and returns its name
+        */
+        std::string Declare(const std::string& code);
+        /*
+            Name of the built-in or helper function of the language, name is the one of this namespace
+        */
+        std::string Function(const std::string& name) const;
+
+        const std::string& Statements() const { return mStatements; }
+    private:
+        Language mLanguage;
+        std::string mIndent;
+        std::string mStatements;
+        unsigned int mVariableCount = 0;
+    };
+
+    /*
+        Float value traced into a Writer. Operations on constants only are
+        folded with the float functions instead of being written
+    */
+    class Expression {
+    public:
+        Expression(float value) : mValue(value)
+        {
+        }
+
+        /*
+            Input of the traced function, such as p.x or a uniform
+        */
+        Expression(Writer& writer, const std::string& code) : mWriter(&writer), mCode(code)
+        {
+        }
+
+        bool IsConstant() const { return mWriter == nullptr; }
+        float Value() const { return mValue; }
+        Writer* GetWriter() const { return mWriter; }
+        std::string Code() const { return IsConstant() ? Literal(mValue) : mCode; }
+
+        /*
+            Float literal valid in GLSL and C++ that reads back as the same float
+        */
+        static std::string Literal(float value);
+
+        /*
+            Writes name(args...) of non-constant args, folds constant ones with fold
+        */
+        template <typename Fold, typename... Args>
+        static Expression Call(const std::string& name, const Fold& fold, const Args&... args)
+        {
+            Writer* writer = nullptr;
+            ((writer = writer ? writer : args.GetWriter()), ...);
+            if (!writer) {
+                return Expression(fold(args.Value()...));
+            }
+            std::string code;
+            ((code += (code.empty() ? "" : ", ") + args.Code()), ...);
+            return Expression(*writer, writer->Declare(writer->Function(name) + '(' + code + ')'));
+        }
+
+        static Expression Binary(const Expression& a, const char* op, const Expression& b, float value);
+    private:
+        Writer* mWriter = nullptr;
+        std::string mCode;
+        float mValue = 0.0f;
+    };
+
+    inline Expression operator+(const Expression& a, const Expression& b) { return Expression::Binary(a, "+", b, a.Value() + b.Value()); }
+    inline Expression operator-(const Expression& a, const Expression& b) { return Expression::Binary(a, "-", b, a.Value() - b.Value()); }
+    inline Expression operator*(const Expression& a, const Expression& b) { return Expression::Binary(a, "*", b, a.Value() * b.Value()); }
+    inline Expression operator/(const Expression& a, const Expression& b) { return Expression::Binary(a, "/", b, a.Value() / b.Value()); }
+    Expression operator-(const Expression& a);
+
+    /*
+        Functions of float, Float4 and Interval
+    */
+    inline float Sin(float x) { return std::sin(x); }
+    inline float Cos(float x) { return std::cos(x); }
+    using Math::Sin;
+    using Math::Cos;
+    using Math::Sqrt;
+    using Math::Abs;
+    using Math::Min;
+    using Math::Max;
+    using Math::Square;
+    using Math::Clamp;
+    using Math::Mix;
+    using Math::SmoothStep;
+
+    template <typename T>
+    inline T Square(const T& x)
+    {
+        return x * x;
+    }
+
+    /*
+        Same as std::clamp
+    */
+    template <typename T>
+    inline T Clamp(const T& x, float min, float max)
+    {
+        return Min(Max(x, T(min)), T(max));
+    }
+
+    template <typename T>
+    inline T Mix(const T& x, const T& y, const T& a)
+    {
+        return x + (y - x) * a;
+    }
+
+    template <typename T>
+    inline T SmoothStep(float edge0, float edge1, const T& x)
+    {
+        T t = Clamp((x - edge0) / (edge1 - edge0), 0.0f, 1.0f);
+        return t * t * (3.0f - 2.0f * t);
+    }
+
+    /*
+        Expression counterparts, written as GLSL built-ins or their C++ equivalents
+    */
+    inline Expression Sin(const Expression& x) { return Expression::Call("Sin", [](float v) { return Sin(v); }, x); }
+    inline Expression Cos(const Expression& x) { return Expression::Call("Cos", [](float v) { return Cos(v); }, x); }
+    inline Expression Sqrt(const Expression& x) { return Expression::Call("Sqrt", [](float v) { return Sqrt(v); }, x); }
+    inline Expression Abs(const Expression& x) { return Expression::Call("Abs", [](float v) { return Abs(v); }, x); }
+    inline Expression Min(const Expression& a, const Expression& b)
+    {
+        return Expression::Call("Min", [](float u, float v) { return Min(u, v); }, a, b);
+    }
+    inline Expression Max(const Expression& a, const Expression& b)
+    {
+        return Expression::Call("Max", [](float u, float v) { return Max(u, v); }, a, b);
+    }
+    inline Expression Clamp(const Expression& x, float min, float max)
+    {
+        return Expression::Call("Clamp", [](float v, float low, float high) { return Clamp(v, low, high); }, x, Expression(min), Expression(max));
+    }
+    inline Expression Mix(const Expression& x, const Expression& y, const Expression& a)
+    {
+        return Expression::Call("Mix", [](float u, float v, float t) { return Mix(u, v, t); }, x, y, a);
+    }
+    inline Expression SmoothStep(const Expression& edge0, const Expression& edge1, const Expression& x)
+    {
+        return Expression::Call("SmoothStep", [](float e0, float e1, float v) { return SmoothStep(e0, e1, v); }, edge0, edge1, x);
+    }
+
+    /*
+        Distance to a box centered at origin with half extents size, same as Math::BoxDistance
+    */
+    template <typename T, typename P>
+    inline T BoxDistance(const T& x, const T& y, const T& z, const P& sizeX, const P& sizeY, const P& sizeZ)
+    {
+        T dx = Abs(x) - sizeX;
+        T dy = Abs(y) - sizeY;
+        T dz = Abs(z) - sizeZ;
+        T ox = Max(dx, T(0.0f));
+        T oy = Max(dy, T(0.0f));
+        T oz = Max(dz, T(0.0f));
+        return Min(Max(dx, Max(dy, dz)), T(0.0f)) + Sqrt(ox * ox + oy * oy + oz * oz);
+    }
+
+    /*
+        float name(vec3 p, float|vec4 obj) of Shape::Sdf, reading u_Time
+    */
+    template <typename Shape>
+    std::string GlslDefinition(const std::string& name)
+    {
+        Writer writer(Language::Glsl, "    ");
+        std::array<Expression, 4> obj = { 0.0f, 0.0f, 0.0f, 0.0f };
+        const char* components[] = { ".x", ".y", ".z", ".w" };
+        for (unsigned int i = 0; i < Shape::sParamCount; i++) {
+            obj[i] = Expression(writer, Shape::sParamCount == 1 ? "obj" : std::string("obj") + components[i]);
+        }
+        Expression p[] = { Expression(writer, "p.x"), Expression(writer, "p.y"), Expression(writer, "p.z") };
+        Expression dist = Shape::Sdf(p[0], p[1], p[2], obj, Expression(writer, "u_Time"));
+        return "float " + name + "(vec3 p, " + (Shape::sParamCount == 1 ? "float" : "vec4") + " obj)\n{\n" +
+            writer.Statements() + "    return " + dist.Code() + ";\n}\n";
+    }
+
+    /*
+        Body of Shape::Sdf with obj written in for CppSceneSource::AddFunction
+    */
+    template <typename Shape>
+    std::string CppBody(const std::array<float, 4>& obj)
+    {
+        Writer writer(Language::Cpp, "");
+        std::array<Expression, 4> constants = { obj[0], obj[1], obj[2], obj[3] };
+        Expression p[] = { Expression(writer, "p.x"), Expression(writer, "p.y"), Expression(writer, "p.z") };
+        Expression dist = Shape::Sdf(p[0], p[1], p[2], constants, Expression(writer, "c.Time"));
+        return writer.Statements() + "return " + dist.Code() + ';';
+    }
+
+    /*
+        Declarations that compile the GLSL of GlslDefinition as C++ in
+        namespace glsl, with built-ins computed as the GLSL specification
+        defines them, to check it against the native code
+    */
+    extern const char* sGlslAsCppPrelude;
+
+}
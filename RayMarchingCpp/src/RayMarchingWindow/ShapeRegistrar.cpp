@@ -4,35 +4,140 @@
 
 std::string_view ShapeRegistrar::sUniformMarker = "/*<uniforms>*/";
 std::string_view ShapeRegistrar::sDistFunctionsMarker = "/*<dist_functions>*/";
+std::string_view ShapeRegistrar::sSceneFunctionsMarker = "/*<scene_functions>*/";
+std::string_view ShapeRegistrar::sObjectDistFunctionCodeMarker = "/*<object_dist_code>*/";
 std::string_view ShapeRegistrar::sSceneDistFunctionCodeMarker = "/*<scene_dist_code>*/";
+std::string_view ShapeRegistrar::sMarchedDistFunctionCodeMarker = "/*<marched_dist_code>*/";
+std::string_view ShapeRegistrar::sAnalyticHitCodeMarker = "/*<analytic_hit_code>*/";
 
 void ShapeRegistrar::RegisterObjects(const std::vector<std::shared_ptr<IShapedObject>>& objects, OpenGL::ShaderSource& source)
 {
+	mRegisteredFunctions.clear();
+	mMarchedFunctions.clear();
+	mAnalyticCode.clear();
+	mAnalyticCount = 0;
+	mAnalyticGridObjects.clear();
+	mGridObjects.clear();
+	mGridInstancedObjects.clear();
+
+	size_t boundedCount = 0;
+	for (const std::shared_ptr<IShapedObject>& obj : objects) {
+		if (auto instanced = std::dynamic_pointer_cast<IInstancedObject>(obj)) {
+			boundedCount += instanced->InstanceCount();
+		} else if (obj->Bounds()) {
+			boundedCount++;
+		}
+	}
+	bool useGrid = boundedCount >= mGridThreshold;
+	std::string objectCases;
+	std::string groupCases;
+	// The grid is marched if anything in it has no closed form intersection
+	bool marchGrid = false;
+
 	for (unsigned int i = 0; i < objects.size(); i++) {
 		std::shared_ptr<IShapedObject> obj = objects[i];
 		std::string uniforms = obj->UniformsDefinitions() + '\n' + sUniformMarker.data();
 
 		source.Substitute(sUniformMarker, uniforms);
-		mRegisteredFunctions.push_front(obj->DistFunctionCall("cameraPos"));
+		source.Substitute(sSceneFunctionsMarker, obj->SceneFunctionsDefinitions() + sSceneFunctionsMarker.data());
+
+		std::string hitCall = obj->RayHitCall("ro", "rd");
+		if (!hitCall.empty()) {
+			mAnalyticCode = mAnalyticCode.empty() ? hitCall : "min(" + mAnalyticCode + ", " + hitCall + ")";
+			mAnalyticCount++;
+		}
+
+		auto instanced = std::dynamic_pointer_cast<IInstancedObject>(obj);
+		bool inGrid = useGrid && (instanced || obj->Bounds());
+		if (inGrid && instanced) {
+			mGridInstancedObjects.push_back(instanced);
+			groupCases += "\tcase " + std::to_string(mGridInstancedObjects.size()) + ": return " + instanced->InstanceDistFunctionCall("index", "p") + ";\n";
+		} else if (inGrid) {
+			objectCases += "\t\tcase " + std::to_string(mGridObjects.size()) + ": return " + obj->DistFunctionCall("p") + ";\n";
+			mGridObjects.push_back(obj);
+		} else {
+			mRegisteredFunctions.push_front(obj->DistFunctionCall("cameraPos"));
+			if (hitCall.empty()) {
+				mMarchedFunctions.push_front(mRegisteredFunctions.front());
+			}
+		}
+
+		if (inGrid && hitCall.empty()) {
+			marchGrid = true;
+		} else if (inGrid) {
+			mAnalyticGridObjects.push_back(obj);
+		}
+	}
+
+	if (UsesGrid()) {
+		if (!objectCases.empty()) {
+			groupCases = "\tcase 0:\n\t\tswitch (index) {\n" + objectCases + "\t\t}\n\t\tbreak;\n" + groupCases;
+		}
+		source.Substitute(sObjectDistFunctionCodeMarker, "int index = id & " + std::to_string((1u << sGridIndexBits) - 1) + ";\n"
+			"\tswitch (id >> " + std::to_string(sGridIndexBits) + ") {\n" + groupCases + "\t}");
+		mRegisteredFunctions.push_front("GetGridDistance(cameraPos)");
+		if (marchGrid) {
+			mMarchedFunctions.push_front(mRegisteredFunctions.front());
+		}
+	}
+}
+
+size_t ShapeRegistrar::AnalyticGridEntries() const
+{
+	size_t entries = 0;
+	for (const std::shared_ptr<IShapedObject>& obj : mAnalyticGridObjects) {
+		auto instanced = std::dynamic_pointer_cast<IInstancedObject>(obj);
+		entries += instanced ? instanced->InstanceCount() : 1;
+	}
+	return entries;
+}
+
+void ShapeRegistrar::GridEntries(std::vector<Math::AABB>& bounds, std::vector<int32_t>& ids) const
+{
+	bounds.clear();
+	ids.clear();
+
+	for (unsigned int i = 0; i < mGridObjects.size(); i++) {
+		bounds.push_back(*mGridObjects[i]->Bounds());
+		ids.push_back(GridId(0, i));
+	}
+	for (unsigned int group = 0; group < mGridInstancedObjects.size(); group++) {
+		const IInstancedObject& instanced = *mGridInstancedObjects[group];
+		for (unsigned int i = 0; i < instanced.InstanceCount(); i++) {
+			bounds.push_back(instanced.InstanceBounds(i));
+			ids.push_back(GridId(group + 1, i));
+		}
 	}
 }
 
 void ShapeRegistrar::GenerateSceneDistanceFunction(OpenGL::ShaderSource& source)
 {
 	if (!mRegisteredFunctions.empty()) {
-		std::stack<std::string> functionStack(mRegisteredFunctions);
+		source.Substitute(sSceneDistFunctionCodeMarker, "return " + UnionCode(mRegisteredFunctions) + ';');
+	}
+	if (mAnalyticCount == 0) {
+		source.Substitute(sMarchedDistFunctionCodeMarker, "return GetSceneDistance(cameraPos);");
+		return;
+	}
+	source.Substitute(sAnalyticHitCodeMarker, "return " + mAnalyticCode + ';');
+	if (!mMarchedFunctions.empty()) {
+		source.Substitute(sMarchedDistFunctionCodeMarker, "return " + UnionCode(mMarchedFunctions) + ';');
+	}
+}
+
+std::string ShapeRegistrar::UnionCode(const std::deque<std::string>& functions)
+{
+	std::stack<std::string> functionStack(functions);
 
-		while (true) {
-			std::string func1 = functionStack.top();
-			functionStack.pop();
+	while (true) {
+		std::string func1 = functionStack.top();
+		functionStack.pop();
 
-			if (functionStack.empty()) {
-				source.Substitute(sSceneDistFunctionCodeMarker, "return " + func1 + ';');
-				return;
-			}
-			std::string func2 = functionStack.top();
-			functionStack.pop();
-			functionStack.push("smin("+func1+','+func2+", u_SmoothMinValue)");
+		if (functionStack.empty()) {
+			return func1;
 		}
+		std::string func2 = functionStack.top();
+		functionStack.pop();
+		functionStack.push("smin("+func1+','+func2+", u_SmoothMinValue)");
 	}
 }
@@ -1,10 +1,13 @@
 #pragma once
 
+#include <cstdint>
 #include <deque>
 #include <memory>
 #include <string_view>
+#include <vector>
 
 #include "IShapedObject.h"
+#include "IInstancedObject.h"
 #include "OpenGL/ShaderSource.h"
 
 class ShapeRegistrar {
@@ -15,11 +18,52 @@ public:
 		source.Substitute(sDistFunctionsMarker, ShapeType::DistFunctionDefinition() + '\n' + sDistFunctionsMarker.data());
 	}
 
+	/*
+		Bounded objects and instances of instanced objects are placed into the
+		object grid once there are at least GridThreshold() of them, the rest
+		are always evaluated. Instanced objects outside the grid loop over
+		their instances. Objects with a RayHitCall are also intersected by
+		GetAnalyticHit and left out of GetMarchedDistance, which rays march
+		instead of GetSceneDistance while unions are hard
+	*/
 	void RegisterObjects(const std::vector<std::shared_ptr<IShapedObject>>& objects, OpenGL::ShaderSource& source);
 	void GenerateSceneDistanceFunction(OpenGL::ShaderSource& source);
+
+	void SetGridThreshold(size_t threshold) { mGridThreshold = threshold; }
+	size_t GridThreshold() const { return mGridThreshold; }
+	bool UsesGrid() const { return !mGridObjects.empty() || !mGridInstancedObjects.empty(); }
+	size_t AnalyticCount() const { return mAnalyticCount; }
+	/*
+		Objects and instances of GetAnalyticHit that are in the object grid.
+		A ray intersects all of them, so it pays off only for a few
+	*/
+	size_t AnalyticGridEntries() const;
+	/*
+		Current boxes of everything evaluated through GetGridDistance and their
+		ids in shader. Instance counts may change without registering again
+	*/
+	void GridEntries(std::vector<Math::AABB>& bounds, std::vector<int32_t>& ids) const;
+private:
+	// Shader id keeps object group in the high bits: 0 for single objects,
+	// 1 + n for n-th instanced object, instance index in the low bits
+	static int32_t GridId(unsigned int group, unsigned int index) { return static_cast<int32_t>((group << sGridIndexBits) | index); }
+	static std::string UnionCode(const std::deque<std::string>& functions);
 private:
+	static constexpr unsigned int sGridIndexBits = 24;
+
 	std::deque<std::string> mRegisteredFunctions;
+	std::deque<std::string> mMarchedFunctions;
+	std::string mAnalyticCode;
+	size_t mAnalyticCount = 0;
+	std::vector<std::shared_ptr<IShapedObject>> mAnalyticGridObjects;
+	std::vector<std::shared_ptr<IShapedObject>> mGridObjects;
+	std::vector<std::shared_ptr<IInstancedObject>> mGridInstancedObjects;
+	size_t mGridThreshold = 8;
 	static std::string_view sUniformMarker;
 	static std::string_view sDistFunctionsMarker;
+	static std::string_view sSceneFunctionsMarker;
+	static std::string_view sObjectDistFunctionCodeMarker;
 	static std::string_view sSceneDistFunctionCodeMarker;
+	static std::string_view sMarchedDistFunctionCodeMarker;
+	static std::string_view sAnalyticHitCodeMarker;
 };
\ No newline at end of file
@@ -0,0 +1,68 @@
+#include "SharedLibrary.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+#ifdef _WIN32
+
+std::unique_ptr<SharedLibrary> SharedLibrary::Open(const std::string& path)
+{
+    HMODULE handle = LoadLibraryA(path.c_str());
+    if (!handle) {
+        return nullptr;
+    }
+    std::unique_ptr<SharedLibrary> library(new SharedLibrary());
+    library->mHandle = handle;
+    return library;
+}
+
+SharedLibrary::~SharedLibrary()
+{
+    FreeLibrary(static_cast<HMODULE>(mHandle));
+}
+
+void* SharedLibrary::Symbol(const std::string& name) const
+{
+    return reinterpret_cast<void*>(GetProcAddress(static_cast<HMODULE>(mHandle), name.c_str()));
+}
+
+const char* SharedLibrary::Extension()
+{
+    return ".dll";
+}
+
+#else
+
+std::unique_ptr<SharedLibrary> SharedLibrary::Open(const std::string& path)
+{
+    // RTLD_LOCAL keeps symbols of libraries built from different scenes apart
+    void* handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        return nullptr;
+    }
+    std::unique_ptr<SharedLibrary> library(new SharedLibrary());
+    library->mHandle = handle;
+    return library;
+}
+
+SharedLibrary::~SharedLibrary()
+{
+    dlclose(mHandle);
+}
+
+void* SharedLibrary::Symbol(const std::string& name) const
+{
+    return dlsym(mHandle, name.c_str());
+}
+
+const char* SharedLibrary::Extension()
+{
+    return ".so";
+}
+
+#endif
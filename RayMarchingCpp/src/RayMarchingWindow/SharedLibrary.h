@@ -0,0 +1,32 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+/*
+    Shared library loaded at runtime, a .dll on Windows and a .so
+    elsewhere. Unloaded on destruction, so function pointers taken from it
+    must not outlive it
+*/
+class SharedLibrary {
+public:
+    /*
+        Returns nullptr if the library can't be loaded
+    */
+    static std::unique_ptr<SharedLibrary> Open(const std::string& path);
+
+    SharedLibrary(const SharedLibrary&) = delete;
+    SharedLibrary& operator=(const SharedLibrary&) = delete;
+    ~SharedLibrary();
+
+    /*
+        Address of an exported extern "C" symbol, nullptr if there's none
+    */
+    void* Symbol(const std::string& name) const;
+
+    static const char* Extension();
+private:
+    SharedLibrary() = default;
+private:
+    void* mHandle = nullptr;
+};
@@ -0,0 +1,92 @@
+#include "StartupProfiler.h"
+
+#include <algorithm>
+#include <cstdio>
+
+StartupProfiler::Scope::Scope(StartupProfiler& profiler, std::string name)
+    : mProfiler(profiler), mName(std::move(name)), mStart(std::chrono::steady_clock::now())
+{
+}
+
+StartupProfiler::Scope::~Scope()
+{
+    mProfiler.Record(std::move(mName), mStart, std::chrono::steady_clock::now());
+}
+
+StartupProfiler::StartupProfiler() : mStart(std::chrono::steady_clock::now()), mMainThread(std::this_thread::get_id())
+{
+}
+
+void StartupProfiler::Record(std::string name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+{
+    Phase phase;
+    phase.Name = std::move(name);
+    phase.StartMilliseconds = std::chrono::duration<double, std::milli>(start - mStart).count();
+    phase.Milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+    phase.MainThread = std::this_thread::get_id() == mMainThread;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mFirstFrameMarked) {
+        mPhases.push_back(std::move(phase));
+    }
+}
+
+void StartupProfiler::MarkFirstFrame()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mFirstFrameMarked) {
+        mFirstFrameMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mStart).count();
+        mFirstFrameMarked = true;
+    }
+}
+
+bool StartupProfiler::FirstFrameMarked() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mFirstFrameMarked;
+}
+
+double StartupProfiler::FirstFrameMilliseconds() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mFirstFrameMilliseconds;
+}
+
+double StartupProfiler::JobMilliseconds() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    double milliseconds = 0.0;
+    for (const Phase& phase : mPhases) {
+        if (!phase.MainThread) {
+            milliseconds += phase.Milliseconds;
+        }
+    }
+    return milliseconds;
+}
+
+std::vector<StartupProfiler::Phase> StartupProfiler::Phases() const
+{
+    std::vector<Phase> phases;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        phases = mPhases;
+    }
+    // Nested phases end before the ones around them, so they're recorded first
+    std::stable_sort(phases.begin(), phases.end(), [](const Phase& a, const Phase& b) {
+        return a.StartMilliseconds < b.StartMilliseconds;
+    });
+    return phases;
+}
+
+void StartupProfiler::Report(std::ostream& out) const
+{
+    char line[160];
+    for (const Phase& phase : Phases()) {
+        std::snprintf(line, sizeof(line), "[Startup] %-36s %8.2f ms, from %8.2f ms%s\n", phase.Name.c_str(), phase.Milliseconds,
+            phase.StartMilliseconds, phase.MainThread ? "" : " on a job thread");
+        out << line;
+    }
+    std::snprintf(line, sizeof(line), "[Startup] first frame after %.2f ms, jobs took %.2f ms next to the main thread\n",
+        FirstFrameMilliseconds(), JobMilliseconds());
+    out << line;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+    Times the phases between the start of the program and its first
+    finished frame. Phases may run on job threads at the same time as
+    those of the main thread, so the report shows where each of them
+    started as well as how long it took
+*/
+class StartupProfiler {
+public:
+    struct Phase {
+        std::string Name;
+        // From the construction of the profiler
+        double StartMilliseconds = 0.0;
+        double Milliseconds = 0.0;
+        bool MainThread = true;
+    };
+
+    /*
+        Records its phase when destroyed
+    */
+    class Scope {
+    public:
+        Scope(StartupProfiler& profiler, std::string name);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        StartupProfiler& mProfiler;
+        std::string mName;
+        std::chrono::steady_clock::time_point mStart;
+    };
+public:
+    /*
+        The thread constructing the profiler is the main one
+    */
+    StartupProfiler();
+
+    StartupProfiler(const StartupProfiler&) = delete;
+    StartupProfiler& operator=(const StartupProfiler&) = delete;
+
+    Scope Measure(std::string name) { return Scope(*this, std::move(name)); }
+    /*
+        Phases ending after the first frame aren't part of the startup and
+        are ignored
+    */
+    void Record(std::string name, std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end);
+
+    /*
+        Only the first call counts
+    */
+    void MarkFirstFrame();
+    bool FirstFrameMarked() const;
+    /*
+        Time to the first frame, zero until it's marked
+    */
+    double FirstFrameMilliseconds() const;
+    /*
+        Sum of the phases of the job threads, which ran next to the main one
+    */
+    double JobMilliseconds() const;
+    std::vector<Phase> Phases() const;
+
+    void Report(std::ostream& out) const;
+private:
+    std::chrono::steady_clock::time_point mStart;
+    std::thread::id mMainThread;
+    mutable std::mutex mMutex;
+    std::vector<Phase> mPhases;
+    double mFirstFrameMilliseconds = 0.0;
+    bool mFirstFrameMarked = false;
+};
@@ -0,0 +1,376 @@
+#include "TileCoordinator.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+#endif
+
+namespace {
+
+    double Since(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+}
+
+TileCoordinator::TileCoordinator(const Settings& settings)
+    : mSettings(settings)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    if (mSettings.Executable.empty()) {
+        mSettings.Executable = CurrentExecutable();
+    }
+    mSettings.Pipeline = std::max(mSettings.Pipeline, 1u);
+    mWorkers.resize(std::max(mSettings.Workers, 1u));
+    std::vector<bool> started(mWorkers.size());
+    for (unsigned int i = 0; i < mWorkers.size(); i++) {
+        started[i] = StartWorker(mWorkers[i], i);
+        if (!started[i]) {
+            std::cerr << "[Error] TileCoordinator: can't start '" << mSettings.Executable << "'\n";
+        }
+    }
+
+    // Workers accept connections once their window and scene are set up
+    for (unsigned int i = 0; i < mWorkers.size(); i++) {
+        Worker& worker = mWorkers[i];
+        while (started[i] && !worker.Alive && Since(start) < mSettings.StartTimeoutMilliseconds) {
+            worker.Client = std::make_unique<RenderClient>(worker.Address);
+            worker.Alive = worker.Client->IsConnected();
+            if (!worker.Alive) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            }
+        }
+        if (!worker.Alive) {
+            std::cerr << "[Error] TileCoordinator: worker on " << worker.Address << " doesn't accept connections\n";
+        }
+    }
+    mStartMilliseconds = Since(start);
+}
+
+TileCoordinator::~TileCoordinator()
+{
+    for (Worker& worker : mWorkers) {
+        if (worker.Alive) {
+            worker.Client->Send("shutdown");
+        }
+    }
+    for (Worker& worker : mWorkers) {
+        StopWorker(worker, false);
+    }
+}
+
+unsigned int TileCoordinator::ConnectedWorkers() const
+{
+    return static_cast<unsigned int>(std::count_if(mWorkers.begin(), mWorkers.end(), [](const Worker& worker) { return worker.Alive; }));
+}
+
+std::string TileCoordinator::CurrentExecutable()
+{
+#ifdef _WIN32
+    char path[MAX_PATH];
+    DWORD size = GetModuleFileNameA(nullptr, path, MAX_PATH);
+    return std::string(path, size);
+#else
+    std::error_code error;
+    std::filesystem::path path = std::filesystem::read_symlink("/proc/self/exe", error);
+    return error ? std::string() : path.string();
+#endif
+}
+
+bool TileCoordinator::StartWorker(Worker& worker, unsigned int index)
+{
+#ifdef _WIN32
+    worker.Address = "tcp:" + std::to_string(mSettings.BasePort + index);
+    std::string commandLine = "\"" + mSettings.Executable + "\" --serve " + worker.Address;
+    STARTUPINFOA startup = {};
+    startup.cb = sizeof(startup);
+    PROCESS_INFORMATION process = {};
+    if (!CreateProcessA(mSettings.Executable.c_str(), commandLine.data(), nullptr, nullptr, FALSE, CREATE_NO_WINDOW, nullptr, nullptr,
+        &startup, &process)) {
+        return false;
+    }
+    CloseHandle(process.hThread);
+    worker.Process = process.hProcess;
+    return true;
+#else
+    std::error_code error;
+    std::filesystem::create_directories(mSettings.SocketDirectory, error);
+    worker.Address = (std::filesystem::path(mSettings.SocketDirectory) /
+        ("tiles_" + std::to_string(getpid()) + "_" + std::to_string(index) + ".sock")).string();
+
+    // Logs of workers would interleave with ours, only their errors are kept
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    std::string serve = "--serve";
+    char* arguments[] = { mSettings.Executable.data(), serve.data(), worker.Address.data(), nullptr };
+    pid_t process = -1;
+    int result = posix_spawn(&process, mSettings.Executable.c_str(), &actions, nullptr, arguments, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    if (result != 0) {
+        return false;
+    }
+    worker.Process = process;
+    return true;
+#endif
+}
+
+void TileCoordinator::StopWorker(Worker& worker, bool terminate)
+{
+    worker.Client.reset();
+    worker.Alive = false;
+#ifdef _WIN32
+    if (!worker.Process) {
+        return;
+    }
+    if (WaitForSingleObject(worker.Process, terminate ? 0 : static_cast<DWORD>(sExitTimeoutMilliseconds)) != WAIT_OBJECT_0) {
+        TerminateProcess(worker.Process, 1);
+    }
+    CloseHandle(worker.Process);
+    worker.Process = nullptr;
+#else
+    if (worker.Process < 0) {
+        return;
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    while (waitpid(worker.Process, nullptr, WNOHANG) == 0) {
+        if (terminate || Since(start) > sExitTimeoutMilliseconds) {
+            // Stuck or stopped workers are killed, SIGKILL ends stopped processes as well
+            kill(worker.Process, SIGKILL);
+            waitpid(worker.Process, nullptr, 0);
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    worker.Process = -1;
+    std::remove(worker.Address.c_str());
+#endif
+}
+
+std::optional<std::vector<uint8_t>> TileCoordinator::Render(const Frame& frame, Stats* stats)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    FrameState state;
+    state.Target = &frame;
+    const unsigned int tileSize = std::max(mSettings.TileSize, 1u);
+    for (unsigned int y = 0; y < frame.Height; y += tileSize) {
+        for (unsigned int x = 0; x < frame.Width; x += tileSize) {
+            Tile tile;
+            tile.X = x;
+            tile.Y = y;
+            tile.Width = std::min(tileSize, frame.Width - x);
+            tile.Height = std::min(tileSize, frame.Height - y);
+            state.Pending.push_back(state.Tiles.size());
+            state.Tiles.push_back(tile);
+        }
+    }
+    state.Image.resize(static_cast<size_t>(frame.Width) * frame.Height * 4);
+    state.Result.Tiles = static_cast<unsigned int>(state.Tiles.size());
+    state.Result.WorkerTiles.assign(mWorkers.size(), 0);
+    state.Finished = state.Tiles.empty();
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < mWorkers.size(); i++) {
+        if (mWorkers[i].Alive) {
+            mWorkers[i].Busy = true;
+            state.Running++;
+            state.Alive++;
+            threads.emplace_back(&TileCoordinator::Work, this, i, std::ref(state));
+        }
+    }
+    if (state.Alive == 0) {
+        state.Finished = state.Failed = true;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(state.Mutex);
+        state.Changed.wait(lock, [&]() { return state.Finished; });
+        state.Result.Milliseconds = Since(start);
+        // Workers still rendering tiles someone else finished get a while to answer, then they're given up
+        double drain = std::max(sMinDrainMilliseconds, mSettings.SlowFactor * state.TileMilliseconds / std::max<size_t>(state.DoneCount, 1));
+        if (!state.Changed.wait_for(lock, std::chrono::duration<double, std::milli>(drain), [&]() { return state.Running == 0; })) {
+            for (Worker& worker : mWorkers) {
+                if (worker.Busy) {
+                    worker.Client->Disconnect();
+                }
+            }
+        }
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    for (Worker& worker : mWorkers) {
+        if (worker.Client && !worker.Alive) {
+            state.Result.LostWorkers++;
+            StopWorker(worker, true);
+        }
+    }
+
+    state.Result.MeanTileMilliseconds = state.TileMilliseconds / std::max<size_t>(state.DoneCount, 1);
+    if (stats) {
+        *stats = state.Result;
+    }
+    if (state.Failed) {
+        return std::nullopt;
+    }
+    return std::move(state.Image);
+}
+
+void TileCoordinator::Work(size_t workerIndex, FrameState& state)
+{
+    struct Sent {
+        size_t Tile;
+        std::chrono::steady_clock::time_point Start;
+        bool Reassigned;
+    };
+
+    Worker& worker = mWorkers[workerIndex];
+    const Frame& frame = *state.Target;
+    std::unordered_map<uint64_t, Sent> sent;
+    std::vector<std::pair<uint64_t, size_t>> sending;
+    std::unique_lock<std::mutex> lock(state.Mutex);
+    while (!sent.empty() || !state.Finished) {
+        sending.clear();
+        while (!state.Finished && sent.size() + sending.size() < mSettings.Pipeline) {
+            std::optional<size_t> tile = NextTile(state, sent.empty() && sending.empty());
+            if (!tile) {
+                break;
+            }
+            sending.emplace_back(worker.NextNumber++, *tile);
+        }
+        if (sent.empty() && sending.empty()) {
+            state.Changed.wait_for(lock, sIdlePoll);
+            continue;
+        }
+        for (const auto& [number, index] : sending) {
+            sent[number] = { index, std::chrono::steady_clock::now(), state.Tiles[index].InFlight > 1 };
+        }
+        lock.unlock();
+
+        bool connected = true;
+        for (const auto& [number, index] : sending) {
+            const Tile& tile = state.Tiles[index];
+            std::ostringstream line;
+            line << "render " << frame.Scene << ' ' << frame.Width << ' ' << frame.Height << ' ' << frame.Time << ' ' << frame.Camera.x()
+                << ' ' << frame.Camera.y() << ' ' << frame.Camera.z() << ' ' << frame.RotationY << ' ';
+            if (frame.Tier >= 0) {
+                line << frame.Tier << ' ';
+            }
+            line << "rgba tile " << tile.X << ' ' << tile.Y << ' ' << tile.Width << ' ' << tile.Height;
+            connected = connected && worker.Client->Send(line.str());
+        }
+        std::optional<RenderClient::Answer> answer = connected ? worker.Client->Receive() : std::nullopt;
+        lock.lock();
+
+        auto request = answer ? sent.find(answer->Number) : sent.end();
+        if (request == sent.end()) {
+            // Gone, stopped by Render or answering out of protocol: its tiles go to the others
+            worker.Alive = false;
+            for (const auto& [number, rendering] : sent) {
+                Release(state, rendering.Tile);
+            }
+            sent.clear();
+            if (--state.Alive == 0 && !state.Finished) {
+                state.Finished = state.Failed = true;
+            }
+            state.Changed.notify_all();
+            break;
+        }
+        Sent rendered = request->second;
+        sent.erase(request);
+        Tile& tile = state.Tiles[rendered.Tile];
+        tile.InFlight--;
+        if (tile.Done) {
+            continue;
+        }
+        if (!answer->Ok || answer->Data.size() != static_cast<size_t>(tile.Width) * tile.Height * 4) {
+            std::cerr << "[Error] TileCoordinator: tile at " << tile.X << ", " << tile.Y << ": " << answer->Message << '\n';
+            if (++tile.Failures >= sMaxTileFailures) {
+                state.Finished = state.Failed = true;
+            } else if (tile.InFlight == 0) {
+                state.Pending.push_front(rendered.Tile);
+            }
+            state.Changed.notify_all();
+            continue;
+        }
+
+        // Answers go top to bottom, the frame bottom to top
+        const size_t rowSize = static_cast<size_t>(tile.Width) * 4;
+        for (unsigned int row = 0; row < tile.Height; row++) {
+            size_t frameRow = frame.Height - 1 - (tile.Y + row);
+            std::memcpy(state.Image.data() + (frameRow * frame.Width + tile.X) * 4, answer->Data.data() + row * rowSize, rowSize);
+        }
+        tile.Done = true;
+        state.DoneCount++;
+        state.TileMilliseconds += Since(rendered.Start);
+        state.Result.WorkerTiles[workerIndex]++;
+        state.Result.ReassignedWon += rendered.Reassigned ? 1 : 0;
+        if (state.DoneCount == state.Tiles.size()) {
+            state.Finished = true;
+        }
+        state.Changed.notify_all();
+    }
+    worker.Busy = false;
+    state.Running--;
+    state.Changed.notify_all();
+}
+
+std::optional<size_t> TileCoordinator::NextTile(FrameState& state, bool idle) const
+{
+    if (!state.Pending.empty()) {
+        size_t index = state.Pending.front();
+        state.Pending.pop_front();
+        state.Tiles[index].InFlight++;
+        state.Tiles[index].Started = std::chrono::steady_clock::now();
+        return index;
+    }
+    // Slow tiles are judged against tiles already done, and only workers with nothing to do take them
+    if (!idle || state.DoneCount == 0) {
+        return std::nullopt;
+    }
+    std::chrono::duration<double, std::milli> limit(mSettings.SlowFactor * state.TileMilliseconds / state.DoneCount);
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    std::optional<size_t> slowest;
+    for (size_t i = 0; i < state.Tiles.size(); i++) {
+        const Tile& tile = state.Tiles[i];
+        if (tile.Done || tile.Reassigned || tile.InFlight != 1 || now - tile.Started < limit) {
+            continue;
+        }
+        if (!slowest || tile.Started < state.Tiles[*slowest].Started) {
+            slowest = i;
+        }
+    }
+    if (slowest) {
+        state.Tiles[*slowest].Reassigned = true;
+        state.Tiles[*slowest].InFlight++;
+        state.Result.Reassigned++;
+    }
+    return slowest;
+}
+
+void TileCoordinator::Release(FrameState& state, size_t tile) const
+{
+    Tile& released = state.Tiles[tile];
+    released.InFlight--;
+    if (!released.Done && released.InFlight == 0) {
+        state.Pending.push_front(tile);
+    }
+}
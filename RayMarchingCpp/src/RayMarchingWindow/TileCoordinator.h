@@ -0,0 +1,162 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "RenderServer.h"
+#include "Math/Math.h"
+
+/*
+    Renders stills too large for one process as tiles shared between
+    worker processes, each a RenderServer of this executable started with
+    --serve on a socket of its own. Workers take the next tile whenever
+    they answer one, so faster workers render more of the frame. A tile
+    that takes much longer than the mean tile is rendered again by an idle
+    worker and the first answer wins, tiles of a worker that exits go back
+    to the others. Workers stay up between frames, so only the first frame
+    compiles the scene
+*/
+class TileCoordinator {
+public:
+    struct Settings {
+        // Started as "<executable> --serve <address>", CurrentExecutable() if empty
+        std::string Executable;
+        unsigned int Workers = 2;
+        // Workers listen on sockets made here, on ports from BasePort on Windows
+        std::string SocketDirectory = "cache";
+        unsigned int BasePort = 47900;
+        unsigned int TileSize = 256;
+        // Tiles sent to a worker ahead of its answers
+        unsigned int Pipeline = 2;
+        // Tiles taking this many times the mean tile are rendered again
+        float SlowFactor = 3.0f;
+        double StartTimeoutMilliseconds = 30000.0;
+    };
+
+    struct Frame {
+        std::string Scene;
+        unsigned int Width = 0;
+        unsigned int Height = 0;
+        float Time = 0.0f;
+        Math::Vec3 Camera;
+        float RotationY = 0.0f;
+        // Negative takes the tier of the scene
+        int Tier = -1;
+    };
+
+    struct Stats {
+        unsigned int Tiles = 0;
+        // Tiles rendered again by another worker, and how many of those it finished first
+        unsigned int Reassigned = 0;
+        unsigned int ReassignedWon = 0;
+        unsigned int LostWorkers = 0;
+        // Tiles of the frame each worker finished
+        std::vector<unsigned int> WorkerTiles;
+        double MeanTileMilliseconds = 0.0;
+        double Milliseconds = 0.0;
+    };
+public:
+    /*
+        Starts the workers and waits until they accept connections
+    */
+    explicit TileCoordinator(const Settings& settings);
+    /*
+        Shuts the workers down, terminating those that don't exit
+    */
+    ~TileCoordinator();
+
+    TileCoordinator(const TileCoordinator&) = delete;
+    TileCoordinator& operator=(const TileCoordinator&) = delete;
+
+    unsigned int ConnectedWorkers() const;
+    double StartMilliseconds() const { return mStartMilliseconds; }
+    /*
+        RGBA rows of the frame bottom to top, as glReadPixels returns them.
+        Nullopt if a tile fails on every try or no worker is left
+    */
+    std::optional<std::vector<uint8_t>> Render(const Frame& frame, Stats* stats = nullptr);
+
+    static std::string CurrentExecutable();
+private:
+    struct Worker {
+#ifdef _WIN32
+        void* Process = nullptr;
+#else
+        int Process = -1;
+#endif
+        std::string Address;
+        std::unique_ptr<RenderClient> Client;
+        // Request numbers of the connection, the server counts them the same way
+        uint64_t NextNumber = 0;
+        bool Alive = false;
+        // Has a thread of the frame being rendered
+        bool Busy = false;
+    };
+
+    struct Tile {
+        unsigned int X = 0;
+        unsigned int Y = 0;
+        unsigned int Width = 0;
+        unsigned int Height = 0;
+        unsigned int InFlight = 0;
+        unsigned int Failures = 0;
+        bool Reassigned = false;
+        bool Done = false;
+        std::chrono::steady_clock::time_point Started;
+    };
+
+    /*
+        Tiles and image of the frame being rendered, shared by the threads
+        talking to the workers
+    */
+    struct FrameState {
+        const Frame* Target = nullptr;
+        std::vector<Tile> Tiles;
+        std::deque<size_t> Pending;
+        std::vector<uint8_t> Image;
+        size_t DoneCount = 0;
+        double TileMilliseconds = 0.0;
+        unsigned int Running = 0;
+        unsigned int Alive = 0;
+        bool Finished = false;
+        bool Failed = false;
+        Stats Result;
+        std::mutex Mutex;
+        std::condition_variable Changed;
+    };
+private:
+    bool StartWorker(Worker& worker, unsigned int index);
+    /*
+        Waits for worker to exit, or kills it at once if terminate
+    */
+    void StopWorker(Worker& worker, bool terminate);
+    /*
+        Sends tiles to worker and stitches its answers until the frame is
+        finished and every answer it owes has come, or it's gone
+    */
+    void Work(size_t workerIndex, FrameState& state);
+    /*
+        A pending tile, or if idle a tile in flight long enough to be given
+        to a second worker
+    */
+    std::optional<size_t> NextTile(FrameState& state, bool idle) const;
+    void Release(FrameState& state, size_t tile) const;
+private:
+    // A tile answered by an error this many times fails the frame
+    static constexpr unsigned int sMaxTileFailures = 3;
+    static constexpr std::chrono::milliseconds sIdlePoll = std::chrono::milliseconds(5);
+    // Answers owed by workers after the frame is finished are waited for this long at least
+    static constexpr double sMinDrainMilliseconds = 1000.0;
+    static constexpr double sExitTimeoutMilliseconds = 2000.0;
+
+    Settings mSettings;
+    std::vector<Worker> mWorkers;
+    double mStartMilliseconds = 0.0;
+};
@@ -19,8 +19,11 @@ public:
 private:
     Window(GLFWwindow *window, const std::string& title, unsigned int width, unsigned int height);
 protected:
+    /*
+        Hidden windows only provide the OpenGL context, for rendering offscreen
+    */
     template <typename WindowType>
-    static WindowType* Create(const std::string& title, unsigned int width = 640, unsigned int height = 480)
+    static WindowType* Create(const std::string& title, unsigned int width = 640, unsigned int height = 480, bool visible = true)
     {
         static bool sIsContextInitialized = false;
 
@@ -32,6 +35,7 @@ protected:
         glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
         glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
         glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
 
         GLFWwindow* window = glfwCreateWindow(width, height, title.c_str(), NULL, NULL);
         ASSERT(window);
@@ -0,0 +1,172 @@
+#pragma once
+
+#include "RayMarchingWindow/IShapedObject.h"
+#include "RayMarchingWindow/IImGuiEditable.h"
+#include "Math/Math.h"
+#include <imgui.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+/*
+    Repeats wrapped shapes over XZ grid cells. Cell and its random shift are
+    computed once per evaluation in a generated function and the local point
+    is passed to all children. Uniform holds cell origin in xyz, cell size in w
+*/
+class RepeatedSpaceWrapper : public IShapedObject, public IImGuiEditable {
+public:
+    RepeatedSpaceWrapper(const std::vector<std::shared_ptr<IShapedObject>>& shapes, Math::Vec4 cell, const std::string& name)
+        : mShapes(shapes), mCell(cell), mName(name)
+    {
+    }
+
+    virtual void PassToShader(OpenGL::ShaderProgram& shader) override
+    {
+        shader.SetUniform4f(Name(), mCell.x(), mCell.y(), mCell.z(), mCell.w());
+        for (unsigned int i = 0; i < mShapes.size(); i++) {
+            mShapes[i]->PassToShader(shader);
+        }
+    }
+
+    virtual void RenderImGuiEditor() override
+    {
+        ImGui::SliderFloat("origin x", &mCell.x(), -10.0f, 10.0f);
+        ImGui::SliderFloat("origin y", &mCell.y(), -10.0f, 10.0f);
+        ImGui::SliderFloat("origin z", &mCell.z(), -10.0f, 10.0f);
+        ImGui::SliderFloat("cell size", &mCell.w(), 5.0f, 50.0f);
+    }
+
+    virtual std::string_view SectionName() const override
+    {
+        return Name();
+    }
+
+    virtual std::string UniformsDefinitions() const override
+    {
+        std::string uniforms = UNIFORM(vec4, Name());
+        for (unsigned int i = 0; i < mShapes.size(); i++) {
+            uniforms += mShapes[i]->UniformsDefinitions();
+        }
+        return uniforms;
+    }
+
+    virtual std::string SceneFunctionsDefinitions() const override
+    {
+        std::string functions;
+        for (unsigned int i = 0; i < mShapes.size(); i++) {
+            functions += mShapes[i]->SceneFunctionsDefinitions();
+        }
+
+        std::string code = mShapes.empty() ? "MAX_DISTANCE" : mShapes[0]->DistFunctionCall("local");
+        for (unsigned int i = 1; i < mShapes.size(); i++) {
+            code = "smin(" + code + ", " + mShapes[i]->DistFunctionCall("local") + ", u_SmoothMinValue)";
+        }
+
+        return functions + DIST_FUNCTION_PROTOTYPE(DistFunctionName(), vec3 p) + "\n{\n"
+            "    vec3 local = wrapSpace(p - " + Name() + ".xyz, " + Name() + ".w) + " + Name() + ".xyz;\n"
+            "    return " + code + ";\n"
+            "}\n";
+    }
+
+    virtual std::string DistFunctionCall(const std::string& fixedParam) const override
+    {
+        return DistFunctionName() + '(' + fixedParam + ')';
+    }
+
+    virtual float Distance(const Math::Vec3& p, const DistanceContext& context) const override
+    {
+        Math::Vec3 origin(mCell.x(), mCell.y(), mCell.z());
+        Math::Vec3 local = WrapSpace(p - origin, mCell.w(), context) + origin;
+
+        float dist = mShapes.empty() ? std::numeric_limits<float>::max() : mShapes[0]->Distance(local, context);
+        for (unsigned int i = 1; i < mShapes.size(); i++) {
+            dist = Math::SmoothMin(dist, mShapes[i]->Distance(local, context), context.SmoothMin);
+        }
+        return dist;
+    }
+
+    /*
+        Box spanning few cells is split between them, each part is moved by
+        its cell's shift. Larger boxes are mapped onto the whole cell widened
+        by any shift
+    */
+    virtual Math::Interval DistanceRange(const Math::AABB& box, const DistanceContext& context) const override
+    {
+        Math::Vec3 origin(mCell.x(), mCell.y(), mCell.z());
+        const float space = mCell.w();
+        Math::Vec3 min = box.Min() - origin;
+        Math::Vec3 max = box.Max() - origin;
+
+        int firstX = static_cast<int>(std::floor(min.x() / space));
+        int lastX = static_cast<int>(std::floor(max.x() / space));
+        int firstZ = static_cast<int>(std::floor(min.z() / space));
+        int lastZ = static_cast<int>(std::floor(max.z() / space));
+
+        if (static_cast<long long>(lastX - firstX + 1) * (lastZ - firstZ + 1) > sMaxRangeCells) {
+            float extent = space / 2 + space * 0.375f;
+            return ChildrenDistanceRange(Math::AABB(Math::Vec3(-extent, min.y(), -extent) + origin, Math::Vec3(extent, max.y(), extent) + origin), context);
+        }
+
+        std::optional<Math::Interval> range;
+        for (int x = firstX; x <= lastX; x++) {
+            for (int z = firstZ; z <= lastZ; z++) {
+                float randomShift = (context.NoiseTexture ? context.NoiseTexture->Sample(x / space, z / space) : 0.0f) - 0.5f;
+                Math::Vec3 offset(-x * space - space / 2 + randomShift * space * 0.75f, 0.0f, -z * space - space / 2 + randomShift * space * 0.75f);
+                Math::Vec3 partMin(std::max(min.x(), x * space), min.y(), std::max(min.z(), z * space));
+                Math::Vec3 partMax(std::min(max.x(), (x + 1) * space), max.y(), std::min(max.z(), (z + 1) * space));
+
+                Math::Interval part = ChildrenDistanceRange(Math::AABB(partMin + offset + origin, partMax + offset + origin), context);
+                range = range ? range->Union(part) : part;
+            }
+        }
+        return *range;
+    }
+
+    virtual bool IsAnimated() const override
+    {
+        return std::any_of(mShapes.begin(), mShapes.end(), [](const std::shared_ptr<IShapedObject>& shape) {
+            return shape->IsAnimated();
+        });
+    }
+
+    const std::string& Name() const
+    {
+        return mName;
+    }
+private:
+    std::string DistFunctionName() const
+    {
+        return mName + "Dist";
+    }
+
+    Math::Interval ChildrenDistanceRange(const Math::AABB& box, const DistanceContext& context) const
+    {
+        Math::Interval dist = mShapes.empty() ? std::numeric_limits<float>::max() : mShapes[0]->DistanceRange(box, context);
+        for (unsigned int i = 1; i < mShapes.size(); i++) {
+            dist = Math::SmoothMin(dist, mShapes[i]->DistanceRange(box, context), context.SmoothMin);
+        }
+        return dist;
+    }
+
+    /*
+        Same as wrapSpace in shader
+    */
+    static Math::Vec3 WrapSpace(Math::Vec3 p, float space, const DistanceContext& context)
+    {
+        float cx = std::floor(p.x() / space) / space;
+        float cz = std::floor(p.z() / space) / space;
+        float randomShift = (context.NoiseTexture ? context.NoiseTexture->Sample(cx, cz) : 0.0f) - 0.5f;
+        p.x() = Math::Mod(p.x(), space) - space / 2 + randomShift * space * 0.75f;
+        p.z() = Math::Mod(p.z(), space) - space / 2 + randomShift * space * 0.75f;
+        return p;
+    }
+private:
+    // Boxes over more cells aren't split
+    static constexpr long long sMaxRangeCells = 16;
+
+    std::vector<std::shared_ptr<IShapedObject>> mShapes;
+    Math::Vec4 mCell;
+    const std::string mName;
+};
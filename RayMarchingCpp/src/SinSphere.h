@@ -2,6 +2,7 @@
 
 #include "RayMarchingWindow/IShapedObject.h"
 #include "RayMarchingWindow/IImGuiEditable.h"
+#include "RayMarchingWindow/ShapeCode.h"
 #include "Math/Math.h"
 #include <imgui.h>
 
@@ -39,20 +40,72 @@ public:
         return DistFunctionName() + '(' + fixedParam + ", " + Name() + ')';
     }
 
+    virtual std::string CppDistFunctionCall(const std::string& fixedParam, CppSceneSource& source) const override
+    {
+        return source.AddFunction(ShapeCode::CppBody<SinSphereShape>(Params()), fixedParam);
+    }
+
     static std::string DistFunctionDefinition()
     {
-        return DIST_FUNCTION_PROTOTYPE(DistFunctionName(), vec3 p, vec4 sphereObj) DIST_FUNCTION_CODE(
-            vec3 d = p - sphereObj.xyz;
-            d = wrapSpace(d, 25);
-            return (length(d) - sphereObj.w - sin(p.x*40 + u_Time*3)*0.05)*0.5;
-        );
+        return ShapeCode::GlslDefinition<SinSphereShape>(DistFunctionName());
+    }
+
+    /*
+        Sphere with center in obj xyz and radius in w, rippled along X over time
+    */
+    template <typename T, typename P>
+    static T Sdf(T x, T y, T z, const std::array<P, 4>& obj, P time)
+    {
+        T radius = ShapeCode::Sqrt(ShapeCode::Square(x - obj[0]) + ShapeCode::Square(y - obj[1]) + ShapeCode::Square(z - obj[2])) - obj[3];
+        return (radius - ShapeCode::Sin(x * 40.0f + time * 3.0f) * 0.05f) * 0.5f;
+    }
+
+    virtual float Distance(const Math::Vec3& p, const DistanceContext& context) const override
+    {
+        return Sdf(p.x(), p.y(), p.z(), Params(), context.Time);
+    }
+
+    virtual void Distances(const PointBatch& batch, float* out, const DistanceContext& context) const override
+    {
+        const std::array<float, 4> obj = Params();
+        const float time = context.Time;
+        batch.Evaluate(out, [&](auto x, auto y, auto z) {
+            return Sdf(x, y, z, obj, time);
+        });
+    }
+
+    virtual Math::Interval DistanceRange(const Math::AABB& box, const DistanceContext& context) const override
+    {
+        Math::Interval3 p(box);
+        return Sdf(p.x(), p.y(), p.z(), Params(), context.Time);
+    }
+
+    virtual bool IsAnimated() const override
+    {
+        return true;
+    }
+
+    virtual std::optional<Math::AABB> Bounds() const override
+    {
+        // Radius plus amplitude of the sin displacement
+        Math::Vec3 center(mCoords.x(), mCoords.y(), mCoords.z());
+        Math::Vec3 extent = Math::Vec3(mCoords.w() + 0.05f);
+        return Math::AABB(center - extent, center + extent);
     }
 
     const std::string& Name() const
     {
         return mName;
     }
+
+    // Uniform of the shape is a vec4
+    static constexpr unsigned int sParamCount = 4;
 private:
+    std::array<float, 4> Params() const
+    {
+        return { mCoords.x(), mCoords.y(), mCoords.z(), mCoords.w() };
+    }
+
     static std::string DistFunctionName()
     {
         return "SinSphereDist";
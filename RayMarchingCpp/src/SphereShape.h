@@ -2,6 +2,7 @@
 
 #include "RayMarchingWindow/IShapedObject.h"
 #include "RayMarchingWindow/IImGuiEditable.h"
+#include "RayMarchingWindow/ShapeCode.h"
 #include "Math/Math.h"
 #include <imgui.h>
 
@@ -39,20 +40,70 @@ public:
         return DistFunctionName()+'('+ fixedParam + ", " + Name() + ')';
     }
 
+    virtual std::string RayHitCall(const std::string& originParam, const std::string& directionParam) const override
+    {
+        return "SphereHit(" + originParam + ", " + directionParam + ", " + Name() + ".xyz, " + Name() + ".w)";
+    }
+
+    virtual std::string CppDistFunctionCall(const std::string& fixedParam, CppSceneSource& source) const override
+    {
+        return source.AddFunction(ShapeCode::CppBody<SphereShape>(Params()), fixedParam);
+    }
+
     static std::string DistFunctionDefinition()
     {
-        return DIST_FUNCTION_PROTOTYPE(DistFunctionName(), vec3 p, vec4 sphereObj) DIST_FUNCTION_CODE(
-            vec3 d = p - sphereObj.xyz;
-            d = wrapSpace(d, 25);
-            return length(d) - sphereObj.w;
-        );
+        return ShapeCode::GlslDefinition<SphereShape>(DistFunctionName());
+    }
+
+    /*
+        Center in obj xyz, radius in w
+    */
+    template <typename T, typename P>
+    static T Sdf(T x, T y, T z, const std::array<P, 4>& obj, P)
+    {
+        return ShapeCode::Sqrt(ShapeCode::Square(x - obj[0]) + ShapeCode::Square(y - obj[1]) + ShapeCode::Square(z - obj[2])) - obj[3];
+    }
+
+    virtual float Distance(const Math::Vec3& p, const DistanceContext& context) const override
+    {
+        return Sdf(p.x(), p.y(), p.z(), Params(), context.Time);
+    }
+
+    virtual void Distances(const PointBatch& batch, float* out, const DistanceContext& context) const override
+    {
+        const std::array<float, 4> obj = Params();
+        const float time = context.Time;
+        batch.Evaluate(out, [&](auto x, auto y, auto z) {
+            return Sdf(x, y, z, obj, time);
+        });
+    }
+
+    virtual Math::Interval DistanceRange(const Math::AABB& box, const DistanceContext& context) const override
+    {
+        Math::Interval3 p(box);
+        return Sdf(p.x(), p.y(), p.z(), Params(), context.Time);
+    }
+
+    virtual std::optional<Math::AABB> Bounds() const override
+    {
+        Math::Vec3 center(mCoords.x(), mCoords.y(), mCoords.z());
+        Math::Vec3 extent = Math::Vec3(mCoords.w());
+        return Math::AABB(center - extent, center + extent);
     }
 
     const std::string& Name() const
     {
         return mName;
     }
+
+    // Uniform of the shape is a vec4
+    static constexpr unsigned int sParamCount = 4;
 private:
+    std::array<float, 4> Params() const
+    {
+        return { mCoords.x(), mCoords.y(), mCoords.z(), mCoords.w() };
+    }
+
     static std::string DistFunctionName()
     {
         return "SphereDist";
@@ -0,0 +1,413 @@
+#pragma once
+
+#include "RayMarchingWindow/DistanceContext.h"
+#include "Math/Math.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <type_traits>
+
+/*
+    Scenes fixed at build time composed into one type, so evaluating them
+    has no virtual calls and the compiler inlines the whole tree. A node has
+    template <typename T> T Distance(T x, T y, T z, const DistanceContext&),
+    evaluated with float for a point and Math::Interval for a box, Glsl
+    printing the same code for the shader and sAnimated. Nodes match the
+    dynamic shapes they are named after, see StaticShapeWrapper for using
+    them as an IShapedObject
+*/
+namespace StaticScene {
+
+    /*
+        Collects GLSL functions of nodes that need local variables, the same
+        way CppSceneSource does for C++. Function names start with prefix so
+        several scenes can live in one shader
+    */
+    class GlslPrinter {
+    public:
+        explicit GlslPrinter(const std::string& prefix) : mPrefix(prefix)
+        {
+        }
+
+        /*
+            Defines float <prefix>N(vec3 p) with body and returns its call with fixedParam
+        */
+        std::string AddFunction(const std::string& body, const std::string& fixedParam)
+        {
+            std::string name = mPrefix + std::to_string(mFunctionCount++);
+            mFunctions += "float " + name + "(vec3 p)\n{\n" + body + "\n}\n";
+            return name + '(' + fixedParam + ')';
+        }
+
+        const std::string& Functions() const
+        {
+            return mFunctions;
+        }
+
+        /*
+            Float literal that reads back as the same float, always with a point or exponent
+        */
+        static std::string Literal(float value)
+        {
+            char buffer[32];
+            std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+            std::string literal(buffer);
+            if (literal.find_first_of(".e") == std::string::npos) {
+                literal += ".0";
+            }
+            return literal;
+        }
+
+        static std::string Literal(float x, float y, float z)
+        {
+            return "vec3(" + Literal(x) + ", " + Literal(y) + ", " + Literal(z) + ')';
+        }
+    private:
+        std::string mPrefix;
+        std::string mFunctions;
+        unsigned int mFunctionCount = 0;
+    };
+
+    /*
+        float counterparts of the Interval functions of Math, which are found
+        by argument lookup, so nodes evaluate points and boxes with the same code
+    */
+    inline float Sin(float x) { return std::sin(x); }
+    inline float Cos(float x) { return std::cos(x); }
+    inline float Square(float x) { return x * x; }
+
+    template <typename T>
+    inline T Length(T x, T y, T z)
+    {
+        return Math::Sqrt(Square(x) + Square(y) + Square(z));
+    }
+
+    /*
+        Same as PlaneShape
+    */
+    struct Plane {
+        static constexpr bool sAnimated = false;
+
+        constexpr Plane(float y = 0.0f) : Y(y)
+        {
+        }
+
+        template <typename T>
+        T Distance(T x, T y, T, const DistanceContext&) const
+        {
+            return y - Y - Sin(x / 10.0f);
+        }
+
+        std::string Glsl(GlslPrinter&, const std::string& p) const
+        {
+            return "(" + p + ".y - " + GlslPrinter::Literal(Y) + " - sin(" + p + ".x / 10.0))";
+        }
+
+        float Y;
+    };
+
+    /*
+        Same as SphereShape
+    */
+    struct Sphere {
+        static constexpr bool sAnimated = false;
+
+        constexpr Sphere(float x = 0.0f, float y = 0.0f, float z = 0.0f, float radius = 1.0f) : X(x), Y(y), Z(z), Radius(radius)
+        {
+        }
+
+        template <typename T>
+        T Distance(T x, T y, T z, const DistanceContext&) const
+        {
+            return Length<T>(x - X, y - Y, z - Z) - Radius;
+        }
+
+        std::string Glsl(GlslPrinter&, const std::string& p) const
+        {
+            return "(length(" + p + " - " + GlslPrinter::Literal(X, Y, Z) + ") - " + GlslPrinter::Literal(Radius) + ')';
+        }
+
+        float X, Y, Z, Radius;
+    };
+
+    /*
+        Same as SinSphereShape, animated with u_Time
+    */
+    struct SinSphere {
+        static constexpr bool sAnimated = true;
+
+        constexpr SinSphere(float x = 0.0f, float y = 0.0f, float z = 0.0f, float radius = 1.0f) : X(x), Y(y), Z(z), Radius(radius)
+        {
+        }
+
+        template <typename T>
+        T Distance(T x, T y, T z, const DistanceContext& context) const
+        {
+            T radius = Length<T>(x - X, y - Y, z - Z) - Radius;
+            return (radius - Sin(x * 40.0f + context.Time * 3.0f) * 0.05f) * 0.5f;
+        }
+
+        std::string Glsl(GlslPrinter&, const std::string& p) const
+        {
+            return "((length(" + p + " - " + GlslPrinter::Literal(X, Y, Z) + ") - " + GlslPrinter::Literal(Radius) +
+                " - sin(" + p + ".x * 40.0 + u_Time * 3.0) * 0.05) * 0.5)";
+        }
+
+        float X, Y, Z, Radius;
+    };
+
+    /*
+        Box with half extents Size, CubeShape when they are equal
+    */
+    struct Box {
+        static constexpr bool sAnimated = false;
+
+        constexpr Box(float x = 0.0f, float y = 0.0f, float z = 0.0f, float sizeX = 1.0f, float sizeY = 1.0f, float sizeZ = 1.0f)
+            : X(x), Y(y), Z(z), SizeX(sizeX), SizeY(sizeY), SizeZ(sizeZ)
+        {
+        }
+
+        template <typename T>
+        T Distance(T x, T y, T z, const DistanceContext&) const
+        {
+            return Math::BoxDistance<T>(x - X, y - Y, z - Z, SizeX, SizeY, SizeZ);
+        }
+
+        std::string Glsl(GlslPrinter& printer, const std::string& p) const
+        {
+            return printer.AddFunction(
+                "    vec3 d = abs(p - " + GlslPrinter::Literal(X, Y, Z) + ") - " + GlslPrinter::Literal(SizeX, SizeY, SizeZ) + ";\n"
+                "    return min(max(d.x, max(d.y, d.z)), 0.0) + length(max(d, 0.0));", p);
+        }
+
+        float X, Y, Z, SizeX, SizeY, SizeZ;
+    };
+
+    /*
+        Same as VaseShape
+    */
+    struct Vase {
+        static constexpr bool sAnimated = false;
+
+        constexpr Vase(float x = 0.0f, float y = 0.0f, float z = 0.0f, float size = 1.0f) : X(x), Y(y), Z(z), Size(size)
+        {
+        }
+
+        template <typename T>
+        T Distance(T x, T y, T z, const DistanceContext&) const
+        {
+            T localY = y - Y;
+            T scale = Math::Mix(1.0f, 4.0f, Math::SmoothStep(-Size, Size, localY));
+            T localX = (x - X) * scale;
+            T localZ = (z - Z) * scale;
+            T c = Cos(localY);
+            T s = Sin(localY);
+            return Math::BoxDistance<T>(localX * c - localZ * s, localY, localX * s + localZ * c, Size, Size, Size) / scale;
+        }
+
+        std::string Glsl(GlslPrinter& printer, const std::string& p) const
+        {
+            std::string size = GlslPrinter::Literal(Size);
+            return printer.AddFunction(
+                "    vec3 p1 = p - " + GlslPrinter::Literal(X, Y, Z) + ";\n"
+                "    float scale = mix(1.0, 4.0, smoothstep(-" + size + ", " + size + ", p1.y));\n"
+                "    p1.xz *= scale;\n"
+                "    p1.xz *= Rotate(p1.y);\n"
+                "    vec3 d = abs(p1) - vec3(" + size + ");\n"
+                "    return (min(max(d.x, max(d.y, d.z)), 0.0) + length(max(d, 0.0))) / scale;", p);
+        }
+
+        float X, Y, Z, Size;
+    };
+
+    /*
+        Child moved to X, Y, Z and turned by Angle around Y like instances of
+        InstancedShapeSet. The rotation is computed once on construction
+    */
+    template <typename A>
+    struct Transform {
+        static constexpr bool sAnimated = A::sAnimated;
+
+        Transform() = default;
+        Transform(const A& child, float x, float y, float z, float angle)
+            : Child(child), X(x), Y(y), Z(z), Angle(angle), CosAngle(std::cos(angle)), SinAngle(std::sin(angle))
+        {
+        }
+
+        template <typename T>
+        T Distance(T x, T y, T z, const DistanceContext& context) const
+        {
+            T localX = x - X;
+            T localZ = z - Z;
+            return Child.Distance(localX * CosAngle - localZ * SinAngle, y - Y, localX * SinAngle + localZ * CosAngle, context);
+        }
+
+        std::string Glsl(GlslPrinter& printer, const std::string& p) const
+        {
+            std::string body = "    p -= " + GlslPrinter::Literal(X, Y, Z) + ";\n"
+                "    p.xz *= Rotate(" + GlslPrinter::Literal(Angle) + ");\n";
+            return printer.AddFunction(body + "    return " + Child.Glsl(printer, "p") + ';', p);
+        }
+
+        A Child;
+        float X = 0.0f, Y = 0.0f, Z = 0.0f, Angle = 0.0f;
+        float CosAngle = 1.0f, SinAngle = 0.0f;
+    };
+
+    /*
+        Same as UnitedShapeWrapper of two objects
+    */
+    template <typename A, typename B>
+    struct SmoothUnion {
+        static constexpr bool sAnimated = A::sAnimated || B::sAnimated;
+
+        constexpr SmoothUnion(const A& first = A(), const B& second = B()) : First(first), Second(second)
+        {
+        }
+
+        template <typename T>
+        T Distance(T x, T y, T z, const DistanceContext& context) const
+        {
+            return Math::SmoothMin(First.Distance(x, y, z, context), Second.Distance(x, y, z, context), context.SmoothMin);
+        }
+
+        std::string Glsl(GlslPrinter& printer, const std::string& p) const
+        {
+            return "smin(" + First.Glsl(printer, p) + ", " + Second.Glsl(printer, p) + ", u_SmoothMinValue)";
+        }
+
+        A First;
+        B Second;
+    };
+
+    /*
+        Second carved out of first, same as CroppedShapeWrapper
+    */
+    template <typename A, typename B>
+    struct Subtract {
+        static constexpr bool sAnimated = A::sAnimated || B::sAnimated;
+
+        constexpr Subtract(const A& first = A(), const B& second = B()) : First(first), Second(second)
+        {
+        }
+
+        template <typename T>
+        T Distance(T x, T y, T z, const DistanceContext& context) const
+        {
+            return Math::SmoothMin(First.Distance(x, y, z, context), -Second.Distance(x, y, z, context), -context.SmoothMin);
+        }
+
+        std::string Glsl(GlslPrinter& printer, const std::string& p) const
+        {
+            return "smin(" + First.Glsl(printer, p) + ", -" + Second.Glsl(printer, p) + ", -u_SmoothMinValue)";
+        }
+
+        A First;
+        B Second;
+    };
+
+    /*
+        Same as InterpolatedShapeWrapper
+    */
+    template <typename A, typename B>
+    struct Mix {
+        static constexpr bool sAnimated = A::sAnimated || B::sAnimated;
+
+        constexpr Mix(const A& first = A(), const B& second = B(), float grade = 0.5f) : First(first), Second(second), Grade(grade)
+        {
+        }
+
+        template <typename T>
+        T Distance(T x, T y, T z, const DistanceContext& context) const
+        {
+            return Math::Mix(First.Distance(x, y, z, context), Second.Distance(x, y, z, context), std::clamp(Grade, 0.0f, 1.0f));
+        }
+
+        std::string Glsl(GlslPrinter& printer, const std::string& p) const
+        {
+            return "mix(" + First.Glsl(printer, p) + ", " + Second.Glsl(printer, p) + ", " +
+                GlslPrinter::Literal(std::clamp(Grade, 0.0f, 1.0f)) + ')';
+        }
+
+        A First;
+        B Second;
+        float Grade;
+    };
+
+    /*
+        Same as RepeatedSpaceWrapper, cell origin X, Y, Z and size Space.
+        A box can cross cells with different shifts, so its shift is the whole noise range
+    */
+    template <typename A>
+    struct Repeat {
+        static constexpr bool sAnimated = A::sAnimated;
+
+        constexpr Repeat(const A& child = A(), float x = 0.0f, float y = 0.0f, float z = 0.0f, float space = 1.0f)
+            : Child(child), X(x), Y(y), Z(z), Space(space)
+        {
+        }
+
+        template <typename T>
+        T Distance(T x, T y, T z, const DistanceContext& context) const
+        {
+            T localX = x - X;
+            T localZ = z - Z;
+            T shift;
+            if constexpr (std::is_same_v<T, float>) {
+                float cellX = std::floor(localX / Space) / Space;
+                float cellZ = std::floor(localZ / Space) / Space;
+                shift = (context.NoiseTexture ? context.NoiseTexture->Sample(cellX, cellZ) : 0.0f) - 0.5f;
+            } else {
+                shift = context.NoiseTexture ? T(-0.5f, 0.5f) : T(-0.5f);
+            }
+            localX = Math::Mod(localX, Space) - Space / 2 + shift * Space * 0.75f;
+            localZ = Math::Mod(localZ, Space) - Space / 2 + shift * Space * 0.75f;
+            return Child.Distance(localX + X, (y - Y) + Y, localZ + Z, context);
+        }
+
+        std::string Glsl(GlslPrinter& printer, const std::string& p) const
+        {
+            std::string origin = GlslPrinter::Literal(X, Y, Z);
+            std::string body = "    vec3 local = wrapSpace(p - " + origin + ", " + GlslPrinter::Literal(Space) + ") + " + origin + ";\n";
+            return printer.AddFunction(body + "    return " + Child.Glsl(printer, "local") + ';', p);
+        }
+
+        A Child;
+        float X, Y, Z, Space;
+    };
+
+    /*
+        Smooth union of N objects of one type, evaluated in a loop instead of
+        a type per element, like InstancedShapeSet
+    */
+    template <typename A, size_t N>
+    struct Array {
+        static_assert(N > 0, "Array needs at least one element");
+        static constexpr bool sAnimated = A::sAnimated;
+
+        template <typename T>
+        T Distance(T x, T y, T z, const DistanceContext& context) const
+        {
+            T dist = Elements[0].Distance(x, y, z, context);
+            for (size_t i = 1; i < N; i++) {
+                dist = Math::SmoothMin(dist, Elements[i].Distance(x, y, z, context), context.SmoothMin);
+            }
+            return dist;
+        }
+
+        std::string Glsl(GlslPrinter& printer, const std::string& p) const
+        {
+            std::string code = Elements[0].Glsl(printer, "p");
+            for (size_t i = 1; i < N; i++) {
+                code = "smin(" + code + ", " + Elements[i].Glsl(printer, "p") + ", u_SmoothMinValue)";
+            }
+            return printer.AddFunction("    return " + code + ';', p);
+        }
+
+        std::array<A, N> Elements;
+    };
+
+}
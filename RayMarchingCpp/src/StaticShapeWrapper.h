@@ -0,0 +1,75 @@
+#pragma once
+
+#include "RayMarchingWindow/IShapedObject.h"
+#include "StaticScene.h"
+#include "Math/Math.h"
+
+/*
+    Registers a StaticScene type as an object. GLSL is printed once on
+    construction with the scene's values as literals, so it has no
+    uniforms and isn't editable
+*/
+template <typename Node>
+class StaticShapeWrapper : public IShapedObject {
+public:
+    StaticShapeWrapper(const Node& scene, const std::string& name) : mScene(scene), mName(name)
+    {
+        StaticScene::GlslPrinter printer(mName + "Part");
+        std::string code = mScene.Glsl(printer, "p");
+        mFunctions = printer.Functions() + DIST_FUNCTION_PROTOTYPE(DistFunctionName(), vec3 p) + "\n{\n    return " + code + ";\n}\n";
+    }
+
+    virtual void PassToShader(OpenGL::ShaderProgram&) override
+    {
+    }
+
+    virtual std::string UniformsDefinitions() const override
+    {
+        return "";
+    }
+
+    virtual std::string SceneFunctionsDefinitions() const override
+    {
+        return mFunctions;
+    }
+
+    virtual std::string DistFunctionCall(const std::string& fixedParam) const override
+    {
+        return DistFunctionName() + '(' + fixedParam + ')';
+    }
+
+    virtual float Distance(const Math::Vec3& p, const DistanceContext& context) const override
+    {
+        return mScene.Distance(p.x(), p.y(), p.z(), context);
+    }
+
+    virtual Math::Interval DistanceRange(const Math::AABB& box, const DistanceContext& context) const override
+    {
+        Math::Interval3 p(box);
+        return mScene.Distance(p.x(), p.y(), p.z(), context);
+    }
+
+    virtual bool IsAnimated() const override
+    {
+        return Node::sAnimated;
+    }
+
+    const Node& Scene() const
+    {
+        return mScene;
+    }
+
+    const std::string& Name() const
+    {
+        return mName;
+    }
+private:
+    std::string DistFunctionName() const
+    {
+        return mName + "Dist";
+    }
+private:
+    Node mScene;
+    const std::string mName;
+    std::string mFunctions;
+};
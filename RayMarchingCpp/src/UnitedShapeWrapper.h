@@ -0,0 +1,133 @@
+#pragma once
+
+#include "RayMarchingWindow/IShapedObject.h"
+#include "Math/Math.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+/*
+    Smooth union of any number of shapes, the same smin chain the window
+    builds over registered objects. Lets a whole scene be passed where a
+    single object is expected, e.g. to bake it on CPU
+*/
+class UnitedShapeWrapper : public IShapedObject {
+public:
+    UnitedShapeWrapper(const std::vector<std::shared_ptr<IShapedObject>>& shapes) : mShapes(shapes)
+    {
+    }
+
+    virtual void PassToShader(OpenGL::ShaderProgram& shader) override
+    {
+        for (const std::shared_ptr<IShapedObject>& shape : mShapes) {
+            shape->PassToShader(shader);
+        }
+    }
+
+    virtual std::string UniformsDefinitions() const override
+    {
+        std::string uniforms;
+        for (const std::shared_ptr<IShapedObject>& shape : mShapes) {
+            uniforms += shape->UniformsDefinitions();
+        }
+        return uniforms;
+    }
+
+    virtual std::string SceneFunctionsDefinitions() const override
+    {
+        std::string functions;
+        for (const std::shared_ptr<IShapedObject>& shape : mShapes) {
+            functions += shape->SceneFunctionsDefinitions();
+        }
+        return functions;
+    }
+
+    virtual std::string DistFunctionCall(const std::string& fixedParam) const override
+    {
+        std::string code = mShapes.empty() ? "MAX_DISTANCE" : mShapes[0]->DistFunctionCall(fixedParam);
+        for (unsigned int i = 1; i < mShapes.size(); i++) {
+            code = "smin(" + code + ", " + mShapes[i]->DistFunctionCall(fixedParam) + ", u_SmoothMinValue)";
+        }
+        return code;
+    }
+
+    /*
+        Nearest hit of the shapes if all of them have one
+    */
+    virtual std::string RayHitCall(const std::string& originParam, const std::string& directionParam) const override
+    {
+        std::string code = mShapes.empty() ? "NO_HIT" : "";
+        for (const std::shared_ptr<IShapedObject>& shape : mShapes) {
+            std::string call = shape->RayHitCall(originParam, directionParam);
+            if (call.empty()) {
+                return "";
+            }
+            code = code.empty() ? call : "min(" + code + ", " + call + ")";
+        }
+        return code;
+    }
+
+    virtual std::string CppDistFunctionCall(const std::string& fixedParam, CppSceneSource& source) const override
+    {
+        std::string code = mShapes.empty() ? CppSceneSource::Literal(std::numeric_limits<float>::max()) : mShapes[0]->CppDistFunctionCall("p", source);
+        for (unsigned int i = 1; i < mShapes.size(); i++) {
+            code = "SmoothMin(" + code + ", " + mShapes[i]->CppDistFunctionCall("p", source) + ", c.SmoothMin)";
+        }
+        return source.AddFunction("return " + code + ";", fixedParam);
+    }
+
+    virtual float Distance(const Math::Vec3& p, const DistanceContext& context) const override
+    {
+        float dist = mShapes.empty() ? std::numeric_limits<float>::max() : mShapes[0]->Distance(p, context);
+        for (unsigned int i = 1; i < mShapes.size(); i++) {
+            dist = Math::SmoothMin(dist, mShapes[i]->Distance(p, context), context.SmoothMin);
+        }
+        return dist;
+    }
+
+    virtual void Distances(const PointBatch& batch, float* out, const DistanceContext& context) const override
+    {
+        if (mShapes.empty()) {
+            std::fill(out, out + batch.Count, std::numeric_limits<float>::max());
+            return;
+        }
+        mShapes[0]->Distances(batch, out, context);
+        float dist[PointBatch::sMaxCount];
+        for (unsigned int i = 1; i < mShapes.size(); i++) {
+            mShapes[i]->Distances(batch, dist, context);
+            Math::SmoothMin(out, dist, batch.Count, context.SmoothMin);
+        }
+    }
+
+    virtual Math::Interval DistanceRange(const Math::AABB& box, const DistanceContext& context) const override
+    {
+        Math::Interval dist = mShapes.empty() ? std::numeric_limits<float>::max() : mShapes[0]->DistanceRange(box, context);
+        for (unsigned int i = 1; i < mShapes.size(); i++) {
+            dist = Math::SmoothMin(dist, mShapes[i]->DistanceRange(box, context), context.SmoothMin);
+        }
+        return dist;
+    }
+
+    virtual bool IsAnimated() const override
+    {
+        return std::any_of(mShapes.begin(), mShapes.end(), [](const std::shared_ptr<IShapedObject>& shape) {
+            return shape->IsAnimated();
+        });
+    }
+
+    virtual std::optional<Math::AABB> Bounds() const override
+    {
+        Math::AABB bounds;
+        for (const std::shared_ptr<IShapedObject>& shape : mShapes) {
+            std::optional<Math::AABB> shapeBounds = shape->Bounds();
+            if (!shapeBounds) {
+                return std::nullopt;
+            }
+            bounds = bounds.Union(*shapeBounds);
+        }
+        return bounds;
+    }
+private:
+    std::vector<std::shared_ptr<IShapedObject>> mShapes;
+};
@@ -2,6 +2,7 @@
 
 #include "RayMarchingWindow/IShapedObject.h"
 #include "RayMarchingWindow/IImGuiEditable.h"
+#include "RayMarchingWindow/ShapeCode.h"
 #include "Math/Math.h"
 #include <imgui.h>
 
@@ -39,32 +40,79 @@ public:
         return DistFunctionName() + '(' + fixedParam + ", " + Name() + ')';
     }
 
+    virtual std::string CppDistFunctionCall(const std::string& fixedParam, CppSceneSource& source) const override
+    {
+        return source.AddFunction(ShapeCode::CppBody<VaseShape>(Params()), fixedParam);
+    }
+
     static std::string DistFunctionDefinition()
     {
-        return DIST_FUNCTION_PROTOTYPE(DistFunctionName(), vec3 p, vec4 cubeObj) DIST_FUNCTION_CODE(
+        return ShapeCode::GlslDefinition<VaseShape>(DistFunctionName());
+    }
+
+    /*
+        Box of half size obj w at obj xyz, widened towards its top and twisted around Y by height
+    */
+    template <typename T, typename P>
+    static T Sdf(T x, T y, T z, const std::array<P, 4>& obj, P)
+    {
+        T localY = y - obj[1];
+        T scale = ShapeCode::Mix(T(1.0f), T(4.0f), ShapeCode::SmoothStep(-obj[3], obj[3], localY));
+        T localX = (x - obj[0]) * scale;
+        T localZ = (z - obj[2]) * scale;
+        T c = ShapeCode::Cos(localY);
+        T s = ShapeCode::Sin(localY);
+        return ShapeCode::BoxDistance(localX * c - localZ * s, localY, localX * s + localZ * c, obj[3], obj[3], obj[3]) / scale;
+    }
+
+    virtual float Distance(const Math::Vec3& p, const DistanceContext& context) const override
+    {
+        return Sdf(p.x(), p.y(), p.z(), Params(), context.Time);
+    }
+
+    virtual void Distances(const PointBatch& batch, float* out, const DistanceContext& context) const override
+    {
+        const std::array<float, 4> obj = Params();
+        const float time = context.Time;
+        batch.Evaluate(out, [&](auto x, auto y, auto z) {
+            return Sdf(x, y, z, obj, time);
+        });
+    }
+
+    virtual Math::Interval DistanceRange(const Math::AABB& box, const DistanceContext& context) const override
+    {
+        Math::Interval3 p(box);
+        return Sdf(p.x(), p.y(), p.z(), Params(), context.Time);
+    }
 
-            vec3 size = vec3(cubeObj.w);
-            vec3 p1 = p - cubeObj.xyz;
-            p1 = wrapSpace(p1, 25);
-            float scale = mix(1.0f, 4.0f, smoothstep(-cubeObj.w, cubeObj.w, p1.y));
-            p1.xz *= scale;
-            p1.xz *= Rotate(p1.y);
-            vec3 d = abs(p1) - size;
-            return (min(max(d.x, max(d.y, d.z)), 0.0) +
-                length(max(d, 0.0))) / scale;
-        );
+    virtual std::optional<Math::AABB> Bounds() const override
+    {
+        // Scale never shrinks XZ below the box, rotation widens it up to the diagonal
+        Math::Vec3 center(mCoords.x(), mCoords.y(), mCoords.z());
+        Math::Vec3 extent = Math::Vec3(mCoords.w() * sSqrt2, mCoords.w(), mCoords.w() * sSqrt2);
+        return Math::AABB(center - extent, center + extent);
     }
 
     const std::string& Name() const
     {
         return mName;
     }
+
+    // Uniform of the shape is a vec4
+    static constexpr unsigned int sParamCount = 4;
 private:
+    std::array<float, 4> Params() const
+    {
+        return { mCoords.x(), mCoords.y(), mCoords.z(), mCoords.w() };
+    }
+
     static std::string DistFunctionName()
     {
         return "VaseShape";
     }
 private:
+    static constexpr float sSqrt2 = 1.41421356f;
+
     Math::Vec4 mCoords;
     const std::string mName;
 };
\ No newline at end of file